@@ -32,6 +32,7 @@ typedef enum sp_parameter_parse_msg_t {
 	SP_PARAMETER_PARSE_INVALID_KEY,
 	SP_PARAMETER_PARSE_INVALID_ENUM_VALUE,
 	SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT,
+	SP_PARAMETER_PARSE_INVALID_DOUBLE_FORMAT,
 	SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT,
 	SP_PARAMETER_PARSE_SUCCESS
 } SP_PARAMETER_PARSE_MSG;
@@ -46,20 +47,39 @@ struct sp_config_t {
 	// Optional Fields - Have default values
 	int PCADimension;
 	char *PCAFilename;
+	int PCATrainingImages;
+	int PCATrainingSamples;
 	int numOfFeatures;
+	int maxImageSide;
 	bool extractionMode;
+	bool extractionCache;
+	bool featuresStore;
+	bool featuresSync;
 	int numOfSimilarImages;
 	SP_TREE_SPLIT_METHOD splitMethod;
+	SP_SEARCH_INDEX_TYPE searchIndex;
+	int PQSubquantizers;
+	int IVFLists;
+	int IVFProbes;
+	int HNSWM;
+	int HNSWEfConstruction;
+	int HNSWEfSearch;
 	int KNN;
+	SP_VOTING_MODE votingMode;
+	double ratioTestThreshold;
+	int numOfThreads;
 	bool minimalGUI;
 	SP_LOGGER_LEVEL loggerLevel;
 	char *loggerFilename;
+	bool loggerAsync;
+	bool loggerRecordTags;
 };
 
 
 /*** Method Declarations ***/
 
 int intValue(const char *parameterAsString, bool* success);
+double doubleValue(const char *parameterAsString, bool* success);
 bool boolValue(const char *parameterAsString, bool* success);
 SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		char *requiredFieldsBitMask, bool* usedValueAsString);
@@ -70,6 +90,8 @@ char *defaultStringValue(const char *val);
 /*** Constants ***/
 
 static const char *FEATURES_PATH_SUFFIX = ".feats";
+static const char *FEATURES_STORE_PATH_SUFFIX = ".store";
+static const char *HNSW_INDEX_PATH_SUFFIX = ".hnsw";
 
 static const char IMAGES_DIRECTORY_BIT_MASK = 0x01;
 static const char IMAGES_PREFIX_BIT_MASK = 0x02;
@@ -154,6 +176,12 @@ SPConfig spConfigCreate(const char* filename, SP_CONFIG_MSG* msg) {
 				printRErrorMsg(filename, lineNum, MESSAGE_INVALID_VALUE_CONSTRAINT_NOT_MET);
 				validParameters = false;
 				break;
+			case SP_PARAMETER_PARSE_INVALID_DOUBLE_FORMAT:
+				returnValue = NULL;
+				*msg = SP_CONFIG_INVALID_DOUBLE;
+				printRErrorMsg(filename, lineNum, MESSAGE_INVALID_VALUE_CONSTRAINT_NOT_MET);
+				validParameters = false;
+				break;
 			default:
 				break;
 			}
@@ -218,14 +246,32 @@ int setupConfigWithDefaultValues(SPConfig config) {
 
 	config->PCADimension = 20;
 	config->PCAFilename = PCAFilename;
+	config->PCATrainingImages = 0;
+	config->PCATrainingSamples = 0;
 	config->numOfFeatures = 100;
+	config->maxImageSide = 0;
 	config->extractionMode = true;
+	config->extractionCache = false;
+	config->featuresStore = false;
+	config->featuresSync = false;
 	config->minimalGUI = false;
 	config->numOfSimilarImages = 1;
 	config->KNN = 1;
+	config->votingMode = VOTING_MODE_FLAT;
+	config->ratioTestThreshold = 0.8;
+	config->numOfThreads = 4;
 	config->splitMethod = TREE_SPLIT_METHOD_MAX_SPREAD;
+	config->searchIndex = SEARCH_INDEX_KD_TREE;
+	config->PQSubquantizers = 8;
+	config->IVFLists = 256;
+	config->IVFProbes = 8;
+	config->HNSWM = 16;
+	config->HNSWEfConstruction = 200;
+	config->HNSWEfSearch = 64;
 	config->loggerLevel = SP_LOGGER_INFO_WARNING_ERROR_LEVEL;
 	config->loggerFilename = loggerFilename;
+	config->loggerAsync = false;
+	config->loggerRecordTags = false;
 	return 0;
 }
 
@@ -242,6 +288,7 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		char *requiredFieldsBitMask, bool* usedValueAsString) {
 	bool parsedBool, conversionSucceeded = false;
 	int parsedInt;
+	double parsedDouble;
 
 	*usedValueAsString = false;
 	if (strcmp(key, "spImagesDirectory") == 0) {
@@ -277,6 +324,20 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 	} else if (strcmp(key, "spPCAFilename") == 0) {
 		config->PCAFilename = value;
 		*usedValueAsString = true;
+	} else if (strcmp(key, "spPCATrainingImages") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt >= 0) {
+			config->PCATrainingImages = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spPCATrainingSamples") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt >= 0) {
+			config->PCATrainingSamples = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
 	} else if (strcmp(key, "spNumOfFeatures") == 0) {
 		parsedInt = intValue(value, &conversionSucceeded);
 		if (conversionSucceeded && parsedInt >= 0) {
@@ -284,6 +345,13 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		} else {
 			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
 		}
+	} else if (strcmp(key, "spMaxImageSide") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt >= 0) {
+			config->maxImageSide = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
 	} else if (strcmp(key, "spExtractionMode") == 0) {
 		parsedBool = boolValue(value, &conversionSucceeded);
 		if (conversionSucceeded) {
@@ -291,6 +359,27 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		} else {
 			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
 		}
+	} else if (strcmp(key, "spExtractionCache") == 0) {
+		parsedBool = boolValue(value, &conversionSucceeded);
+		if (conversionSucceeded) {
+			config->extractionCache = parsedBool;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
+		}
+	} else if (strcmp(key, "spFeaturesStore") == 0) {
+		parsedBool = boolValue(value, &conversionSucceeded);
+		if (conversionSucceeded) {
+			config->featuresStore = parsedBool;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
+		}
+	} else if (strcmp(key, "spFeaturesSync") == 0) {
+		parsedBool = boolValue(value, &conversionSucceeded);
+		if (conversionSucceeded) {
+			config->featuresSync = parsedBool;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
+		}
 	} else if (strcmp(key, "spNumOfSimilarImages") == 0) {
 		parsedInt = intValue(value, &conversionSucceeded);
 		if (conversionSucceeded && parsedInt > 0) {
@@ -308,6 +397,63 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		} else {
 			return SP_PARAMETER_PARSE_INVALID_ENUM_VALUE;
 		}
+	} else if (strcmp(key, "spSearchIndex") == 0) {
+		if (strcmp(value, "KD_TREE") == 0) {
+			config->searchIndex = SEARCH_INDEX_KD_TREE;
+		} else if (strcmp(value, "PQ") == 0) {
+			config->searchIndex = SEARCH_INDEX_PQ;
+		} else if (strcmp(value, "IVF") == 0) {
+			config->searchIndex = SEARCH_INDEX_IVF;
+		} else if (strcmp(value, "IVF_PQ") == 0) {
+			config->searchIndex = SEARCH_INDEX_IVF_PQ;
+		} else if (strcmp(value, "HNSW") == 0) {
+			config->searchIndex = SEARCH_INDEX_HNSW;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_ENUM_VALUE;
+		}
+	} else if (strcmp(key, "spPQSubquantizers") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->PQSubquantizers = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spIVFLists") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->IVFLists = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spIVFProbes") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->IVFProbes = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spHNSWM") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		// The levels of the graph are drawn with a factor of 1 / ln(M), so M must be larger than 1
+		if (conversionSucceeded && parsedInt > 1) {
+			config->HNSWM = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spHNSWEfConstruction") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->HNSWEfConstruction = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
+	} else if (strcmp(key, "spHNSWEfSearch") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->HNSWEfSearch = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
 	} else if (strcmp(key, "spKNN") == 0) {
 		parsedInt = intValue(value, &conversionSucceeded);
 		if (conversionSucceeded && parsedInt > 0) {
@@ -315,6 +461,30 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 		} else {
 			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
 		}
+	} else if (strcmp(key, "spVotingMode") == 0) {
+		if (strcmp(value, "FLAT") == 0) {
+			config->votingMode = VOTING_MODE_FLAT;
+		} else if (strcmp(value, "DISTANCE_WEIGHTED") == 0) {
+			config->votingMode = VOTING_MODE_DISTANCE_WEIGHTED;
+		} else if (strcmp(value, "RATIO_TEST") == 0) {
+			config->votingMode = VOTING_MODE_RATIO_TEST;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_ENUM_VALUE;
+		}
+	} else if (strcmp(key, "spRatioTestThreshold") == 0) {
+		parsedDouble = doubleValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedDouble > 0 && parsedDouble <= 1) {
+			config->ratioTestThreshold = parsedDouble;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_DOUBLE_FORMAT;
+		}
+	} else if (strcmp(key, "spNumOfThreads") == 0) {
+		parsedInt = intValue(value, &conversionSucceeded);
+		if (conversionSucceeded && parsedInt > 0) {
+			config->numOfThreads = parsedInt;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_INTEGER_FORMAT;
+		}
 	} else if (strcmp(key, "spMinimalGUI") == 0) {
 		parsedBool = boolValue(value, &conversionSucceeded);
 		if (conversionSucceeded) {
@@ -332,6 +502,20 @@ SP_PARAMETER_PARSE_MSG parseParameter(SPConfig config, char *key, char *value,
 	} else if (strcmp(key, "spLoggerFilename") == 0) {
 		config->loggerFilename = value;
 		*usedValueAsString = true;
+	} else if (strcmp(key, "spLoggerAsync") == 0) {
+		parsedBool = boolValue(value, &conversionSucceeded);
+		if (conversionSucceeded) {
+			config->loggerAsync = parsedBool;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
+		}
+	} else if (strcmp(key, "spLoggerRecordTags") == 0) {
+		parsedBool = boolValue(value, &conversionSucceeded);
+		if (conversionSucceeded) {
+			config->loggerRecordTags = parsedBool;
+		} else {
+			return SP_PARAMETER_PARSE_INVALID_BOOL_FORMAT;
+		}
 	} else {
 		return SP_PARAMETER_PARSE_INVALID_KEY;
 	}
@@ -350,6 +534,14 @@ int intValue(const char *parameterAsString, bool* success) {
 	return val;
 }
 
+double doubleValue(const char *parameterAsString, bool* success) {
+	char *end;
+	double val = strtod(parameterAsString, &end);
+	// The whole value must be a number
+	*success = (end != parameterAsString && *end == '\0');
+	return val;
+}
+
 bool boolValue(const char *parameterAsString, bool* success) {
 	if (strcmp(parameterAsString, "true") == 0) {
 		*success = true;
@@ -404,6 +596,33 @@ bool spConfigIsExtractionMode(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return config->extractionMode;
 }
 
+bool spConfigIsExtractionCache(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return false;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->extractionCache;
+}
+
+bool spConfigIsFeaturesStore(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return false;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->featuresStore;
+}
+
+bool spConfigIsFeaturesSync(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return false;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->featuresSync;
+}
+
 bool spConfigMinimalGui(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -431,6 +650,15 @@ int spConfigGetNumOfFeatures(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return config->numOfFeatures;
 }
 
+int spConfigGetMaxImageSide(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->maxImageSide;
+}
+
 int spConfigGetPCADim(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -440,6 +668,24 @@ int spConfigGetPCADim(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return config->PCADimension;
 }
 
+int spConfigGetPCATrainingImages(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->PCATrainingImages;
+}
+
+int spConfigGetPCATrainingSamples(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->PCATrainingSamples;
+}
+
 SP_TREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -449,6 +695,69 @@ SP_TREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_MSG
 	return config->splitMethod;
 }
 
+SP_SEARCH_INDEX_TYPE spConfigGetSearchIndex(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return SEARCH_INDEX_KD_TREE;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->searchIndex;
+}
+
+int spConfigGetPQSubquantizers(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->PQSubquantizers;
+}
+
+int spConfigGetIVFLists(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->IVFLists;
+}
+
+int spConfigGetIVFProbes(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->IVFProbes;
+}
+
+int spConfigGetHNSWM(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->HNSWM;
+}
+
+int spConfigGetHNSWEfConstruction(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->HNSWEfConstruction;
+}
+
+int spConfigGetHNSWEfSearch(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->HNSWEfSearch;
+}
+
 int spConfigGetKNN(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -458,6 +767,33 @@ int spConfigGetKNN(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return config->KNN;
 }
 
+SP_VOTING_MODE spConfigGetVotingMode(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return VOTING_MODE_FLAT;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->votingMode;
+}
+
+double spConfigGetRatioTestThreshold(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->ratioTestThreshold;
+}
+
+int spConfigGetNumOfThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return -1;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->numOfThreads;
+}
+
 int spConfigGetNumOfSimilarImages(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -498,6 +834,22 @@ SP_CONFIG_MSG spConfigGetImageFeaturesPath(char *featuresPath, const SPConfig co
 	return SP_CONFIG_SUCCESS;
 }
 
+SP_CONFIG_MSG spConfigGetFeaturesStorePath(char *featuresStorePath, const SPConfig config) {
+	if (featuresStorePath == NULL || config == NULL) {
+		return SP_CONFIG_INVALID_ARGUMENT;
+	}
+	sprintf(featuresStorePath, "%s%s%s", config->imagesDirectory, config->imagesPrefix, FEATURES_STORE_PATH_SUFFIX);
+	return SP_CONFIG_SUCCESS;
+}
+
+SP_CONFIG_MSG spConfigGetHNSWIndexPath(char *indexPath, const SPConfig config) {
+	if (indexPath == NULL || config == NULL) {
+		return SP_CONFIG_INVALID_ARGUMENT;
+	}
+	sprintf(indexPath, "%s%s%s", config->imagesDirectory, config->imagesPrefix, HNSW_INDEX_PATH_SUFFIX);
+	return SP_CONFIG_SUCCESS;
+}
+
 char *spConfigGetLoggerFilename(const SPConfig config, SP_CONFIG_MSG* msg) {
 	if (config == NULL) {
 		*msg = SP_CONFIG_INVALID_ARGUMENT;
@@ -516,4 +868,22 @@ SP_LOGGER_LEVEL spConfigGetLoggerLevel(const SPConfig config, SP_CONFIG_MSG* msg
 	return config->loggerLevel;
 }
 
+bool spConfigIsLoggerAsync(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return false;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->loggerAsync;
+}
+
+bool spConfigIsLoggerRecordTags(const SPConfig config, SP_CONFIG_MSG* msg) {
+	if (config == NULL) {
+		*msg = SP_CONFIG_INVALID_ARGUMENT;
+		return false;
+	}
+	*msg = SP_CONFIG_SUCCESS;
+	return config->loggerRecordTags;
+}
+
 
@@ -14,6 +14,16 @@ typedef enum sp_tree_split_method_t {
 	TREE_SPLIT_METHOD_RANDOM, TREE_SPLIT_METHOD_MAX_SPREAD, TREE_SPLIT_METHOD_INCREMENTAL
 } SP_TREE_SPLIT_METHOD;
 
+/** The different configurable indices of the images features. */
+typedef enum sp_search_index_type_t {
+	SEARCH_INDEX_KD_TREE, SEARCH_INDEX_PQ, SEARCH_INDEX_IVF, SEARCH_INDEX_IVF_PQ, SEARCH_INDEX_HNSW
+} SP_SEARCH_INDEX_TYPE;
+
+/** The different configurable images voting methods. */
+typedef enum sp_voting_mode_t {
+	VOTING_MODE_FLAT, VOTING_MODE_DISTANCE_WEIGHTED, VOTING_MODE_RATIO_TEST
+} SP_VOTING_MODE;
+
 /** Enumeration to communicate possible results for SPConfig methods. */
 typedef enum sp_config_msg_t {
 	SP_CONFIG_MISSING_DIR,
@@ -23,6 +33,7 @@ typedef enum sp_config_msg_t {
 	SP_CONFIG_CANNOT_OPEN_FILE,
 	SP_CONFIG_ALLOC_FAIL,
 	SP_CONFIG_INVALID_INTEGER,
+	SP_CONFIG_INVALID_DOUBLE,
 	SP_CONFIG_INVALID_STRING,
 	SP_CONFIG_INVALID_ARGUMENT,
 	SP_CONFIG_INDEX_OUT_OF_RANGE,
@@ -47,6 +58,7 @@ typedef struct sp_config_t* SPConfig;
  * - SP_CONFIG_CANNOT_OPEN_FILE - if the configuration file given by filename cannot be open
  * - SP_CONFIG_ALLOC_FAIL - if an allocation failure occurred
  * - SP_CONFIG_INVALID_INTEGER - if a line in the config file contains invalid integer
+ * - SP_CONFIG_INVALID_DOUBLE - if a line in the config file contains invalid floating point number
  * - SP_CONFIG_INVALID_STRING - if a line in the config file contains invalid string
  * - SP_CONFIG_MISSING_DIR - if spImagesDirectory is missing
  * - SP_CONFIG_MISSING_PREFIX - if spImagesPrefix is missing
@@ -101,6 +113,54 @@ char *spConfigImagesPrefix(const SPConfig config, SP_CONFIG_MSG *msg);
  */
 bool spConfigIsExtractionMode(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns true if spExtractionCache = true, false otherwise. In extraction mode with the cache, an existing PCA
+ * basis is reused, and an image is not extracted again if its contents and the extraction parameters (including
+ * the PCA basis) did not change since its features file was written.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if spExtractionCache = true, false otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+bool spConfigIsExtractionCache(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns true if spFeaturesStore = true, false otherwise. With the features store, the features of all of the
+ * images are written to (and loaded from) the single file given by spConfigGetFeaturesStorePath, instead of a
+ * features file per image.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if spFeaturesStore = true, false otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+bool spConfigIsFeaturesStore(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns true if spFeaturesSync = true, false otherwise. With it, every features file written in extraction mode
+ * is flushed to the disk (with fdatasync) before the next one is written, so a crash never leaves a features file
+ * which was reported as written only in the page cache. The features store is always flushed when it is committed.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if spFeaturesSync = true, false otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+bool spConfigIsFeaturesSync(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /*
  * Returns true if spMinimalGUI = true, false otherwise.
  *
@@ -145,6 +205,23 @@ int spConfigGetNumOfImages(const SPConfig config, SP_CONFIG_MSG* msg);
  */
 int spConfigGetNumOfFeatures(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns the maximal side (in pixels) of an image the features are extracted from, i.e the value of
+ * spMaxImageSide. Larger images are scaled down before the features extraction, 0 (the default) means
+ * images are never scaled.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetMaxImageSide(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /**
  * Returns the dimension of the PCA. i.e the value of spPCADimension.
  *
@@ -159,6 +236,39 @@ int spConfigGetNumOfFeatures(const SPConfig config, SP_CONFIG_MSG* msg);
  */
 int spConfigGetPCADim(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns the number of images the PCA is trained on in extraction mode, i.e the value of spPCATrainingImages.
+ * The images are spread evenly over all of the images, 0 (the default) means training on all of them.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetPCATrainingImages(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of SIFT descriptors the PCA is trained on in extraction mode, i.e the value of
+ * spPCATrainingSamples. The descriptors are a reproducible random sample of the training images' descriptors,
+ * 0 (the default) means training on all of them.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetPCATrainingSamples(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /*
  * Returns the desired tree split method (max_spread, random or incremental).
  *
@@ -176,6 +286,129 @@ int spConfigGetPCADim(const SPConfig config, SP_CONFIG_MSG* msg);
  */
 SP_TREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns the desired index of the images features (kd_tree, pq, ivf, ivf_pq or hnsw).
+ *
+ * 	SEARCH_INDEX_KD_TREE	- A kd-tree of the features, searched exactly.
+ * 	SEARCH_INDEX_PQ			- The features encoded by product quantization, searched with approximate distances
+ * 							  (see spConfigGetPQSubquantizers). Takes spPQSubquantizers bytes per feature.
+ * 	SEARCH_INDEX_IVF		- The features grouped in spIVFLists inverted lists, of which only the spIVFProbes lists
+ * 							  nearest to a query are searched (see spConfigGetIVFLists).
+ * 	SEARCH_INDEX_IVF_PQ		- As SEARCH_INDEX_IVF, with the features of the lists encoded by product quantization
+ * 							  (relative to the centers of their lists).
+ * 	SEARCH_INDEX_HNSW		- A hierarchical navigable small world graph of the features, searched greedily from its
+ * 							  top layer down (see spConfigGetHNSWM). The graph is saved next to the features, and
+ * 							  is loaded instead of being rebuilt as long as the features do not change.
+ *
+ * NOTICE: The method returns a valid value on failure, so the msg's value must be used for validation.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return The configured index on success, undefined value otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+SP_SEARCH_INDEX_TYPE spConfigGetSearchIndex(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of sub-quantizers of the product quantization index, i.e the value of spPQSubquantizers.
+ * Every feature is split to this many sub-vectors, each encoded by a single byte, so it must not be larger than
+ * spPCADimension.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetPQSubquantizers(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of inverted lists of the IVF index, i.e the value of spIVFLists.
+ * Every feature belongs to the list of its nearest list center (the centers are clustered by k-means), so more
+ * lists mean shorter lists to search.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetIVFLists(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of inverted lists searched per query feature by the IVF index, i.e the value of spIVFProbes.
+ * The lists whose centers are the nearest to the query feature are searched, so more probes mean better recall
+ * and slower queries.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetIVFProbes(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of neighbors every feature is linked to in each layer of the HNSW graph, i.e the value of
+ * spHNSWM (the features of the bottom layer are linked to up to twice as many). More links mean better recall,
+ * and a larger graph which is slower to build.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetHNSWM(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of candidate neighbors the HNSW graph keeps while a feature is inserted to it, i.e the value
+ * of spHNSWEfConstruction. Larger values build a better connected graph, more slowly.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetHNSWEfConstruction(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of candidate neighbors the HNSW graph keeps while a query feature is searched, i.e the value
+ * of spHNSWEfSearch (at least spKNN candidates are kept in any case). Larger values mean better recall and slower
+ * queries.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetHNSWEfSearch(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /*
  * Returns the desired number of nearest neighbors required in feature search.
  *
@@ -191,6 +424,60 @@ SP_TREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_MSG
  */
 int spConfigGetKNN(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns the desired images voting method (flat, distance_weighted or ratio_test).
+ *
+ * 	VOTING_MODE_FLAT				- Each of the nearest neighbors gives one hit to its image.
+ * 	VOTING_MODE_DISTANCE_WEIGHTED	- Each of the nearest neighbors gives its image a hit weighted by the squared distance
+ * 									  of the nearest neighbor divided by its own squared distance.
+ * 	VOTING_MODE_RATIO_TEST			- Only the nearest neighbor gives one hit to its image, and only if its distance is
+ * 									  smaller than spRatioTestThreshold times the distance of the second nearest neighbor.
+ *
+ * NOTICE: The method returns a valid value on failure, so the msg's value must be used for validation.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return The configured voting method on success, undefined value otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+SP_VOTING_MODE spConfigGetVotingMode(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the distances ratio threshold used by the ratio test voting method, i.e the value of spRatioTestThreshold.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return a value in (0, 1] in success, negative value otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+double spConfigGetRatioTestThreshold(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of worker threads to use for work which is done concurrently (e.g. serving queries),
+ * i.e the value of spNumOfThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+int spConfigGetNumOfThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /*
  * Returns the number of similar images to show in the results.
  *
@@ -279,6 +566,42 @@ SP_CONFIG_MSG spConfigGetPCAPath(char* pcaPath, const SPConfig config);
  */
 SP_CONFIG_MSG spConfigGetImageFeaturesPath(char *featuresPath, const SPConfig config, int index);
 
+/**
+ * The function stores in featuresStorePath the full path of the features store.
+ * For example given the values of:
+ *  spImagesDirectory = "./images/"
+ *  spImagesPrefix = "img"
+ *
+ * The functions stores "./images/img.store" to the address given by featuresStorePath.
+ * Thus the address given by featuresStorePath must contain enough space to
+ * store the resulting string.
+ *
+ * @param featuresStorePath - an address to store the result in, it must contain enough space.
+ * @param config - the configuration structure
+ * @return
+ *  - SP_CONFIG_INVALID_ARGUMENT - if featuresStorePath == NULL or config == NULL
+ *  - SP_CONFIG_SUCCESS - in case of success
+ */
+SP_CONFIG_MSG spConfigGetFeaturesStorePath(char *featuresStorePath, const SPConfig config);
+
+/**
+ * The function stores in indexPath the full path of the saved HNSW graph.
+ * For example given the values of:
+ *  spImagesDirectory = "./images/"
+ *  spImagesPrefix = "img"
+ *
+ * The functions stores "./images/img.hnsw" to the address given by indexPath.
+ * Thus the address given by indexPath must contain enough space to
+ * store the resulting string.
+ *
+ * @param indexPath - an address to store the result in, it must contain enough space.
+ * @param config - the configuration structure
+ * @return
+ *  - SP_CONFIG_INVALID_ARGUMENT - if indexPath == NULL or config == NULL
+ *  - SP_CONFIG_SUCCESS - in case of success
+ */
+SP_CONFIG_MSG spConfigGetHNSWIndexPath(char *indexPath, const SPConfig config);
+
 /*
  * Returns the log file name.
  *
@@ -311,6 +634,37 @@ char *spConfigGetLoggerFilename(const SPConfig config, SP_CONFIG_MSG* msg);
  */
 SP_LOGGER_LEVEL spConfigGetLoggerLevel(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns true if the logger should be created in asynchronous mode, i.e the value of spLoggerAsync.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return true if the logger is asynchronous, false otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+bool spConfigIsLoggerAsync(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns true if the log records should be tagged with the printing thread and a timestamp,
+ * i.e the value of spLoggerRecordTags.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ *
+ * @return true if the records are tagged, false otherwise.
+ *
+ * The resulting value stored in msg is as follow:
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ */
+bool spConfigIsLoggerRecordTags(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /**
  * Frees all memory resources associate with config. 
  * If config == NULL nothig is done.
@@ -0,0 +1,1019 @@
+/*
+ * SPHNSWIndex.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "SPHNSWIndex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "SPListElement.h"
+#include "SPThreadPool.h"
+#include "sp_metrics.h"
+#include "sp_util.h"
+
+/*** Constants ***/
+
+#define HNSW_INDEX_MAGIC "SPHN"
+#define HNSW_INDEX_VERSION 1
+#define HNSW_TEMPORARY_FILE_SUFFIX ".tmp"
+
+/** The number of consecutive features inserted by a single thread pool job. */
+#define INSERTIONS_PER_JOB 64
+
+/** The number of insertion jobs per thread which may wait for a worker. */
+#define INSERTION_JOBS_PER_THREAD 4
+
+/** The highest level a feature may be drawn to, which is far above the level of the top layer of any real graph. */
+#define MAX_FEATURE_LEVEL 16
+
+/** The seed the levels of the features are drawn with. */
+#define LEVELS_SEED 0x9E3779B97F4A7C15ULL
+
+/*** Type declarations ***/
+
+/** The file header - its size is a multiple of 8, so the coordinates after it are aligned. */
+typedef struct sp_hnsw_index_header_t {
+	char magic[4];
+	uint32_t version;
+	uint32_t dimension;
+	uint32_t numOfFeatures;
+	uint32_t M;
+	uint32_t efConstruction;
+	int32_t entryPoint;
+	int32_t maxLevel;
+	uint64_t tag;
+	uint64_t checksum;
+} SPHNSWIndexHeader;
+
+/** A node reached by a search, and its squared distance from the searched vector. */
+typedef struct hnsw_candidate_t {
+	double distance;
+	int feature;
+} HNSWCandidate;
+
+/** A binary heap of candidates - the nearest candidate is at its top, or the farthest if isMaxHeap is set. */
+typedef struct hnsw_heap_t {
+	HNSWCandidate *items;
+	int size;
+	int capacity;
+	bool isMaxHeap;
+} HNSWHeap;
+
+/**
+ * The buffers of a single search - the search marks the nodes it reaches with visitedMark, so the visited array
+ * is cleared only once every UINT_MAX searches. Contexts are reused by the searches of the index.
+ */
+typedef struct hnsw_search_context_t {
+	unsigned int *visited;
+	unsigned int visitedMark;
+	HNSWHeap candidates;
+	HNSWHeap results;
+	int *links;
+	HNSWCandidate *found;
+	HNSWCandidate *neighbours;
+	double *query;
+	long distanceComputations;
+	struct hnsw_search_context_t *next;
+} HNSWSearchContext;
+
+/**
+ * Structure containing the HNSW index data.
+ * The links of a node in a layer are an int holding their number, followed by room for the maximal number of
+ * links of the layer (maxM0 in the bottom layer, M in the upper layers). The links of feature i in the bottom layer
+ * start at baseLinks + i * (maxM0 + 1), and its links in layer l > 0 at upperLinks[i] + (l - 1) * (M + 1).
+ * locks (a lock per feature, guarding its links) is set only while the graph is built.
+ */
+struct sp_hnsw_index_t {
+	int dimension;
+	int numOfFeatures;
+	int M;
+	int maxM0;
+	int efConstruction;
+	int efSearch;
+	double *vectors;
+	int *imageIndices;
+	int *levels;
+	int *baseLinks;
+	int **upperLinks;
+	int entryPoint;
+	int maxLevel;
+	pthread_mutex_t *locks;
+	pthread_mutex_t entryLock;
+	pthread_mutex_t contextsLock;
+	HNSWSearchContext *freeContexts;
+};
+
+/** A range of consecutive features inserted by one thread pool job. */
+typedef struct hnsw_insertion_job_t {
+	SPHNSWIndex index;
+	HNSWSearchContext **contexts;
+	int begin;
+	int end;
+	bool failed;
+} HNSWInsertionJob;
+
+/*** Private Methods ***/
+
+/**
+ * Returns the squared distance between the given vector and the given feature.
+ */
+double hnswDistance(SPHNSWIndex index, HNSWSearchContext *context, const double *vector, int feature) {
+	int j;
+	const double *featureVector = index->vectors + (size_t) feature * index->dimension;
+	double difference, distance = 0;
+	for (j = 0; j < index->dimension; j++) {
+		difference = vector[j] - featureVector[j];
+		distance += difference * difference;
+	}
+	context->distanceComputations++;
+	return distance;
+}
+
+/**
+ * Returns the links of the given feature in the given layer - the number of links followed by the links.
+ */
+int *hnswLinks(SPHNSWIndex index, int feature, int layer) {
+	if (layer == 0) {
+		return index->baseLinks + (size_t) feature * (index->maxM0 + 1);
+	}
+	return index->upperLinks[feature] + (size_t) (layer - 1) * (index->M + 1);
+}
+
+/**
+ * Returns the links of the given feature in the given layer. While the graph is built, they are copied to the
+ * links buffer of the context under the feature's lock, as other threads may change them.
+ */
+const int *hnswReadLinks(SPHNSWIndex index, HNSWSearchContext *context, int feature, int layer) {
+	int *links = hnswLinks(index, feature, layer);
+	if (index->locks == NULL) {
+		return links;
+	}
+	pthread_mutex_lock(&index->locks[feature]);
+	memcpy(context->links, links, (links[0] + 1) * sizeof(int));
+	pthread_mutex_unlock(&index->locks[feature]);
+	return context->links;
+}
+
+/**
+ * Returns whether the first candidate should be nearer to the top of the heap than the second one.
+ */
+bool hnswHeapPrecedes(const HNSWHeap *heap, const HNSWCandidate *first, const HNSWCandidate *second) {
+	return heap->isMaxHeap ? first->distance > second->distance : first->distance < second->distance;
+}
+
+/**
+ * Pushes the given candidate to the heap, which grows if it is full.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool hnswHeapPush(HNSWHeap *heap, double distance, int feature) {
+	int position, parent;
+	HNSWCandidate candidate, *items;
+	if (heap->size == heap->capacity) {
+		items = (HNSWCandidate *) realloc(heap->items, 2 * heap->capacity * sizeof(HNSWCandidate));
+		if (items == NULL) {
+			return false;
+		}
+		heap->items = items;
+		heap->capacity *= 2;
+	}
+	candidate.distance = distance;
+	candidate.feature = feature;
+	for (position = heap->size++; position > 0; position = parent) {
+		parent = (position - 1) / 2;
+		if (!hnswHeapPrecedes(heap, &candidate, &heap->items[parent])) {
+			break;
+		}
+		heap->items[position] = heap->items[parent];
+	}
+	heap->items[position] = candidate;
+	return true;
+}
+
+/**
+ * Removes the top candidate of the given non-empty heap.
+ *
+ * @return
+ * 	The removed candidate.
+ */
+HNSWCandidate hnswHeapPop(HNSWHeap *heap) {
+	int position = 0, child;
+	HNSWCandidate top = heap->items[0], last = heap->items[--heap->size];
+	while ((child = 2 * position + 1) < heap->size) {
+		if (child + 1 < heap->size && hnswHeapPrecedes(heap, &heap->items[child + 1], &heap->items[child])) {
+			child++;
+		}
+		if (!hnswHeapPrecedes(heap, &heap->items[child], &last)) {
+			break;
+		}
+		heap->items[position] = heap->items[child];
+		position = child;
+	}
+	heap->items[position] = last;
+	return top;
+}
+
+void destroySearchContext(HNSWSearchContext *context) {
+	if (context == NULL) {
+		return;
+	}
+	free(context->visited);
+	free(context->candidates.items);
+	free(context->results.items);
+	free(context->links);
+	free(context->found);
+	free(context->neighbours);
+	free(context->query);
+	free(context);
+}
+
+/**
+ * Allocates a search context for the given index.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the context otherwise.
+ */
+HNSWSearchContext *createSearchContext(SPHNSWIndex index) {
+	HNSWSearchContext *context = (HNSWSearchContext *) calloc(1, sizeof(*context));
+	if (context == NULL) {
+		return NULL;
+	}
+	context->visited = (unsigned int *) calloc(index->numOfFeatures, sizeof(unsigned int));
+	context->candidates.capacity = index->efConstruction + 1;
+	context->candidates.items = (HNSWCandidate *) malloc(context->candidates.capacity * sizeof(HNSWCandidate));
+	context->results.capacity = index->efConstruction + 1;
+	context->results.items = (HNSWCandidate *) malloc(context->results.capacity * sizeof(HNSWCandidate));
+	context->results.isMaxHeap = true;
+	context->links = (int *) malloc((index->maxM0 + 1) * sizeof(int));
+	context->found = (HNSWCandidate *) malloc(index->efConstruction * sizeof(HNSWCandidate));
+	context->neighbours = (HNSWCandidate *) malloc((index->maxM0 + 1) * sizeof(HNSWCandidate));
+	context->query = (double *) malloc(index->dimension * sizeof(double));
+	if (context->visited == NULL || context->candidates.items == NULL || context->results.items == NULL
+			|| context->links == NULL || context->found == NULL || context->neighbours == NULL
+			|| context->query == NULL) {
+		destroySearchContext(context);
+		return NULL;
+	}
+	return context;
+}
+
+/**
+ * Takes a search context of the given index, allocating a new one if none is free.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the context otherwise.
+ */
+HNSWSearchContext *acquireSearchContext(SPHNSWIndex index) {
+	HNSWSearchContext *context;
+	pthread_mutex_lock(&index->contextsLock);
+	context = index->freeContexts;
+	if (context != NULL) {
+		index->freeContexts = context->next;
+	}
+	pthread_mutex_unlock(&index->contextsLock);
+	return (context != NULL) ? context : createSearchContext(index);
+}
+
+/**
+ * Returns the given search context to the free contexts of the index.
+ */
+void releaseSearchContext(SPHNSWIndex index, HNSWSearchContext *context) {
+	pthread_mutex_lock(&index->contextsLock);
+	context->next = index->freeContexts;
+	index->freeContexts = context;
+	pthread_mutex_unlock(&index->contextsLock);
+}
+
+/**
+ * Starts a new search with the given context - no node is visited yet.
+ */
+void startSearch(SPHNSWIndex index, HNSWSearchContext *context) {
+	if (++context->visitedMark == 0) {
+		memset(context->visited, 0, index->numOfFeatures * sizeof(unsigned int));
+		context->visitedMark = 1;
+	}
+	context->candidates.size = 0;
+	context->results.size = 0;
+}
+
+/**
+ * Walks greedily in the given layer from the given node, to the node nearest to the vector which is reachable by
+ * always moving to a nearer neighbor.
+ *
+ * @param entryPoint The node to start from, which is set to the nearest node found.
+ * @param entryDistance The distance of the entry point, which is set to the distance of the nearest node found.
+ */
+void greedySearch(SPHNSWIndex index, HNSWSearchContext *context, const double *vector, int layer,
+		int *entryPoint, double *entryDistance) {
+	int i;
+	const int *links;
+	double distance;
+	bool moved = true;
+	while (moved) {
+		moved = false;
+		links = hnswReadLinks(index, context, *entryPoint, layer);
+		for (i = 1; i <= links[0]; i++) {
+			distance = hnswDistance(index, context, vector, links[i]);
+			if (distance < *entryDistance) {
+				*entryDistance = distance;
+				*entryPoint = links[i];
+				moved = true;
+			}
+		}
+	}
+}
+
+/**
+ * Searches the given layer from the given node, keeping the ef nearest nodes reached in the results heap of the
+ * context. The search stops once the nearest candidate left is farther than all of the ef results.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool searchLayer(SPHNSWIndex index, HNSWSearchContext *context, const double *vector, int layer, int entryPoint,
+		double entryDistance, int ef) {
+	int i, neighbour;
+	const int *links;
+	double distance;
+	HNSWCandidate nearest;
+	startSearch(index, context);
+	context->visited[entryPoint] = context->visitedMark;
+	if (!hnswHeapPush(&context->candidates, entryDistance, entryPoint)
+			|| !hnswHeapPush(&context->results, entryDistance, entryPoint)) {
+		return false;
+	}
+	while (context->candidates.size > 0) {
+		nearest = hnswHeapPop(&context->candidates);
+		if (nearest.distance > context->results.items[0].distance && context->results.size >= ef) {
+			break;
+		}
+		links = hnswReadLinks(index, context, nearest.feature, layer);
+		for (i = 1; i <= links[0]; i++) {
+			neighbour = links[i];
+			if (context->visited[neighbour] == context->visitedMark) {
+				continue;
+			}
+			context->visited[neighbour] = context->visitedMark;
+			distance = hnswDistance(index, context, vector, neighbour);
+			if (context->results.size >= ef && distance >= context->results.items[0].distance) {
+				continue;
+			}
+			if (!hnswHeapPush(&context->candidates, distance, neighbour)
+					|| !hnswHeapPush(&context->results, distance, neighbour)) {
+				return false;
+			}
+			if (context->results.size > ef) {
+				hnswHeapPop(&context->results);
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Selects up to maxLinks neighbors out of the given candidates (sorted by their distances, nearest first), moving
+ * them to the start of the array. A candidate is selected only if it is not nearer to any neighbor selected before
+ * it than to the linked node, so the links point in different directions rather than to a single near cluster.
+ *
+ * @return
+ * 	The number of selected neighbors.
+ */
+int selectNeighbours(SPHNSWIndex index, HNSWSearchContext *context, HNSWCandidate *candidates,
+		int numOfCandidates, int maxLinks) {
+	int i, j, numOfSelected = 0;
+	bool diverse;
+	for (i = 0; i < numOfCandidates && numOfSelected < maxLinks; i++) {
+		diverse = true;
+		for (j = 0; j < numOfSelected && diverse; j++) {
+			diverse = hnswDistance(index, context, index->vectors + (size_t) candidates[i].feature * index->dimension,
+					candidates[j].feature) >= candidates[i].distance;
+		}
+		if (diverse) {
+			candidates[numOfSelected++] = candidates[i];
+		}
+	}
+	return numOfSelected;
+}
+
+int compareCandidates(const void *first, const void *second) {
+	double difference = ((const HNSWCandidate *) first)->distance - ((const HNSWCandidate *) second)->distance;
+	return (difference > 0) - (difference < 0);
+}
+
+/**
+ * Links the given neighbor to the given inserted feature in the given layer. If the neighbor already has the
+ * maximal number of links, its links are selected again out of its current ones and the inserted feature.
+ */
+void linkNeighbour(SPHNSWIndex index, HNSWSearchContext *context, int neighbour, int feature, int layer) {
+	int i, numOfCandidates, maxLinks = (layer == 0) ? index->maxM0 : index->M;
+	int *links = hnswLinks(index, neighbour, layer);
+	const double *neighbourVector = index->vectors + (size_t) neighbour * index->dimension;
+	pthread_mutex_lock(&index->locks[neighbour]);
+	if (links[0] < maxLinks) {
+		links[++links[0]] = feature;
+		pthread_mutex_unlock(&index->locks[neighbour]);
+		return;
+	}
+	numOfCandidates = links[0] + 1;
+	for (i = 0; i < links[0]; i++) {
+		context->neighbours[i].feature = links[i + 1];
+		context->neighbours[i].distance = hnswDistance(index, context, neighbourVector, links[i + 1]);
+	}
+	context->neighbours[links[0]].feature = feature;
+	context->neighbours[links[0]].distance = hnswDistance(index, context, neighbourVector, feature);
+	qsort(context->neighbours, numOfCandidates, sizeof(HNSWCandidate), compareCandidates);
+	links[0] = selectNeighbours(index, context, context->neighbours, numOfCandidates, maxLinks);
+	for (i = 0; i < links[0]; i++) {
+		links[i + 1] = context->neighbours[i].feature;
+	}
+	pthread_mutex_unlock(&index->locks[neighbour]);
+}
+
+/**
+ * Inserts the given feature to the graph - walks down from the entry point to the feature's level, and links the
+ * feature to its selected neighbors in every layer from its level down. The neighbors are linked back to the feature
+ * only after all of its own links are set.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool insertFeature(SPHNSWIndex index, HNSWSearchContext *context, int feature) {
+	int i, layer, entryPoint, maxLevel, numOfFound, numOfLinks, *links, level = index->levels[feature];
+	const int *selected;
+	const double *vector = index->vectors + (size_t) feature * index->dimension;
+	double entryDistance;
+	pthread_mutex_lock(&index->entryLock);
+	entryPoint = index->entryPoint;
+	maxLevel = index->maxLevel;
+	pthread_mutex_unlock(&index->entryLock);
+
+	entryDistance = hnswDistance(index, context, vector, entryPoint);
+	for (layer = maxLevel; layer > level; layer--) {
+		greedySearch(index, context, vector, layer, &entryPoint, &entryDistance);
+	}
+	for (layer = (level < maxLevel) ? level : maxLevel; layer >= 0; layer--) {
+		if (!searchLayer(index, context, vector, layer, entryPoint, entryDistance, index->efConstruction)) {
+			return false;
+		}
+		// The results are popped farthest first, so they are sorted by filling the array from its end
+		numOfFound = context->results.size;
+		for (i = numOfFound - 1; i >= 0; i--) {
+			context->found[i] = hnswHeapPop(&context->results);
+		}
+		entryPoint = context->found[0].feature;
+		entryDistance = context->found[0].distance;
+		numOfLinks = selectNeighbours(index, context, context->found, numOfFound, index->M);
+
+		links = hnswLinks(index, feature, layer);
+		pthread_mutex_lock(&index->locks[feature]);
+		for (i = 0; i < numOfLinks; i++) {
+			links[i + 1] = context->found[i].feature;
+		}
+		links[0] = numOfLinks;
+		pthread_mutex_unlock(&index->locks[feature]);
+	}
+
+	// The feature is reachable only once its neighbors link to it, so no other insertion walks down from it to
+	// layers it has no links in yet. The bottom layer is linked first, so the feature is not reachable in a layer
+	// before its links in that layer are read.
+	for (layer = 0; layer <= level && layer <= maxLevel; layer++) {
+		selected = hnswReadLinks(index, context, feature, layer);
+		for (i = 1; i <= selected[0]; i++) {
+			linkNeighbour(index, context, selected[i], feature, layer);
+		}
+	}
+
+	if (level > maxLevel) {
+		pthread_mutex_lock(&index->entryLock);
+		if (level > index->maxLevel) {
+			index->maxLevel = level;
+			index->entryPoint = feature;
+		}
+		pthread_mutex_unlock(&index->entryLock);
+	}
+	return true;
+}
+
+/**
+ * Thread pool job - inserts the features of the job's range, with the search context of the executing worker.
+ */
+void insertFeatures(void *arg, int worker) {
+	int feature;
+	HNSWInsertionJob *job = (HNSWInsertionJob *) arg;
+	for (feature = job->begin; feature < job->end && !job->failed; feature++) {
+		job->failed = !insertFeature(job->index, job->contexts[worker], feature);
+	}
+}
+
+/**
+ * Inserts all of the features but the first one (which is the initial entry point) to the graph, with the given
+ * number of threads. Submitting a job blocks while the queue of the pool is full, so it fails only on an invalid
+ * argument - which would be a bug, and is reported as a failure of the insertion rather than retried.
+ *
+ * @return
+ * 	false in case of allocation failure, or if a job could not be submitted, true otherwise.
+ */
+bool insertAllFeatures(SPHNSWIndex index, int numOfThreads) {
+	int i, numOfSubmitted = 0, numOfJobs = (index->numOfFeatures - 1 + INSERTIONS_PER_JOB - 1) / INSERTIONS_PER_JOB;
+	HNSWInsertionJob *jobs = (HNSWInsertionJob *) malloc((numOfJobs + 1) * sizeof(HNSWInsertionJob));
+	HNSWSearchContext **contexts = (HNSWSearchContext **) calloc(numOfThreads, sizeof(HNSWSearchContext *));
+	SPThreadPool pool = NULL;
+	bool success = (jobs != NULL && contexts != NULL);
+	for (i = 0; i < numOfThreads && success; i++) {
+		contexts[i] = createSearchContext(index);
+		success = (contexts[i] != NULL);
+	}
+	pool = success ? spThreadPoolCreate(numOfThreads, numOfThreads * INSERTION_JOBS_PER_THREAD) : NULL;
+	if (pool != NULL) {
+		// The jobs are taken in their submission order, so the features are inserted in about their order
+		for (i = 0; i < numOfJobs && success; i++) {
+			jobs[i].index = index;
+			jobs[i].contexts = contexts;
+			jobs[i].begin = 1 + i * INSERTIONS_PER_JOB;
+			jobs[i].end = (jobs[i].begin + INSERTIONS_PER_JOB < index->numOfFeatures) ?
+					jobs[i].begin + INSERTIONS_PER_JOB : index->numOfFeatures;
+			jobs[i].failed = false;
+			success = (spThreadPoolSubmit(pool, insertFeatures, &jobs[i]) == SP_THREAD_POOL_SUCCESS);
+			numOfSubmitted += success ? 1 : 0;
+		}
+		spThreadPoolDestroy(pool);
+		for (i = 0; i < numOfSubmitted; i++) {
+			success = success && !jobs[i].failed;
+		}
+	} else {
+		success = false;
+	}
+	for (i = 0; contexts != NULL && i < numOfThreads; i++) {
+		destroySearchContext(contexts[i]);
+	}
+	free(contexts);
+	free(jobs);
+	return success;
+}
+
+/**
+ * Draws the level of every feature - level l with probability (1 - 1 / M) / M^l. The levels are drawn from a
+ * hash of the positions of the features, so they do not depend on the order the features are inserted in.
+ */
+void drawLevels(SPHNSWIndex index) {
+	int i;
+	unsigned long long hash;
+	double uniform, levelFactor = 1.0 / log((double) index->M);
+	for (i = 0; i < index->numOfFeatures; i++) {
+		// splitmix64 of the position
+		hash = LEVELS_SEED * (unsigned long long) (i + 1);
+		hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+		hash ^= hash >> 31;
+		// Uniform in (0, 1], out of the upper 53 bits of the hash
+		uniform = ((hash >> 11) + 1.0) / 9007199254740992.0;
+		index->levels[i] = (int) (-log(uniform) * levelFactor);
+		if (index->levels[i] > MAX_FEATURE_LEVEL) {
+			index->levels[i] = MAX_FEATURE_LEVEL;
+		}
+	}
+}
+
+/**
+ * Allocates the upper layers links of every feature above the bottom layer, according to the levels.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool allocateUpperLinks(SPHNSWIndex index) {
+	int i;
+	for (i = 0; i < index->numOfFeatures; i++) {
+		if (index->levels[i] > 0) {
+			index->upperLinks[i] = (int *) calloc((size_t) index->levels[i] * (index->M + 1), sizeof(int));
+			if (index->upperLinks[i] == NULL) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Allocates an index with no links, whose features, levels and upper links are set by the caller.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the index otherwise.
+ */
+SPHNSWIndex allocateHNSWIndex(int dimension, int numOfFeatures, int M, int efConstruction, int efSearch) {
+	SPHNSWIndex index = (SPHNSWIndex) calloc(1, sizeof(*index));
+	if (index == NULL) {
+		return NULL;
+	}
+	if (pthread_mutex_init(&index->entryLock, NULL) != 0) {
+		free(index);
+		return NULL;
+	}
+	if (pthread_mutex_init(&index->contextsLock, NULL) != 0) {
+		pthread_mutex_destroy(&index->entryLock);
+		free(index);
+		return NULL;
+	}
+	index->dimension = dimension;
+	index->numOfFeatures = numOfFeatures;
+	index->M = M;
+	index->maxM0 = 2 * M;
+	index->efConstruction = efConstruction;
+	index->efSearch = efSearch;
+	index->vectors = (double *) malloc((size_t) numOfFeatures * dimension * sizeof(double));
+	index->imageIndices = (int *) malloc(numOfFeatures * sizeof(int));
+	index->levels = (int *) malloc(numOfFeatures * sizeof(int));
+	index->baseLinks = (int *) calloc((size_t) numOfFeatures * (index->maxM0 + 1), sizeof(int));
+	index->upperLinks = (int **) calloc(numOfFeatures, sizeof(int *));
+	if (index->vectors == NULL || index->imageIndices == NULL || index->levels == NULL || index->baseLinks == NULL
+			|| index->upperLinks == NULL) {
+		spHNSWIndexDestroy(index);
+		return NULL;
+	}
+	return index;
+}
+
+/**
+ * Creates a lock per feature, guarding its links while the graph is built.
+ *
+ * @return
+ * 	false in case of failure (in which case no lock is left), true otherwise.
+ */
+bool createFeatureLocks(SPHNSWIndex index) {
+	int i;
+	index->locks = (pthread_mutex_t *) malloc(index->numOfFeatures * sizeof(pthread_mutex_t));
+	if (index->locks == NULL) {
+		return false;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		if (pthread_mutex_init(&index->locks[i], NULL) != 0) {
+			while (--i >= 0) {
+				pthread_mutex_destroy(&index->locks[i]);
+			}
+			free(index->locks);
+			index->locks = NULL;
+			return false;
+		}
+	}
+	return true;
+}
+
+void destroyFeatureLocks(SPHNSWIndex index) {
+	int i;
+	if (index->locks == NULL) {
+		return;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		pthread_mutex_destroy(&index->locks[i]);
+	}
+	free(index->locks);
+	index->locks = NULL;
+}
+
+/**
+ * Writes the given block to the file, and adds it to the checksum.
+ */
+bool writeHNSWBlock(FILE *file, const void *data, size_t size, unsigned long long *checksum) {
+	*checksum = spUtilFNV1aHash(data, size, *checksum);
+	return fwrite(data, 1, size, file) == size;
+}
+
+/**
+ * Reads the given block from the file, and adds it to the checksum.
+ */
+bool readHNSWBlock(FILE *file, void *data, size_t size, unsigned long long *checksum) {
+	if (fread(data, 1, size, file) != size) {
+		return false;
+	}
+	*checksum = spUtilFNV1aHash(data, size, *checksum);
+	return true;
+}
+
+/**
+ * Checks that the given links of a node in the given layer are of a valid number, and point to nodes of the layer.
+ */
+bool areLinksValid(SPHNSWIndex index, const int *links, int layer) {
+	int i, maxLinks = (layer == 0) ? index->maxM0 : index->M;
+	if (links[0] < 0 || links[0] > maxLinks) {
+		return false;
+	}
+	for (i = 1; i <= links[0]; i++) {
+		if (links[i] < 0 || links[i] >= index->numOfFeatures || index->levels[links[i]] < layer) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Reads the features and the links of the index from the file (after its header), and validates them.
+ *
+ * @return
+ * 	SP_HNSW_INDEX_ALLOC_FAIL in case of allocation failure, SP_HNSW_INDEX_INVALID_FORMAT in case the file is
+ * 	truncated or invalid, SP_HNSW_INDEX_SUCCESS otherwise.
+ */
+SP_HNSW_INDEX_MSG readHNSWGraph(SPHNSWIndex index, FILE *file, unsigned long long expectedChecksum) {
+	int i, layer;
+	unsigned long long checksum = SP_UTIL_FNV1A_INITIAL_HASH;
+	size_t n = (size_t) index->numOfFeatures;
+	if (!readHNSWBlock(file, index->vectors, n * index->dimension * sizeof(double), &checksum)
+			|| !readHNSWBlock(file, index->imageIndices, n * sizeof(int), &checksum)
+			|| !readHNSWBlock(file, index->levels, n * sizeof(int), &checksum)) {
+		return SP_HNSW_INDEX_INVALID_FORMAT;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		if (index->imageIndices[i] < 0 || index->levels[i] < 0 || index->levels[i] > index->maxLevel) {
+			return SP_HNSW_INDEX_INVALID_FORMAT;
+		}
+	}
+	if (index->levels[index->entryPoint] != index->maxLevel) {
+		return SP_HNSW_INDEX_INVALID_FORMAT;
+	}
+	if (!allocateUpperLinks(index)) {
+		return SP_HNSW_INDEX_ALLOC_FAIL;
+	}
+	if (!readHNSWBlock(file, index->baseLinks, n * (index->maxM0 + 1) * sizeof(int), &checksum)) {
+		return SP_HNSW_INDEX_INVALID_FORMAT;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		if (index->levels[i] > 0 && !readHNSWBlock(file, index->upperLinks[i],
+				(size_t) index->levels[i] * (index->M + 1) * sizeof(int), &checksum)) {
+			return SP_HNSW_INDEX_INVALID_FORMAT;
+		}
+	}
+	if (fgetc(file) != EOF || checksum != expectedChecksum) {
+		return SP_HNSW_INDEX_INVALID_FORMAT;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		for (layer = 0; layer <= index->levels[i]; layer++) {
+			if (!areLinksValid(index, hnswLinks(index, i, layer), layer)) {
+				return SP_HNSW_INDEX_INVALID_FORMAT;
+			}
+		}
+	}
+	return SP_HNSW_INDEX_SUCCESS;
+}
+
+/*** Public Methods ***/
+
+SPHNSWIndex spHNSWIndexCreate(const SPPoint *features, int numOfFeatures, int M, int efConstruction, int efSearch,
+		int numOfThreads, SP_HNSW_INDEX_MSG *msg) {
+	int i, j, dimension;
+	SPHNSWIndex index;
+	bool success;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (features == NULL || numOfFeatures <= 0 || M < 2 || efConstruction <= 0 || efSearch <= 0
+			|| numOfThreads <= 0) {
+		*msg = SP_HNSW_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	dimension = spPointGetDimension(features[0]);
+	for (i = 1; i < numOfFeatures; i++) {
+		if (spPointGetDimension(features[i]) != dimension) {
+			*msg = SP_HNSW_INDEX_INVALID_ARGUMENT;
+			return NULL;
+		}
+	}
+	index = allocateHNSWIndex(dimension, numOfFeatures, M, efConstruction, efSearch);
+	if (index == NULL) {
+		*msg = SP_HNSW_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	for (i = 0; i < numOfFeatures; i++) {
+		for (j = 0; j < dimension; j++) {
+			index->vectors[(size_t) i * dimension + j] = spPointGetAxisCoor(features[i], j);
+		}
+		index->imageIndices[i] = spPointGetIndex(features[i]);
+	}
+	drawLevels(index);
+	// The first feature is the initial entry point, and the others are inserted around it
+	index->entryPoint = 0;
+	index->maxLevel = index->levels[0];
+	success = allocateUpperLinks(index) && createFeatureLocks(index);
+	success = success && insertAllFeatures(index, numOfThreads);
+	destroyFeatureLocks(index);
+	if (!success) {
+		spHNSWIndexDestroy(index);
+		*msg = SP_HNSW_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	*msg = SP_HNSW_INDEX_SUCCESS;
+	return index;
+}
+
+void spHNSWIndexDestroy(SPHNSWIndex index) {
+	int i;
+	HNSWSearchContext *context;
+	if (index == NULL) {
+		return;
+	}
+	while (index->freeContexts != NULL) {
+		context = index->freeContexts;
+		index->freeContexts = context->next;
+		destroySearchContext(context);
+	}
+	for (i = 0; index->upperLinks != NULL && i < index->numOfFeatures; i++) {
+		free(index->upperLinks[i]);
+	}
+	destroyFeatureLocks(index);
+	pthread_mutex_destroy(&index->entryLock);
+	pthread_mutex_destroy(&index->contextsLock);
+	free(index->upperLinks);
+	free(index->baseLinks);
+	free(index->levels);
+	free(index->imageIndices);
+	free(index->vectors);
+	free(index);
+}
+
+int spHNSWIndexGetNumOfFeatures(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->numOfFeatures;
+}
+
+int spHNSWIndexGetDimension(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->dimension;
+}
+
+int spHNSWIndexGetM(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->M;
+}
+
+int spHNSWIndexGetEfConstruction(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->efConstruction;
+}
+
+int spHNSWIndexGetEfSearch(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->efSearch;
+}
+
+int spHNSWIndexGetNumOfLayers(SPHNSWIndex index) {
+	return (index == NULL) ? -1 : index->maxLevel + 1;
+}
+
+int spHNSWIndexGetNumOfLinks(SPHNSWIndex index, int feature, int layer) {
+	if (index == NULL || feature < 0 || feature >= index->numOfFeatures || layer < 0
+			|| layer > index->levels[feature]) {
+		return -1;
+	}
+	return hnswLinks(index, feature, layer)[0];
+}
+
+SP_HNSW_INDEX_MSG spHNSWIndexKNearestNeighbours(SPHNSWIndex index, SPBPQueue queue, SPPoint point) {
+	int j, layer, entryPoint, ef;
+	double entryDistance;
+	HNSWSearchContext *context;
+	HNSWCandidate result;
+	SPListElement element;
+	SP_HNSW_INDEX_MSG msg = SP_HNSW_INDEX_SUCCESS;
+	if (index == NULL || queue == NULL || point == NULL || spPointGetDimension(point) != index->dimension) {
+		return SP_HNSW_INDEX_INVALID_ARGUMENT;
+	}
+	context = acquireSearchContext(index);
+	if (context == NULL) {
+		return SP_HNSW_INDEX_ALLOC_FAIL;
+	}
+	SP_METRICS_TIMER_START(traversalTimer);
+	context->distanceComputations = 0;
+	for (j = 0; j < index->dimension; j++) {
+		context->query[j] = spPointGetAxisCoor(point, j);
+	}
+	ef = (spBPQueueGetMaxSize(queue) > index->efSearch) ? spBPQueueGetMaxSize(queue) : index->efSearch;
+	entryPoint = index->entryPoint;
+	entryDistance = hnswDistance(index, context, context->query, entryPoint);
+	for (layer = index->maxLevel; layer > 0; layer--) {
+		greedySearch(index, context, context->query, layer, &entryPoint, &entryDistance);
+	}
+	if (!searchLayer(index, context, context->query, 0, entryPoint, entryDistance, ef)) {
+		msg = SP_HNSW_INDEX_ALLOC_FAIL;
+	}
+	while (msg == SP_HNSW_INDEX_SUCCESS && context->results.size > 0) {
+		result = hnswHeapPop(&context->results);
+		element = spListElementCreate(index->imageIndices[result.feature], result.distance);
+		if (element == NULL || spBPQueueEnqueue(queue, element) == SP_BPQUEUE_OUT_OF_MEMORY) {
+			msg = SP_HNSW_INDEX_ALLOC_FAIL;
+		}
+		spListElementDestroy(element);
+	}
+	SP_METRICS_TIMER_STOP(traversalTimer, SP_METRICS_TREE_TRAVERSAL);
+	SP_METRICS_COUNT(SP_METRICS_DISTANCE_COMPUTATIONS, context->distanceComputations);
+	releaseSearchContext(index, context);
+	return msg;
+}
+
+SP_HNSW_INDEX_MSG spHNSWIndexSave(SPHNSWIndex index, const char *filePath, unsigned long long tag) {
+	int i;
+	char *temporaryPath;
+	FILE *file;
+	SPHNSWIndexHeader header;
+	unsigned long long checksum = SP_UTIL_FNV1A_INITIAL_HASH;
+	size_t n;
+	bool success;
+	if (index == NULL || filePath == NULL) {
+		return SP_HNSW_INDEX_INVALID_ARGUMENT;
+	}
+	temporaryPath = (char *) malloc(strlen(filePath) + strlen(HNSW_TEMPORARY_FILE_SUFFIX) + 1);
+	if (temporaryPath == NULL) {
+		return SP_HNSW_INDEX_ALLOC_FAIL;
+	}
+	sprintf(temporaryPath, "%s%s", filePath, HNSW_TEMPORARY_FILE_SUFFIX);
+	file = fopen(temporaryPath, "wb");
+	if (file == NULL) {
+		free(temporaryPath);
+		return SP_HNSW_INDEX_WRITE_ERROR;
+	}
+	// The header is rewritten once the checksum is known
+	n = (size_t) index->numOfFeatures;
+	memset(&header, 0, sizeof(header));
+	success = fwrite(&header, sizeof(header), 1, file) == 1
+			&& writeHNSWBlock(file, index->vectors, n * index->dimension * sizeof(double), &checksum)
+			&& writeHNSWBlock(file, index->imageIndices, n * sizeof(int), &checksum)
+			&& writeHNSWBlock(file, index->levels, n * sizeof(int), &checksum)
+			&& writeHNSWBlock(file, index->baseLinks, n * (index->maxM0 + 1) * sizeof(int), &checksum);
+	for (i = 0; i < index->numOfFeatures && success; i++) {
+		if (index->levels[i] > 0) {
+			success = writeHNSWBlock(file, index->upperLinks[i],
+					(size_t) index->levels[i] * (index->M + 1) * sizeof(int), &checksum);
+		}
+	}
+	memcpy(header.magic, HNSW_INDEX_MAGIC, sizeof(header.magic));
+	header.version = HNSW_INDEX_VERSION;
+	header.dimension = (uint32_t) index->dimension;
+	header.numOfFeatures = (uint32_t) index->numOfFeatures;
+	header.M = (uint32_t) index->M;
+	header.efConstruction = (uint32_t) index->efConstruction;
+	header.entryPoint = (int32_t) index->entryPoint;
+	header.maxLevel = (int32_t) index->maxLevel;
+	header.tag = (uint64_t) tag;
+	header.checksum = (uint64_t) checksum;
+	success = success
+			&& fseek(file, 0, SEEK_SET) == 0
+			&& fwrite(&header, sizeof(header), 1, file) == 1
+			&& fflush(file) == 0
+			&& fsync(fileno(file)) == 0;
+	success = (fclose(file) == 0) && success;
+	success = success && rename(temporaryPath, filePath) == 0;
+	if (!success) {
+		remove(temporaryPath);
+	}
+	free(temporaryPath);
+	return success ? SP_HNSW_INDEX_SUCCESS : SP_HNSW_INDEX_WRITE_ERROR;
+}
+
+SPHNSWIndex spHNSWIndexLoad(const char *filePath, int efSearch, unsigned long long *tag, SP_HNSW_INDEX_MSG *msg) {
+	FILE *file;
+	SPHNSWIndexHeader header;
+	SPHNSWIndex index;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (filePath == NULL || tag == NULL || efSearch <= 0) {
+		*msg = SP_HNSW_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	file = fopen(filePath, "rb");
+	if (file == NULL) {
+		*msg = (errno == ENOENT) ? SP_HNSW_INDEX_MISSING : SP_HNSW_INDEX_READ_ERROR;
+		return NULL;
+	}
+	if (fread(&header, sizeof(header), 1, file) != 1
+			|| memcmp(header.magic, HNSW_INDEX_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != HNSW_INDEX_VERSION || header.dimension == 0 || header.dimension > INT_MAX
+			|| header.numOfFeatures == 0 || header.numOfFeatures > INT_MAX || header.M < 2
+			|| header.M > INT_MAX / 2 - 1 || header.efConstruction == 0 || header.efConstruction > INT_MAX
+			|| header.maxLevel < 0 || header.maxLevel > MAX_FEATURE_LEVEL || header.entryPoint < 0
+			|| (uint32_t) header.entryPoint >= header.numOfFeatures) {
+		fclose(file);
+		*msg = SP_HNSW_INDEX_INVALID_FORMAT;
+		return NULL;
+	}
+	index = allocateHNSWIndex((int) header.dimension, (int) header.numOfFeatures, (int) header.M,
+			(int) header.efConstruction, efSearch);
+	if (index == NULL) {
+		fclose(file);
+		*msg = SP_HNSW_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	index->entryPoint = (int) header.entryPoint;
+	index->maxLevel = (int) header.maxLevel;
+	*msg = readHNSWGraph(index, file, (unsigned long long) header.checksum);
+	fclose(file);
+	if (*msg != SP_HNSW_INDEX_SUCCESS) {
+		spHNSWIndexDestroy(index);
+		return NULL;
+	}
+	*tag = (unsigned long long) header.tag;
+	return index;
+}
@@ -0,0 +1,212 @@
+/*
+ * SPHNSWIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPHNSWINDEX_H_
+#define SPHNSWINDEX_H_
+
+#include "SPPoint.h"
+#include "SPBPriorityQueue.h"
+
+/**
+ * Implementation of a hierarchical navigable small world (HNSW) graph index of features.
+ *
+ * Every feature is a node of the graph's bottom layer, and of each of the layers up to its level, which is drawn
+ * at random with exponentially decaying probability - so every layer has about 1 / M of the nodes of the layer
+ * below it. In every layer a node is linked to up to M of its near neighbors (up to 2 * M in the bottom layer),
+ * chosen so that the links point in different directions.
+ * A query walks greedily from the single node of the top layer down to the bottom layer, where it keeps the
+ * efSearch nearest nodes it has reached as candidates, so only a small part of the features is compared to it
+ * whatever their dimension is. The search is approximate - more candidates mean better recall.
+ *
+ * The features are inserted to the graph concurrently by a pool of threads, each node guarded by its own lock
+ * while its links are changed. The graph is read-only once created (or loaded), so it can be searched by many
+ * threads at once.
+ *
+ * The graph can be saved to a single binary file, in the machine's byte order:
+ * 		magic "SPHN", version, dimension, number of features, M, efConstruction, entry point, top level, tag and
+ * 		checksum																			- the header
+ * 		coordinates, image indices and levels of the features									- the features
+ * 		links of the bottom layer, then the links of the upper layers of every feature above it	- the graph
+ * The checksum is the 64-bit FNV-1a hash of everything after the header.
+ *
+ * The following functions are available:
+ *
+ * 		spHNSWIndexCreate				- Builds the graph of the given features.
+ * 		spHNSWIndexDestroy				- Deallocates the index.
+ * 		spHNSWIndexGetNumOfFeatures		- Returns the number of indexed features.
+ * 		spHNSWIndexGetDimension			- Returns the dimension of the indexed features.
+ * 		spHNSWIndexGetM					- Returns the number of links per node of the upper layers.
+ * 		spHNSWIndexGetEfConstruction	- Returns the number of candidates the graph was built with.
+ * 		spHNSWIndexGetEfSearch			- Returns the number of candidates kept while searching.
+ * 		spHNSWIndexGetNumOfLayers		- Returns the number of layers of the graph.
+ * 		spHNSWIndexGetNumOfLinks		- Returns the number of links of a feature in a layer.
+ * 		spHNSWIndexKNearestNeighbours	- Fills a queue with the nearest features to a query.
+ * 		spHNSWIndexSave					- Writes the index to a file.
+ * 		spHNSWIndexLoad					- Reads an index written by spHNSWIndexSave.
+ */
+
+/** Type for defining the HNSW index. */
+typedef struct sp_hnsw_index_t *SPHNSWIndex;
+
+/** Enumeration to inform result of HNSW index method calls. */
+typedef enum sp_hnsw_index_msg_t {
+	SP_HNSW_INDEX_INVALID_ARGUMENT,
+	SP_HNSW_INDEX_ALLOC_FAIL,
+	SP_HNSW_INDEX_MISSING,
+	SP_HNSW_INDEX_WRITE_ERROR,
+	SP_HNSW_INDEX_READ_ERROR,
+	SP_HNSW_INDEX_INVALID_FORMAT,
+	SP_HNSW_INDEX_SUCCESS
+} SP_HNSW_INDEX_MSG;
+
+/**
+ * Creates an HNSW index of the given features - draws the levels of the features, and inserts them to the graph
+ * with numOfThreads threads. The levels depend only on the order of the features, but the links depend on the
+ * order the threads insert them in, so the graph may differ between builds of more than one thread.
+ * The features are not kept by the index, so they can be destroyed once it is created.
+ *
+ * @param features The features to index, all of the same dimension. The index of each feature is the index of
+ * 		its image, which is the index of the neighbors found for it.
+ * @param numOfFeatures The number of features.
+ * @param M The number of links per node of the upper layers (twice as many in the bottom layer), larger than 1.
+ * @param efConstruction The number of candidates kept while searching for the neighbors of an inserted feature.
+ * @param efSearch The number of candidates kept while searching for the neighbors of a query.
+ * @param numOfThreads The number of threads inserting the features.
+ * @param msg Place-holder for the SP_HNSW_INDEX_MSG informing the result:
+ * 		SP_HNSW_INDEX_INVALID_ARGUMENT	- In case features or msg is NULL, M is smaller than 2, numOfFeatures,
+ * 										  efConstruction, efSearch or numOfThreads is non-positive, or the
+ * 										  features are not of the same dimension.
+ * 		SP_HNSW_INDEX_ALLOC_FAIL		- In case of allocation failure, or if the threads could not be started or given
+ * 										  the insertion jobs.
+ * 		SP_HNSW_INDEX_SUCCESS			- Otherwise.
+ *
+ * @return
+ * 	NULL in case of failure, the index otherwise.
+ */
+SPHNSWIndex spHNSWIndexCreate(const SPPoint *features, int numOfFeatures, int M, int efConstruction, int efSearch,
+		int numOfThreads, SP_HNSW_INDEX_MSG *msg);
+
+/**
+ * Deallocates the given index. If index is NULL nothing is done.
+ *
+ * @param index The index to deallocate.
+ */
+void spHNSWIndexDestroy(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of indexed features otherwise.
+ */
+int spHNSWIndexGetNumOfFeatures(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the dimension of the indexed features otherwise.
+ */
+int spHNSWIndexGetDimension(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the maximal number of links of a node in an upper layer otherwise.
+ */
+int spHNSWIndexGetM(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of candidates kept while the features were inserted otherwise.
+ */
+int spHNSWIndexGetEfConstruction(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of candidates kept while searching otherwise.
+ */
+int spHNSWIndexGetEfSearch(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of layers of the graph (including the bottom layer) otherwise.
+ */
+int spHNSWIndexGetNumOfLayers(SPHNSWIndex index);
+
+/**
+ * @param index The index.
+ * @param feature The position of the feature, in the order the features were given on creation.
+ * @param layer The layer, 0 being the bottom layer.
+ *
+ * @return
+ * 	-1 if index is NULL, the feature is out of range or it is not a node of the layer, the number of its links in
+ * 	the layer otherwise.
+ */
+int spHNSWIndexGetNumOfLinks(SPHNSWIndex index, int feature, int layer);
+
+/**
+ * Fills the given queue with the features nearest to the given point, out of the nodes reached by the search.
+ * The search keeps at least as many candidates as the queue can hold (and at least efSearch). Every element of
+ * the queue is the index of a feature's image, with the squared distance from the point as its value.
+ *
+ * @param index The index to search in.
+ * @param queue The priority queue to hold the nearest neighbors.
+ * @param point The feature to search for its nearest neighbors.
+ *
+ * @return
+ * 	SP_HNSW_INDEX_INVALID_ARGUMENT	- In case any argument is NULL or the point is not of the index's dimension.
+ * 	SP_HNSW_INDEX_ALLOC_FAIL		- In case of allocation failure.
+ * 	SP_HNSW_INDEX_SUCCESS			- Otherwise.
+ */
+SP_HNSW_INDEX_MSG spHNSWIndexKNearestNeighbours(SPHNSWIndex index, SPBPQueue queue, SPPoint point);
+
+/**
+ * Writes the given index to a file. The index is written to a temporary file which is renamed over the given one
+ * once it is complete, so the previous file (if any) is left as it was in case of failure.
+ *
+ * @param index The index to write.
+ * @param filePath The path of the file.
+ * @param tag A value written with the index and returned when it is loaded, such as a hash of the parameters
+ * 		of the features it was built of.
+ *
+ * @return
+ * 	SP_HNSW_INDEX_INVALID_ARGUMENT	- In case index or filePath is NULL.
+ * 	SP_HNSW_INDEX_ALLOC_FAIL		- In case of allocation failure.
+ * 	SP_HNSW_INDEX_WRITE_ERROR		- In case writing the file failed.
+ * 	SP_HNSW_INDEX_SUCCESS			- Otherwise.
+ */
+SP_HNSW_INDEX_MSG spHNSWIndexSave(SPHNSWIndex index, const char *filePath, unsigned long long tag);
+
+/**
+ * Reads an index written by spHNSWIndexSave, and validates its header, checksum and links.
+ *
+ * @param filePath The path of the file.
+ * @param efSearch The number of candidates kept while searching the loaded index.
+ * @param tag Place-holder for the tag the index was written with.
+ * @param msg Place-holder for the SP_HNSW_INDEX_MSG informing the result:
+ * 		SP_HNSW_INDEX_INVALID_ARGUMENT	- In case filePath or tag is NULL, or efSearch is non-positive.
+ * 		SP_HNSW_INDEX_MISSING			- In case the file does not exist.
+ * 		SP_HNSW_INDEX_ALLOC_FAIL		- In case of allocation failure.
+ * 		SP_HNSW_INDEX_READ_ERROR		- In case the file could not be opened.
+ * 		SP_HNSW_INDEX_INVALID_FORMAT	- In case the file is not an index of this version, is truncated, does not
+ * 										  match its checksum, or links a feature out of range.
+ * 		SP_HNSW_INDEX_SUCCESS			- Otherwise.
+ *
+ * @return
+ * 	NULL in case of failure, the index otherwise.
+ */
+SPHNSWIndex spHNSWIndexLoad(const char *filePath, int efSearch, unsigned long long *tag, SP_HNSW_INDEX_MSG *msg);
+
+#endif /* SPHNSWINDEX_H_ */
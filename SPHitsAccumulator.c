@@ -0,0 +1,269 @@
+/*
+ * SPHitsAccumulator.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include "SPHitsAccumulator.h"
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*** Constants ***/
+
+/** The initial capacity of the touched images list. */
+#define INITIAL_TOUCHED_CAPACITY 64
+
+/*** Inner implementation type declarations ***/
+
+/** Structure containing an image index and its hits - used for ranking. */
+typedef struct hit_info_t {
+	int index;
+	double hits;
+} HitInfo;
+
+/*** Type declarations ***/
+
+/** Structure containing the accumulator data. */
+struct sp_hits_accumulator_t {
+	int numOfImages;
+	double *hits;
+	int *touchedImages;
+	int touchedCount;
+	int touchedCapacity;
+	HitInfo *heap;
+	int heapCapacity;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Compares to HitInfos - to be used by qsort.
+ * First it compares by hits in descending order - meaning higher amount of hits will come before.
+ * If two HitInfos have same amount of hits, than the one with lower index will come before.
+ *
+ * @param a - First HitInfo pointer.
+ * @param b - Second HitInfo pointer.
+ *
+ * @return
+ * 	The compare result.
+ */
+int cmpHitInfos(const void * a, const void * b) {
+	HitInfo aInfo = *(HitInfo*)a;
+	HitInfo bInfo = *(HitInfo*)b;
+	if (aInfo.hits != bInfo.hits) {
+		return aInfo.hits > bInfo.hits ? -1 : 1;
+	}
+	return aInfo.index - bInfo.index;
+}
+
+/**
+ * Returns whether the first HitInfo should be ranked after the second one, with respect to cmpHitInfos.
+ *
+ * @param a - First HitInfo pointer.
+ * @param b - Second HitInfo pointer.
+ *
+ * @return
+ * 	true if a is ranked after b, false otherwise.
+ */
+bool isRankedAfter(const HitInfo *a, const HitInfo *b) {
+	return cmpHitInfos(a, b) > 0;
+}
+
+/**
+ * Restores the heap property of the given "worst on top" heap, starting from the given position downwards.
+ * The top of the heap is the HitInfo which is ranked last (according to cmpHitInfos).
+ *
+ * @param heap The heap array.
+ * @param heapSize The number of HitInfos in the heap.
+ * @param position The position to sift down from.
+ */
+void siftDownHitInfos(HitInfo *heap, int heapSize, int position) {
+	int child;
+	HitInfo tmp;
+	while ((child = 2 * position + 1) < heapSize) {
+		if (child + 1 < heapSize && isRankedAfter(&heap[child + 1], &heap[child])) {
+			child++;
+		}
+		if (!isRankedAfter(&heap[child], &heap[position])) {
+			return;
+		}
+		tmp = heap[position];
+		heap[position] = heap[child];
+		heap[child] = tmp;
+		position = child;
+	}
+}
+
+/**
+ * Restores the heap property of the given "worst on top" heap, starting from the given position upwards.
+ *
+ * @param heap The heap array.
+ * @param position The position to sift up from.
+ */
+void siftUpHitInfos(HitInfo *heap, int position) {
+	int parent;
+	HitInfo tmp;
+	while (position > 0) {
+		parent = (position - 1) / 2;
+		if (!isRankedAfter(&heap[position], &heap[parent])) {
+			return;
+		}
+		tmp = heap[position];
+		heap[position] = heap[parent];
+		heap[parent] = tmp;
+		position = parent;
+	}
+}
+
+/**
+ * Makes sure the reusable selection heap can hold the given amount of HitInfos.
+ *
+ * @param accumulator The accumulator whose heap to grow.
+ * @param capacity The required capacity.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool ensureHeapCapacity(SPHitsAccumulator accumulator, int capacity) {
+	HitInfo *heap;
+	if (accumulator->heapCapacity >= capacity) {
+		return true;
+	}
+	heap = (HitInfo *) realloc(accumulator->heap, capacity * sizeof(HitInfo));
+	if (heap == NULL) {
+		return false;
+	}
+	accumulator->heap = heap;
+	accumulator->heapCapacity = capacity;
+	return true;
+}
+
+/*** Public Methods ***/
+
+SPHitsAccumulator spHitsAccumulatorCreate(int numOfImages) {
+	SPHitsAccumulator accumulator;
+	if (numOfImages <= 0) {
+		return NULL;
+	}
+	accumulator = (SPHitsAccumulator) malloc(sizeof(*accumulator));
+	if (accumulator == NULL) {
+		return NULL;
+	}
+	accumulator->numOfImages = numOfImages;
+	accumulator->touchedCount = 0;
+	accumulator->touchedCapacity = numOfImages < INITIAL_TOUCHED_CAPACITY ? numOfImages : INITIAL_TOUCHED_CAPACITY;
+	accumulator->hits = (double *) calloc(numOfImages, sizeof(double));
+	accumulator->touchedImages = (int *) malloc(accumulator->touchedCapacity * sizeof(int));
+	accumulator->heap = NULL;
+	accumulator->heapCapacity = 0;
+	if (accumulator->hits == NULL || accumulator->touchedImages == NULL) {
+		spHitsAccumulatorDestroy(accumulator);
+		return NULL;
+	}
+	return accumulator;
+}
+
+void spHitsAccumulatorDestroy(SPHitsAccumulator accumulator) {
+	if (accumulator == NULL) {
+		return;
+	}
+	free(accumulator->hits);
+	free(accumulator->touchedImages);
+	free(accumulator->heap);
+	free(accumulator);
+}
+
+void spHitsAccumulatorClear(SPHitsAccumulator accumulator) {
+	int i;
+	if (accumulator == NULL) {
+		return;
+	}
+	for (i = 0; i < accumulator->touchedCount; i++) {
+		accumulator->hits[accumulator->touchedImages[i]] = 0;
+	}
+	accumulator->touchedCount = 0;
+}
+
+SP_HITS_ACCUMULATOR_MSG spHitsAccumulatorAdd(SPHitsAccumulator accumulator, int imageIndex, double hits) {
+	int newCapacity, *touchedImages;
+	if (accumulator == NULL || hits <= 0 || imageIndex < 0 || imageIndex >= accumulator->numOfImages) {
+		return SP_HITS_ACCUMULATOR_INVALID_ARGUMENT;
+	}
+	if (accumulator->hits[imageIndex] == 0) {
+		// First hit of the image since the last clear - it is now touched
+		if (accumulator->touchedCount == accumulator->touchedCapacity) {
+			newCapacity = 2 * accumulator->touchedCapacity;
+			if (newCapacity > accumulator->numOfImages) {
+				newCapacity = accumulator->numOfImages;
+			}
+			touchedImages = (int *) realloc(accumulator->touchedImages, newCapacity * sizeof(int));
+			if (touchedImages == NULL) {
+				return SP_HITS_ACCUMULATOR_OUT_OF_MEMORY;
+			}
+			accumulator->touchedImages = touchedImages;
+			accumulator->touchedCapacity = newCapacity;
+		}
+		accumulator->touchedImages[accumulator->touchedCount++] = imageIndex;
+	}
+	accumulator->hits[imageIndex] += hits;
+	return SP_HITS_ACCUMULATOR_SUCCESS;
+}
+
+double spHitsAccumulatorGetHits(SPHitsAccumulator accumulator, int imageIndex) {
+	if (accumulator == NULL || imageIndex < 0 || imageIndex >= accumulator->numOfImages) {
+		return -1;
+	}
+	return accumulator->hits[imageIndex];
+}
+
+int spHitsAccumulatorGetNumOfImages(SPHitsAccumulator accumulator) {
+	return accumulator == NULL ? -1 : accumulator->numOfImages;
+}
+
+int spHitsAccumulatorGetTouchedCount(SPHitsAccumulator accumulator) {
+	return accumulator == NULL ? -1 : accumulator->touchedCount;
+}
+
+int *spHitsAccumulatorTopImages(SPHitsAccumulator accumulator, int count, int *resultsCount) {
+	int i, imageIndex, heapSize = 0, *results;
+	HitInfo candidate, *heap;
+	if (accumulator == NULL || resultsCount == NULL || count <= 0) {
+		return NULL;
+	}
+	// There can not be more results than images
+	if (count > accumulator->numOfImages) {
+		count = accumulator->numOfImages;
+	}
+	results = (int *) malloc(count * sizeof(int));
+	if (results == NULL || !ensureHeapCapacity(accumulator, count)) {
+		free(results);
+		return NULL;
+	}
+	heap = accumulator->heap;
+	for (i = 0; i < accumulator->touchedCount; i++) {
+		imageIndex = accumulator->touchedImages[i];
+		candidate = (HitInfo) {imageIndex, accumulator->hits[imageIndex]};
+		if (heapSize < count) {
+			heap[heapSize] = candidate;
+			siftUpHitInfos(heap, heapSize);
+			heapSize++;
+		} else if (isRankedAfter(&heap[0], &candidate)) {
+			heap[0] = candidate;
+			siftDownHitInfos(heap, heapSize, 0);
+		}
+	}
+	qsort(heap, heapSize, sizeof(HitInfo), cmpHitInfos);
+	for (i = 0; i < heapSize; i++) {
+		results[i] = heap[i].index;
+	}
+	// Complete with images that had no hits, lower indices first.
+	// At most touchedCount + count images are visited here.
+	for (imageIndex = 0; i < count; imageIndex++) {
+		if (accumulator->hits[imageIndex] == 0) {
+			results[i++] = imageIndex;
+		}
+	}
+	*resultsCount = count;
+	return results;
+}
@@ -0,0 +1,137 @@
+/*
+ * SPHitsAccumulator.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPHITSACCUMULATOR_H_
+#define SPHITSACCUMULATOR_H_
+
+#include <stdbool.h>
+
+/**
+ * Implementation of an images hits accumulator - a data-structure used to count images 'hits',
+ * meaning the amount of times an image's feature was found in nearest neighbor search.
+ * Hits are weights, so a single vote may be worth less than a whole hit (e.g. when weighted by distance).
+ *
+ * The accumulator keeps a dense hits array (one entry per image) which is allocated once, together with the list
+ * of images that were touched since the last clear. Adding hits, clearing and selecting the top images only
+ * visit the touched images, so once created, the cost of a query depends on the number of votes and not on the
+ * number of images. An accumulator is meant to be created once per worker and reused across queries.
+ *
+ * Images are ranked by their hits in descending order, and images with the same amount of hits are
+ * ranked by their index in ascending order.
+ *
+ * The following functions are available:
+ *
+ * 		spHitsAccumulatorCreate				- Creates a new empty accumulator for the given number of images.
+ * 		spHitsAccumulatorDestroy			- Deallocates the given accumulator.
+ * 		spHitsAccumulatorClear				- Resets the hits of all of the touched images.
+ * 		spHitsAccumulatorAdd				- Adds hits to an image.
+ * 		spHitsAccumulatorGetHits			- Returns the hits of an image.
+ * 		spHitsAccumulatorGetNumOfImages		- Returns the number of images the accumulator was created for.
+ * 		spHitsAccumulatorGetTouchedCount	- Returns the number of images with hits.
+ * 		spHitsAccumulatorTopImages			- Returns the indices of the top ranked images.
+ */
+
+/** Type for defining the hits accumulator. */
+typedef struct sp_hits_accumulator_t *SPHitsAccumulator;
+
+/** Enumeration to inform result of accumulator method calls. */
+typedef enum sp_hits_accumulator_msg_t {
+	SP_HITS_ACCUMULATOR_INVALID_ARGUMENT,
+	SP_HITS_ACCUMULATOR_OUT_OF_MEMORY,
+	SP_HITS_ACCUMULATOR_SUCCESS
+} SP_HITS_ACCUMULATOR_MSG;
+
+/**
+ * Allocates a new empty hits accumulator for the given number of images.
+ *
+ * @param numOfImages The number of images, every added image index must be lower than it.
+ *
+ * @return
+ * 	NULL - If allocations failed or numOfImages is non-positive.
+ * 	A new accumulator in case of success.
+ */
+SPHitsAccumulator spHitsAccumulatorCreate(int numOfImages);
+
+/**
+ * Deallocates the given accumulator.
+ *
+ * @param accumulator The accumulator to deallocate. If NULL nothing is done.
+ */
+void spHitsAccumulatorDestroy(SPHitsAccumulator accumulator);
+
+/**
+ * Resets the hits of every touched image to zero, so the accumulator can be reused for another query.
+ * Only the touched images are visited.
+ *
+ * @param accumulator The accumulator to clear. If NULL nothing is done.
+ */
+void spHitsAccumulatorClear(SPHitsAccumulator accumulator);
+
+/**
+ * Adds the given amount of hits to the image with the given index.
+ *
+ * @param accumulator The accumulator to add the hits to.
+ * @param imageIndex The index of the image which was hit.
+ * @param hits The positive amount of hits to add (need not be whole).
+ *
+ * @return
+ * 	SP_HITS_ACCUMULATOR_INVALID_ARGUMENT	- If accumulator is NULL, hits is non-positive or the index is out of range.
+ * 	SP_HITS_ACCUMULATOR_OUT_OF_MEMORY		- If an allocation failure occurred.
+ * 	SP_HITS_ACCUMULATOR_SUCCESS				- Otherwise.
+ */
+SP_HITS_ACCUMULATOR_MSG spHitsAccumulatorAdd(SPHitsAccumulator accumulator, int imageIndex, double hits);
+
+/**
+ * Returns the hits of the image with the given index.
+ *
+ * @param accumulator The queried accumulator.
+ * @param imageIndex The index of the image.
+ *
+ * @return
+ * 	-1 if the accumulator is NULL or the index is out of range.
+ * 	Otherwise, returns the amount of hits accumulated for the image since the last clear.
+ */
+double spHitsAccumulatorGetHits(SPHitsAccumulator accumulator, int imageIndex);
+
+/**
+ * Returns the number of images the accumulator was created for.
+ *
+ * @param accumulator The queried accumulator.
+ *
+ * @return
+ * 	-1 if the accumulator is NULL, the number of images otherwise.
+ */
+int spHitsAccumulatorGetNumOfImages(SPHitsAccumulator accumulator);
+
+/**
+ * Returns the number of images which have hits since the last clear.
+ *
+ * @param accumulator The queried accumulator.
+ *
+ * @return
+ * 	-1 if the accumulator is NULL, the number of touched images otherwise.
+ */
+int spHitsAccumulatorGetTouchedCount(SPHitsAccumulator accumulator);
+
+/**
+ * Returns the indices of the top ranked images.
+ *
+ * The selection is done with a bounded heap over the touched images only. In case less than the requested amount
+ * of images were touched, the result is completed with the lowest indices of images with no hits, so the result is
+ * the same as ranking all of the images.
+ *
+ * @param accumulator The queried accumulator.
+ * @param count The requested number of images.
+ * @param resultsCount Place-holder for the number of returned indices - the minimum of count and the number of images.
+ *
+ * @return
+ * 	NULL if accumulator or resultsCount is NULL, count is non-positive or an allocation failure occurred.
+ * 	Otherwise, returns the top ranked images indices, ordered from the highest rank.
+ */
+int *spHitsAccumulatorTopImages(SPHitsAccumulator accumulator, int count, int *resultsCount);
+
+#endif /* SPHITSACCUMULATOR_H_ */
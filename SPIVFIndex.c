@@ -0,0 +1,434 @@
+/*
+ * SPIVFIndex.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include "SPIVFIndex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "SPListElement.h"
+#include "sp_algorithms.h"
+#include "sp_metrics.h"
+
+/*** Constants ***/
+
+/** The number of training samples per list center. */
+#define TRAINING_SAMPLES_PER_LIST 64
+
+/** The maximal number of k-means iterations of the list centers training. */
+#define COARSE_KMEANS_ITERATIONS 20
+
+/*** Type declarations ***/
+
+/**
+ * Structure containing the IVF index data.
+ * The features of list l are the features [listStarts[l], listStarts[l + 1]) of the lists order. If the index is
+ * not quantized, their coordinates are the rows of vectors and their images indices are in imageIndices (both in
+ * the lists order). Otherwise codes is a PQ index of the differences of all of the features from the centers of
+ * their lists (in the lists order, so a list is a range of it), and vectors and imageIndices are NULL.
+ */
+struct sp_ivf_index_t {
+	int dimension;
+	int numOfLists;
+	int numOfProbes;
+	int numOfFeatures;
+	double *centers;
+	int *listStarts;
+	double *vectors;
+	int *imageIndices;
+	SPPQIndex codes;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Copies the coordinates of the given features to a new matrix, a row per feature.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the matrix otherwise.
+ */
+double *featuresMatrix(const SPPoint *features, int numOfFeatures, int dimension) {
+	int i, j;
+	double *matrix = (double *) malloc((size_t) numOfFeatures * dimension * sizeof(double));
+	if (matrix == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < numOfFeatures; i++) {
+		for (j = 0; j < dimension; j++) {
+			matrix[(size_t) i * dimension + j] = spPointGetAxisCoor(features[i], j);
+		}
+	}
+	return matrix;
+}
+
+/**
+ * Trains the list centers with k-means, on a sample of the features spread evenly over them.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool trainListCenters(SPIVFIndex index, const double *matrix) {
+	int i, numOfSamples = index->numOfLists * TRAINING_SAMPLES_PER_LIST;
+	double *samples;
+	bool success;
+	if (numOfSamples >= index->numOfFeatures) {
+		return spKMeans(matrix, index->numOfFeatures, index->dimension, index->numOfLists,
+				COARSE_KMEANS_ITERATIONS, index->centers);
+	}
+	samples = (double *) malloc((size_t) numOfSamples * index->dimension * sizeof(double));
+	if (samples == NULL) {
+		return false;
+	}
+	for (i = 0; i < numOfSamples; i++) {
+		memcpy(samples + (size_t) i * index->dimension,
+				matrix + ((size_t) i * index->numOfFeatures / numOfSamples) * index->dimension,
+				index->dimension * sizeof(double));
+	}
+	success = spKMeans(samples, numOfSamples, index->dimension, index->numOfLists, COARSE_KMEANS_ITERATIONS,
+			index->centers);
+	free(samples);
+	return success;
+}
+
+/**
+ * Assigns every feature to the list of its nearest center, and sets the lists starts accordingly.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the positions of the features in the lists order otherwise.
+ */
+int *assignToLists(SPIVFIndex index, const double *matrix) {
+	int i, list, *lists, *positions;
+	lists = (int *) malloc(index->numOfFeatures * sizeof(int));
+	positions = (int *) malloc(index->numOfFeatures * sizeof(int));
+	if (lists == NULL || positions == NULL) {
+		free(lists);
+		free(positions);
+		return NULL;
+	}
+	memset(index->listStarts, 0, (index->numOfLists + 1) * sizeof(int));
+	for (i = 0; i < index->numOfFeatures; i++) {
+		lists[i] = spNearestCentroid(index->centers, index->numOfLists, index->dimension,
+				matrix + (size_t) i * index->dimension, NULL);
+		index->listStarts[lists[i] + 1]++;
+	}
+	for (list = 0; list < index->numOfLists; list++) {
+		index->listStarts[list + 1] += index->listStarts[list];
+	}
+	// The features keep their relative order within their lists
+	for (i = 0; i < index->numOfFeatures; i++) {
+		positions[i] = index->listStarts[lists[i]]++;
+	}
+	for (list = index->numOfLists; list > 0; list--) {
+		index->listStarts[list] = index->listStarts[list - 1];
+	}
+	index->listStarts[0] = 0;
+	free(lists);
+	return positions;
+}
+
+/**
+ * Fills the lists with the features as they are.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool fillLists(SPIVFIndex index, const SPPoint *features, const double *matrix, const int *positions) {
+	int i;
+	index->vectors = (double *) malloc((size_t) index->numOfFeatures * index->dimension * sizeof(double));
+	index->imageIndices = (int *) malloc(index->numOfFeatures * sizeof(int));
+	if (index->vectors == NULL || index->imageIndices == NULL) {
+		return false;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		memcpy(index->vectors + (size_t) positions[i] * index->dimension, matrix + (size_t) i * index->dimension,
+				index->dimension * sizeof(double));
+		index->imageIndices[positions[i]] = spPointGetIndex(features[i]);
+	}
+	return true;
+}
+
+/**
+ * Fills the lists with the features encoded by product quantization - the differences of the features from the
+ * centers of their lists are indexed by a single PQ index, whose codebooks are shared by all of the lists.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool fillQuantizedLists(SPIVFIndex index, const SPPoint *features, const double *matrix, const int *positions,
+		int numOfSubquantizers) {
+	int i, j, position, list;
+	SP_PQ_INDEX_MSG pqMsg;
+	const double *center;
+	double *residual = (double *) malloc(index->dimension * sizeof(double));
+	SPPoint *residuals = (SPPoint *) calloc(index->numOfFeatures, sizeof(SPPoint));
+	int *featureAt = (int *) malloc(index->numOfFeatures * sizeof(int));
+	bool success = (residual != NULL && residuals != NULL && featureAt != NULL);
+	for (i = 0; i < index->numOfFeatures && success; i++) {
+		featureAt[positions[i]] = i;
+	}
+	for (list = 0; list < index->numOfLists && success; list++) {
+		center = index->centers + (size_t) list * index->dimension;
+		for (position = index->listStarts[list]; position < index->listStarts[list + 1] && success; position++) {
+			i = featureAt[position];
+			for (j = 0; j < index->dimension; j++) {
+				residual[j] = matrix[(size_t) i * index->dimension + j] - center[j];
+			}
+			residuals[position] = spPointCreate(residual, index->dimension, spPointGetIndex(features[i]));
+			success = (residuals[position] != NULL);
+		}
+	}
+	if (success) {
+		index->codes = spPQIndexCreate(residuals, index->numOfFeatures, numOfSubquantizers, &pqMsg);
+		success = (index->codes != NULL);
+	}
+	for (i = 0; residuals != NULL && i < index->numOfFeatures; i++) {
+		spPointDestroy(residuals[i]);
+	}
+	free(residuals);
+	free(residual);
+	free(featureAt);
+	return success;
+}
+
+/**
+ * Fills the given probes queue with the lists whose centers are the nearest to the query.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool selectProbes(SPIVFIndex index, const double *query, SPBPQueue probes) {
+	int list, j;
+	const double *center = index->centers;
+	double difference, distance;
+	SPListElement element;
+	SP_BPQUEUE_MSG queueMsg;
+	for (list = 0; list < index->numOfLists; list++) {
+		distance = 0;
+		for (j = 0; j < index->dimension; j++, center++) {
+			difference = query[j] - *center;
+			distance += difference * difference;
+		}
+		element = spListElementCreate(list, distance);
+		if (element == NULL) {
+			return false;
+		}
+		queueMsg = spBPQueueEnqueue(probes, element);
+		spListElementDestroy(element);
+		if (queueMsg == SP_BPQUEUE_OUT_OF_MEMORY) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Adds the features of the given (not quantized) list which are nearer to the query than the queued ones to the
+ * queue. The distance to a feature stops being summed once it is known to be too far.
+ *
+ * @return
+ * 	The number of features of the list, or -1 in case of allocation failure.
+ */
+int scanList(SPIVFIndex index, int list, const double *query, SPBPQueue queue) {
+	int i, j, dimension = index->dimension;
+	const double *vector;
+	double difference, distance;
+	double maxQueueValue = spBPQueueIsFull(queue) ? spBPQueueMaxValue(queue) : INFINITY;
+	SPListElement element;
+	for (i = index->listStarts[list]; i < index->listStarts[list + 1]; i++) {
+		vector = index->vectors + (size_t) i * dimension;
+		distance = 0;
+		for (j = 0; j < dimension && distance < maxQueueValue; j++) {
+			difference = query[j] - vector[j];
+			distance += difference * difference;
+		}
+		if (distance >= maxQueueValue) {
+			continue;
+		}
+		element = spListElementCreate(index->imageIndices[i], distance);
+		if (element == NULL || spBPQueueEnqueue(queue, element) == SP_BPQUEUE_OUT_OF_MEMORY) {
+			spListElementDestroy(element);
+			return -1;
+		}
+		spListElementDestroy(element);
+		if (spBPQueueIsFull(queue)) {
+			maxQueueValue = spBPQueueMaxValue(queue);
+		}
+	}
+	return index->listStarts[list + 1] - index->listStarts[list];
+}
+
+/**
+ * Searches the codes of the given list for the difference of the query from the center of the list.
+ */
+SP_IVF_INDEX_MSG searchQuantizedList(SPIVFIndex index, int list, const double *query, double *residual,
+		SPBPQueue queue) {
+	int j;
+	SPPoint residualPoint;
+	SP_PQ_INDEX_MSG pqMsg;
+	if (index->listStarts[list] == index->listStarts[list + 1]) {
+		return SP_IVF_INDEX_SUCCESS;
+	}
+	for (j = 0; j < index->dimension; j++) {
+		residual[j] = query[j] - index->centers[(size_t) list * index->dimension + j];
+	}
+	residualPoint = spPointCreate(residual, index->dimension, 0);
+	if (residualPoint == NULL) {
+		return SP_IVF_INDEX_ALLOC_FAIL;
+	}
+	pqMsg = spPQIndexKNearestNeighboursInRange(index->codes, queue, residualPoint, index->listStarts[list],
+			index->listStarts[list + 1]);
+	spPointDestroy(residualPoint);
+	return (pqMsg == SP_PQ_INDEX_SUCCESS) ? SP_IVF_INDEX_SUCCESS : SP_IVF_INDEX_ALLOC_FAIL;
+}
+
+/*** Public Methods ***/
+
+SPIVFIndex spIVFIndexCreate(const SPPoint *features, int numOfFeatures, int numOfLists, int numOfProbes,
+		int numOfSubquantizers, SP_IVF_INDEX_MSG *msg) {
+	int i, dimension, *positions = NULL;
+	double *matrix = NULL;
+	SPIVFIndex index;
+	bool success;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (features == NULL || numOfFeatures <= 0 || numOfLists <= 0 || numOfProbes <= 0 || numOfSubquantizers < 0) {
+		*msg = SP_IVF_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	dimension = spPointGetDimension(features[0]);
+	for (i = 1; i < numOfFeatures; i++) {
+		if (spPointGetDimension(features[i]) != dimension) {
+			*msg = SP_IVF_INDEX_INVALID_ARGUMENT;
+			return NULL;
+		}
+	}
+	if (numOfSubquantizers > dimension) {
+		*msg = SP_IVF_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	index = (SPIVFIndex) calloc(1, sizeof(*index));
+	if (index == NULL) {
+		*msg = SP_IVF_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	index->dimension = dimension;
+	index->numOfFeatures = numOfFeatures;
+	index->numOfLists = (numOfLists < numOfFeatures) ? numOfLists : numOfFeatures;
+	index->numOfProbes = (numOfProbes < index->numOfLists) ? numOfProbes : index->numOfLists;
+	index->centers = (double *) malloc((size_t) index->numOfLists * dimension * sizeof(double));
+	index->listStarts = (int *) malloc((index->numOfLists + 1) * sizeof(int));
+	success = (index->centers != NULL && index->listStarts != NULL);
+	matrix = success ? featuresMatrix(features, numOfFeatures, dimension) : NULL;
+	success = success && matrix != NULL && trainListCenters(index, matrix);
+	positions = success ? assignToLists(index, matrix) : NULL;
+	success = success && positions != NULL;
+	if (success && numOfSubquantizers == 0) {
+		success = fillLists(index, features, matrix, positions);
+	} else if (success) {
+		success = fillQuantizedLists(index, features, matrix, positions, numOfSubquantizers);
+	}
+	free(matrix);
+	free(positions);
+	if (!success) {
+		spIVFIndexDestroy(index);
+		*msg = SP_IVF_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	*msg = SP_IVF_INDEX_SUCCESS;
+	return index;
+}
+
+void spIVFIndexDestroy(SPIVFIndex index) {
+	if (index == NULL) {
+		return;
+	}
+	spPQIndexDestroy(index->codes);
+	free(index->centers);
+	free(index->listStarts);
+	free(index->vectors);
+	free(index->imageIndices);
+	free(index);
+}
+
+int spIVFIndexGetNumOfFeatures(SPIVFIndex index) {
+	return (index == NULL) ? -1 : index->numOfFeatures;
+}
+
+int spIVFIndexGetDimension(SPIVFIndex index) {
+	return (index == NULL) ? -1 : index->dimension;
+}
+
+int spIVFIndexGetNumOfLists(SPIVFIndex index) {
+	return (index == NULL) ? -1 : index->numOfLists;
+}
+
+int spIVFIndexGetNumOfProbes(SPIVFIndex index) {
+	return (index == NULL) ? -1 : index->numOfProbes;
+}
+
+int spIVFIndexGetListSize(SPIVFIndex index, int list) {
+	if (index == NULL || list < 0 || list >= index->numOfLists) {
+		return -1;
+	}
+	return index->listStarts[list + 1] - index->listStarts[list];
+}
+
+bool spIVFIndexIsQuantized(SPIVFIndex index) {
+	return index != NULL && index->codes != NULL;
+}
+
+SP_IVF_INDEX_MSG spIVFIndexKNearestNeighbours(SPIVFIndex index, SPBPQueue queue, SPPoint point) {
+	int j, list, scanned, numOfScanned = 0;
+	double *query, *residual;
+	SPBPQueue probes;
+	SPListElement probe;
+	SP_IVF_INDEX_MSG msg = SP_IVF_INDEX_SUCCESS;
+	if (index == NULL || queue == NULL || point == NULL || spPointGetDimension(point) != index->dimension) {
+		return SP_IVF_INDEX_INVALID_ARGUMENT;
+	}
+	query = (double *) malloc(index->dimension * sizeof(double));
+	residual = (double *) malloc(index->dimension * sizeof(double));
+	probes = spBPQueueCreate(index->numOfProbes);
+	if (query == NULL || residual == NULL || probes == NULL) {
+		free(query);
+		free(residual);
+		spBPQueueDestroy(probes);
+		return SP_IVF_INDEX_ALLOC_FAIL;
+	}
+	// The lists are searched from the nearest one, so the farther ones are mostly cut off by the queued distances.
+	// The scans of quantized lists are timed by their PQ indices.
+	SP_METRICS_TIMER_START(traversalTimer);
+	for (j = 0; j < index->dimension; j++) {
+		query[j] = spPointGetAxisCoor(point, j);
+	}
+	if (!selectProbes(index, query, probes)) {
+		msg = SP_IVF_INDEX_ALLOC_FAIL;
+	}
+	while (msg == SP_IVF_INDEX_SUCCESS && !spBPQueueIsEmpty(probes)) {
+		probe = spBPQueuePeek(probes);
+		list = spListElementGetIndex(probe);
+		spListElementDestroy(probe);
+		spBPQueueDequeue(probes);
+		if (index->codes != NULL) {
+			msg = searchQuantizedList(index, list, query, residual, queue);
+			continue;
+		}
+		scanned = scanList(index, list, query, queue);
+		if (scanned < 0) {
+			msg = SP_IVF_INDEX_ALLOC_FAIL;
+		}
+		numOfScanned += scanned;
+	}
+	if (index->codes == NULL) {
+		SP_METRICS_TIMER_STOP(traversalTimer, SP_METRICS_TREE_TRAVERSAL);
+		SP_METRICS_COUNT(SP_METRICS_DISTANCE_COMPUTATIONS, numOfScanned + index->numOfLists);
+	}
+	free(query);
+	free(residual);
+	spBPQueueDestroy(probes);
+	return msg;
+}
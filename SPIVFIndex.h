@@ -0,0 +1,151 @@
+/*
+ * SPIVFIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPIVFINDEX_H_
+#define SPIVFINDEX_H_
+
+#include "SPPoint.h"
+#include "SPBPriorityQueue.h"
+#include "SPPQIndex.h"
+
+/**
+ * Implementation of an inverted file (IVF) index of features.
+ *
+ * The features are clustered by a coarse quantizer - list centers trained with k-means on a sample of the
+ * features - and every feature is kept in the inverted list of its nearest center. The lists are stored one after
+ * the other in a single array, so a list is a contiguous range of it.
+ * A query searches only the lists whose centers are the nearest to it (the probes), so the number of features it
+ * is compared to is about numOfProbes / numOfLists of all of the features, whatever their dimension is.
+ *
+ * The features of the lists are either kept as they are (and their distances to a query are exact), or encoded by
+ * product quantization (see SPPQIndex) relative to the centers of their lists, which takes numOfSubquantizers
+ * bytes per feature. The codebooks are shared by all of the lists, as the differences from the centers of all of
+ * the lists are alike.
+ *
+ * The index is read-only once created, so it can be searched by many threads at once.
+ *
+ * The following functions are available:
+ *
+ * 		spIVFIndexCreate					- Trains the list centers and fills the lists with the given features.
+ * 		spIVFIndexDestroy					- Deallocates the index.
+ * 		spIVFIndexGetNumOfFeatures			- Returns the number of indexed features.
+ * 		spIVFIndexGetDimension				- Returns the dimension of the indexed features.
+ * 		spIVFIndexGetNumOfLists				- Returns the number of inverted lists.
+ * 		spIVFIndexGetNumOfProbes			- Returns the number of lists searched per query.
+ * 		spIVFIndexGetListSize				- Returns the number of features in a list.
+ * 		spIVFIndexIsQuantized				- Returns whether the features are encoded by product quantization.
+ * 		spIVFIndexKNearestNeighbours		- Fills a queue with the nearest features to a query.
+ */
+
+/** Type for defining the IVF index. */
+typedef struct sp_ivf_index_t *SPIVFIndex;
+
+/** Enumeration to inform result of IVF index method calls. */
+typedef enum sp_ivf_index_msg_t {
+	SP_IVF_INDEX_INVALID_ARGUMENT,
+	SP_IVF_INDEX_ALLOC_FAIL,
+	SP_IVF_INDEX_SUCCESS
+} SP_IVF_INDEX_MSG;
+
+/**
+ * Creates an IVF index of the given features - trains the list centers on a sample of the features, and adds
+ * every feature to the list of its nearest center. The features are not kept by the index, so they can be
+ * destroyed once it is created.
+ *
+ * @param features The features to index, all of the same dimension. The index of each feature is the index of
+ * 		its image, which is the index of the neighbors found for it.
+ * @param numOfFeatures The number of features.
+ * @param numOfLists The number of inverted lists. At most numOfFeatures lists are created.
+ * @param numOfProbes The number of lists searched per query. At most numOfLists lists are searched.
+ * @param numOfSubquantizers The number of product quantization sub-quantizers the features of the lists are
+ * 		encoded with (at most the dimension of the features), or 0 in order to keep the features as they are.
+ * @param msg Place-holder for the SP_IVF_INDEX_MSG informing the result:
+ * 		SP_IVF_INDEX_INVALID_ARGUMENT	- In case features or msg is NULL, numOfFeatures, numOfLists or numOfProbes
+ * 										  is non-positive, the features are not of the same dimension, or the
+ * 										  number of sub-quantizers is negative or larger than the dimension.
+ * 		SP_IVF_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 		SP_IVF_INDEX_SUCCESS			- Otherwise.
+ *
+ * @return
+ * 	NULL in case of failure, the index otherwise.
+ */
+SPIVFIndex spIVFIndexCreate(const SPPoint *features, int numOfFeatures, int numOfLists, int numOfProbes,
+		int numOfSubquantizers, SP_IVF_INDEX_MSG *msg);
+
+/**
+ * Deallocates the given index. If index is NULL nothing is done.
+ *
+ * @param index The index to deallocate.
+ */
+void spIVFIndexDestroy(SPIVFIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of indexed features otherwise.
+ */
+int spIVFIndexGetNumOfFeatures(SPIVFIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the dimension of the indexed features otherwise.
+ */
+int spIVFIndexGetDimension(SPIVFIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of inverted lists otherwise.
+ */
+int spIVFIndexGetNumOfLists(SPIVFIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of lists searched per query otherwise.
+ */
+int spIVFIndexGetNumOfProbes(SPIVFIndex index);
+
+/**
+ * @param index The index.
+ * @param list The index of the list.
+ *
+ * @return
+ * 	-1 if index is NULL or list is not the index of one of its lists, the number of features in the list otherwise.
+ */
+int spIVFIndexGetListSize(SPIVFIndex index, int list);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	true if the features of the lists are encoded by product quantization, false otherwise (or if index is NULL).
+ */
+bool spIVFIndexIsQuantized(SPIVFIndex index);
+
+/**
+ * Fills the given queue with the features nearest to the given point, out of the features of the numOfProbes
+ * lists whose centers are the nearest to it. Every element of the queue is the index of a feature's image, with
+ * the squared distance from the point (approximated, if the features are quantized) as its value.
+ *
+ * @param index The index to search in.
+ * @param queue The priority queue to hold the nearest neighbors.
+ * @param point The feature to search for its nearest neighbors.
+ *
+ * @return
+ * 	SP_IVF_INDEX_INVALID_ARGUMENT	- In case any argument is NULL or the point is not of the index's dimension.
+ * 	SP_IVF_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 	SP_IVF_INDEX_SUCCESS			- Otherwise.
+ */
+SP_IVF_INDEX_MSG spIVFIndexKNearestNeighbours(SPIVFIndex index, SPBPQueue queue, SPPoint point);
+
+#endif /* SPIVFINDEX_H_ */
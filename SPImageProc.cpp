@@ -7,9 +7,17 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
 #include <cstdio>
+#include <random>
+#include <map>
+#include <mutex>
+#include <string>
+#include <fstream>
 #include "SPImageProc.h"
 extern "C" {
 #include "SPLogger.h"
+#include "sp_metrics.h"
+#include "sp_pca_file.h"
+#include "sp_util.h"
 }
 
 using namespace cv;
@@ -18,15 +26,26 @@ using namespace std;
 #define PCA_MEAN_STR "mean"
 #define PCA_EIGEN_VEC_STR "e_vectors"
 #define PCA_EIGEN_VAL_STR "e_values"
+#define PCA_BINARY_SUFFIX ".bin"
+#define SIFT_DESCRIPTOR_DIM 128
+#define PCA_SAMPLING_SEED 2026
+#define PCA_MIN_SAMPLES_PER_IMAGE 8
 #define STRING_LENGTH 1024
-#define WARNING_MSG_LENGTH 2048
 
 #define GENERAL_ERROR_MSG "An error occurred"
 #define PCA_DIM_ERROR_MSG "PCA dimension couldn't be resolved"
 #define PCA_FILE_NOT_EXIST "PCA file doesn't exist"
 #define PCA_FILE_NOT_RESOLVED "PCA filename couldn't be resolved"
+#define PCA_BINARY_WRITE_WARNING "Binary PCA file couldn't be written, workers will parse the YAML PCA file"
+#define PCA_BINARY_LOAD_WARNING "Binary PCA file couldn't be loaded, falling back to the YAML PCA file"
+#define PCA_BINARY_STALE_INFO "Binary PCA file doesn't match the YAML PCA file, it will be rebuilt"
 #define NUM_OF_IMAGES_ERROR "Number of images couldn't be resolved"
 #define NUM_OF_FEATS_ERROR "Number of features couldn't be resolved"
+#define MAX_IMAGE_SIDE_ERROR "Maximal image side couldn't be resolved"
+#define PCA_TRAINING_IMAGES_ERROR "Number of PCA training images couldn't be resolved"
+#define PCA_TRAINING_SAMPLES_ERROR "Number of PCA training samples couldn't be resolved"
+#define PCA_NO_FEATURES_ERROR "No features were extracted for the PCA"
+#define DESCRIPTORS_CACHE_WARNING "Descriptors couldn't be cached, the image will be decoded again"
 #define MINIMAL_GUI_ERROR "Minimal GUI mode couldn't be resolved"
 #define IMAGE_PATH_ERROR "Image path couldn't be resolved"
 #define IMAGE_NOT_EXIST_MSG ": Images doesn't exist"
@@ -34,81 +53,278 @@ using namespace std;
 #define ALLOC_ERROR_MSG "Allocation error"
 #define INVALID_ARG_ERROR "Invalid arguments"
 
+/**
+ * The raw SIFT descriptors of the images decoded while training the PCA, spilled to a temporary binary file and
+ * indexed by the image index. The features extraction projects them instead of decoding and running SIFT on the
+ * same images again. Every cached image is removed once it is read, and the file is deleted with the cache.
+ */
+class sp::DescriptorsCache {
+private:
+	struct Entry {
+		string imagePath;
+		long offset;
+		int rows;
+	};
+	FILE* file;
+	map<int, Entry> entries;
+	mutex entriesMutex;
+public:
+	DescriptorsCache() : file(tmpfile()) {
+	}
+
+	~DescriptorsCache() {
+		if (file) {
+			fclose(file);
+		}
+	}
+
+	bool put(int index, const char* imagePath, const Mat& descriptors) {
+		Mat continuous = descriptors.isContinuous() ? descriptors : descriptors.clone();
+		lock_guard<mutex> lock(entriesMutex);
+		if (!file || (descriptors.rows > 0 && (descriptors.type() != CV_32F || descriptors.cols != SIFT_DESCRIPTOR_DIM))
+				|| fseek(file, 0, SEEK_END) != 0) {
+			return false;
+		}
+		Entry entry = { imagePath, ftell(file), descriptors.rows };
+		size_t size = (size_t) descriptors.rows * SIFT_DESCRIPTOR_DIM;
+		if (entry.offset < 0 || (size > 0 && fwrite(continuous.ptr<float>(0), sizeof(float), size, file) != size)) {
+			return false;
+		}
+		entries[index] = entry;
+		return true;
+	}
+
+	/**
+	 * Reads the cached descriptors of the given image. The image path is matched as well, so query images (which
+	 * may share an index with a catalog image) are never served from the cache.
+	 */
+	bool take(int index, const char* imagePath, Mat& descriptors) {
+		lock_guard<mutex> lock(entriesMutex);
+		map<int, Entry>::iterator entry = entries.find(index);
+		if (entry == entries.end() || entry->second.imagePath != imagePath) {
+			return false;
+		}
+		descriptors.create(entry->second.rows, SIFT_DESCRIPTOR_DIM, CV_32F);
+		size_t size = (size_t) entry->second.rows * SIFT_DESCRIPTOR_DIM;
+		bool success = fseek(file, entry->second.offset, SEEK_SET) == 0
+				&& (size == 0 || fread(descriptors.ptr<float>(0), sizeof(float), size, file) == size);
+		entries.erase(entry);
+		if (entries.empty()) {
+			// Release the disk space as soon as the extraction consumed all of the images
+			fclose(file);
+			file = NULL;
+		}
+		return success;
+	}
+};
+
 void sp::ImageProc::initFromConfig(const SPConfig config) {
 	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
 	pcaDim = spConfigGetPCADim(config, &msg);
 	if (msg != SP_CONFIG_SUCCESS) {
-		spLoggerPrintError(PCA_DIM_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(PCA_DIM_ERROR_MSG);
 		throw Exception();
 	}
 	numOfImages = spConfigGetNumOfImages(config, &msg);
 	if (msg != SP_CONFIG_SUCCESS) {
-		spLoggerPrintError(NUM_OF_IMAGES_ERROR, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(NUM_OF_IMAGES_ERROR);
 		throw Exception();
 	}
 	numOfFeatures = spConfigGetNumOfFeatures(config, &msg);
 	if (msg != SP_CONFIG_SUCCESS) {
-		spLoggerPrintError(NUM_OF_FEATS_ERROR, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(NUM_OF_FEATS_ERROR);
+		throw Exception();
+	}
+	maxImageSide = spConfigGetMaxImageSide(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS) {
+		SP_LOG_ERROR(MAX_IMAGE_SIDE_ERROR);
+		throw Exception();
+	}
+	pcaTrainingImages = spConfigGetPCATrainingImages(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS) {
+		SP_LOG_ERROR(PCA_TRAINING_IMAGES_ERROR);
+		throw Exception();
+	}
+	pcaTrainingSamples = spConfigGetPCATrainingSamples(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS) {
+		SP_LOG_ERROR(PCA_TRAINING_SAMPLES_ERROR);
 		throw Exception();
 	}
 	minimalGui = spConfigMinimalGui(config, &msg);
 	if (msg != SP_CONFIG_SUCCESS) {
-		spLoggerPrintError(MINIMAL_GUI_ERROR, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(MINIMAL_GUI_ERROR);
 		throw Exception();
 	}
 }
 
-void sp::ImageProc::getImagesMat(vector<Mat>& images, const SPConfig config) {
-	char warningMSG[WARNING_MSG_LENGTH] = { '\0' };
-	for (int i = 0; i < numOfImages; i++) {
-		char imagePath[STRING_LENGTH + 1] = { '\0' };
-		if (spConfigGetImagePath(imagePath, config, i) != SP_CONFIG_SUCCESS) {
-			spLoggerPrintError(IMAGE_PATH_ERROR, __FILE__, __func__, __LINE__);
-			throw Exception();
-		}
-		Mat img = imread(imagePath, IMREAD_GRAYSCALE);
-		if (img.empty()) {
-			sprintf(warningMSG, "%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
-			spLoggerPrintWarning(warningMSG, __FILE__, __func__, __LINE__);
-			continue;
+bool sp::ImageProc::getImageDescriptors(const char* imagePath, Mat& descriptors) {
+	vector<KeyPoint> keypoints;
+	Mat img, scaledImg;
+	Ptr<xfeatures2d::SiftDescriptorExtractor> detector;
+	// The decoding time includes the scaling down
+	SP_METRICS_TIMER_START(decodeTimer);
+	img = imread(imagePath, IMREAD_GRAYSCALE);
+	if (img.empty()) {
+		return false;
+	}
+	if (maxImageSide > 0 && max(img.rows, img.cols) > maxImageSide) {
+		// SIFT on a multi-megapixel image is much slower than on a scaled one, and the strongest features survive
+		double scale = (double) maxImageSide / max(img.rows, img.cols);
+		resize(img, scaledImg, Size(), scale, scale, INTER_AREA);
+		img = scaledImg;
+	}
+	SP_METRICS_TIMER_STOP(decodeTimer, SP_METRICS_IMAGE_DECODE);
+	SP_METRICS_TIMER_START(siftTimer);
+	detector = xfeatures2d::SIFT::create(numOfFeatures);
+	detector->detect(img, keypoints);
+	detector->compute(img, keypoints, descriptors);
+	SP_METRICS_TIMER_STOP(siftTimer, SP_METRICS_SIFT);
+	return true;
+}
+
+/**
+ * Returns a random index in [0, bound). std::mt19937 is fully specified by the standard (unlike the standard
+ * distributions), so the sampling is reproducible across platforms.
+ */
+static int randomIndex(mt19937& generator, int bound) {
+	return (int) (generator() % (unsigned int) bound);
+}
+
+void sp::ImageProc::getTrainingImages(vector<int>& trainingImages, mt19937& generator) {
+	int numOfTrainingImages = pcaTrainingImages > 0 && pcaTrainingImages < numOfImages ?
+			pcaTrainingImages : numOfImages;
+	for (int i = 0; i < numOfTrainingImages; i++) {
+		// Spread the training images evenly over all of the images
+		trainingImages.push_back((int) ((long long) i * numOfImages / numOfTrainingImages));
+	}
+	if (pcaTrainingSamples > 0) {
+		// Visit the images in a random order, so that the sampled images are random
+		for (int i = numOfTrainingImages - 1; i > 0; i--) {
+			swap(trainingImages[i], trainingImages[randomIndex(generator, i + 1)]);
 		}
-		images.push_back(img);
 	}
 }
 
-void sp::ImageProc::getFeatures(vector<Mat>& images, Mat& features) {
-	//To store the keypoints that will be extracted by SIFT
-	vector<KeyPoint> keypoints;
-	//To store the SIFT descriptor of current image
-	Mat descriptor;
-	//To store all the descriptors that are extracted from all the images.
+void sp::ImageProc::sampleDescriptors(const Mat& descriptors, int numOfSamples, mt19937& generator,
+		Mat& samples) {
+	vector<int> rows(descriptors.rows);
+	samples.release();
+	for (int i = 0; i < descriptors.rows; i++) {
+		rows[i] = i;
+	}
+	// A partial Fisher-Yates shuffle, the first numOfSamples rows are the sample
+	for (int i = 0; i < numOfSamples && i < descriptors.rows; i++) {
+		swap(rows[i], rows[i + randomIndex(generator, descriptors.rows - i)]);
+		samples.push_back(descriptors.row(rows[i]));
+	}
+}
 
-	//The SIFT feature extractor and descriptor
-	Ptr<xfeatures2d::SiftDescriptorExtractor> detector =
-			xfeatures2d::SIFT::create(numOfFeatures);
+void sp::ImageProc::accumulateDescriptors(const Mat& descriptors, Mat& sum, Mat& outerProductsSum) {
+	Mat descriptors64, rowsSum, outerProducts;
+	descriptors.convertTo(descriptors64, CV_64F);
+	reduce(descriptors64, rowsSum, 0, REDUCE_SUM, CV_64F);
+	add(sum, rowsSum, sum);
+	// The sum of the outer products of the rows is descriptors^T * descriptors
+	gemm(descriptors64, descriptors64, 1, noArray(), 0, outerProducts, GEMM_1_T);
+	add(outerProductsSum, outerProducts, outerProductsSum);
+}
+
+void sp::ImageProc::initProjection() {
+	Mat mean64, eigenvectors64, projectedMeanMat;
+	pca.eigenvectors.rowRange(0, pcaDim).convertTo(eigenvectors64, CV_64F);
+	transpose(eigenvectors64, projection); //E^T, a row of pcaDim weights per descriptor coordinate
+	pca.mean.convertTo(mean64, CV_64F);
+	// (x - mean) * E^T = x * E^T - mean * E^T, so the mean is folded in as a bias of the projection
+	gemm(mean64, projection, 1, noArray(), 0, projectedMeanMat);
+	projectedMean.resize(pcaDim);
+	for (int j = 0; j < pcaDim; j++) {
+		projectedMean[j] = projectedMeanMat.at<double>(0, j);
+	}
+}
 
-	//feature descriptors and build the vocabulary
-	for (int i = 0; i < static_cast<int>(images.size()); i++) {
-		//detect feature points
-		detector->detect(images[i], keypoints);
-		//compute the descriptors for each keypoint
-		detector->compute(images[i], keypoints, descriptor);
-		//put the all feature descriptors in a single Mat object
-		features.push_back(descriptor);
+void sp::ImageProc::projectDescriptors(const Mat& descriptors, double* coordinates, size_t stride) {
+	assert(descriptors.type() == CV_32F && descriptors.cols == projection.rows);
+	const double* weights = projection.ptr<double>(0);
+	for (int i = 0; i < descriptors.rows; i++) {
+		const float* descriptor = descriptors.ptr<float>(i);
+		double* row = (double*) ((char*) coordinates + i * stride);
+		for (int j = 0; j < pcaDim; j++) { //The bias
+			row[j] = -projectedMean[j];
+		}
+		// Accumulates a row of E^T per descriptor coordinate, so the inner loop runs over contiguous memory
+		for (int k = 0; k < descriptors.cols; k++) {
+			const double value = descriptor[k];
+			const double* coordinateWeights = weights + (size_t) k * pcaDim;
+			for (int j = 0; j < pcaDim; j++) {
+				row[j] += value * coordinateWeights[j];
+			}
+		}
 	}
 }
 
+void sp::ImageProc::trainPCA(const Mat& sum, const Mat& outerProductsSum, long long numOfDescriptors) {
+	Mat mean64, covariance, eigenvalues, eigenvectors;
+	sum.convertTo(mean64, CV_64F, 1.0 / numOfDescriptors);
+	// covariance = outerProductsSum / n - mean^T * mean
+	gemm(mean64, mean64, -1, outerProductsSum, 1.0 / numOfDescriptors, covariance, GEMM_1_T);
+	// The eigenvalues are sorted in descending order, the eigenvectors are the matching rows
+	eigen(covariance, eigenvalues, eigenvectors);
+	mean64.convertTo(pca.mean, CV_32F);
+	eigenvectors.rowRange(0, pcaDim).convertTo(pca.eigenvectors, CV_32F);
+	eigenvalues.rowRange(0, pcaDim).convertTo(pca.eigenvalues, CV_32F);
+}
+
 void sp::ImageProc::preprocess(const SPConfig config) {
 	try {
-		vector<Mat> images;
-		Mat features;
 		char pcaPath[STRING_LENGTH + 1] = { '\0' };
-		getImagesMat(images, config);
-		getFeatures(images, features);
-		pca = PCA(features, Mat(), CV_PCA_DATA_AS_ROW, pcaDim);
+		Mat descriptors, samples;
+		vector<int> trainingImages;
+		mt19937 generator(PCA_SAMPLING_SEED);
+		// Only the mean and covariance sums are kept, so the memory does not depend on the number of images
+		Mat sum = Mat::zeros(1, SIFT_DESCRIPTOR_DIM, CV_64F);
+		Mat outerProductsSum = Mat::zeros(SIFT_DESCRIPTOR_DIM, SIFT_DESCRIPTOR_DIM, CV_64F);
+		long long numOfDescriptors = 0;
+		int samplesPerImage = 0;
+		getTrainingImages(trainingImages, generator);
+		if (pcaTrainingSamples > 0 && !trainingImages.empty()) {
+			// Spread the samples over as many images as possible, but do not decode an image for a few samples
+			samplesPerImage = (int) ((pcaTrainingSamples + trainingImages.size() - 1) / trainingImages.size());
+			samplesPerImage = max(samplesPerImage, PCA_MIN_SAMPLES_PER_IMAGE);
+		}
+		for (int i = 0; i < (int) trainingImages.size(); i++) {
+			char imagePath[STRING_LENGTH + 1] = { '\0' };
+			if (pcaTrainingSamples > 0 && numOfDescriptors >= pcaTrainingSamples) {
+				break;
+			}
+			if (spConfigGetImagePath(imagePath, config, trainingImages[i]) != SP_CONFIG_SUCCESS) {
+				SP_LOG_ERROR(IMAGE_PATH_ERROR);
+				throw Exception();
+			}
+			if (!getImageDescriptors(imagePath, descriptors)) {
+				SP_LOG_WARNING("%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
+				continue;
+			}
+			if (!descriptorsCache->put(trainingImages[i], imagePath, descriptors)) {
+				SP_LOG_WARNING(DESCRIPTORS_CACHE_WARNING);
+			}
+			if (descriptors.empty()) {
+				continue;
+			}
+			if (pcaTrainingSamples > 0) {
+				sampleDescriptors(descriptors, min(samplesPerImage, (int) (pcaTrainingSamples - numOfDescriptors)),
+						generator, samples);
+			}
+			const Mat& trainingDescriptors = pcaTrainingSamples > 0 ? samples : descriptors;
+			accumulateDescriptors(trainingDescriptors, sum, outerProductsSum);
+			numOfDescriptors += trainingDescriptors.rows;
+		}
+		if (numOfDescriptors == 0) {
+			SP_LOG_ERROR(PCA_NO_FEATURES_ERROR);
+			throw Exception();
+		}
+		trainPCA(sum, outerProductsSum, numOfDescriptors);
 		if (spConfigGetPCAPath(pcaPath, config) != SP_CONFIG_SUCCESS) {
-			spLoggerPrintError(PCA_FILE_NOT_RESOLVED, __FILE__, __func__,
-			__LINE__);
+			SP_LOG_ERROR(PCA_FILE_NOT_RESOLVED);
 			throw Exception();
 		}
 		FileStorage fs(pcaPath, FileStorage::WRITE);
@@ -116,93 +332,151 @@ void sp::ImageProc::preprocess(const SPConfig config) {
 		fs << PCA_EIGEN_VAL_STR << pca.eigenvalues;
 		fs << PCA_MEAN_STR << pca.mean;
 		fs.release();
+		unsigned long long yamlHash = SP_UTIL_FNV1A_INITIAL_HASH;
+		if (spUtilFNV1aHashFile(pcaPath, &yamlHash)) {
+			writePCABinaryFile(pcaPath, yamlHash);
+		} else {
+			SP_LOG_WARNING(PCA_BINARY_WRITE_WARNING);
+		}
 	} catch (...) {
-		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(GENERAL_ERROR_MSG);
 		throw Exception();
 	}
 }
 
+void sp::ImageProc::writePCABinaryFile(const char* pcaPath, unsigned long long yamlHash) {
+	string binaryPath = string(pcaPath) + PCA_BINARY_SUFFIX;
+	// The matrices were converted by trainPCA or read from the YAML file, so they are continuous floats
+	if (spPCAFileWrite(binaryPath.c_str(), pca.mean.cols, pca.eigenvectors.rows, pca.mean.ptr<float>(0),
+			pca.eigenvectors.ptr<float>(0), pca.eigenvalues.ptr<float>(0), yamlHash) != SP_PCA_FILE_SUCCESS) {
+		SP_LOG_WARNING(PCA_BINARY_WRITE_WARNING);
+	}
+}
+
+bool sp::ImageProc::initPCAFromBinaryFile(const char* pcaPath, unsigned long long yamlHash) {
+	string binaryPath = string(pcaPath) + PCA_BINARY_SUFFIX;
+	SP_PCA_FILE_MSG msg;
+	SPPCAFile pcaFile = spPCAFileLoad(binaryPath.c_str(), yamlHash, &msg);
+	if (!pcaFile) {
+		if (msg == SP_PCA_FILE_SOURCE_MISMATCH) {
+			SP_LOG_INFO(PCA_BINARY_STALE_INFO);
+		} else if (msg != SP_PCA_FILE_MISSING) {
+			SP_LOG_WARNING(PCA_BINARY_LOAD_WARNING);
+		}
+		return false;
+	}
+	int dimension = spPCAFileGetDimension(pcaFile);
+	int numOfComponents = spPCAFileGetNumOfComponents(pcaFile);
+	if (dimension != SIFT_DESCRIPTOR_DIM || numOfComponents < pcaDim) {
+		spPCAFileDestroy(pcaFile);
+		SP_LOG_WARNING(PCA_BINARY_LOAD_WARNING);
+		return false;
+	}
+	// The matrices are headers over the read-only mapping, which lives as long as this object (or its copies)
+	pcaMapping = shared_ptr<sp_pca_file_t>(pcaFile, spPCAFileDestroy);
+	pca.mean = Mat(1, dimension, CV_32F, (void*) spPCAFileGetMean(pcaFile));
+	pca.eigenvectors = Mat(numOfComponents, dimension, CV_32F, (void*) spPCAFileGetEigenvectors(pcaFile));
+	pca.eigenvalues = Mat(numOfComponents, 1, CV_32F, (void*) spPCAFileGetEigenvalues(pcaFile));
+	return true;
+}
+
+bool sp::ImageProc::pcaFileExists(const SPConfig config) {
+	char pcaFilename[STRING_LENGTH + 1] = { '\0' };
+	if (spConfigGetPCAPath(pcaFilename, config) != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	return ifstream(pcaFilename).good();
+}
+
 void sp::ImageProc::initPCAFromFile(const SPConfig config) {
 	if (!config) {
-		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(GENERAL_ERROR_MSG);
 		throw Exception();
 	}
 	char pcaFilename[STRING_LENGTH + 1] = { '\0' };
 	if (spConfigGetPCAPath(pcaFilename, config) != SP_CONFIG_SUCCESS) {
-		spLoggerPrintError(PCA_FILE_NOT_RESOLVED, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(PCA_FILE_NOT_RESOLVED);
 		throw Exception();
 	}
+	// The binary file is used only if it was written from the YAML file as it is now
+	unsigned long long yamlHash = SP_UTIL_FNV1A_INITIAL_HASH;
+	bool yamlHashed = spUtilFNV1aHashFile(pcaFilename, &yamlHash);
+	if (yamlHashed && initPCAFromBinaryFile(pcaFilename, yamlHash)) {
+		return;
+	}
 	FileStorage fs(pcaFilename, FileStorage::READ);
 	if (!fs.isOpened()) {
-		spLoggerPrintError(PCA_FILE_NOT_EXIST, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(PCA_FILE_NOT_EXIST);
 		throw Exception();
 	}
 	fs[PCA_EIGEN_VEC_STR] >> pca.eigenvectors;
 	fs[PCA_EIGEN_VAL_STR] >> pca.eigenvalues;
 	fs[PCA_MEAN_STR] >> pca.mean;
 	fs.release();
+	if (yamlHashed) { //The binary file was missing, stale or invalid - rebuilt for the next runs
+		writePCABinaryFile(pcaFilename, yamlHash);
+	}
 }
 
 sp::ImageProc::ImageProc(const SPConfig config) {
 	try {
 		if (!config) {
-			spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
+			SP_LOG_ERROR(INVALID_ARG_ERROR);
 			throw Exception();
 		}
 		SP_CONFIG_MSG msg;
 		bool preprocMode = false;
 		initFromConfig(config);
 		if ((preprocMode = spConfigIsExtractionMode(config, &msg))) {
-			preprocess(config);
+			if (spConfigIsExtractionCache(config, &msg) && pcaFileExists(config)) {
+				// A retrained basis would invalidate all of the cached features
+				initPCAFromFile(config);
+			} else {
+				descriptorsCache = make_shared<DescriptorsCache>();
+				preprocess(config);
+			}
 		} else {
 			initPCAFromFile(config);
 		}
+		initProjection();
 	} catch (...) {
-		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(GENERAL_ERROR_MSG);
 		throw Exception();
 	}
 }
 
 SPPoint* sp::ImageProc::getImageFeatures(const char* imagePath, int index,
 		int* numOfFeats) {
-	vector<KeyPoint> keypoints;
-	Mat descriptor, img, points;
-	double* pcaSift = NULL;
-	char errorMSG[STRING_LENGTH * 2];
-	Ptr<xfeatures2d::SiftDescriptorExtractor> detector;
+	Mat descriptor;
+	double* coordinates = NULL;
+	size_t stride = 0;
 	if (!imagePath || !numOfFeats) {
-		spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
-		return NULL;
-	}
-	img = imread(imagePath, IMREAD_GRAYSCALE);
-	if (img.empty()) {
-		sprintf(errorMSG, "%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
-		spLoggerPrintError(errorMSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(INVALID_ARG_ERROR);
 		return NULL;
 	}
-	detector = xfeatures2d::SIFT::create(numOfFeatures);
-	detector->detect(img, keypoints);
-	detector->compute(img, keypoints, descriptor);
-	points = pca.project(descriptor);
-	pcaSift = (double*) malloc(sizeof(double) * pcaDim);
-	if (!pcaSift) {
-		spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
+	if ((!descriptorsCache || !descriptorsCache->take(index, imagePath, descriptor))
+			&& !getImageDescriptors(imagePath, descriptor)) {
+		SP_LOG_ERROR("%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
 		return NULL;
 	}
-	*numOfFeats = points.rows;
-	SPPoint* resPoints = (SPPoint*) malloc(sizeof(*resPoints) * points.rows);
+	SPPoint* resPoints = (SPPoint*) malloc(sizeof(*resPoints) * max(descriptor.rows, 1));
 	if (!resPoints) {
-		free(pcaSift);
-		spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(ALLOC_ERROR_MSG);
 		return NULL;
 	}
-	for (int i = 0; i < points.rows; i++) {
-		for (int j = 0; j < points.cols; j++) {
-			pcaSift[j] = (double) points.at<float>(i, j);
+	if (descriptor.rows > 0) { //The points of the image are a single allocation
+		coordinates = spPointCreateBlock(resPoints, descriptor.rows, pcaDim, index, &stride);
+		if (!coordinates) {
+			free(resPoints);
+			SP_LOG_ERROR(ALLOC_ERROR_MSG);
+			return NULL;
 		}
-		resPoints[i] = spPointCreate(pcaSift, pcaDim, index);
+		SP_METRICS_TIMER_START(projectionTimer);
+		// Projected straight into the points' coordinates, there is no intermediate buffer
+		projectDescriptors(descriptor, coordinates, stride);
+		SP_METRICS_TIMER_STOP(projectionTimer, SP_METRICS_PCA_PROJECTION);
 	}
-	free(pcaSift);
+	*numOfFeats = descriptor.rows;
 	return resPoints;
 }
 
@@ -210,16 +484,14 @@ void sp::ImageProc::showImage(const char* imgPath) {
 	if (minimalGui) {
 		Mat img = imread(imgPath, cv::IMREAD_COLOR);
 		if (img.empty()) {
-			spLoggerPrintWarning(IMAGE_NOT_EXIST_MSG, __FILE__, __func__,
-			__LINE__);
+			SP_LOG_WARNING(IMAGE_NOT_EXIST_MSG);
 			return;
 		}
 		imshow(windowName, img);
 		waitKey(0);
 		destroyAllWindows();
 	} else {
-		spLoggerPrintWarning(MINIMAL_GUI_NOT_SET_WARNING, __FILE__, __func__,
-		__LINE__);
+		SP_LOG_WARNING(MINIMAL_GUI_NOT_SET_WARNING);
 	}
 
 }
@@ -3,14 +3,19 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <vector>
+#include <random>
+#include <memory>
 
 extern "C" {
 #include "SPConfig.h"
 #include "SPPoint.h"
+#include "sp_pca_file.h"
 }
 
 namespace sp {
 
+class DescriptorsCache;
+
 /**
  * A class which supports different image processing functionalites.
  */
@@ -20,13 +25,27 @@ private:
 	int pcaDim;
 	int numOfImages;
 	int numOfFeatures;
+	int maxImageSide;
+	int pcaTrainingImages;
+	int pcaTrainingSamples;
 	cv::PCA pca;
+	cv::Mat projection;
+	std::vector<double> projectedMean;
 	bool minimalGui;
+	std::shared_ptr<DescriptorsCache> descriptorsCache;
+	std::shared_ptr<sp_pca_file_t> pcaMapping;
 	void initFromConfig(const SPConfig);
-	void getImagesMat(std::vector<cv::Mat>&, const SPConfig);
-	void getFeatures(std::vector<cv::Mat>&,
-			cv::Mat&);
+	bool getImageDescriptors(const char*, cv::Mat&);
+	void getTrainingImages(std::vector<int>&, std::mt19937&);
+	void sampleDescriptors(const cv::Mat&, int, std::mt19937&, cv::Mat&);
+	void accumulateDescriptors(const cv::Mat&, cv::Mat&, cv::Mat&);
+	void initProjection();
+	void projectDescriptors(const cv::Mat&, double*, size_t);
+	void trainPCA(const cv::Mat&, const cv::Mat&, long long);
 	void preprocess(const SPConfig config);
+	void writePCABinaryFile(const char*, unsigned long long);
+	bool initPCAFromBinaryFile(const char*, unsigned long long);
+	bool pcaFileExists(const SPConfig config);
 	void initPCAFromFile(const SPConfig config);
 public:
 
@@ -41,6 +60,8 @@ public:
 	 * Returns an array of features for the image imagePath. All SPPoint elements
 	 * will have the index given by index. The actual number of features extracted
 	 * for this image will be stored in the pointer given by numOfFeats.
+	 * In extraction mode, the images which were decoded for the PCA training are not
+	 * decoded again - their cached SIFT descriptors are projected.
 	 *
 	 * @param imagePath - the target imagePath
 	 * @param index - the index  of the image in the database
@@ -1,8 +1,13 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "SPLogger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
 
 //File open mode
 #define SP_LOGGER_OPEN_MODE "w"
@@ -23,32 +28,109 @@
 #define MSG_ROW_R_MSG "Message: "
 #define NEW_LINE "\n"
 
+// Record tags consts
+#define THREAD_ID_TAG_FORMAT " [thread: %lu]"
+#define TIMESTAMP_TAG_FORMAT " [time: %.6f]"
+#define TAGS_MAX_LENGTH 64
+
+// Asynchronous mode consts
+#define ASYNC_RECORD_TEXT_LENGTH 1024 //The bytes kept in the ring for the message, file and function of a record
+#define ASYNC_WRITER_RETRY_NANOS 1000000 //The sleep time of a writer thread which could not allocate its buffer
+#define TRUNCATED_RECORD_MARKER "... [truncated]" //Ends a message which was cut to the record size
+#define DROPPED_RECORDS_MSG "Log records were dropped since the log buffer was full, total dropped: "
+
+// Initial size of a thread's formatting buffer, it grows for longer records
+#define THREAD_BUFFER_INITIAL_CAPACITY 512
+
+// The formatting state of a single thread
+typedef struct sp_logger_thread_state_t {
+	char* buffer; //The buffer the thread formats its records into
+	size_t capacity;
+	unsigned long threadId; //A small sequential id, for the thread id tag
+} SPLoggerThreadState;
 
 SP_LOGGER_MSG generalLoggerPrint(const char* header, SP_LOGGER_LEVEL minLevel, const char* msg, const char* file,
 		const char* function, const int line);
-int loggerDetailLines(const char* header, const char* msg, const char* file, const char* function, const int line);
-int loggerPrintRow(const char* prefix, const char* info);
-int loggerPrintText(const char* text);
-int loggerPrintLine(const char* prefix, const int line);
+SP_LOGGER_MSG loggerWriteRecord(SPLoggerThreadState* state, const char* header, const char* msg, const char* file,
+		const char* function, const int line, unsigned long threadId, double timestamp);
+SPLoggerThreadState* loggerThreadState();
+void createThreadStateKey();
+void destroyThreadState(void* state);
+double loggerTimestamp();
+SP_LOGGER_MSG asyncLoggerPrint(const char* header, const char* msg, const char* file,
+		const char* function, const int line);
+void* asyncLoggerWriter(void* arg);
+bool asyncLoggerInitWakeups(SPLogger asyncLogger);
+void asyncLoggerWake(SPLogger asyncLogger);
 
 // Global variable holding the logger
 SPLogger logger = NULL;
 
+// The key of the threads' formatting states. Created once, and kept for the life of the process since
+// threads may outlive the logger
+static pthread_once_t threadStateKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadStateKey;
+static unsigned long numOfThreadStates = 0;
+
+// A log record waiting in the ring buffer of an asynchronous logger
+typedef struct sp_logger_record_t {
+	unsigned long sequence; //The ring position this slot is ready for (see enqueue / dequeue)
+	const char* header; //The record header, NULL for a plain message
+	bool hasDetails; //Indicates if the record has file, function and line rows
+	int line;
+	unsigned long threadId; //The thread id tag of the printing thread
+	double timestamp; //The timestamp tag of the print
+	int fileOffset; //Offset of the file in the record's text
+	int functionOffset; //Offset of the function in the record's text
+	int msgOffset; //Offset of the message in the record's text
+	char* longText; //The text of a record which does not fit in text, freed by the writer thread
+	char text[ASYNC_RECORD_TEXT_LENGTH]; //The file, function and message, NUL separated
+} SPLoggerRecord;
+
 struct sp_logger_t {
 	FILE* outputChannel; //The logger file
 	bool isStdOut; //Indicates if the logger is stdout
 	SP_LOGGER_LEVEL level; //Indicates the level
+	bool threadIdTag; //Indicates if records are tagged with the printing thread id
+	bool timestampTag; //Indicates if records are tagged with a monotonic timestamp
+	double startTime; //The monotonic time of the logger creation, timestamps are relative to it
+	// Asynchronous mode only
+	bool isAsync; //Indicates if records are written by the writer thread
+	SPLoggerRecord* ring; //The ring buffer of pending records
+	unsigned long ringMask; //The ring capacity (a power of two) minus one
+	unsigned long enqueuePosition; //Claimed by the producers with compare-and-swap
+	unsigned long dequeuePosition; //Advanced by the writer thread only
+	unsigned long droppedRecords; //Records dropped since the ring was full
+	unsigned long reportedDrops; //Dropped records which the writer already reported
+	int writeFailed; //Set by the writer thread when a write failed
+	int stopping; //Set when the writer thread should write the pending records and exit
+	int writerSleeping; //Set while the writer thread waits for records, so producers know to wake it
+	pthread_mutex_t wakeLock; //Guards the waits of the writer thread and of the flushing threads
+	pthread_cond_t recordsAvailable; //Signaled when a record is published while the writer sleeps
+	pthread_cond_t recordsWritten; //Broadcast when the writer thread wrote a batch of records
+	pthread_t writer;
 };
 
+// Returns the current time of the monotonic clock, in seconds
+double monotonicTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
 SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 	if (logger != NULL) { //Already defined
 		return SP_LOGGER_DEFINED;
 	}
-	logger = (SPLogger) malloc(sizeof(*logger));
+	logger = (SPLogger) calloc(1, sizeof(*logger));
 	if (logger == NULL) { //Allocation failure
 		return SP_LOGGER_OUT_OF_MEMORY;
 	}
 	logger->level = level; //Set the level of the logger
+	logger->isAsync = false;
+	logger->threadIdTag = false;
+	logger->timestampTag = false;
+	logger->startTime = monotonicTime();
 	if (filename == NULL) { //In case the filename is not set use stdout
 		logger->outputChannel = stdout;
 		logger->isStdOut = true;
@@ -64,15 +146,90 @@ SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 	return SP_LOGGER_SUCCESS;
 }
 
+SP_LOGGER_MSG spLoggerCreateAsync(const char* filename, SP_LOGGER_LEVEL level, int capacity) {
+	unsigned long i, ringCapacity = 1;
+	SPLoggerRecord* ring;
+	SP_LOGGER_MSG res;
+	if (logger != NULL) { //Already defined
+		return SP_LOGGER_DEFINED;
+	}
+	if (capacity <= 0) {
+		return SP_LOGGER_INVAlID_ARGUMENT;
+	}
+	while (ringCapacity < (unsigned long) capacity) { //Round up to a power of two
+		ringCapacity <<= 1;
+	}
+	ring = (SPLoggerRecord*) malloc(ringCapacity * sizeof(SPLoggerRecord));
+	if (ring == NULL) {
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	res = spLoggerCreate(filename, level);
+	if (res != SP_LOGGER_SUCCESS) {
+		free(ring);
+		return res;
+	}
+	for (i = 0; i < ringCapacity; i++) { //Every slot is ready for its first enqueue
+		ring[i].sequence = i;
+	}
+	logger->ring = ring;
+	logger->ringMask = ringCapacity - 1;
+	if (!asyncLoggerInitWakeups(logger)) {
+		free(ring);
+		logger->ring = NULL;
+		spLoggerDestroy();
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	logger->isAsync = true;
+	if (pthread_create(&logger->writer, NULL, asyncLoggerWriter, logger) != 0) {
+		pthread_cond_destroy(&logger->recordsWritten);
+		pthread_cond_destroy(&logger->recordsAvailable);
+		pthread_mutex_destroy(&logger->wakeLock);
+		free(ring);
+		logger->ring = NULL;
+		logger->isAsync = false;
+		spLoggerDestroy();
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	return SP_LOGGER_SUCCESS;
+}
+
+SP_LOGGER_MSG spLoggerSetRecordTags(bool threadId, bool timestamp) {
+	if (logger == NULL) {
+		return SP_LOGGER_UNDEFINED;
+	}
+	logger->threadIdTag = threadId;
+	logger->timestampTag = timestamp;
+	return SP_LOGGER_SUCCESS;
+}
+
 void spLoggerDestroy() {
+	SPLoggerThreadState* state;
 	if (!logger) {
 		return;
 	}
+	if (logger->isAsync) { //The writer thread writes the pending records before it exits
+		pthread_mutex_lock(&logger->wakeLock);
+		__atomic_store_n(&logger->stopping, 1, __ATOMIC_SEQ_CST);
+		pthread_cond_signal(&logger->recordsAvailable);
+		pthread_mutex_unlock(&logger->wakeLock);
+		pthread_join(logger->writer, NULL);
+		pthread_cond_destroy(&logger->recordsWritten);
+		pthread_cond_destroy(&logger->recordsAvailable);
+		pthread_mutex_destroy(&logger->wakeLock);
+		free(logger->ring);
+	}
 	if (!logger->isStdOut) {//Close file only if not stdout
 		fclose(logger->outputChannel);
 	}
 	free(logger);//free allocation
 	logger = NULL;
+	// The states of other threads are freed when they exit, the calling thread may be the main thread
+	pthread_once(&threadStateKeyOnce, createThreadStateKey);
+	state = (SPLoggerThreadState*) pthread_getspecific(threadStateKey);
+	if (state != NULL) {
+		destroyThreadState(state);
+		pthread_setspecific(threadStateKey, NULL);
+	}
 }
 
 SP_LOGGER_MSG spLoggerPrintError(const char* msg, const char* file,
@@ -91,40 +248,101 @@ SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
 }
 
 SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
+	SPLoggerThreadState* state;
+	SP_LOGGER_MSG res;
 	if (logger == NULL){
 		return SP_LOGGER_UNDEFINED;
 	}
 	if (msg == NULL){
 		return SP_LOGGER_INVAlID_ARGUMENT;
 	}
-	if (logger->level >= SP_LOGGER_INFO_WARNING_ERROR_LEVEL) {
-		int res = loggerPrintText(INFO_HEADER);
-		if (res < 0){
-			return SP_LOGGER_WRITE_FAIL;
-		}
-		res = loggerPrintRow(MSG_ROW_PREFIX, msg);
-		if (res < 0){
-			return SP_LOGGER_WRITE_FAIL;
-		}
+	if (logger->level < SP_LOGGER_INFO_WARNING_ERROR_LEVEL) {
+		return SP_LOGGER_SUCCESS;
 	}
-	if (!logger->isStdOut) {
+	if (logger->isAsync) {
+		return asyncLoggerPrint(INFO_HEADER, msg, NULL, NULL, 0);
+	}
+	state = loggerThreadState();
+	if (state == NULL) {
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	res = loggerWriteRecord(state, INFO_HEADER, msg, NULL, NULL, 0, state->threadId, loggerTimestamp());
+	if (res == SP_LOGGER_SUCCESS && !logger->isStdOut) {
 		fflush(logger->outputChannel);
 	}
-	return SP_LOGGER_SUCCESS;
+	return res;
 }
 
 SP_LOGGER_MSG spLoggerPrintMsg(const char* msg) {
+	SPLoggerThreadState* state;
 	if (logger == NULL){
 		return SP_LOGGER_UNDEFINED;
 	}
 	if (msg == NULL){
 		return SP_LOGGER_INVAlID_ARGUMENT;
 	}
-	int res = loggerPrintRow(MSG_ROW_PREFIX, msg);
-	if (res < 0){
-		return SP_LOGGER_WRITE_FAIL;
+	if (logger->isAsync) {
+		return asyncLoggerPrint(NULL, msg, NULL, NULL, 0);
+	}
+	state = loggerThreadState();
+	if (state == NULL) {
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	return loggerWriteRecord(state, NULL, msg, NULL, NULL, 0, state->threadId, 0);
+}
+
+SP_LOGGER_MSG spLoggerFlush() {
+	unsigned long target;
+	if (logger == NULL) {
+		return SP_LOGGER_UNDEFINED;
+	}
+	if (!logger->isAsync) {
+		return fflush(logger->outputChannel) == 0 ? SP_LOGGER_SUCCESS : SP_LOGGER_WRITE_FAIL;
+	}
+	// Waits for the records which were enqueued before the call
+	target = __atomic_load_n(&logger->enqueuePosition, __ATOMIC_ACQUIRE);
+	pthread_mutex_lock(&logger->wakeLock);
+	while (__atomic_load_n(&logger->dequeuePosition, __ATOMIC_ACQUIRE) < target) {
+		pthread_cond_wait(&logger->recordsWritten, &logger->wakeLock);
+	}
+	pthread_mutex_unlock(&logger->wakeLock);
+	return __atomic_load_n(&logger->writeFailed, __ATOMIC_ACQUIRE) ? SP_LOGGER_WRITE_FAIL : SP_LOGGER_SUCCESS;
+}
+
+unsigned long spLoggerGetNumOfDroppedRecords() {
+	if (logger == NULL) {
+		return 0;
+	}
+	return __atomic_load_n(&logger->droppedRecords, __ATOMIC_RELAXED);
+}
+
+bool spLoggerIsLevelEnabled(SP_LOGGER_LEVEL level) {
+	return logger != NULL && logger->level >= level;
+}
+
+SP_LOGGER_MSG spLoggerPrintFormat(SP_LOGGER_LEVEL level, const char* file, const char* function,
+		const int line, const char* format, ...) {
+	char msg[SP_LOGGER_FORMAT_MSG_LENGTH];
+	va_list args;
+	if (format == NULL) {
+		return SP_LOGGER_INVAlID_ARGUMENT;
+	}
+	if (!spLoggerIsLevelEnabled(level)) { //Not formatted in vain
+		return logger == NULL ? SP_LOGGER_UNDEFINED : SP_LOGGER_SUCCESS;
+	}
+	va_start(args, format);
+	vsnprintf(msg, SP_LOGGER_FORMAT_MSG_LENGTH, format, args);
+	va_end(args);
+	switch (level) {
+	case SP_LOGGER_ERROR_LEVEL:
+		return spLoggerPrintError(msg, file, function, line);
+	case SP_LOGGER_WARNING_ERROR_LEVEL:
+		return spLoggerPrintWarning(msg, file, function, line);
+	case SP_LOGGER_INFO_WARNING_ERROR_LEVEL:
+		return spLoggerPrintInfo(msg);
+	default:
+		return spLoggerPrintDebug(msg, file, function, line);
 	}
-	return SP_LOGGER_SUCCESS;
 }
 
 // In order to reduce code lines, mutual logic of ERROR, WARNING and DEBUG is
@@ -132,81 +350,320 @@ SP_LOGGER_MSG spLoggerPrintMsg(const char* msg) {
 // This method validates the input and prints whats needed.
 SP_LOGGER_MSG generalLoggerPrint(const char* header, SP_LOGGER_LEVEL minLevel, const char* msg, const char* file,
 		const char* function, const int line) {
+	SPLoggerThreadState* state;
+	SP_LOGGER_MSG res;
 	if (logger == NULL){
 		return SP_LOGGER_UNDEFINED;
 	}
 	if (msg == NULL || file == NULL || function == NULL || line < 0) {
 		return SP_LOGGER_INVAlID_ARGUMENT;
 	}
-	if (logger->level >= minLevel) {
-		int res = loggerDetailLines(header, msg, file, function, line);
-		if (res == 0) {
-			return SP_LOGGER_WRITE_FAIL;
-		}
+	if (logger->level < minLevel) {
+		return SP_LOGGER_SUCCESS;
+	}
+	if (logger->isAsync) {
+		return asyncLoggerPrint(header, msg, file, function, line);
+	}
+	state = loggerThreadState();
+	if (state == NULL) {
+		return SP_LOGGER_OUT_OF_MEMORY;
 	}
-	if (!logger->isStdOut) {
+	res = loggerWriteRecord(state, header, msg, file, function, line, state->threadId, loggerTimestamp());
+	if (res == SP_LOGGER_SUCCESS && !logger->isStdOut) {
 		fflush(logger->outputChannel);
 	}
+	return res;
+}
+
+// Frees a thread's formatting state, called when the thread exits
+void destroyThreadState(void* state) {
+	if (state == NULL) {
+		return;
+	}
+	free(((SPLoggerThreadState*) state)->buffer);
+	free(state);
+}
+
+void createThreadStateKey() {
+	pthread_key_create(&threadStateKey, destroyThreadState);
+}
+
+// Returns the formatting state of the calling thread, which is created on its first print.
+// Returns NULL in case of allocation failure.
+SPLoggerThreadState* loggerThreadState() {
+	SPLoggerThreadState* state;
+	pthread_once(&threadStateKeyOnce, createThreadStateKey);
+	state = (SPLoggerThreadState*) pthread_getspecific(threadStateKey);
+	if (state != NULL) {
+		return state;
+	}
+	state = (SPLoggerThreadState*) malloc(sizeof(*state));
+	if (state == NULL) {
+		return NULL;
+	}
+	state->buffer = (char*) malloc(THREAD_BUFFER_INITIAL_CAPACITY);
+	if (state->buffer == NULL || pthread_setspecific(threadStateKey, state) != 0) {
+		destroyThreadState(state);
+		return NULL;
+	}
+	state->capacity = THREAD_BUFFER_INITIAL_CAPACITY;
+	state->threadId = __atomic_add_fetch(&numOfThreadStates, 1, __ATOMIC_RELAXED);
+	return state;
+}
+
+// Returns the timestamp tag of a record printed now, in seconds since the logger creation
+double loggerTimestamp() {
+	return logger->timestampTag ? monotonicTime() - logger->startTime : 0;
+}
+
+// Formats a record in the assignment required format into the thread's buffer, growing it as needed.
+// A record without a header is a plain message row, and a record without a file has no detail rows.
+// Returns the length of the formatted record, or a negative number in case of failure.
+int loggerFormatRecord(SPLoggerThreadState* state, const char* header, const char* msg, const char* file,
+		const char* function, const int line, unsigned long threadId, double timestamp) {
+	char tags[TAGS_MAX_LENGTH];
+	int length, tagsLength = 0;
+	char* grownBuffer;
+	tags[0] = '\0';
+	if (logger->threadIdTag) {
+		tagsLength += sprintf(tags + tagsLength, THREAD_ID_TAG_FORMAT, threadId);
+	}
+	if (logger->timestampTag) {
+		sprintf(tags + tagsLength, TIMESTAMP_TAG_FORMAT, timestamp);
+	}
+	while (true) {
+		if (header == NULL) {
+			length = snprintf(state->buffer, state->capacity, "%s%s%s", MSG_ROW_PREFIX, msg, NEW_LINE);
+		} else if (file == NULL) {
+			length = snprintf(state->buffer, state->capacity, "%s%s%s%s%s%s", header, tags, NEW_LINE,
+					MSG_ROW_PREFIX, msg, NEW_LINE);
+		} else {
+			length = snprintf(state->buffer, state->capacity, "%s%s%s%s%s%s%s%s%s%s%d%s%s%s%s", header, tags,
+					NEW_LINE, FILE_ROW_PREFIX, file, NEW_LINE, FUNCTION_ROW_PREFIX, function, NEW_LINE,
+					LINE_ROW_PREFIX, line, NEW_LINE, MSG_ROW_PREFIX, msg, NEW_LINE);
+		}
+		if (length < 0 || (size_t) length < state->capacity) {
+			return length;
+		}
+		grownBuffer = (char*) realloc(state->buffer, length + 1);
+		if (grownBuffer == NULL) {
+			return -1;
+		}
+		state->buffer = grownBuffer;
+		state->capacity = length + 1;
+	}
+}
+
+// Formats a record and writes it with a single write - stdio locks the stream for the write only, so
+// records of concurrent threads are never interleaved, and the formatting itself is done in parallel.
+SP_LOGGER_MSG loggerWriteRecord(SPLoggerThreadState* state, const char* header, const char* msg, const char* file,
+		const char* function, const int line, unsigned long threadId, double timestamp) {
+	int length = loggerFormatRecord(state, header, msg, file, function, line, threadId, timestamp);
+	if (length < 0) {
+		return SP_LOGGER_OUT_OF_MEMORY;
+	}
+	if (fwrite(state->buffer, 1, length, logger->outputChannel) != (size_t) length) {
+		return SP_LOGGER_WRITE_FAIL;
+	}
 	return SP_LOGGER_SUCCESS;
 }
 
+// Copies as much of src as fits in the remaining bytes of a record text, always NUL terminated. A copy which
+// was cut ends with TRUNCATED_RECORD_MARKER (if there is room for it). Returns the number of bytes used.
+int copyToRecordText(char* dst, int remaining, const char* src) {
+	int length = (int) strlen(src), markerLength = (int) strlen(TRUNCATED_RECORD_MARKER);
+	if (length <= remaining - 1) {
+		memcpy(dst, src, length + 1);
+		return length + 1;
+	}
+	length = remaining - 1;
+	memcpy(dst, src, length);
+	if (length >= markerLength) {
+		memcpy(dst + length - markerLength, TRUNCATED_RECORD_MARKER, markerLength);
+	}
+	dst[length] = '\0';
+	return length + 1;
+}
 
-// Method for printing in the assignment required format
-int loggerDetailLines(const char* header, const char* msg, const char* file, const char* function, const int line) {
-	int res = loggerPrintText(header);
-	if (res < 0) {
-		return 0;
+// Copies the file, function and message of a record into its text. A record which does not fit in the ring
+// slot is copied to memory of its own, and only if that allocation fails it is cut to the slot size.
+void fillRecordText(SPLoggerRecord* record, const char* msg, const char* file, const char* function) {
+	size_t length = strlen(msg) + 1;
+	char* text = record->text;
+	int capacity = ASYNC_RECORD_TEXT_LENGTH, used = 0;
+	if (record->hasDetails) {
+		length += strlen(file) + strlen(function) + 2;
 	}
-	res = loggerPrintRow(FILE_ROW_PREFIX, file);
-	if (res < 0) {
-		return 0;
+	record->longText = NULL;
+	if (length > ASYNC_RECORD_TEXT_LENGTH) {
+		record->longText = (char*) malloc(length);
+		if (record->longText != NULL) {
+			text = record->longText;
+			capacity = (int) length;
+		}
 	}
-	res = loggerPrintRow(FUNCTION_ROW_PREFIX, function);
-	if (res < 0) {
-		return 0;
+	if (record->hasDetails) { //The names are short, most of a cut record is left to the message
+		record->fileOffset = used;
+		used += copyToRecordText(text + used, capacity / 4, file);
+		record->functionOffset = used;
+		used += copyToRecordText(text + used, capacity / 4, function);
 	}
-	res = loggerPrintLine(LINE_ROW_PREFIX, line);
-	if (res < 0) {
-		return 0;
+	record->msgOffset = used;
+	copyToRecordText(text + used, capacity - used, msg);
+}
+
+// Enqueues a record into the ring buffer without taking any lock - producers claim a position with
+// compare-and-swap and publish the filled slot through its sequence number (a bounded MPSC queue).
+// If the ring is full the record is dropped and counted, so a slow disk never blocks the caller - the caller
+// gets SP_LOGGER_RECORD_DROPPED.
+SP_LOGGER_MSG asyncLoggerPrint(const char* header, const char* msg, const char* file,
+		const char* function, const int line) {
+	SPLoggerRecord* record;
+	SPLoggerThreadState* state = NULL;
+	unsigned long sequence, position;
+	long difference;
+	if (logger->threadIdTag) {
+		state = loggerThreadState();
+		if (state == NULL) {
+			return SP_LOGGER_OUT_OF_MEMORY;
+		}
 	}
-	res = loggerPrintRow(MSG_ROW_PREFIX, msg);
-	if (res < 0) {
-		return 0;
+	position = __atomic_load_n(&logger->enqueuePosition, __ATOMIC_RELAXED);
+	while (true) {
+		record = &logger->ring[position & logger->ringMask];
+		sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+		difference = (long) (sequence - position);
+		if (difference == 0) { //The slot is free - try to claim the position
+			if (__atomic_compare_exchange_n(&logger->enqueuePosition, &position, position + 1, true,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (difference < 0) { //The slot was not written yet - the ring is full
+			__atomic_add_fetch(&logger->droppedRecords, 1, __ATOMIC_RELAXED);
+			return SP_LOGGER_RECORD_DROPPED;
+		} else { //Another producer claimed the position
+			position = __atomic_load_n(&logger->enqueuePosition, __ATOMIC_RELAXED);
+		}
+	}
+	record->header = header;
+	record->hasDetails = (file != NULL);
+	record->line = line;
+	record->threadId = state != NULL ? state->threadId : 0;
+	record->timestamp = loggerTimestamp();
+	fillRecordText(record, msg, file, function);
+	// Publishes the record to the writer. The publication and the check whether the writer sleeps are both
+	// sequentially consistent, so either the writer sees the record before it sleeps or it is woken up
+	__atomic_store_n(&record->sequence, position + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&logger->writerSleeping, __ATOMIC_SEQ_CST)) {
+		asyncLoggerWake(logger);
 	}
-	return 1;
+	return __atomic_load_n(&logger->writeFailed, __ATOMIC_RELAXED) ? SP_LOGGER_WRITE_FAIL : SP_LOGGER_SUCCESS;
 }
 
-// fprintf or fprint text (mostly headers)
-int loggerPrintText(const char* text) {
-	int res;
-	if (logger->isStdOut){
-		res = printf("%s%s", text, NEW_LINE);
-	} else {
-		res = fprintf(logger->outputChannel, "%s%s", text, NEW_LINE);
+// Initializes the lock and the condition variables the writer thread and the flushing threads wait on.
+// Returns false if any of them could not be initialized, after destroying the others.
+bool asyncLoggerInitWakeups(SPLogger asyncLogger) {
+	if (pthread_mutex_init(&asyncLogger->wakeLock, NULL) != 0) {
+		return false;
 	}
-	return res;
+	if (pthread_cond_init(&asyncLogger->recordsAvailable, NULL) != 0) {
+		pthread_mutex_destroy(&asyncLogger->wakeLock);
+		return false;
+	}
+	if (pthread_cond_init(&asyncLogger->recordsWritten, NULL) != 0) {
+		pthread_cond_destroy(&asyncLogger->recordsAvailable);
+		pthread_mutex_destroy(&asyncLogger->wakeLock);
+		return false;
+	}
+	return true;
+}
+
+// Wakes the writer thread up, if it waits for records
+void asyncLoggerWake(SPLogger asyncLogger) {
+	pthread_mutex_lock(&asyncLogger->wakeLock);
+	pthread_cond_signal(&asyncLogger->recordsAvailable);
+	pthread_mutex_unlock(&asyncLogger->wakeLock);
 }
 
-// fprintf or fprint row with prefix and info
-int loggerPrintRow(const char* prefix, const char* info) {
-	int res;
-	if (logger->isStdOut){
-		res = printf("%s%s%s", prefix, info, NEW_LINE);
-	} else {
-		res = fprintf(logger->outputChannel, "%s%s%s", prefix, info, NEW_LINE);
+// Blocks the writer thread until the record at the dequeue position is published, or the logger is stopping
+void asyncLoggerWaitForRecords(SPLogger asyncLogger) {
+	unsigned long position = asyncLogger->dequeuePosition;
+	SPLoggerRecord* record = &asyncLogger->ring[position & asyncLogger->ringMask];
+	pthread_mutex_lock(&asyncLogger->wakeLock);
+	__atomic_store_n(&asyncLogger->writerSleeping, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&record->sequence, __ATOMIC_SEQ_CST) != position + 1
+			&& !__atomic_load_n(&asyncLogger->stopping, __ATOMIC_SEQ_CST)) {
+		pthread_cond_wait(&asyncLogger->recordsAvailable, &asyncLogger->wakeLock);
 	}
-	return res;
+	__atomic_store_n(&asyncLogger->writerSleeping, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&asyncLogger->wakeLock);
 }
 
-// fprintf or fprint line prefix and line number
-int loggerPrintLine(const char* prefix, const int line) {
-	int res;
-	if (logger->isStdOut){
-		res = printf("%s%d%s", prefix, line, NEW_LINE);
-	} else {
-		res = fprintf(logger->outputChannel, "%s%d%s", prefix, line, NEW_LINE);
+// Writes all of the published records as a single batch, followed by one flush.
+// Returns the number of records written.
+unsigned long asyncLoggerWritePending(SPLogger asyncLogger, SPLoggerThreadState* state) {
+	unsigned long count = 0, position = asyncLogger->dequeuePosition, dropped;
+	char droppedMsg[sizeof(DROPPED_RECORDS_MSG) + 24];
+	SP_LOGGER_MSG res;
+	const char* text;
+	SPLoggerRecord* record = &asyncLogger->ring[position & asyncLogger->ringMask];
+	while (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) == position + 1) {
+		text = record->longText != NULL ? record->longText : record->text;
+		res = loggerWriteRecord(state, record->header, text + record->msgOffset,
+				record->hasDetails ? text + record->fileOffset : NULL,
+				record->hasDetails ? text + record->functionOffset : NULL,
+				record->line, record->threadId, record->timestamp);
+		if (res != SP_LOGGER_SUCCESS) {
+			__atomic_store_n(&asyncLogger->writeFailed, 1, __ATOMIC_RELEASE);
+		}
+		free(record->longText);
+		record->longText = NULL;
+		// Hands the slot back to the producers, for the next round of the ring
+		__atomic_store_n(&record->sequence, position + asyncLogger->ringMask + 1, __ATOMIC_RELEASE);
+		position++;
+		__atomic_store_n(&asyncLogger->dequeuePosition, position, __ATOMIC_RELEASE);
+		record = &asyncLogger->ring[position & asyncLogger->ringMask];
+		count++;
 	}
-	return res;
+	dropped = __atomic_load_n(&asyncLogger->droppedRecords, __ATOMIC_RELAXED);
+	if (dropped != asyncLogger->reportedDrops) {
+		sprintf(droppedMsg, "%s%lu", DROPPED_RECORDS_MSG, dropped);
+		loggerWriteRecord(state, NULL, droppedMsg, NULL, NULL, 0, 0, 0);
+		asyncLogger->reportedDrops = dropped;
+		count++;
+	}
+	if (count > 0 && fflush(asyncLogger->outputChannel) != 0) {
+		__atomic_store_n(&asyncLogger->writeFailed, 1, __ATOMIC_RELEASE);
+	}
+	return count;
+}
+
+// The writer thread routine - writes the records in batches, and waits on a condition variable while there
+// are none.
+void* asyncLoggerWriter(void* arg) {
+	SPLogger asyncLogger = (SPLogger) arg;
+	struct timespec retry = { 0, ASYNC_WRITER_RETRY_NANOS };
+	SPLoggerThreadState* state = loggerThreadState();
+	int stopping;
+	while (true) {
+		stopping = __atomic_load_n(&asyncLogger->stopping, __ATOMIC_SEQ_CST);
+		if (state == NULL) { //No formatting buffer yet - retried after a short sleep
+			__atomic_store_n(&asyncLogger->writeFailed, 1, __ATOMIC_RELEASE);
+			nanosleep(&retry, NULL);
+			state = loggerThreadState();
+			continue;
+		}
+		if (asyncLoggerWritePending(asyncLogger, state) > 0) { //Wakes the threads waiting in spLoggerFlush
+			pthread_mutex_lock(&asyncLogger->wakeLock);
+			pthread_cond_broadcast(&asyncLogger->recordsWritten);
+			pthread_mutex_unlock(&asyncLogger->wakeLock);
+		} else if (stopping) {
+			break;
+		} else {
+			asyncLoggerWaitForRecords(asyncLogger);
+		}
+	}
+	return NULL;
 }
 
 void printRErrorMsg(const char* filename, const int line, const char* msg) {
@@ -1,5 +1,7 @@
 #ifndef SPLOGGER_H_
 #define SPLOGGER_H_
+
+#include <stdbool.h>
 /**
  * SP Logger summary:
  * SP Logger is defined at compilation time and it must be initialized
@@ -13,15 +15,41 @@
  * 	
  * The logger supports another printing function which can be called at any level
  * The user must destroy the logger at end of usage
+ *
+ * The logger may be created in asynchronous mode (spLoggerCreateAsync), in which the
+ * print functions only copy the record into a bounded lock-free ring buffer, and a
+ * background writer thread formats and writes the records in batches. The print
+ * functions never block in this mode - when the ring buffer is full the record is
+ * dropped, and the writer reports the number of dropped records in the log.
+ * The records are written in the same format as in synchronous mode.
+ *
+ * The print functions may be called concurrently from any number of threads, in
+ * both modes. Every thread formats its records into its own buffer, and every record
+ * is written with a single write, so records of different threads never interleave.
+ * Records may optionally be tagged with the printing thread and a monotonic timestamp
+ * (spLoggerSetRecordTags), which are appended to the record header:
+ * 	---INFO--- [thread: <id>] [time: <seconds since the logger creation>]
  *	
  * The following functions are supported:
  * spLoggerCreate 		- Creates and initializes the logger
+ * spLoggerCreateAsync 	- Creates and initializes the logger in asynchronous mode
+ * spLoggerSetRecordTags - Sets the tags of the records (thread id, timestamp)
  * spLoggerDestroy		- Closes are frees all resources of the logger
+ * spLoggerFlush		- Waits for the printed records to be written
+ * spLoggerGetNumOfDroppedRecords - Returns the number of records dropped in asynchronous mode
  * spLoggerPrintError   - Prints error messages at leves {Error, Warning, Info, Debug}
  * spLoggerPrintWarning - Prints warnning messages at levels {Warning, Info, Debug}
  * spLoggerPrintInfo    - Prints info messages at levels {Info, Debug}
  * spLoggerPrintDebug   - Prints debug messages at level {Debug}
  * spLoggerPrintMsg     - Prints the exact message at any level (Without formatting)
+ * spLoggerIsLevelEnabled - Checks if messages of a level are printed
+ * spLoggerPrintFormat  - Formats a message printf style and prints it at its level
+ *
+ * The SP_LOG_ERROR, SP_LOG_WARNING, SP_LOG_INFO and SP_LOG_DEBUG macros should be
+ * preferred over the print functions - they take a printf style format and arguments,
+ * fill in the file, function and line, and do not evaluate the arguments nor format
+ * the message unless the level is printed. Levels above SP_LOGGER_COMPILE_LEVEL are
+ * compiled out entirely.
  */
 
 /** A type used to decide the level of the logger**/
@@ -32,6 +60,33 @@ typedef enum sp_logger_level_t {
 	SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL = 4 //Debug level
 } SP_LOGGER_LEVEL;
 
+/**
+ * The highest level which the SP_LOG_* macros compile in. Records of higher levels
+ * are removed at compile time, regardless of the level the logger is created with.
+ * May be set at build time, e.g. -DSP_LOGGER_COMPILE_LEVEL=3 removes debug records.
+ */
+#ifndef SP_LOGGER_COMPILE_LEVEL
+#define SP_LOGGER_COMPILE_LEVEL SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL
+#endif
+
+/**
+ * Prints a printf style message at the given level, if the level is compiled in and
+ * printed by the logger - otherwise the arguments are not evaluated.
+ * The level and format must be followed by the format's arguments, e.g.
+ * SP_LOG(SP_LOGGER_ERROR_LEVEL, "%s %d", msg, value);
+ */
+#define SP_LOG(level, ...) \
+	do { \
+		if ((level) <= SP_LOGGER_COMPILE_LEVEL && spLoggerIsLevelEnabled(level)) { \
+			spLoggerPrintFormat((level), __FILE__, __func__, __LINE__, __VA_ARGS__); \
+		} \
+	} while (0)
+
+#define SP_LOG_ERROR(...) SP_LOG(SP_LOGGER_ERROR_LEVEL, __VA_ARGS__)
+#define SP_LOG_WARNING(...) SP_LOG(SP_LOGGER_WARNING_ERROR_LEVEL, __VA_ARGS__)
+#define SP_LOG_INFO(...) SP_LOG(SP_LOGGER_INFO_WARNING_ERROR_LEVEL, __VA_ARGS__)
+#define SP_LOG_DEBUG(...) SP_LOG(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL, __VA_ARGS__)
+
 /** A type used to indicate errors in function calls **/
 typedef enum sp_logger_msg_t {
 	SP_LOGGER_CANNOT_OPEN_FILE,
@@ -40,9 +95,13 @@ typedef enum sp_logger_msg_t {
 	SP_LOGGER_UNDEFINED,
 	SP_LOGGER_DEFINED,
 	SP_LOGGER_WRITE_FAIL,
+	SP_LOGGER_RECORD_DROPPED,
 	SP_LOGGER_SUCCESS
 } SP_LOGGER_MSG;
 
+/** The maximal length of a message formatted by spLoggerPrintFormat **/
+#define SP_LOGGER_FORMAT_MSG_LENGTH 2048
+
 /** A type used for defining the logger**/
 typedef struct sp_logger_t* SPLogger;
 
@@ -63,12 +122,69 @@ typedef struct sp_logger_t* SPLogger;
  */
 SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level);
 
+/**
+ * Creates a logger in asynchronous mode. Same as spLoggerCreate, except that the
+ * records are written by a background writer thread. The print functions may be
+ * called concurrently from any number of threads.
+ *
+ * In this mode the print functions return once the record is enqueued, so
+ * SP_LOGGER_WRITE_FAIL informs that writing a previous record has failed.
+ * If all capacity records are pending the record is dropped, and the print
+ * function returns SP_LOGGER_RECORD_DROPPED.
+ * Records longer than about 1KB (including the file and function names) are
+ * copied to memory of their own. Only if that allocation fails the message is
+ * truncated, and its end is replaced by "... [truncated]".
+ *
+ * @param filename - The name of the log file, if not specified stdout is used
+ * 					 as default.
+ * @param level - The level of the logger prints
+ * @param capacity - The number of records the ring buffer holds, rounded up to
+ * 					 a power of two. Records printed while it is full are dropped.
+ * @return
+ * SP_LOGGER_DEFINED 			- The logger has been defined
+ * SP_LOGGER_INVAlID_ARGUMENT	- If capacity is not positive
+ * SP_LOGGER_OUT_OF_MEMORY 		- In case of memory allocation (or thread creation) failure
+ * SP_LOGGER_CANNOT_OPEN_FILE 	- If the file given by filename cannot be opened
+ * SP_LOGGER_SUCCESS 			- In case the logger has been successfully opened
+ */
+SP_LOGGER_MSG spLoggerCreateAsync(const char* filename, SP_LOGGER_LEVEL level, int capacity);
+
+/**
+ * Sets the tags which are appended to the header of every record. No tags are
+ * set when the logger is created. Should be called before the logger is used.
+ *
+ * @param threadId - Whether records are tagged with a small sequential id of the printing thread
+ * @param timestamp - Whether records are tagged with the seconds (of a monotonic clock) since
+ * 					  the logger creation. In asynchronous mode this is the time of the print call.
+ * @return
+ * SP_LOGGER_UNDEFINED 			- If the logger is undefined
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+SP_LOGGER_MSG spLoggerSetRecordTags(bool threadId, bool timestamp);
+
 /**
  * Frees all memory allocated for the logger. If the logger is not defined
- * then nothing happens.
+ * then nothing happens. In asynchronous mode the pending records are written
+ * first, and no other thread may print while the logger is destroyed.
  */
 void spLoggerDestroy();
 
+/**
+ * Waits until the records printed before the call are written to the log.
+ *
+ * @return
+ * SP_LOGGER_UNDEFINED 			- If the logger is undefined
+ * SP_LOGGER_WRITE_FAIL			- If Write failure occurred
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+SP_LOGGER_MSG spLoggerFlush();
+
+/**
+ * Returns the number of records which were dropped since the ring buffer of an
+ * asynchronous logger was full. 0 if the logger is undefined or synchronous.
+ */
+unsigned long spLoggerGetNumOfDroppedRecords();
+
 /**
  * 	Prints error message. The error message format is given below:
  * 	---ERROR---
@@ -101,7 +217,9 @@ void spLoggerDestroy();
  * @return
  * SP_LOGGER_UNDEFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If any of msg or file or function are null or line is negative
+ * SP_LOGGER_OUT_OF_MEMORY		- If the formatting buffer could not be allocated
  * SP_LOGGER_WRITE_FAIL			- If Write failure occurred
+ * SP_LOGGER_RECORD_DROPPED		- If the asynchronous logger dropped the record, since its buffer was full
  * SP_LOGGER_SUCCESS			- otherwise
  */
 SP_LOGGER_MSG spLoggerPrintError(const char* msg, const char* file,
@@ -138,7 +256,9 @@ SP_LOGGER_MSG spLoggerPrintError(const char* msg, const char* file,
  * @return
  * SP_LOGGER_UNDEFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If any of msg or file or function are null or line is negative
+ * SP_LOGGER_OUT_OF_MEMORY		- If the formatting buffer could not be allocated
  * SP_LOGGER_WRITE_FAIL			- If write failure occurred
+ * SP_LOGGER_RECORD_DROPPED		- If the asynchronous logger dropped the record, since its buffer was full
  * SP_LOGGER_SUCCESS			- otherwise
  */
 SP_LOGGER_MSG spLoggerPrintWarning(const char* msg, const char* file,
@@ -161,7 +281,9 @@ SP_LOGGER_MSG spLoggerPrintWarning(const char* msg, const char* file,
  * @return
  * SP_LOGGER_UNDEFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If msg is null
+ * SP_LOGGER_OUT_OF_MEMORY		- If the formatting buffer could not be allocated
  * SP_LOGGER_WRITE_FAIL			- If Write failure occurred
+ * SP_LOGGER_RECORD_DROPPED		- If the asynchronous logger dropped the record, since its buffer was full
  * SP_LOGGER_SUCCESS			- otherwise
  */
 SP_LOGGER_MSG spLoggerPrintInfo(const char* msg);
@@ -195,7 +317,9 @@ SP_LOGGER_MSG spLoggerPrintInfo(const char* msg);
  * @return
  * SP_LOGGER_UNDEFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If any of msg or file or function are null or line is negative
+ * SP_LOGGER_OUT_OF_MEMORY		- If the formatting buffer could not be allocated
  * SP_LOGGER_WRITE_FAIL			- If Write failure occurred
+ * SP_LOGGER_RECORD_DROPPED		- If the asynchronous logger dropped the record, since its buffer was full
  * SP_LOGGER_SUCCESS			- otherwise
  */
 SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
@@ -209,11 +333,44 @@ SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
  * @return
  * SP_LOGGER_UNDEFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If msg is null
+ * SP_LOGGER_OUT_OF_MEMORY		- If the formatting buffer could not be allocated
  * SP_LOGGER_WRITE_FAIL			- If Write failure occurred
+ * SP_LOGGER_RECORD_DROPPED		- If the asynchronous logger dropped the record, since its buffer was full
  * SP_LOGGER_SUCCESS			- otherwise
  */
 SP_LOGGER_MSG spLoggerPrintMsg(const char* msg);
 
+/**
+ * Checks if messages of the given level are printed by the logger.
+ *
+ * @param level - The level of the message
+ * @return
+ * true if the logger is defined and its level includes the given level, false otherwise
+ */
+bool spLoggerIsLevelEnabled(SP_LOGGER_LEVEL level);
+
+/**
+ * Formats a printf style message and prints it at the given level, as the
+ * matching print function does (spLoggerPrintError for SP_LOGGER_ERROR_LEVEL etc.).
+ * The file, function and line are not printed for info messages.
+ * Formatted messages longer than SP_LOGGER_FORMAT_MSG_LENGTH are truncated.
+ *
+ * @param level 	- The level of the message
+ * @param file    	- A string representing the filename in which the call occurred
+ * @param function 	- A string representing the function name in which the call ocurred
+ * @param line		- A string representing the line in which the call occurred
+ * @param format	- The printf style format of the message, followed by its arguments
+ * @return
+ * SP_LOGGER_INVAlID_ARGUMENT	- If format is null
+ * Otherwise, the result of the matching print function
+ */
+SP_LOGGER_MSG spLoggerPrintFormat(SP_LOGGER_LEVEL level, const char* file, const char* function,
+		const int line, const char* format, ...)
+#ifdef __GNUC__
+		__attribute__((format(printf, 5, 6)))
+#endif
+		;
+
 /**
  * Helper void method for printing [R] error messages
  *
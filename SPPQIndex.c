@@ -0,0 +1,286 @@
+/*
+ * SPPQIndex.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include "SPPQIndex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "SPListElement.h"
+#include "sp_algorithms.h"
+#include "sp_metrics.h"
+
+/*** Constants ***/
+
+/** The number of training samples per codebook centroid. */
+#define TRAINING_SAMPLES_PER_CENTROID 32
+
+/** The maximal number of k-means iterations of a codebook training. */
+#define KMEANS_ITERATIONS 20
+
+/*** Type declarations ***/
+
+/**
+ * Structure containing the PQ index data.
+ * Sub-quantizer m covers the coordinates [subspaceStarts[m], subspaceStarts[m + 1]), and its codebook
+ * (numOfCentroids rows of the sub-vector's dimension) starts at codebooks + numOfCentroids * subspaceStarts[m].
+ */
+struct sp_pq_index_t {
+	int dimension;
+	int numOfSubquantizers;
+	int numOfCentroids;
+	int *subspaceStarts;
+	double *codebooks;
+	int numOfFeatures;
+	unsigned char *codes;
+	int *imageIndices;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Allocates an index without its codebooks and codes, and splits the dimension to the sub-quantizers as evenly as
+ * possible.
+ */
+SPPQIndex allocateIndex(int dimension, int numOfSubquantizers, int numOfCentroids, int numOfFeatures) {
+	int m;
+	SPPQIndex index = (SPPQIndex) malloc(sizeof(*index));
+	if (index == NULL) {
+		return NULL;
+	}
+	index->dimension = dimension;
+	index->numOfSubquantizers = numOfSubquantizers;
+	index->numOfCentroids = numOfCentroids;
+	index->numOfFeatures = numOfFeatures;
+	index->subspaceStarts = (int *) malloc((numOfSubquantizers + 1) * sizeof(int));
+	index->codebooks = (double *) malloc((size_t) numOfCentroids * dimension * sizeof(double));
+	index->codes = (unsigned char *) malloc((size_t) numOfFeatures * numOfSubquantizers);
+	index->imageIndices = (int *) malloc(numOfFeatures * sizeof(int));
+	if (index->subspaceStarts == NULL || index->codebooks == NULL || index->codes == NULL
+			|| index->imageIndices == NULL) {
+		spPQIndexDestroy(index);
+		return NULL;
+	}
+	for (m = 0; m <= numOfSubquantizers; m++) {
+		index->subspaceStarts[m] = m * dimension / numOfSubquantizers;
+	}
+	return index;
+}
+
+/**
+ * Copies the coordinates of the given point to the given vector.
+ */
+void copyCoordinates(SPPoint point, int dimension, double *vector) {
+	int i;
+	for (i = 0; i < dimension; i++) {
+		vector[i] = spPointGetAxisCoor(point, i);
+	}
+}
+
+/**
+ * Trains the codebook of every sub-quantizer with k-means, on a sample of the features spread evenly over them.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool trainCodebooks(SPPQIndex index, const SPPoint *features, int numOfSamples) {
+	int i, m, subspaceDimension;
+	double *samples = (double *) malloc((size_t) numOfSamples * index->dimension * sizeof(double));
+	double *subspaceSamples = (double *) malloc((size_t) numOfSamples * index->dimension * sizeof(double));
+	bool success = (samples != NULL && subspaceSamples != NULL);
+	for (i = 0; i < numOfSamples && success; i++) {
+		copyCoordinates(features[(size_t) i * index->numOfFeatures / numOfSamples], index->dimension,
+				samples + (size_t) i * index->dimension);
+	}
+	for (m = 0; m < index->numOfSubquantizers && success; m++) {
+		subspaceDimension = index->subspaceStarts[m + 1] - index->subspaceStarts[m];
+		for (i = 0; i < numOfSamples; i++) {
+			memcpy(subspaceSamples + (size_t) i * subspaceDimension,
+					samples + (size_t) i * index->dimension + index->subspaceStarts[m],
+					subspaceDimension * sizeof(double));
+		}
+		success = spKMeans(subspaceSamples, numOfSamples, subspaceDimension, index->numOfCentroids,
+				KMEANS_ITERATIONS, index->codebooks + (size_t) index->numOfCentroids * index->subspaceStarts[m]);
+	}
+	free(samples);
+	free(subspaceSamples);
+	return success;
+}
+
+/**
+ * Encodes every feature by the nearest centroid of each sub-quantizer.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool encodeFeatures(SPPQIndex index, const SPPoint *features) {
+	int i, m, subspaceStart;
+	double *vector = (double *) malloc(index->dimension * sizeof(double));
+	if (vector == NULL) {
+		return false;
+	}
+	for (i = 0; i < index->numOfFeatures; i++) {
+		copyCoordinates(features[i], index->dimension, vector);
+		for (m = 0; m < index->numOfSubquantizers; m++) {
+			subspaceStart = index->subspaceStarts[m];
+			index->codes[(size_t) i * index->numOfSubquantizers + m] = (unsigned char) spNearestCentroid(
+					index->codebooks + (size_t) index->numOfCentroids * subspaceStart, index->numOfCentroids,
+					index->subspaceStarts[m + 1] - subspaceStart, vector + subspaceStart, NULL);
+		}
+		index->imageIndices[i] = spPointGetIndex(features[i]);
+	}
+	free(vector);
+	return true;
+}
+
+/**
+ * Computes the lookup tables of the given query - the squared distance from the query's sub-vector of every
+ * sub-quantizer to every centroid of its codebook, numOfCentroids entries per sub-quantizer.
+ */
+void computeDistanceTables(SPPQIndex index, const double *query, double *tables) {
+	int m, k, j, subspaceStart, subspaceDimension;
+	const double *centroid;
+	double difference, distance;
+	for (m = 0; m < index->numOfSubquantizers; m++) {
+		subspaceStart = index->subspaceStarts[m];
+		subspaceDimension = index->subspaceStarts[m + 1] - subspaceStart;
+		centroid = index->codebooks + (size_t) index->numOfCentroids * subspaceStart;
+		for (k = 0; k < index->numOfCentroids; k++, centroid += subspaceDimension) {
+			distance = 0;
+			for (j = 0; j < subspaceDimension; j++) {
+				difference = query[subspaceStart + j] - centroid[j];
+				distance += difference * difference;
+			}
+			tables[m * index->numOfCentroids + k] = distance;
+		}
+	}
+}
+
+/*** Public Methods ***/
+
+SPPQIndex spPQIndexCreate(const SPPoint *features, int numOfFeatures, int numOfSubquantizers, SP_PQ_INDEX_MSG *msg) {
+	int i, dimension, numOfCentroids, numOfSamples;
+	SPPQIndex index;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (features == NULL || numOfFeatures <= 0 || numOfSubquantizers <= 0) {
+		*msg = SP_PQ_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	dimension = spPointGetDimension(features[0]);
+	for (i = 1; i < numOfFeatures; i++) {
+		if (spPointGetDimension(features[i]) != dimension) {
+			*msg = SP_PQ_INDEX_INVALID_ARGUMENT;
+			return NULL;
+		}
+	}
+	if (numOfSubquantizers > dimension) {
+		*msg = SP_PQ_INDEX_INVALID_ARGUMENT;
+		return NULL;
+	}
+	numOfCentroids = (numOfFeatures < SP_PQ_INDEX_MAX_CENTROIDS) ? numOfFeatures : SP_PQ_INDEX_MAX_CENTROIDS;
+	numOfSamples = numOfCentroids * TRAINING_SAMPLES_PER_CENTROID;
+	numOfSamples = (numOfFeatures < numOfSamples) ? numOfFeatures : numOfSamples;
+
+	index = allocateIndex(dimension, numOfSubquantizers, numOfCentroids, numOfFeatures);
+	if (index == NULL || !trainCodebooks(index, features, numOfSamples) || !encodeFeatures(index, features)) {
+		spPQIndexDestroy(index);
+		*msg = SP_PQ_INDEX_ALLOC_FAIL;
+		return NULL;
+	}
+	*msg = SP_PQ_INDEX_SUCCESS;
+	return index;
+}
+
+void spPQIndexDestroy(SPPQIndex index) {
+	if (index == NULL) {
+		return;
+	}
+	free(index->subspaceStarts);
+	free(index->codebooks);
+	free(index->codes);
+	free(index->imageIndices);
+	free(index);
+}
+
+int spPQIndexGetNumOfFeatures(SPPQIndex index) {
+	return (index == NULL) ? -1 : index->numOfFeatures;
+}
+
+int spPQIndexGetDimension(SPPQIndex index) {
+	return (index == NULL) ? -1 : index->dimension;
+}
+
+int spPQIndexGetNumOfSubquantizers(SPPQIndex index) {
+	return (index == NULL) ? -1 : index->numOfSubquantizers;
+}
+
+size_t spPQIndexGetCodesSize(SPPQIndex index) {
+	if (index == NULL) {
+		return 0;
+	}
+	return (size_t) index->numOfFeatures * (index->numOfSubquantizers + sizeof(*index->imageIndices));
+}
+
+SP_PQ_INDEX_MSG spPQIndexKNearestNeighbours(SPPQIndex index, SPBPQueue queue, SPPoint point) {
+	if (index == NULL) {
+		return SP_PQ_INDEX_INVALID_ARGUMENT;
+	}
+	return spPQIndexKNearestNeighboursInRange(index, queue, point, 0, index->numOfFeatures);
+}
+
+SP_PQ_INDEX_MSG spPQIndexKNearestNeighboursInRange(SPPQIndex index, SPBPQueue queue, SPPoint point, int begin,
+		int end) {
+	int i, m, numOfSubquantizers;
+	double *query, *tables, distance, maxQueueValue;
+	const unsigned char *code;
+	SPListElement element;
+	if (index == NULL || queue == NULL || point == NULL || spPointGetDimension(point) != index->dimension
+			|| begin < 0 || end < begin || end > index->numOfFeatures) {
+		return SP_PQ_INDEX_INVALID_ARGUMENT;
+	}
+	query = (double *) malloc(index->dimension * sizeof(double));
+	tables = (double *) malloc((size_t) index->numOfSubquantizers * index->numOfCentroids * sizeof(double));
+	if (query == NULL || tables == NULL) {
+		free(query);
+		free(tables);
+		return SP_PQ_INDEX_ALLOC_FAIL;
+	}
+	// The scan of the codes takes the place of the tree traversal
+	SP_METRICS_TIMER_START(traversalTimer);
+	copyCoordinates(point, index->dimension, query);
+	computeDistanceTables(index, query, tables);
+	numOfSubquantizers = index->numOfSubquantizers;
+	maxQueueValue = spBPQueueIsFull(queue) ? spBPQueueMaxValue(queue) : INFINITY;
+	code = index->codes + (size_t) begin * numOfSubquantizers;
+	for (i = begin; i < end; i++, code += numOfSubquantizers) {
+		distance = 0;
+		for (m = 0; m < numOfSubquantizers; m++) {
+			distance += tables[m * index->numOfCentroids + code[m]];
+		}
+		// Most of the features are farther than the queued ones, and are not enqueued at all
+		if (distance >= maxQueueValue) {
+			continue;
+		}
+		element = spListElementCreate(index->imageIndices[i], distance);
+		if (element == NULL || spBPQueueEnqueue(queue, element) == SP_BPQUEUE_OUT_OF_MEMORY) {
+			spListElementDestroy(element);
+			free(query);
+			free(tables);
+			return SP_PQ_INDEX_ALLOC_FAIL;
+		}
+		spListElementDestroy(element);
+		if (spBPQueueIsFull(queue)) {
+			maxQueueValue = spBPQueueMaxValue(queue);
+		}
+	}
+	SP_METRICS_TIMER_STOP(traversalTimer, SP_METRICS_TREE_TRAVERSAL);
+	SP_METRICS_COUNT(SP_METRICS_DISTANCE_COMPUTATIONS, end - begin);
+	free(query);
+	free(tables);
+	return SP_PQ_INDEX_SUCCESS;
+}
@@ -0,0 +1,152 @@
+/*
+ * SPPQIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPPQINDEX_H_
+#define SPPQINDEX_H_
+
+#include <stddef.h>
+#include "SPPoint.h"
+#include "SPBPriorityQueue.h"
+
+/**
+ * Implementation of a product quantization (PQ) index of features.
+ *
+ * Every feature is split to M consecutive sub-vectors (the sub-quantizers), and every sub-vector is encoded by the
+ * index of its nearest centroid in the sub-quantizer's codebook - a single byte, as a codebook has at most 256
+ * centroids. The codebooks are trained with k-means on a sample of the indexed features. So a feature takes M bytes
+ * (and the index of its image) instead of its dimension doubles.
+ *
+ * The nearest neighbors of a query are searched with asymmetric distance computation: the query is not encoded,
+ * but the squared distances from each of its sub-vectors to all of the centroids of the sub-quantizer are
+ * computed once per query, into lookup tables. The approximate squared distance to every indexed feature is then
+ * the sum of M table lookups. The search scans all of the indexed features.
+ *
+ * The index is read-only once created, so it can be searched by many threads at once.
+ *
+ * The following functions are available:
+ *
+ * 		spPQIndexCreate						- Trains the codebooks and encodes the given features.
+ * 		spPQIndexDestroy					- Deallocates the index.
+ * 		spPQIndexGetNumOfFeatures			- Returns the number of indexed features.
+ * 		spPQIndexGetDimension				- Returns the dimension of the indexed features.
+ * 		spPQIndexGetNumOfSubquantizers		- Returns the number of sub-quantizers.
+ * 		spPQIndexGetCodesSize				- Returns the number of bytes the encoded features take.
+ * 		spPQIndexKNearestNeighbours			- Fills a queue with the nearest features to a query.
+ * 		spPQIndexKNearestNeighboursInRange	- Fills a queue with the nearest features of a range to a query.
+ */
+
+/** Type for defining the PQ index. */
+typedef struct sp_pq_index_t *SPPQIndex;
+
+/** Enumeration to inform result of PQ index method calls. */
+typedef enum sp_pq_index_msg_t {
+	SP_PQ_INDEX_INVALID_ARGUMENT,
+	SP_PQ_INDEX_ALLOC_FAIL,
+	SP_PQ_INDEX_SUCCESS
+} SP_PQ_INDEX_MSG;
+
+/** The maximal number of centroids of a sub-quantizer, as a code is a single byte. */
+#define SP_PQ_INDEX_MAX_CENTROIDS 256
+
+/**
+ * Creates a PQ index of the given features - trains the codebooks on a sample of the features, and encodes
+ * all of them. The features are not kept by the index, so they can be destroyed once it is created.
+ *
+ * @param features The features to index, all of the same dimension. The index of each feature is the index of
+ * 		its image, which is the index of the neighbors found for it.
+ * @param numOfFeatures The number of features.
+ * @param numOfSubquantizers The number of sub-quantizers, at most the dimension of the features.
+ * @param msg Place-holder for the SP_PQ_INDEX_MSG informing the result:
+ * 		SP_PQ_INDEX_INVALID_ARGUMENT	- In case features or msg is NULL, numOfFeatures is non-positive, the features
+ * 										  are not of the same dimension, or the number of sub-quantizers is
+ * 										  non-positive or larger than the dimension.
+ * 		SP_PQ_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 		SP_PQ_INDEX_SUCCESS				- Otherwise.
+ *
+ * @return
+ * 	NULL in case of failure, the index otherwise.
+ */
+SPPQIndex spPQIndexCreate(const SPPoint *features, int numOfFeatures, int numOfSubquantizers, SP_PQ_INDEX_MSG *msg);
+
+/**
+ * Deallocates the given index. If index is NULL nothing is done.
+ *
+ * @param index The index to deallocate.
+ */
+void spPQIndexDestroy(SPPQIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of indexed features otherwise.
+ */
+int spPQIndexGetNumOfFeatures(SPPQIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the dimension of the indexed features otherwise.
+ */
+int spPQIndexGetDimension(SPPQIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	-1 if index is NULL, the number of sub-quantizers (bytes per encoded feature) otherwise.
+ */
+int spPQIndexGetNumOfSubquantizers(SPPQIndex index);
+
+/**
+ * Returns the number of bytes the encoded features take - their codes and their images indices - which is the
+ * memory the index takes per feature, apart from the codebooks which do not depend on the number of features.
+ *
+ * @param index The index.
+ *
+ * @return
+ * 	0 if index is NULL, the size of the encoded features otherwise.
+ */
+size_t spPQIndexGetCodesSize(SPPQIndex index);
+
+/**
+ * Fills the given queue with the indexed features nearest to the given point, by their approximate squared
+ * distances (see asymmetric distance computation above). Every element of the queue is the index of a feature's
+ * image, with the approximate squared distance as its value.
+ *
+ * @param index The index to search in.
+ * @param queue The priority queue to hold the nearest neighbors.
+ * @param point The feature to search for its nearest neighbors.
+ *
+ * @return
+ * 	SP_PQ_INDEX_INVALID_ARGUMENT	- In case any argument is NULL or the point is not of the index's dimension.
+ * 	SP_PQ_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 	SP_PQ_INDEX_SUCCESS				- Otherwise.
+ */
+SP_PQ_INDEX_MSG spPQIndexKNearestNeighbours(SPPQIndex index, SPBPQueue queue, SPPoint point);
+
+/**
+ * As spPQIndexKNearestNeighbours, searching only the features [begin, end) of the features the index was created
+ * with (in their order). Features nearer to the point than the ones already in the queue are added to it.
+ *
+ * @param index The index to search in.
+ * @param queue The priority queue to hold the nearest neighbors.
+ * @param point The feature to search for its nearest neighbors.
+ * @param begin The first searched feature.
+ * @param end The feature following the last searched feature.
+ *
+ * @return
+ * 	SP_PQ_INDEX_INVALID_ARGUMENT	- In case any argument is NULL, the point is not of the index's dimension, or
+ * 									  the range is not a range of the indexed features.
+ * 	SP_PQ_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 	SP_PQ_INDEX_SUCCESS				- Otherwise.
+ */
+SP_PQ_INDEX_MSG spPQIndexKNearestNeighboursInRange(SPPQIndex index, SPBPQueue queue, SPPoint point, int begin,
+		int end);
+
+#endif /* SPPQINDEX_H_ */
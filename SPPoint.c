@@ -3,41 +3,60 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define ZERO 0
 
+// The points created by spPointCreateBlock, followed by the points themselves
+typedef struct sp_point_block_t {
+	unsigned long references; //The points of the block which were not destroyed yet
+	double points[]; //Where the points start, aligned as their coordinates
+} SPPointBlock;
+
+// The coordinates are allocated together with the point, so a point is a single allocation
+// (or a part of the single allocation of its block)
 struct sp_point_t {
-	double* pData;
+	SPPointBlock* block; //The block of the point, NULL for a point allocated on its own
 	int index;
 	int dim;
+	double pData[];
 };
 
 SPPoint spPointCreate(double* data, int dim, int index) {
 	assert(!(data == NULL || dim <= ZERO  || index < ZERO));
 
-	SPPoint createdPoint = (SPPoint) malloc(sizeof(*createdPoint));
+	SPPoint createdPoint = (SPPoint) malloc(sizeof(*createdPoint) + dim * sizeof(double));
 	if (createdPoint == NULL) {
 		return NULL;
 	}
 
-	double* pointData = (double*) malloc(dim * sizeof(double));
-	if (pointData == NULL) {
-		free(createdPoint);
-		return NULL;
-	}
-
-	int i;
-	for (i = 0; i < dim; i++){
-		pointData[i] = data[i];
-	}
-
-	createdPoint->pData = pointData;
+	memcpy(createdPoint->pData, data, dim * sizeof(double));
+	createdPoint->block = NULL;
 	createdPoint->index = index;
 	createdPoint->dim = dim;
 	return createdPoint;
 
 }
 
+double* spPointCreateBlock(SPPoint* points, int count, int dim, int index, size_t* stride) {
+	assert(!(points == NULL || count <= ZERO || dim <= ZERO || index < ZERO || stride == NULL));
+	size_t pointSize = sizeof(struct sp_point_t) + dim * sizeof(double);
+	SPPointBlock* block = (SPPointBlock*) malloc(sizeof(*block) + count * pointSize);
+	int i;
+	if (block == NULL) {
+		return NULL;
+	}
+	block->references = count;
+	for (i = 0; i < count; i++) {
+		points[i] = (SPPoint) ((char*) block->points + i * pointSize);
+		points[i]->block = block;
+		points[i]->index = index;
+		points[i]->dim = dim;
+	}
+	*stride = pointSize;
+	return points[0]->pData;
+}
+
 SPPoint spPointCopy(SPPoint source) {
 	assert(source != NULL);
 	SPPoint copyPoint = spPointCreate(source->pData, source->dim, source->index);
@@ -45,10 +64,11 @@ SPPoint spPointCopy(SPPoint source) {
 }
 
 void spPointDestroy(SPPoint point) {
-	if (point != NULL){
-		free(point->pData);
+	if (point == NULL || point->block == NULL) {
+		free(point);
+	} else if (__atomic_sub_fetch(&point->block->references, 1, __ATOMIC_ACQ_REL) == 0) {
+		free(point->block); //The points of a block may be destroyed by different threads
 	}
-	free(point);
 }
 
 int spPointGetDimension(SPPoint point)  {
@@ -1,5 +1,6 @@
 #ifndef SPPOINT_H_
 #define SPPOINT_H_
+#include <stddef.h>
 
 /**
  * SPPoint Summary
@@ -10,6 +11,7 @@
  * The following functions are supported:
  *
  * spPointCreate        	- Creates a new point
+ * spPointCreateBlock		- Creates points whose coordinates are written in place
  * spPointCopy				- Create a new copy of a given point
  * spPointDestroy 			- Free all resources associated with a point
  * spPointGetDimension		- A getter of the dimension of a point
@@ -38,6 +40,29 @@ typedef struct sp_point_t* SPPoint;
  */
 SPPoint spPointCreate(double* data, int dim, int index);
 
+/**
+ * Allocates count points of dimension dim with the given index, as a single
+ * allocation which is freed once all of the points were destroyed. Each point
+ * is destroyed with spPointDestroy, as any other point.
+ *
+ * The coordinates are not initialized - the caller writes them in place, before
+ * the points are used. The coordinates of the ith point are the dim doubles
+ * starting at coordinates + i * stride / sizeof(double), where coordinates is
+ * the returned pointer.
+ *
+ * @param points - An array of count points, which receives the new points
+ * @param count  - The number of points
+ * @param dim    - The dimension of the points
+ * @param index  - The index of the points
+ * @param stride - Receives the distance, in bytes, between the coordinates of consecutive points.
+ * 				   It is a multiple of sizeof(double).
+ * @assert points != NULL && count > 0 && dim > 0 && index >= 0 && stride != NULL
+ * @return
+ * NULL in case allocation failure ocurred
+ * Otherwise, the coordinates of the first point
+ */
+double* spPointCreateBlock(SPPoint* points, int count, int dim, int index, size_t* stride);
+
 /**
  * Allocates a copy of the given point.
  *
@@ -0,0 +1,152 @@
+/*
+ * SPSearchIndex.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include "SPSearchIndex.h"
+#include <stdlib.h>
+#include "sp_algorithms.h"
+
+/*** Type declarations ***/
+
+/** Structure containing the search index - its type, and the data-structure of that type. */
+struct sp_search_index_t {
+	SP_SEARCH_INDEX_TYPE type;
+	union {
+		SPKDTreeNode tree;
+		SPPQIndex pqIndex;
+		SPIVFIndex ivfIndex;
+		SPHNSWIndex hnswIndex;
+	} data;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Allocates an index of the given type, whose data-structure is set by the caller.
+ */
+SPSearchIndex allocateSearchIndex(SP_SEARCH_INDEX_TYPE type) {
+	SPSearchIndex index = (SPSearchIndex) malloc(sizeof(*index));
+	if (index != NULL) {
+		index->type = type;
+	}
+	return index;
+}
+
+/*** Public Methods ***/
+
+SPSearchIndex spSearchIndexCreateKDTree(SPKDTreeNode tree) {
+	SPSearchIndex index;
+	if (tree == NULL) {
+		return NULL;
+	}
+	index = allocateSearchIndex(SEARCH_INDEX_KD_TREE);
+	if (index != NULL) {
+		index->data.tree = tree;
+	}
+	return index;
+}
+
+SPSearchIndex spSearchIndexCreatePQ(SPPQIndex pqIndex) {
+	SPSearchIndex index;
+	if (pqIndex == NULL) {
+		return NULL;
+	}
+	index = allocateSearchIndex(SEARCH_INDEX_PQ);
+	if (index != NULL) {
+		index->data.pqIndex = pqIndex;
+	}
+	return index;
+}
+
+SPSearchIndex spSearchIndexCreateIVF(SPIVFIndex ivfIndex) {
+	SPSearchIndex index;
+	if (ivfIndex == NULL) {
+		return NULL;
+	}
+	index = allocateSearchIndex(spIVFIndexIsQuantized(ivfIndex) ? SEARCH_INDEX_IVF_PQ : SEARCH_INDEX_IVF);
+	if (index != NULL) {
+		index->data.ivfIndex = ivfIndex;
+	}
+	return index;
+}
+
+SPSearchIndex spSearchIndexCreateHNSW(SPHNSWIndex hnswIndex) {
+	SPSearchIndex index;
+	if (hnswIndex == NULL) {
+		return NULL;
+	}
+	index = allocateSearchIndex(SEARCH_INDEX_HNSW);
+	if (index != NULL) {
+		index->data.hnswIndex = hnswIndex;
+	}
+	return index;
+}
+
+void spSearchIndexDestroy(SPSearchIndex index) {
+	if (index == NULL) {
+		return;
+	}
+	switch (index->type) {
+	case SEARCH_INDEX_KD_TREE:
+		spKDTreeDestroy(index->data.tree);
+		break;
+	case SEARCH_INDEX_PQ:
+		spPQIndexDestroy(index->data.pqIndex);
+		break;
+	case SEARCH_INDEX_IVF:
+	case SEARCH_INDEX_IVF_PQ:
+		spIVFIndexDestroy(index->data.ivfIndex);
+		break;
+	case SEARCH_INDEX_HNSW:
+		spHNSWIndexDestroy(index->data.hnswIndex);
+		break;
+	}
+	free(index);
+}
+
+SP_SEARCH_INDEX_TYPE spSearchIndexGetType(SPSearchIndex index) {
+	return (index == NULL) ? SEARCH_INDEX_KD_TREE : index->type;
+}
+
+SP_SEARCH_INDEX_MSG spSearchIndexKNearestNeighbours(SPSearchIndex index, SPBPQueue queue, SPPoint point) {
+	if (index == NULL || queue == NULL || point == NULL) {
+		return SP_SEARCH_INDEX_INVALID_ARGUMENT;
+	}
+	switch (index->type) {
+	case SEARCH_INDEX_KD_TREE:
+		spKNearestNeighbours(index->data.tree, queue, point);
+		return SP_SEARCH_INDEX_SUCCESS;
+	case SEARCH_INDEX_PQ:
+		switch (spPQIndexKNearestNeighbours(index->data.pqIndex, queue, point)) {
+		case SP_PQ_INDEX_SUCCESS:
+			return SP_SEARCH_INDEX_SUCCESS;
+		case SP_PQ_INDEX_ALLOC_FAIL:
+			return SP_SEARCH_INDEX_ALLOC_FAIL;
+		default:
+			return SP_SEARCH_INDEX_INVALID_ARGUMENT;
+		}
+	case SEARCH_INDEX_IVF:
+	case SEARCH_INDEX_IVF_PQ:
+		switch (spIVFIndexKNearestNeighbours(index->data.ivfIndex, queue, point)) {
+		case SP_IVF_INDEX_SUCCESS:
+			return SP_SEARCH_INDEX_SUCCESS;
+		case SP_IVF_INDEX_ALLOC_FAIL:
+			return SP_SEARCH_INDEX_ALLOC_FAIL;
+		default:
+			return SP_SEARCH_INDEX_INVALID_ARGUMENT;
+		}
+	case SEARCH_INDEX_HNSW:
+		switch (spHNSWIndexKNearestNeighbours(index->data.hnswIndex, queue, point)) {
+		case SP_HNSW_INDEX_SUCCESS:
+			return SP_SEARCH_INDEX_SUCCESS;
+		case SP_HNSW_INDEX_ALLOC_FAIL:
+			return SP_SEARCH_INDEX_ALLOC_FAIL;
+		default:
+			return SP_SEARCH_INDEX_INVALID_ARGUMENT;
+		}
+	}
+	return SP_SEARCH_INDEX_INVALID_ARGUMENT;
+}
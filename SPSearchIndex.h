@@ -0,0 +1,125 @@
+/*
+ * SPSearchIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPSEARCHINDEX_H_
+#define SPSEARCHINDEX_H_
+
+#include "SPConfig.h"
+#include "SPPoint.h"
+#include "SPBPriorityQueue.h"
+#include "SPKDTree.h"
+#include "SPPQIndex.h"
+#include "SPIVFIndex.h"
+#include "SPHNSWIndex.h"
+
+/**
+ * An index of the images features, which the nearest neighbors of the query features are searched in.
+ * The index is one of the index types of SP_SEARCH_INDEX_TYPE (see spConfigGetSearchIndex), and is searched the same
+ * way whatever its type is, so the voting on the nearest neighbors does not depend on it.
+ *
+ * The index owns the underlying data-structure it is created with, and destroys it when it is destroyed.
+ * Searching does not modify the index, so it can be searched by many threads at once.
+ *
+ * The following functions are available:
+ *
+ * 		spSearchIndexCreateKDTree			- Creates an index of a kd-tree.
+ * 		spSearchIndexCreatePQ				- Creates an index of a PQ index.
+ * 		spSearchIndexCreateIVF				- Creates an index of an IVF index.
+ * 		spSearchIndexCreateHNSW				- Creates an index of an HNSW index.
+ * 		spSearchIndexDestroy				- Deallocates the index and its data-structure.
+ * 		spSearchIndexGetType				- Returns the type of the index.
+ * 		spSearchIndexKNearestNeighbours		- Fills a queue with the nearest features to a query.
+ */
+
+/** Type for defining the search index. */
+typedef struct sp_search_index_t *SPSearchIndex;
+
+/** Enumeration to inform result of search index method calls. */
+typedef enum sp_search_index_msg_t {
+	SP_SEARCH_INDEX_INVALID_ARGUMENT,
+	SP_SEARCH_INDEX_ALLOC_FAIL,
+	SP_SEARCH_INDEX_SUCCESS
+} SP_SEARCH_INDEX_MSG;
+
+/**
+ * Creates an index of the given kd-tree, which the index takes the ownership of.
+ *
+ * @param tree The kd-tree.
+ *
+ * @return
+ * 	NULL if tree is NULL or in case of allocation failure (in which case the tree is left to the caller),
+ * 	the index otherwise.
+ */
+SPSearchIndex spSearchIndexCreateKDTree(SPKDTreeNode tree);
+
+/**
+ * Creates an index of the given PQ index, which the index takes the ownership of.
+ *
+ * @param pqIndex The PQ index.
+ *
+ * @return
+ * 	NULL if pqIndex is NULL or in case of allocation failure (in which case the PQ index is left to the caller),
+ * 	the index otherwise.
+ */
+SPSearchIndex spSearchIndexCreatePQ(SPPQIndex pqIndex);
+
+/**
+ * Creates an index of the given IVF index, which the index takes the ownership of. The type of the index is
+ * SEARCH_INDEX_IVF_PQ if the features of the IVF index are quantized, SEARCH_INDEX_IVF otherwise.
+ *
+ * @param ivfIndex The IVF index.
+ *
+ * @return
+ * 	NULL if ivfIndex is NULL or in case of allocation failure (in which case the IVF index is left to the caller),
+ * 	the index otherwise.
+ */
+SPSearchIndex spSearchIndexCreateIVF(SPIVFIndex ivfIndex);
+
+/**
+ * Creates an index of the given HNSW index, which the index takes the ownership of.
+ *
+ * @param hnswIndex The HNSW index.
+ *
+ * @return
+ * 	NULL if hnswIndex is NULL or in case of allocation failure (in which case the HNSW index is left to the
+ * 	caller), the index otherwise.
+ */
+SPSearchIndex spSearchIndexCreateHNSW(SPHNSWIndex hnswIndex);
+
+/**
+ * Deallocates the given index, together with its underlying data-structure. If index is NULL nothing is done.
+ *
+ * @param index The index to deallocate.
+ */
+void spSearchIndexDestroy(SPSearchIndex index);
+
+/**
+ * @param index The index.
+ *
+ * @return
+ * 	The type of the index, SEARCH_INDEX_KD_TREE if index is NULL.
+ */
+SP_SEARCH_INDEX_TYPE spSearchIndexGetType(SPSearchIndex index);
+
+/**
+ * Fills the given queue with the indexed features nearest to the given point. Every element of the queue is the
+ * index of a feature's image, with the squared distance from the point (approximated, for a quantized index) as its
+ * value. An IVF index searches only the features of its probed lists, and an HNSW index only the nodes its graph
+ * search reaches.
+ *
+ * @param index The index to search in.
+ * @param queue The priority queue to hold the nearest neighbors.
+ * @param point The feature to search for its nearest neighbors.
+ *
+ * @return
+ * 	SP_SEARCH_INDEX_INVALID_ARGUMENT	- In case any argument is NULL or the point is not of the indexed dimension.
+ * 	SP_SEARCH_INDEX_ALLOC_FAIL			- In case of allocation failure.
+ * 	SP_SEARCH_INDEX_SUCCESS				- Otherwise.
+ */
+SP_SEARCH_INDEX_MSG spSearchIndexKNearestNeighbours(SPSearchIndex index, SPBPQueue queue, SPPoint point);
+
+#endif /* SPSEARCHINDEX_H_ */
@@ -0,0 +1,194 @@
+/*
+ * SPThreadPool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include "SPThreadPool.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+/*** Inner implementation type declarations ***/
+
+/** Structure containing a submitted job and its argument. */
+typedef struct pending_job_t {
+	SPThreadPoolJob job;
+	void *arg;
+} PendingJob;
+
+/** Structure given to each worker thread - its pool and its index. */
+typedef struct worker_context_t {
+	SPThreadPool pool;
+	int index;
+} WorkerContext;
+
+/*** Type declarations ***/
+
+/** Structure containing the thread pool data. */
+struct sp_thread_pool_t {
+	pthread_t *threads;
+	WorkerContext *contexts;
+	int numOfThreads;
+	PendingJob *queue;
+	int queueCapacity;
+	int queueHead;
+	int queueSize;
+	int runningJobs;
+	bool stopping;
+	pthread_mutex_t mutex;
+	pthread_cond_t jobAvailable;
+	pthread_cond_t roomAvailable;
+	pthread_cond_t allDone;
+};
+
+/*** Private Methods ***/
+
+/**
+ * The worker threads routine - takes jobs from the queue and executes them, until the pool is stopping and
+ * there are no more queued jobs.
+ *
+ * @param arg The worker's context.
+ *
+ * @return NULL.
+ */
+void *workerRoutine(void *arg) {
+	WorkerContext *context = (WorkerContext *) arg;
+	SPThreadPool pool = context->pool;
+	PendingJob pendingJob;
+	pthread_mutex_lock(&pool->mutex);
+	while (true) {
+		while (pool->queueSize == 0 && !pool->stopping) {
+			pthread_cond_wait(&pool->jobAvailable, &pool->mutex);
+		}
+		if (pool->queueSize == 0) {
+			// Stopping, and no more jobs
+			break;
+		}
+		pendingJob = pool->queue[pool->queueHead];
+		pool->queueHead = (pool->queueHead + 1) % pool->queueCapacity;
+		pool->queueSize--;
+		pool->runningJobs++;
+		pthread_cond_signal(&pool->roomAvailable);
+		pthread_mutex_unlock(&pool->mutex);
+
+		pendingJob.job(pendingJob.arg, context->index);
+
+		pthread_mutex_lock(&pool->mutex);
+		pool->runningJobs--;
+		if (pool->queueSize == 0 && pool->runningJobs == 0) {
+			pthread_cond_broadcast(&pool->allDone);
+		}
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+/**
+ * Stops the first given amount of worker threads, and deallocates the pool.
+ *
+ * @param pool The pool to deallocate.
+ * @param numOfStartedThreads The number of worker threads which were started.
+ */
+void stopAndDestroyPool(SPThreadPool pool, int numOfStartedThreads) {
+	int i;
+	pthread_mutex_lock(&pool->mutex);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->jobAvailable);
+	pthread_mutex_unlock(&pool->mutex);
+	for (i = 0; i < numOfStartedThreads; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->jobAvailable);
+	pthread_cond_destroy(&pool->roomAvailable);
+	pthread_cond_destroy(&pool->allDone);
+	free(pool->threads);
+	free(pool->contexts);
+	free(pool->queue);
+	free(pool);
+}
+
+/*** Public Methods ***/
+
+SPThreadPool spThreadPoolCreate(int numOfThreads, int queueCapacity) {
+	int i;
+	SPThreadPool pool;
+	if (numOfThreads <= 0 || queueCapacity <= 0) {
+		return NULL;
+	}
+	pool = (SPThreadPool) malloc(sizeof(*pool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	pool->threads = (pthread_t *) malloc(numOfThreads * sizeof(pthread_t));
+	pool->contexts = (WorkerContext *) malloc(numOfThreads * sizeof(WorkerContext));
+	pool->queue = (PendingJob *) malloc(queueCapacity * sizeof(PendingJob));
+	if (pool->threads == NULL || pool->contexts == NULL || pool->queue == NULL) {
+		free(pool->threads);
+		free(pool->contexts);
+		free(pool->queue);
+		free(pool);
+		return NULL;
+	}
+	pool->numOfThreads = numOfThreads;
+	pool->queueCapacity = queueCapacity;
+	pool->queueHead = 0;
+	pool->queueSize = 0;
+	pool->runningJobs = 0;
+	pool->stopping = false;
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->jobAvailable, NULL);
+	pthread_cond_init(&pool->roomAvailable, NULL);
+	pthread_cond_init(&pool->allDone, NULL);
+	for (i = 0; i < numOfThreads; i++) {
+		pool->contexts[i].pool = pool;
+		pool->contexts[i].index = i;
+		if (pthread_create(&pool->threads[i], NULL, workerRoutine, &pool->contexts[i]) != 0) {
+			stopAndDestroyPool(pool, i);
+			return NULL;
+		}
+	}
+	return pool;
+}
+
+void spThreadPoolDestroy(SPThreadPool pool) {
+	if (pool == NULL) {
+		return;
+	}
+	// The workers execute all of the queued jobs before they stop
+	stopAndDestroyPool(pool, pool->numOfThreads);
+}
+
+SP_THREAD_POOL_MSG spThreadPoolSubmit(SPThreadPool pool, SPThreadPoolJob job, void *arg) {
+	int tail;
+	if (pool == NULL || job == NULL) {
+		return SP_THREAD_POOL_INVALID_ARGUMENT;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->queueSize == pool->queueCapacity) {
+		pthread_cond_wait(&pool->roomAvailable, &pool->mutex);
+	}
+	tail = (pool->queueHead + pool->queueSize) % pool->queueCapacity;
+	pool->queue[tail].job = job;
+	pool->queue[tail].arg = arg;
+	pool->queueSize++;
+	pthread_cond_signal(&pool->jobAvailable);
+	pthread_mutex_unlock(&pool->mutex);
+	return SP_THREAD_POOL_SUCCESS;
+}
+
+void spThreadPoolWait(SPThreadPool pool) {
+	if (pool == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->queueSize > 0 || pool->runningJobs > 0) {
+		pthread_cond_wait(&pool->allDone, &pool->mutex);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+int spThreadPoolGetNumOfThreads(SPThreadPool pool) {
+	return pool == NULL ? -1 : pool->numOfThreads;
+}
@@ -0,0 +1,97 @@
+/*
+ * SPThreadPool.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SPTHREADPOOL_H_
+#define SPTHREADPOOL_H_
+
+#include <stdbool.h>
+
+/**
+ * Implementation of a fixed size thread pool.
+ *
+ * The pool runs a fixed number of worker threads, which execute the submitted jobs in their submission order.
+ * Submitted jobs wait in a bounded queue - submitting a job to a full queue blocks until one of the queued jobs
+ * is taken by a worker, so a fast producer can not flood the memory with pending jobs.
+ *
+ * Every job is given the index of the worker which executes it (in the range [0, numOfThreads)), so jobs can
+ * use per-worker resources (such as a hits accumulator) without any locking.
+ *
+ * The following functions are available:
+ *
+ * 		spThreadPoolCreate				- Creates a new pool and starts its worker threads.
+ * 		spThreadPoolDestroy				- Waits for all of the submitted jobs, stops the workers and deallocates the pool.
+ * 		spThreadPoolSubmit				- Submits a job to the pool.
+ * 		spThreadPoolWait				- Waits until all of the submitted jobs are done.
+ * 		spThreadPoolGetNumOfThreads		- Returns the number of worker threads.
+ */
+
+/** Type for defining the thread pool. */
+typedef struct sp_thread_pool_t *SPThreadPool;
+
+/**
+ * Type of a job executed by the pool.
+ * 	- First parameter is the argument given on submission.
+ * 	- Second parameter is the index of the executing worker.
+ */
+typedef void (*SPThreadPoolJob)(void *, int);
+
+/** Enumeration to inform result of thread pool method calls. */
+typedef enum sp_thread_pool_msg_t {
+	SP_THREAD_POOL_INVALID_ARGUMENT,
+	SP_THREAD_POOL_SUCCESS
+} SP_THREAD_POOL_MSG;
+
+/**
+ * Allocates a new thread pool and starts its worker threads.
+ *
+ * @param numOfThreads The number of worker threads.
+ * @param queueCapacity The maximal number of submitted jobs which are waiting for a worker.
+ *
+ * @return
+ * 	NULL - If numOfThreads or queueCapacity is non-positive, allocations failed or a thread could not be started.
+ * 	A new thread pool in case of success.
+ */
+SPThreadPool spThreadPoolCreate(int numOfThreads, int queueCapacity);
+
+/**
+ * Waits for all of the submitted jobs to be done, stops the worker threads and deallocates the pool.
+ *
+ * @param pool The pool to deallocate. If NULL nothing is done.
+ */
+void spThreadPoolDestroy(SPThreadPool pool);
+
+/**
+ * Submits a job to the pool. In case the jobs queue is full, blocks until there is room in it.
+ *
+ * @param pool The pool to submit the job to.
+ * @param job The job to execute.
+ * @param arg The argument to execute the job with.
+ *
+ * @return
+ * 	SP_THREAD_POOL_INVALID_ARGUMENT	- If pool or job is NULL.
+ * 	SP_THREAD_POOL_SUCCESS			- Otherwise.
+ */
+SP_THREAD_POOL_MSG spThreadPoolSubmit(SPThreadPool pool, SPThreadPoolJob job, void *arg);
+
+/**
+ * Waits until all of the jobs which were submitted to the pool are done.
+ *
+ * @param pool The pool to wait for. If NULL nothing is done.
+ */
+void spThreadPoolWait(SPThreadPool pool);
+
+/**
+ * Returns the number of worker threads of the pool.
+ *
+ * @param pool The queried pool.
+ *
+ * @return
+ * 	-1 if the pool is NULL, the number of worker threads otherwise.
+ */
+int spThreadPoolGetNumOfThreads(SPThreadPool pool);
+
+#endif /* SPTHREADPOOL_H_ */
@@ -0,0 +1,216 @@
+/*
+ * benchmark_util.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "benchmark_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*** Constants ***/
+
+#define PI 3.14159265358979323846
+#define USAGE "Usage: %s [-n <size>] [-w <warmup runs>] [-r <measured runs>] [-s <seed>]\n"
+
+/*** Private Variables ***/
+
+/** The state of the xorshift pseudo-random generator - must never be zero. */
+static uint64_t randomState = 88172645463325252ULL;
+
+/*** Private Methods ***/
+
+/**
+ * Advances the xorshift generator and returns its next 64 bits value.
+ */
+uint64_t nextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return randomState;
+}
+
+/**
+ * Comparator of run times, for sorting.
+ */
+int compareMillis(const void *first, const void *second) {
+	double a = *(const double *) first, b = *(const double *) second;
+	return (a > b) - (a < b);
+}
+
+/**
+ * Runs the given case once.
+ *
+ * @return
+ * 	The elapsed milliseconds, or a negative value if the setup failed.
+ */
+double runOnce(const SPBenchmarkCase *benchmarkCase, void *context, long *operations) {
+	double start, elapsed;
+	if (benchmarkCase->setup != NULL && !benchmarkCase->setup(context)) {
+		return -1;
+	}
+	start = spBenchmarkTimeMillis();
+	*operations = benchmarkCase->run(context);
+	elapsed = spBenchmarkTimeMillis() - start;
+	if (benchmarkCase->teardown != NULL) {
+		benchmarkCase->teardown(context);
+	}
+	return elapsed;
+}
+
+/*** Public Methods ***/
+
+double spBenchmarkTimeMillis() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+void spBenchmarkRandomSeed(unsigned int seed) {
+	int i;
+	randomState = 88172645463325252ULL ^ ((uint64_t) seed * 0x9E3779B97F4A7C15ULL);
+	if (randomState == 0) {
+		randomState = 88172645463325252ULL;
+	}
+	// Mix the seed into the whole state
+	for (i = 0; i < 8; i++) {
+		nextRandom();
+	}
+}
+
+int spBenchmarkRandomInt(int bound) {
+	return (int) (nextRandom() % (uint64_t) bound);
+}
+
+double spBenchmarkRandomUniform() {
+	// The 53 high bits fill a double's mantissa
+	return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double spBenchmarkRandomGaussian(double sigma) {
+	// Box-Muller transform, 1 - u is never zero
+	double u = 1 - spBenchmarkRandomUniform();
+	double v = spBenchmarkRandomUniform();
+	return sigma * sqrt(-2 * log(u)) * cos(2 * PI * v);
+}
+
+SPPoint spBenchmarkRandomPoint(const double *center, int dim, double sigma, int index) {
+	int i;
+	SPPoint point;
+	double *data = (double *) malloc(dim * sizeof(double));
+	if (data == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < dim; i++) {
+		data[i] = center[i] + spBenchmarkRandomGaussian(sigma);
+	}
+	point = spPointCreate(data, dim, index);
+	free(data);
+	return point;
+}
+
+SPPoint *spBenchmarkRandomPoints(int count, int dim, double spread) {
+	int i, j;
+	double *data = (double *) malloc(dim * sizeof(double));
+	SPPoint *points = (SPPoint *) malloc(count * sizeof(SPPoint));
+	if (data == NULL || points == NULL) {
+		free(data);
+		free(points);
+		return NULL;
+	}
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < dim; j++) {
+			data[j] = spread * spBenchmarkRandomUniform();
+		}
+		points[i] = spPointCreate(data, dim, i);
+		if (points[i] == NULL) {
+			while (--i >= 0) {
+				spPointDestroy(points[i]);
+			}
+			free(points);
+			free(data);
+			return NULL;
+		}
+	}
+	free(data);
+	return points;
+}
+
+bool spBenchmarkWriteConfig(const char *filename, const char **lines, int numOfLines) {
+	int i;
+	FILE *file = fopen(filename, "w");
+	if (file == NULL) {
+		return false;
+	}
+	for (i = 0; i < numOfLines; i++) {
+		fprintf(file, "%s\n", lines[i]);
+	}
+	return fclose(file) == 0;
+}
+
+bool spBenchmarkParseOptions(int argc, char *argv[], SPBenchmarkOptions *options) {
+	int i, value;
+	for (i = 1; i + 1 < argc; i += 2) {
+		value = atoi(argv[i + 1]);
+		if (strcmp(argv[i], "-n") == 0 && value > 0) {
+			options->size = value;
+		} else if (strcmp(argv[i], "-w") == 0 && value >= 0) {
+			options->warmupRuns = value;
+		} else if (strcmp(argv[i], "-r") == 0 && value > 0) {
+			options->runs = value;
+		} else if (strcmp(argv[i], "-s") == 0) {
+			options->seed = (unsigned int) value;
+		} else {
+			break;
+		}
+	}
+	if (i != argc) {
+		fprintf(stderr, USAGE, argv[0]);
+		return false;
+	}
+	return true;
+}
+
+void spBenchmarkPrintHeader() {
+	printf("benchmark,size,runs,operations,min_ms,median_ms,mean_ms,max_ms,ns_per_operation\n");
+}
+
+bool spBenchmarkRun(const SPBenchmarkCase *benchmarkCase, void *context, const SPBenchmarkOptions *options) {
+	int i;
+	long operations = 0;
+	double total = 0, median;
+	double *millis = (double *) malloc(options->runs * sizeof(double));
+	if (millis == NULL) {
+		return false;
+	}
+	for (i = 0; i < options->warmupRuns; i++) {
+		if (runOnce(benchmarkCase, context, &operations) < 0) {
+			free(millis);
+			return false;
+		}
+	}
+	for (i = 0; i < options->runs; i++) {
+		millis[i] = runOnce(benchmarkCase, context, &operations);
+		if (millis[i] < 0) {
+			free(millis);
+			return false;
+		}
+		total += millis[i];
+	}
+	qsort(millis, options->runs, sizeof(double), compareMillis);
+	median = options->runs % 2 == 1 ? millis[options->runs / 2]
+			: (millis[options->runs / 2 - 1] + millis[options->runs / 2]) / 2;
+	printf("%s,%d,%d,%ld,%.4f,%.4f,%.4f,%.4f,%.2f\n", benchmarkCase->name, options->size, options->runs, operations,
+			millis[0], median, total / options->runs, millis[options->runs - 1],
+			operations > 0 ? median * 1e6 / operations : 0);
+	fflush(stdout);
+	free(millis);
+	return true;
+}
@@ -0,0 +1,159 @@
+/*
+ * benchmark_util.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef BENCHMARKS_BENCHMARK_UTIL_H_
+#define BENCHMARKS_BENCHMARK_UTIL_H_
+
+#include <stdbool.h>
+#include "../SPPoint.h"
+
+/**
+ * Common utilities for the benchmark programs.
+ *
+ * The benchmarks run on synthetic data, generated by a seeded pseudo-random generator so every run of a benchmark
+ * (on every platform) works on exactly the same data.
+ *
+ * The micro-benchmarks share a command line and an output format. They accept the options
+ * 		-n <size> -w <warmup runs> -r <measured runs> -s <seed>
+ * and print a CSV line for every benchmark case:
+ * 		benchmark,size,runs,operations,min_ms,median_ms,mean_ms,max_ms,ns_per_operation
+ * where ns_per_operation is taken from the median run.
+ *
+ * The following functions are available:
+ *
+ * 		spBenchmarkTimeMillis			- Returns a monotonic time stamp in milliseconds.
+ * 		spBenchmarkRandomSeed			- Seeds the pseudo-random generator.
+ * 		spBenchmarkRandomInt			- Returns a pseudo-random integer in a range.
+ * 		spBenchmarkRandomUniform		- Returns a pseudo-random uniformly distributed double.
+ * 		spBenchmarkRandomGaussian		- Returns a pseudo-random normally distributed double.
+ * 		spBenchmarkRandomPoint			- Creates a point with random coordinates around a given center.
+ * 		spBenchmarkRandomPoints			- Creates an array of points with uniformly distributed coordinates.
+ * 		spBenchmarkWriteConfig			- Writes a configuration file with the given parameters lines.
+ * 		spBenchmarkParseOptions			- Parses the micro-benchmarks command line options.
+ * 		spBenchmarkPrintHeader			- Prints the micro-benchmarks CSV header.
+ * 		spBenchmarkRun					- Runs a micro-benchmark case and prints its CSV line.
+ */
+
+/** The micro-benchmarks options. */
+typedef struct sp_benchmark_options_t {
+	int size; // The size of the benchmarked input, its meaning depends on the benchmark
+	int warmupRuns; // Runs which are not measured
+	int runs; // Measured runs
+	unsigned int seed;
+} SPBenchmarkOptions;
+
+/**
+ * A micro-benchmark case. The setup and teardown functions are called before and after every run, and are not
+ * measured. Every run function returns the number of operations it performed.
+ */
+typedef struct sp_benchmark_case_t {
+	const char *name;
+	bool (*setup)(void *);
+	long (*run)(void *);
+	void (*teardown)(void *);
+} SPBenchmarkCase;
+
+/**
+ * Returns a time stamp of a monotonic clock, in milliseconds. Only differences between time stamps are meaningful.
+ */
+double spBenchmarkTimeMillis();
+
+/**
+ * Seeds the benchmarks pseudo-random generator.
+ *
+ * @param seed The seed.
+ */
+void spBenchmarkRandomSeed(unsigned int seed);
+
+/**
+ * Returns a pseudo-random integer in the range [0, bound).
+ *
+ * @param bound The exclusive upper bound, must be positive.
+ */
+int spBenchmarkRandomInt(int bound);
+
+/**
+ * Returns a pseudo-random double, uniformly distributed in the range [0, 1).
+ */
+double spBenchmarkRandomUniform();
+
+/**
+ * Returns a pseudo-random double, normally distributed with the given standard deviation around 0.
+ *
+ * @param sigma The standard deviation.
+ */
+double spBenchmarkRandomGaussian(double sigma);
+
+/**
+ * Creates a point whose coordinates are the given center's coordinates with added gaussian noise.
+ *
+ * @param center The center coordinates.
+ * @param dim The dimension of the point.
+ * @param sigma The standard deviation of the noise of each coordinate.
+ * @param index The index of the created point.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the created point otherwise.
+ */
+SPPoint spBenchmarkRandomPoint(const double *center, int dim, double sigma, int index);
+
+/**
+ * Creates an array of points whose coordinates are uniformly distributed in the range [0, spread).
+ * The index of every point is its position in the array.
+ *
+ * @param count The number of points.
+ * @param dim The dimension of the points.
+ * @param spread The range of the coordinates.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the created points otherwise (to be freed by spKDArrayFreePointsArray).
+ */
+SPPoint *spBenchmarkRandomPoints(int count, int dim, double spread);
+
+/**
+ * Writes a configuration file which contains the given parameters lines.
+ *
+ * @param filename The path of the configuration file to write.
+ * @param lines The "key = value" lines, without line breaks.
+ * @param numOfLines The number of lines.
+ *
+ * @return
+ * 	false if the file could not be written, true otherwise.
+ */
+bool spBenchmarkWriteConfig(const char *filename, const char **lines, int numOfLines);
+
+/**
+ * Parses the micro-benchmarks command line options. Options which are not given keep their value.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param options The options, filled with the defaults of the benchmark.
+ *
+ * @return
+ * 	false if the command line is invalid (a usage line is printed to the standard error), true otherwise.
+ */
+bool spBenchmarkParseOptions(int argc, char *argv[], SPBenchmarkOptions *options);
+
+/**
+ * Prints the micro-benchmarks CSV header to the standard output.
+ */
+void spBenchmarkPrintHeader();
+
+/**
+ * Runs the given case options->warmupRuns times without measuring, then options->runs measured times, and prints
+ * its CSV line to the standard output.
+ *
+ * @param benchmarkCase The case to run. The setup and teardown functions may be NULL.
+ * @param context The argument given to the case functions.
+ * @param options The options.
+ *
+ * @return
+ * 	false if a setup failed or an allocation failure occurred, true otherwise.
+ */
+bool spBenchmarkRun(const SPBenchmarkCase *benchmarkCase, void *context, const SPBenchmarkOptions *options);
+
+#endif /* BENCHMARKS_BENCHMARK_UTIL_H_ */
@@ -0,0 +1,108 @@
+/*
+ * sp_bpqueue_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPBPriorityQueue.h"
+#include "../SPListElement.h"
+
+/**
+ * Micro-benchmark of the bounded priority queue:
+ *
+ * 		bpqueue_enqueue_knn			- -n random enqueues into a queue bounded by a typical spKNN, as in a nearest
+ * 									  neighbors search.
+ * 		bpqueue_enqueue_dequeue		- -n random enqueues into an unbounded (size -n) queue, then dequeuing all.
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 10000
+#define DEFAULT_WARMUP_RUNS 2
+#define DEFAULT_RUNS 10
+#define DEFAULT_SEED 2026
+#define KNN_QUEUE_SIZE 10
+
+/*** Types ***/
+
+typedef struct bpqueue_benchmark_t {
+	SPListElement *elements;
+	int size;
+	int queueSize;
+	SPBPQueue queue;
+} BPQueueBenchmark;
+
+/*** Private Methods ***/
+
+static bool setupQueue(void *context) {
+	BPQueueBenchmark *benchmark = (BPQueueBenchmark *) context;
+	benchmark->queue = spBPQueueCreate(benchmark->queueSize);
+	return benchmark->queue != NULL;
+}
+
+static void teardownQueue(void *context) {
+	spBPQueueDestroy(((BPQueueBenchmark *) context)->queue);
+}
+
+static long runEnqueue(void *context) {
+	BPQueueBenchmark *benchmark = (BPQueueBenchmark *) context;
+	int i;
+	for (i = 0; i < benchmark->size; i++) {
+		spBPQueueEnqueue(benchmark->queue, benchmark->elements[i]);
+	}
+	return benchmark->size;
+}
+
+static long runEnqueueDequeue(void *context) {
+	BPQueueBenchmark *benchmark = (BPQueueBenchmark *) context;
+	runEnqueue(context);
+	while (!spBPQueueIsEmpty(benchmark->queue)) {
+		spBPQueueDequeue(benchmark->queue);
+	}
+	return 2 * benchmark->size;
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	SPBenchmarkCase knnCase = { "bpqueue_enqueue_knn", setupQueue, runEnqueue, teardownQueue };
+	SPBenchmarkCase dequeueCase = { "bpqueue_enqueue_dequeue", setupQueue, runEnqueueDequeue, teardownQueue };
+	BPQueueBenchmark benchmark;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	benchmark.size = options.size;
+	benchmark.elements = (SPListElement *) malloc(options.size * sizeof(SPListElement));
+	if (benchmark.elements == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	for (i = 0; i < options.size; i++) {
+		benchmark.elements[i] = spListElementCreate(i, spBenchmarkRandomUniform());
+		success = success && benchmark.elements[i] != NULL;
+	}
+	spBenchmarkPrintHeader();
+	if (success) {
+		benchmark.queueSize = KNN_QUEUE_SIZE;
+		success = spBenchmarkRun(&knnCase, &benchmark, &options);
+	}
+	if (success) {
+		benchmark.queueSize = options.size;
+		success = spBenchmarkRun(&dequeueCase, &benchmark, &options);
+	}
+	for (i = 0; i < options.size; i++) {
+		spListElementDestroy(benchmark.elements[i]);
+	}
+	free(benchmark.elements);
+	if (!success) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * sp_features_file_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPKDArray.h"
+#include "../sp_features_file_api.h"
+#include "../sp_features_store.h"
+#include "../sp_util.h"
+
+/**
+ * Micro-benchmark of the features files - writing -n features to a features file, and loading them back.
+ * The same features are also written to a features store (FEATURES_PER_IMAGE features per image) and loaded back.
+ * The baseline cases write and load the features file as it was done before the text format had its own parser and
+ * formatter - with sprintf, spUtilStrJoin, spUtilStrSplit and atof - so the two can be compared in the same run.
+ * The size of the features file is printed to the standard error, for converting the times to MB/s.
+ * Every operation is a single feature.
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 20000
+#define DEFAULT_WARMUP_RUNS 1
+#define DEFAULT_RUNS 5
+#define DEFAULT_SEED 2026
+#define DIM 20
+#define SPREAD 100.0
+#define FEATURES_FILENAME "./sp_features_file_benchmark.feats"
+#define FEATURES_STORE_FILENAME "./sp_features_file_benchmark.store"
+#define FEATURES_PER_IMAGE 100
+#define BASELINE_COORDINATE_LEN 20
+#define BASELINE_DELIM ' '
+
+/*** Types ***/
+
+typedef struct features_file_benchmark_t {
+	SPPoint *points;
+	int size;
+	SPPoint *loaded;
+	int numOfLoaded;
+} FeaturesFileBenchmark;
+
+/*** Private Methods ***/
+
+static long runWrite(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	if (spFeaturesFileAPIWrite(FEATURES_FILENAME, benchmark->points, benchmark->size)
+			!= SP_FEATURES_FILE_API_SUCCESS) {
+		return 0;
+	}
+	return benchmark->size;
+}
+
+static long runLoad(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	SP_FEATURES_FILE_API_MSG msg;
+	benchmark->loaded = spFeaturesFileAPILoad(FEATURES_FILENAME, 0, DIM, &benchmark->numOfLoaded, &msg);
+	return benchmark->loaded == NULL ? 0 : benchmark->numOfLoaded;
+}
+
+static void teardownLoad(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	if (benchmark->loaded != NULL) {
+		spKDArrayFreePointsArray(benchmark->loaded, benchmark->numOfLoaded);
+	}
+}
+
+static long runBaselineWrite(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	char *coordinates[DIM], *joined;
+	int i, j;
+	bool success = true;
+	FILE *file = fopen(FEATURES_FILENAME, "w");
+	if (file == NULL) {
+		return 0;
+	}
+	fprintf(file, "%d\n", benchmark->size);
+	for (i = 0; i < benchmark->size && success; i++) {
+		for (j = 0; j < DIM; j++) {
+			coordinates[j] = (char *) malloc(BASELINE_COORDINATE_LEN * sizeof(char));
+			sprintf(coordinates[j], "%f", spPointGetAxisCoor(benchmark->points[i], j));
+		}
+		joined = spUtilStrJoin((const char **) coordinates, DIM, BASELINE_DELIM);
+		success = joined != NULL && fputs(joined, file) != EOF && fputc('\n', file) != EOF;
+		free(joined);
+		for (j = 0; j < DIM; j++) {
+			free(coordinates[j]);
+		}
+	}
+	fclose(file);
+	return success ? benchmark->size : 0;
+}
+
+static long runBaselineLoad(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	int i, j, numOfFeatures, numOfCoordinates, lineLength = (BASELINE_COORDINATE_LEN + 1) * DIM;
+	char **coordinates, *line;
+	double data[DIM];
+	FILE *file = fopen(FEATURES_FILENAME, "r");
+	benchmark->loaded = NULL;
+	if (file == NULL || fscanf(file, "%d\n", &numOfFeatures) != 1) {
+		return 0;
+	}
+	benchmark->loaded = (SPPoint *) malloc(numOfFeatures * sizeof(SPPoint));
+	for (i = 0; i < numOfFeatures; i++) {
+		line = (char *) malloc((lineLength + 1) * sizeof(char));
+		if (fgets(line, lineLength, file) == NULL) {
+			free(line);
+			break;
+		}
+		coordinates = spUtilStrSplit(line, BASELINE_DELIM, &numOfCoordinates);
+		free(line);
+		for (j = 0; j < DIM && j < numOfCoordinates; j++) {
+			data[j] = atof(coordinates[j]);
+		}
+		spUtilFreeStringsArray(coordinates, numOfCoordinates);
+		benchmark->loaded[i] = spPointCreate(data, DIM, 0);
+	}
+	fclose(file);
+	benchmark->numOfLoaded = i;
+	return benchmark->numOfLoaded;
+}
+
+static void printFeaturesFileSize() {
+	long size;
+	FILE *file = fopen(FEATURES_FILENAME, "r");
+	if (file == NULL) {
+		return;
+	}
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+	fprintf(stderr, "features file size: %ld bytes\n", size);
+}
+
+static long runStoreWrite(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	SP_FEATURES_STORE_MSG msg;
+	int imageIndex, numOfImages = (benchmark->size + FEATURES_PER_IMAGE - 1) / FEATURES_PER_IMAGE;
+	SPFeaturesStoreWriter writer = spFeaturesStoreWriterCreate(FEATURES_STORE_FILENAME, DIM, numOfImages, &msg);
+	if (writer == NULL) {
+		return 0;
+	}
+	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
+		int first = imageIndex * FEATURES_PER_IMAGE;
+		int count = (benchmark->size - first < FEATURES_PER_IMAGE) ? benchmark->size - first : FEATURES_PER_IMAGE;
+		if (spFeaturesStoreWriterAppend(writer, imageIndex, benchmark->points + first, count, false, 0)
+				!= SP_FEATURES_STORE_SUCCESS) {
+			spFeaturesStoreWriterAbort(writer);
+			return 0;
+		}
+	}
+	return spFeaturesStoreWriterCommit(writer) == SP_FEATURES_STORE_SUCCESS ? benchmark->size : 0;
+}
+
+static long runStoreLoad(void *context) {
+	FeaturesFileBenchmark *benchmark = (FeaturesFileBenchmark *) context;
+	SP_FEATURES_STORE_MSG msg;
+	SPFeaturesStore store = spFeaturesStoreLoad(FEATURES_STORE_FILENAME, &msg);
+	benchmark->loaded = spFeaturesStoreLoadAll(store, &benchmark->numOfLoaded, &msg);
+	spFeaturesStoreDestroy(store);
+	return benchmark->loaded == NULL ? 0 : benchmark->numOfLoaded;
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	SPBenchmarkCase cases[] = {
+		{ "features_file_write_baseline", NULL, runBaselineWrite, NULL },
+		{ "features_file_load_baseline", NULL, runBaselineLoad, teardownLoad },
+		{ "features_file_write", NULL, runWrite, NULL },
+		{ "features_file_load", NULL, runLoad, teardownLoad },
+		{ "features_store_write", NULL, runStoreWrite, NULL },
+		{ "features_store_load", NULL, runStoreLoad, teardownLoad }
+	};
+	FeaturesFileBenchmark benchmark;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	benchmark.size = options.size;
+	benchmark.points = spBenchmarkRandomPoints(options.size, DIM, SPREAD);
+	if (benchmark.points == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	spBenchmarkPrintHeader();
+	// The load cases read the files of the write cases
+	for (i = 0; i < (int) (sizeof(cases) / sizeof(*cases)) && success; i++) {
+		success = spBenchmarkRun(&cases[i], &benchmark, &options);
+	}
+	printFeaturesFileSize();
+	remove(FEATURES_FILENAME);
+	remove(FEATURES_STORE_FILENAME);
+	spKDArrayFreePointsArray(benchmark.points, options.size);
+	if (!success) {
+		fprintf(stderr, "Benchmark failure\n");
+		return 1;
+	}
+	return 0;
+}
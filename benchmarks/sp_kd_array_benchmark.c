@@ -0,0 +1,96 @@
+/*
+ * sp_kd_array_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPKDArray.h"
+
+/**
+ * Micro-benchmark of the kd-array - initializing a kd-array of -n points (sorting them by every dimension), and
+ * splitting it by its maximal spread dimension.
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 20000
+#define DEFAULT_WARMUP_RUNS 1
+#define DEFAULT_RUNS 5
+#define DEFAULT_SEED 2026
+#define DIM 20
+#define SPREAD 100.0
+
+/*** Types ***/
+
+typedef struct kd_array_benchmark_t {
+	SPPoint *points;
+	int size;
+	SPKDArray kdArray;
+	SPKDArraySplitResult splitResult;
+} KDArrayBenchmark;
+
+/*** Private Methods ***/
+
+static long runInit(void *context) {
+	KDArrayBenchmark *benchmark = (KDArrayBenchmark *) context;
+	benchmark->kdArray = spKDArrayInit(benchmark->points, benchmark->size);
+	return benchmark->size;
+}
+
+static void teardownInit(void *context) {
+	spKDArrayDestroy(((KDArrayBenchmark *) context)->kdArray);
+}
+
+static bool setupSplit(void *context) {
+	KDArrayBenchmark *benchmark = (KDArrayBenchmark *) context;
+	runInit(context);
+	return benchmark->kdArray != NULL;
+}
+
+static long runSplit(void *context) {
+	KDArrayBenchmark *benchmark = (KDArrayBenchmark *) context;
+	benchmark->splitResult = spKDArraySplit(benchmark->kdArray, spKDArrayMaxSpreadDimension(benchmark->kdArray));
+	return benchmark->size;
+}
+
+static void teardownSplit(void *context) {
+	KDArrayBenchmark *benchmark = (KDArrayBenchmark *) context;
+	spKDArraySplitResultDestroy(benchmark->splitResult);
+	spKDArrayDestroy(benchmark->kdArray);
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	SPBenchmarkCase cases[] = {
+		{ "kd_array_init", NULL, runInit, teardownInit },
+		{ "kd_array_split", setupSplit, runSplit, teardownSplit }
+	};
+	KDArrayBenchmark benchmark;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	benchmark.size = options.size;
+	benchmark.points = spBenchmarkRandomPoints(options.size, DIM, SPREAD);
+	if (benchmark.points == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	spBenchmarkPrintHeader();
+	for (i = 0; i < (int) (sizeof(cases) / sizeof(*cases)) && success; i++) {
+		success = spBenchmarkRun(&cases[i], &benchmark, &options);
+	}
+	spKDArrayFreePointsArray(benchmark.points, options.size);
+	if (!success) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
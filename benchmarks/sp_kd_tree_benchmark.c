@@ -0,0 +1,93 @@
+/*
+ * sp_kd_tree_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+
+/**
+ * Micro-benchmark of the kd-tree build - building a tree of -n points with every split method.
+ * The kd-array initialization is not measured (see sp_kd_array_benchmark.c).
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 20000
+#define DEFAULT_WARMUP_RUNS 1
+#define DEFAULT_RUNS 5
+#define DEFAULT_SEED 2026
+#define DIM 20
+#define SPREAD 100.0
+
+/*** Types ***/
+
+typedef struct kd_tree_benchmark_t {
+	SPPoint *points;
+	int size;
+	SP_TREE_SPLIT_METHOD splitMethod;
+	SPKDArray kdArray;
+	SPKDTreeNode tree;
+} KDTreeBenchmark;
+
+/*** Private Methods ***/
+
+static bool setupBuild(void *context) {
+	KDTreeBenchmark *benchmark = (KDTreeBenchmark *) context;
+	benchmark->kdArray = spKDArrayInit(benchmark->points, benchmark->size);
+	return benchmark->kdArray != NULL;
+}
+
+static long runBuild(void *context) {
+	KDTreeBenchmark *benchmark = (KDTreeBenchmark *) context;
+	benchmark->tree = spKDTreeBuild(benchmark->kdArray, benchmark->splitMethod);
+	return benchmark->size;
+}
+
+static void teardownBuild(void *context) {
+	KDTreeBenchmark *benchmark = (KDTreeBenchmark *) context;
+	spKDTreeDestroy(benchmark->tree);
+	spKDArrayDestroy(benchmark->kdArray);
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	const char *names[] = { "kd_tree_build_max_spread", "kd_tree_build_random", "kd_tree_build_incremental" };
+	const SP_TREE_SPLIT_METHOD methods[] = {
+		TREE_SPLIT_METHOD_MAX_SPREAD, TREE_SPLIT_METHOD_RANDOM, TREE_SPLIT_METHOD_INCREMENTAL
+	};
+	SPBenchmarkCase buildCase = { NULL, setupBuild, runBuild, teardownBuild };
+	KDTreeBenchmark benchmark;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	// The random split method uses rand()
+	srand(options.seed);
+	benchmark.size = options.size;
+	benchmark.points = spBenchmarkRandomPoints(options.size, DIM, SPREAD);
+	if (benchmark.points == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	spBenchmarkPrintHeader();
+	for (i = 0; i < (int) (sizeof(methods) / sizeof(*methods)) && success; i++) {
+		buildCase.name = names[i];
+		benchmark.splitMethod = methods[i];
+		success = spBenchmarkRun(&buildCase, &benchmark, &options);
+	}
+	spKDArrayFreePointsArray(benchmark.points, options.size);
+	if (!success) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * sp_knn_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+#include "../SPBPriorityQueue.h"
+#include "../SPListElement.h"
+#include "../SPPQIndex.h"
+#include "../SPIVFIndex.h"
+#include "../SPHNSWIndex.h"
+#include "../sp_algorithms.h"
+
+/**
+ * Micro-benchmark of the nearest neighbors search - NUM_OF_QUERIES searches in a kd-tree of -n points, for
+ * several neighbors counts, and the same searches in a PQ index, in IVF indices (with and without quantization)
+ * and in an HNSW graph of the points. Every operation is a single search.
+ * The memory the PQ index takes per point, the time the HNSW graph takes to build, and the fraction of the
+ * kd-tree's (exact) nearest neighbors each of the other indices finds, are printed to the standard error.
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 50000
+#define DEFAULT_WARMUP_RUNS 1
+#define DEFAULT_RUNS 5
+#define DEFAULT_SEED 2026
+#define NUM_OF_QUERIES 1000
+#define DIM 20
+#define SPREAD 100.0
+#define PQ_SUBQUANTIZERS 10
+#define RECALL_KNN 20
+#define IVF_LISTS 64
+#define IVF_PROBES 8
+#define HNSW_M 16
+#define HNSW_EF_CONSTRUCTION 200
+#define HNSW_EF_SEARCH 64
+#define HNSW_THREADS 4
+
+/*** Types ***/
+
+typedef struct knn_benchmark_t {
+	SPKDTreeNode tree;
+	SPPQIndex pqIndex;
+	SPIVFIndex ivfIndex;
+	SPIVFIndex ivfPQIndex;
+	SPIVFIndex searchedIVFIndex;
+	SPHNSWIndex hnswIndex;
+	SPPoint *queries;
+	int knn;
+	SPBPQueue queue;
+} KNNBenchmark;
+
+/*** Private Methods ***/
+
+static bool setupQueue(void *context) {
+	KNNBenchmark *benchmark = (KNNBenchmark *) context;
+	benchmark->queue = spBPQueueCreate(benchmark->knn);
+	return benchmark->queue != NULL;
+}
+
+static void teardownQueue(void *context) {
+	spBPQueueDestroy(((KNNBenchmark *) context)->queue);
+}
+
+static long runSearches(void *context) {
+	KNNBenchmark *benchmark = (KNNBenchmark *) context;
+	int i;
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spBPQueueClear(benchmark->queue);
+		spKNearestNeighbours(benchmark->tree, benchmark->queue, benchmark->queries[i]);
+	}
+	return NUM_OF_QUERIES;
+}
+
+static long runPQSearches(void *context) {
+	KNNBenchmark *benchmark = (KNNBenchmark *) context;
+	int i;
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spBPQueueClear(benchmark->queue);
+		spPQIndexKNearestNeighbours(benchmark->pqIndex, benchmark->queue, benchmark->queries[i]);
+	}
+	return NUM_OF_QUERIES;
+}
+
+static long runIVFSearches(void *context) {
+	KNNBenchmark *benchmark = (KNNBenchmark *) context;
+	int i;
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spBPQueueClear(benchmark->queue);
+		spIVFIndexKNearestNeighbours(benchmark->searchedIVFIndex, benchmark->queue, benchmark->queries[i]);
+	}
+	return NUM_OF_QUERIES;
+}
+
+static long runHNSWSearches(void *context) {
+	KNNBenchmark *benchmark = (KNNBenchmark *) context;
+	int i;
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spBPQueueClear(benchmark->queue);
+		spHNSWIndexKNearestNeighbours(benchmark->hnswIndex, benchmark->queue, benchmark->queries[i]);
+	}
+	return NUM_OF_QUERIES;
+}
+
+/**
+ * Moves the indices of the queued points to the given marks, and empties the queue.
+ */
+static void markQueued(SPBPQueue queue, bool *marks, bool mark) {
+	SPListElement element;
+	while (!spBPQueueIsEmpty(queue)) {
+		element = spBPQueuePeek(queue);
+		marks[spListElementGetIndex(element)] = mark;
+		spListElementDestroy(element);
+		spBPQueueDequeue(queue);
+	}
+}
+
+/**
+ * Returns the fraction of the RECALL_KNN nearest neighbors of the queries (found by the kd-tree) which are found by
+ * the given index - a PQ index, an IVF index or an HNSW index, whichever is not NULL.
+ */
+static double approximateRecall(KNNBenchmark *benchmark, SPPQIndex pqIndex, SPIVFIndex ivfIndex,
+		SPHNSWIndex hnswIndex, int size) {
+	SPListElement element;
+	int i, found = 0;
+	bool *exact = (bool *) calloc(size, sizeof(bool));
+	SPBPQueue queue = spBPQueueCreate(RECALL_KNN);
+	if (exact == NULL || queue == NULL) {
+		free(exact);
+		spBPQueueDestroy(queue);
+		return -1;
+	}
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spKNearestNeighbours(benchmark->tree, queue, benchmark->queries[i]);
+		markQueued(queue, exact, true);
+		if (pqIndex != NULL) {
+			spPQIndexKNearestNeighbours(pqIndex, queue, benchmark->queries[i]);
+		} else if (ivfIndex != NULL) {
+			spIVFIndexKNearestNeighbours(ivfIndex, queue, benchmark->queries[i]);
+		} else {
+			spHNSWIndexKNearestNeighbours(hnswIndex, queue, benchmark->queries[i]);
+		}
+		while (!spBPQueueIsEmpty(queue)) {
+			element = spBPQueuePeek(queue);
+			found += exact[spListElementGetIndex(element)];
+			spListElementDestroy(element);
+			spBPQueueDequeue(queue);
+		}
+		spKNearestNeighbours(benchmark->tree, queue, benchmark->queries[i]);
+		markQueued(queue, exact, false);
+	}
+	free(exact);
+	spBPQueueDestroy(queue);
+	return (double) found / (NUM_OF_QUERIES * RECALL_KNN);
+}
+
+/**
+ * Prints the memory the PQ index takes per point, the time the HNSW graph took to build, and the recall of the
+ * approximate indices.
+ */
+static void printRecalls(KNNBenchmark *benchmark, int size, double hnswBuildMillis) {
+	fprintf(stderr, "pq index: %.1f bytes per point, recall@%d %.3f\n",
+			(double) spPQIndexGetCodesSize(benchmark->pqIndex) / size, RECALL_KNN,
+			approximateRecall(benchmark, benchmark->pqIndex, NULL, NULL, size));
+	fprintf(stderr, "ivf index (%d/%d lists probed): recall@%d %.3f\n", IVF_PROBES, IVF_LISTS, RECALL_KNN,
+			approximateRecall(benchmark, NULL, benchmark->ivfIndex, NULL, size));
+	fprintf(stderr, "ivf pq index (%d/%d lists probed): recall@%d %.3f\n", IVF_PROBES, IVF_LISTS, RECALL_KNN,
+			approximateRecall(benchmark, NULL, benchmark->ivfPQIndex, NULL, size));
+	fprintf(stderr, "hnsw index (M %d, efSearch %d): built in %.0f ms by %d threads, recall@%d %.3f\n", HNSW_M,
+			HNSW_EF_SEARCH, hnswBuildMillis, HNSW_THREADS, RECALL_KNN,
+			approximateRecall(benchmark, NULL, NULL, benchmark->hnswIndex, size));
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	const char *names[] = { "knn_1", "knn_5", "knn_20" };
+	const char *pqNames[] = { "pq_knn_1", "pq_knn_5", "pq_knn_20" };
+	const char *ivfNames[] = { "ivf_knn_1", "ivf_knn_5", "ivf_knn_20" };
+	const char *ivfPQNames[] = { "ivf_pq_knn_1", "ivf_pq_knn_5", "ivf_pq_knn_20" };
+	const char *hnswNames[] = { "hnsw_knn_1", "hnsw_knn_5", "hnsw_knn_20" };
+	const int knns[] = { 1, 5, 20 };
+	SPBenchmarkCase searchCase = { NULL, setupQueue, runSearches, teardownQueue };
+	SPBenchmarkCase pqSearchCase = { NULL, setupQueue, runPQSearches, teardownQueue };
+	SPBenchmarkCase ivfSearchCase = { NULL, setupQueue, runIVFSearches, teardownQueue };
+	SPBenchmarkCase hnswSearchCase = { NULL, setupQueue, runHNSWSearches, teardownQueue };
+	SP_PQ_INDEX_MSG pqMsg;
+	SP_IVF_INDEX_MSG ivfMsg;
+	SP_HNSW_INDEX_MSG hnswMsg;
+	KNNBenchmark benchmark;
+	SPPoint *points;
+	SPKDArray kdArray;
+	double hnswBuildMillis;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	points = spBenchmarkRandomPoints(options.size, DIM, SPREAD);
+	benchmark.queries = spBenchmarkRandomPoints(NUM_OF_QUERIES, DIM, SPREAD);
+	kdArray = points == NULL ? NULL : spKDArrayInit(points, options.size);
+	benchmark.tree = spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD);
+	spKDArrayDestroy(kdArray);
+	benchmark.pqIndex = points == NULL ? NULL : spPQIndexCreate(points, options.size, PQ_SUBQUANTIZERS, &pqMsg);
+	benchmark.ivfIndex = points == NULL ? NULL : spIVFIndexCreate(points, options.size, IVF_LISTS, IVF_PROBES, 0,
+			&ivfMsg);
+	benchmark.ivfPQIndex = points == NULL ? NULL : spIVFIndexCreate(points, options.size, IVF_LISTS, IVF_PROBES,
+			PQ_SUBQUANTIZERS, &ivfMsg);
+	hnswBuildMillis = spBenchmarkTimeMillis();
+	benchmark.hnswIndex = points == NULL ? NULL : spHNSWIndexCreate(points, options.size, HNSW_M,
+			HNSW_EF_CONSTRUCTION, HNSW_EF_SEARCH, HNSW_THREADS, &hnswMsg);
+	hnswBuildMillis = spBenchmarkTimeMillis() - hnswBuildMillis;
+	if (points != NULL) {
+		spKDArrayFreePointsArray(points, options.size);
+	}
+	success = benchmark.tree != NULL && benchmark.pqIndex != NULL && benchmark.ivfIndex != NULL
+			&& benchmark.ivfPQIndex != NULL && benchmark.hnswIndex != NULL && benchmark.queries != NULL;
+	if (success) {
+		spBenchmarkPrintHeader();
+	}
+	for (i = 0; i < (int) (sizeof(knns) / sizeof(*knns)) && success; i++) {
+		searchCase.name = names[i];
+		benchmark.knn = knns[i];
+		success = spBenchmarkRun(&searchCase, &benchmark, &options);
+	}
+	for (i = 0; i < (int) (sizeof(knns) / sizeof(*knns)) && success; i++) {
+		pqSearchCase.name = pqNames[i];
+		benchmark.knn = knns[i];
+		success = spBenchmarkRun(&pqSearchCase, &benchmark, &options);
+	}
+	for (i = 0; i < (int) (sizeof(knns) / sizeof(*knns)) && success; i++) {
+		ivfSearchCase.name = ivfNames[i];
+		benchmark.knn = knns[i];
+		benchmark.searchedIVFIndex = benchmark.ivfIndex;
+		success = spBenchmarkRun(&ivfSearchCase, &benchmark, &options);
+	}
+	for (i = 0; i < (int) (sizeof(knns) / sizeof(*knns)) && success; i++) {
+		ivfSearchCase.name = ivfPQNames[i];
+		benchmark.knn = knns[i];
+		benchmark.searchedIVFIndex = benchmark.ivfPQIndex;
+		success = spBenchmarkRun(&ivfSearchCase, &benchmark, &options);
+	}
+	for (i = 0; i < (int) (sizeof(knns) / sizeof(*knns)) && success; i++) {
+		hnswSearchCase.name = hnswNames[i];
+		benchmark.knn = knns[i];
+		success = spBenchmarkRun(&hnswSearchCase, &benchmark, &options);
+	}
+	if (success) {
+		printRecalls(&benchmark, options.size, hnswBuildMillis);
+	}
+	spKDTreeDestroy(benchmark.tree);
+	spPQIndexDestroy(benchmark.pqIndex);
+	spIVFIndexDestroy(benchmark.ivfIndex);
+	spIVFIndexDestroy(benchmark.ivfPQIndex);
+	spHNSWIndexDestroy(benchmark.hnswIndex);
+	if (benchmark.queries != NULL) {
+		spKDArrayFreePointsArray(benchmark.queries, NUM_OF_QUERIES);
+	}
+	if (!success) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
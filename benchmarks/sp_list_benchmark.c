@@ -0,0 +1,119 @@
+/*
+ * sp_list_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPList.h"
+#include "../SPListElement.h"
+
+/**
+ * Micro-benchmark of the list insertions - -n insertions at the head of a list, at its tail, and in sorted order
+ * (walking from the head to the first greater element, as the bounded priority queue does).
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 2000
+#define DEFAULT_WARMUP_RUNS 2
+#define DEFAULT_RUNS 10
+#define DEFAULT_SEED 2026
+
+/*** Types ***/
+
+typedef struct list_benchmark_t {
+	SPListElement *elements;
+	int size;
+	SPList list;
+} ListBenchmark;
+
+/*** Private Methods ***/
+
+static bool setupList(void *context) {
+	ListBenchmark *benchmark = (ListBenchmark *) context;
+	benchmark->list = spListCreate();
+	return benchmark->list != NULL;
+}
+
+static void teardownList(void *context) {
+	spListDestroy(((ListBenchmark *) context)->list);
+}
+
+static long runInsertFirst(void *context) {
+	ListBenchmark *benchmark = (ListBenchmark *) context;
+	int i;
+	for (i = 0; i < benchmark->size; i++) {
+		spListInsertFirst(benchmark->list, benchmark->elements[i]);
+	}
+	return benchmark->size;
+}
+
+static long runInsertLast(void *context) {
+	ListBenchmark *benchmark = (ListBenchmark *) context;
+	int i;
+	for (i = 0; i < benchmark->size; i++) {
+		spListInsertLast(benchmark->list, benchmark->elements[i]);
+	}
+	return benchmark->size;
+}
+
+static long runInsertSorted(void *context) {
+	ListBenchmark *benchmark = (ListBenchmark *) context;
+	SPListElement current;
+	int i;
+	for (i = 0; i < benchmark->size; i++) {
+		current = spListGetFirst(benchmark->list);
+		while (current != NULL && spListElementCompare(current, benchmark->elements[i]) <= 0) {
+			current = spListGetNext(benchmark->list);
+		}
+		if (current == NULL) {
+			spListInsertLast(benchmark->list, benchmark->elements[i]);
+		} else {
+			spListInsertBeforeCurrent(benchmark->list, benchmark->elements[i]);
+		}
+	}
+	return benchmark->size;
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	SPBenchmarkCase cases[] = {
+		{ "list_insert_first", setupList, runInsertFirst, teardownList },
+		{ "list_insert_last", setupList, runInsertLast, teardownList },
+		{ "list_insert_sorted", setupList, runInsertSorted, teardownList }
+	};
+	ListBenchmark benchmark;
+	bool success = true;
+	int i;
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	benchmark.size = options.size;
+	benchmark.elements = (SPListElement *) malloc(options.size * sizeof(SPListElement));
+	if (benchmark.elements == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	for (i = 0; i < options.size; i++) {
+		benchmark.elements[i] = spListElementCreate(i, spBenchmarkRandomUniform());
+		success = success && benchmark.elements[i] != NULL;
+	}
+	spBenchmarkPrintHeader();
+	for (i = 0; i < (int) (sizeof(cases) / sizeof(*cases)) && success; i++) {
+		success = spBenchmarkRun(&cases[i], &benchmark, &options);
+	}
+	for (i = 0; i < options.size; i++) {
+		spListElementDestroy(benchmark.elements[i]);
+	}
+	free(benchmark.elements);
+	if (!success) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
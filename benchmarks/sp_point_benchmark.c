@@ -0,0 +1,81 @@
+/*
+ * sp_point_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPKDArray.h"
+
+/**
+ * Micro-benchmark of the points distance - the squared L2 distance between consecutive points of an array of
+ * -n points, in the PCA dimensions range and in the SIFT descriptors dimension.
+ */
+
+/*** Constants ***/
+
+#define DEFAULT_SIZE 100000
+#define DEFAULT_WARMUP_RUNS 2
+#define DEFAULT_RUNS 10
+#define DEFAULT_SEED 2026
+#define PCA_DIM 20
+#define SIFT_DIM 128
+#define SPREAD 100.0
+
+/*** Types ***/
+
+typedef struct point_benchmark_t {
+	SPPoint *points;
+	int size;
+	double checksum; // Keeps the distances computation alive
+} PointBenchmark;
+
+/*** Private Methods ***/
+
+static long runDistance(void *context) {
+	PointBenchmark *benchmark = (PointBenchmark *) context;
+	int i;
+	double sum = 0;
+	for (i = 0; i < benchmark->size; i++) {
+		sum += spPointL2SquaredDistance(benchmark->points[i], benchmark->points[(i + 1) % benchmark->size]);
+	}
+	benchmark->checksum += sum;
+	return benchmark->size;
+}
+
+/**
+ * Runs the distance benchmark case on points of the given dimension.
+ */
+static bool benchmarkDistance(const char *name, int dim, const SPBenchmarkOptions *options) {
+	SPBenchmarkCase distanceCase = { name, NULL, runDistance, NULL };
+	PointBenchmark benchmark;
+	bool success;
+	benchmark.size = options->size;
+	benchmark.checksum = 0;
+	benchmark.points = spBenchmarkRandomPoints(options->size, dim, SPREAD);
+	if (benchmark.points == NULL) {
+		return false;
+	}
+	success = spBenchmarkRun(&distanceCase, &benchmark, options);
+	spKDArrayFreePointsArray(benchmark.points, options->size);
+	return success && benchmark.checksum >= 0;
+}
+
+int main(int argc, char *argv[]) {
+	SPBenchmarkOptions options = { DEFAULT_SIZE, DEFAULT_WARMUP_RUNS, DEFAULT_RUNS, DEFAULT_SEED };
+	if (!spBenchmarkParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	spBenchmarkRandomSeed(options.seed);
+	spBenchmarkPrintHeader();
+	if (!benchmarkDistance("point_l2_squared_distance_pca", PCA_DIM, &options)
+			|| !benchmarkDistance("point_l2_squared_distance_sift", SIFT_DIM, &options)) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * sp_voting_benchmark.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark_util.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+#include "../SPSearchIndex.h"
+#include "../SPHitsAccumulator.h"
+#include "../sp_similar_images_search_api.h"
+
+/**
+ * Benchmark of the images voting methods - measures the ranking quality of every voting method as a function of
+ * the nearest neighbors count (spKNN), together with the average query time.
+ *
+ * The catalog is synthetic: every image is a bag of "visual words" drawn from a shared vocabulary, with popular
+ * words being much more common than rare ones (as in real images). Every query is a noisy view of a random catalog
+ * image - some of the target's features are dropped, the rest are perturbed, and clutter features of random words
+ * are added. A query is recalled if its target image is ranked among the first results.
+ *
+ * The results are printed to the standard output as CSV. An optional argument sets the random seed.
+ */
+
+/*** Constants ***/
+
+#define DIM 16
+#define NUM_OF_IMAGES 200
+#define VOCABULARY_SIZE 400
+#define FEATURES_PER_IMAGE 40
+#define NUM_OF_QUERIES 100
+#define CLUTTER_FEATURES_PER_QUERY 30
+#define KEPT_FEATURE_PROBABILITY 0.3
+#define WORD_SPREAD 100.0
+#define FEATURE_SIGMA 6.0
+#define QUERY_SIGMA 9.0
+#define NUM_OF_SIMILAR_IMAGES 5
+#define CONFIG_FILENAME "./sp_voting_benchmark.config"
+#define QUERY_PATH_PREFIX "query_"
+#define DEFAULT_SEED 2026
+
+/*** Private Variables ***/
+
+/** The features of every benchmark query, returned by the mock extraction function. */
+static SPPoint *queriesFeatures[NUM_OF_QUERIES];
+static int queriesFeaturesCount[NUM_OF_QUERIES];
+
+/*** Private Methods ***/
+
+/**
+ * Draws a word from the vocabulary, low word indices are the popular ones.
+ */
+static int randomWord() {
+	double u = spBenchmarkRandomUniform();
+	return (int) (VOCABULARY_SIZE * u * u);
+}
+
+/**
+ * Extraction function of the benchmark queries - the query path is QUERY_PATH_PREFIX followed by the query number.
+ */
+static SPPoint *queryExtractionFunction(const char *imagePath, int imageIndex, int *numOfFeaturesExtracted) {
+	int i, query = atoi(imagePath + strlen(QUERY_PATH_PREFIX));
+	SPPoint *features = (SPPoint *) malloc(queriesFeaturesCount[query] * sizeof(SPPoint));
+	(void) imageIndex;
+	if (features == NULL) {
+		*numOfFeaturesExtracted = 0;
+		return NULL;
+	}
+	for (i = 0; i < queriesFeaturesCount[query]; i++) {
+		features[i] = spPointCopy(queriesFeatures[query][i]);
+	}
+	*numOfFeaturesExtracted = queriesFeaturesCount[query];
+	return features;
+}
+
+/**
+ * Generates the catalog features and the queries. The query targets are stored in the given array.
+ *
+ * @return The catalog features, NUM_OF_IMAGES * FEATURES_PER_IMAGE points.
+ */
+static SPPoint *generateData(int *queryTargets) {
+	int i, j, k, word, featuresCount, target;
+	double *words = (double *) malloc(VOCABULARY_SIZE * DIM * sizeof(double));
+	SPPoint *catalog = (SPPoint *) malloc(NUM_OF_IMAGES * FEATURES_PER_IMAGE * sizeof(SPPoint));
+	if (words == NULL || catalog == NULL) {
+		free(words);
+		free(catalog);
+		return NULL;
+	}
+	for (i = 0; i < VOCABULARY_SIZE * DIM; i++) {
+		words[i] = WORD_SPREAD * spBenchmarkRandomUniform();
+	}
+	for (i = 0; i < NUM_OF_IMAGES; i++) {
+		for (j = 0; j < FEATURES_PER_IMAGE; j++) {
+			word = randomWord();
+			catalog[i * FEATURES_PER_IMAGE + j] = spBenchmarkRandomPoint(words + word * DIM, DIM, FEATURE_SIGMA, i);
+		}
+	}
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		target = spBenchmarkRandomInt(NUM_OF_IMAGES);
+		queryTargets[i] = target;
+		queriesFeatures[i] = (SPPoint *) malloc((FEATURES_PER_IMAGE + CLUTTER_FEATURES_PER_QUERY) * sizeof(SPPoint));
+		featuresCount = 0;
+		for (j = 0; j < FEATURES_PER_IMAGE; j++) {
+			if (spBenchmarkRandomUniform() < KEPT_FEATURE_PROBABILITY) {
+				double data[DIM];
+				for (k = 0; k < DIM; k++) {
+					data[k] = spPointGetAxisCoor(catalog[target * FEATURES_PER_IMAGE + j], k);
+				}
+				queriesFeatures[i][featuresCount++] = spBenchmarkRandomPoint(data, DIM, QUERY_SIGMA, 0);
+			}
+		}
+		for (j = 0; j < CLUTTER_FEATURES_PER_QUERY; j++) {
+			word = randomWord();
+			queriesFeatures[i][featuresCount++] = spBenchmarkRandomPoint(words + word * DIM, DIM, FEATURE_SIGMA, 0);
+		}
+		queriesFeaturesCount[i] = featuresCount;
+	}
+	free(words);
+	return catalog;
+}
+
+/**
+ * Runs all of the queries with the given voting mode and nearest neighbors count, and prints a CSV line.
+ */
+static void runConfiguration(SPSearchIndex searchIndex, SPHitsAccumulator accumulator, const int *queryTargets,
+		const char *votingMode, int knn) {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	char knnLine[64], numOfImagesLine[64], similarImagesLine[64], votingModeLine[64], queryPath[64];
+	const char *lines[7];
+	int i, j, resultsCount, *results, recalledFirst = 0, recalled = 0;
+	double start, elapsed;
+	SPConfig config;
+
+	sprintf(numOfImagesLine, "spNumOfImages = %d", NUM_OF_IMAGES);
+	sprintf(knnLine, "spKNN = %d", knn);
+	sprintf(similarImagesLine, "spNumOfSimilarImages = %d", NUM_OF_SIMILAR_IMAGES);
+	sprintf(votingModeLine, "spVotingMode = %s", votingMode);
+	lines[0] = "spImagesDirectory = ./";
+	lines[1] = "spImagesPrefix = benchmark";
+	lines[2] = "spImagesSuffix = .png";
+	lines[3] = numOfImagesLine;
+	lines[4] = knnLine;
+	lines[5] = similarImagesLine;
+	lines[6] = votingModeLine;
+	if (!spBenchmarkWriteConfig(CONFIG_FILENAME, lines, 7)) {
+		fprintf(stderr, "Could not write benchmark configuration file\n");
+		return;
+	}
+	config = spConfigCreate(CONFIG_FILENAME, &configMsg);
+	remove(CONFIG_FILENAME);
+	if (config == NULL) {
+		return;
+	}
+
+	start = spBenchmarkTimeMillis();
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		sprintf(queryPath, "%s%d", QUERY_PATH_PREFIX, i);
+		results = spFindSimilarImagesIndicesWithAccumulator(config, queryPath, searchIndex, accumulator, &resultsCount,
+				queryExtractionFunction, &msg);
+		if (results == NULL) {
+			continue;
+		}
+		for (j = 0; j < resultsCount; j++) {
+			if (results[j] == queryTargets[i]) {
+				recalled++;
+				recalledFirst += (j == 0);
+			}
+		}
+		free(results);
+	}
+	elapsed = spBenchmarkTimeMillis() - start;
+	printf("%s,%d,%.3f,%.3f,%.4f\n", votingMode, knn, (double) recalledFirst / NUM_OF_QUERIES,
+			(double) recalled / NUM_OF_QUERIES, elapsed / NUM_OF_QUERIES);
+	spConfigDestroy(config);
+}
+
+int main(int argc, char *argv[]) {
+	const char *votingModes[] = { "FLAT", "DISTANCE_WEIGHTED", "RATIO_TEST" };
+	const int knns[] = { 1, 2, 3, 5, 10, 20 };
+	int i, j, queryTargets[NUM_OF_QUERIES];
+	SPPoint *catalog;
+	SPKDArray kdArray;
+	SPSearchIndex searchIndex;
+	SPHitsAccumulator accumulator;
+
+	spBenchmarkRandomSeed(argc > 1 ? (unsigned int) atoi(argv[1]) : DEFAULT_SEED);
+	catalog = generateData(queryTargets);
+	if (catalog == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+	kdArray = spKDArrayInit(catalog, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	searchIndex = spSearchIndexCreateKDTree(spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD));
+	spKDArrayDestroy(kdArray);
+	spKDArrayFreePointsArray(catalog, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	accumulator = spHitsAccumulatorCreate(NUM_OF_IMAGES);
+	if (searchIndex == NULL || accumulator == NULL) {
+		fprintf(stderr, "Allocation failure\n");
+		return 1;
+	}
+
+	printf("voting_mode,knn,recall_at_1,recall_at_%d,avg_query_ms\n", NUM_OF_SIMILAR_IMAGES);
+	for (i = 0; i < (int) (sizeof(votingModes) / sizeof(*votingModes)); i++) {
+		for (j = 0; j < (int) (sizeof(knns) / sizeof(*knns)); j++) {
+			runConfiguration(searchIndex, accumulator, queryTargets, votingModes[i], knns[j]);
+		}
+	}
+
+	spHitsAccumulatorDestroy(accumulator);
+	spSearchIndexDestroy(searchIndex);
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		spKDArrayFreePointsArray(queriesFeatures[i], queriesFeaturesCount[i]);
+	}
+	return 0;
+}
@@ -9,22 +9,27 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string.h>
+#include <csignal>
 #include "SPImageProc.h"
 extern "C" {
 #include "SPLogger.h"
-#include "SPKDTree.h"
+#include "SPSearchIndex.h"
 #include "SPPoint.h"
 #include "SPLogger.h"
 #include "SPConfig.h"
 #include "sp_kd_tree_factory.h"
 #include "sp_similar_images_search_api.h"
+#include "SPHitsAccumulator.h"
+#include "sp_query_server.h"
+#include "sp_batch_query.h"
+#include "sp_metrics.h"
 }
 
 /**
  * Main SPCBIR implementation
  *
  * The SPCBIR basic functionality is to find similar images to a given query image, by searching in
- * pre-processed data-structure containing different images information (the kd-tree).
+ * pre-processed data-structure containing different images information (the search index).
  *
  */
 
@@ -35,7 +40,7 @@ extern "C" {
 #define NON_MINIMAL_GUI_RESULTS_TITLE_PREFIX "Best candidates for - "
 #define NON_MINIMAL_GUI_RESULTS_TITLE_SUFFIX " - are:"
 
-#define INVALID_COMMAND_LINE_TEXT "Invalid command line : use -c <config_filename>\n"
+#define INVALID_COMMAND_LINE_TEXT "Invalid command line : use -c <config_filename> [-s <socket_path> | -q <queries_filename> -o <results_filename>] [-m <metrics_filename>]\n"
 
 #define ENDING_QUERIES_STRING "<>"
 
@@ -48,29 +53,87 @@ extern "C" {
 
 #define SP_IMAGE_PROC_CREATION_ERROR_MSG "Could not initialize SPImageProc instance."
 
-#define TREE_CREATION_FATAL_ERROR_MSG "Could not initialize kd-tree properly"
-#define TREE_CREATION_NON_FATAL_ERROR_MSG "KD-Tree was created, but some of the operations did not finish successfully.\n"
-#define TREE_SUCCESSFULLY_CREATE_MSG "KD-Tree was successfully created"
+#define TREE_CREATION_FATAL_ERROR_MSG "Could not initialize the search index properly"
+#define TREE_CREATION_NON_FATAL_ERROR_MSG "Search index was created, but some of the operations did not finish successfully.\n"
+#define TREE_SUCCESSFULLY_CREATE_MSG "Search index was successfully created"
 
 #define QUERY_IMAGE_SEARCH_FAIL_MSG "Similar images search failed for path:"
 #define SHOW_IMAGE_FAIL_MSG "Could not show image at path:"
 #define QUERY_RESULT_COUNT_MSG "Image search complete, the number of results is:"
 
+#define QUERY_SERVER_CREATION_ERROR_MSG "Could not start the query server on:"
+#define QUERY_SERVER_RUN_ERROR_MSG "The query server stopped due to a socket error"
+#define QUERY_SERVER_STOPPED_MSG "The query server was stopped"
+
+#define BATCH_QUERY_ERROR_MSG "Batch query failed,"
+#define METRICS_DUMP_ERROR_MSG "Could not write the metrics to:"
+#define METRICS_PROMETHEUS_SUFFIX ".prom"
+
+#define BATCH_QUERY_STATS_FORMAT "Answered %d queries (%d failed) in %.2f seconds - %.1f queries/second"
+
 using namespace sp;
 
+/** The running query server, stopped by the termination signals handler. */
+static SPQueryServer runningServer = NULL;
+
+/**
+ * Termination signals handler - asks the running query server to stop.
+ *
+ * @param signal The received signal.
+ */
+void stopServerHandler(int signal) {
+	(void) signal;
+	spQueryServerStop(runningServer);
+}
+
+/**
+ * Serves queries over a Unix domain socket until SIGINT or SIGTERM is received.
+ *
+ * @param config The configuration used for the search.
+ * @param searchIndex The search index to search in.
+ * @param func Function used to extract the features of query images.
+ * @param socketPath The path of the socket to listen on.
+ *
+ * @return
+ * 	false if the server could not be started or failed, true otherwise.
+ */
+bool runQueryServer(const SPConfig config, const SPSearchIndex searchIndex, FeatureExractionFunction func,
+		const char *socketPath) {
+	SP_QUERY_SERVER_MSG serverMsg;
+	runningServer = spQueryServerCreate(config, searchIndex, func, socketPath, &serverMsg);
+	if (serverMsg != SP_QUERY_SERVER_SUCCESS) {
+		printf("%s %s\n", QUERY_SERVER_CREATION_ERROR_MSG, socketPath);
+		return false;
+	}
+	std::signal(SIGINT, stopServerHandler);
+	std::signal(SIGTERM, stopServerHandler);
+	serverMsg = spQueryServerRun(runningServer);
+	spQueryServerDestroy(runningServer);
+	runningServer = NULL;
+	if (serverMsg != SP_QUERY_SERVER_SUCCESS) {
+		SP_LOG_ERROR(QUERY_SERVER_RUN_ERROR_MSG);
+		return false;
+	}
+	SP_LOG_INFO(QUERY_SERVER_STOPPED_MSG);
+	return true;
+}
+
 /**
  * Deallocates the given parameters and logger instance.
  *
  * @param config SPConfig instance to destroy.
- * @param searchTree SPKDTreeNode instance to destroy.
+ * @param searchIndex SPSearchIndex instance to destroy.
+ * @param accumulator SPHitsAccumulator instance to destroy.
  * @param currentResultImagePath String to deallocate.
  * @param filename String to deallocate.
  * @param imageQueryPath String to deallocate.
  */
-void freeAll(SPConfig config, SPKDTreeNode searchTree, char *currentResultImagePath, char *filename, char *imageQueryPath) {
+void freeAll(SPConfig config, SPSearchIndex searchIndex, SPHitsAccumulator accumulator, char *currentResultImagePath,
+		char *filename, char *imageQueryPath) {
 	spConfigDestroy(config);
 	spLoggerDestroy();
-	spKDTreeDestroy(searchTree);
+	spSearchIndexDestroy(searchIndex);
+	spHitsAccumulatorDestroy(accumulator);
 	free(currentResultImagePath);
 	free(filename);
 	free(imageQueryPath);
@@ -97,19 +160,103 @@ bool createLogger(const SPConfig config, SP_LOGGER_MSG *msg) {
 		return false;
 	}
 
+	bool loggerAsync = spConfigIsLoggerAsync(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+
+	bool loggerRecordTags = spConfigIsLoggerRecordTags(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+
 	// Creating logger
-	*msg = spLoggerCreate(loggerFilename, loggerLevel);
+	if (loggerAsync) {
+		*msg = spLoggerCreateAsync(loggerFilename, loggerLevel, LOGGER_ASYNC_CAPACITY);
+	} else {
+		*msg = spLoggerCreate(loggerFilename, loggerLevel);
+	}
+	if (*msg == SP_LOGGER_SUCCESS && loggerRecordTags) {
+		spLoggerSetRecordTags(true, true);
+	}
+	return true;
+}
+
+/**
+ * Answers all of the queries of the given queries file into the given results file, and reports the throughput.
+ *
+ * @param config The configuration used for the search.
+ * @param searchIndex The search index to search in.
+ * @param func Function used to extract the features of query images.
+ * @param queriesFilename The path of the queries file.
+ * @param resultsFilename The path of the results file.
+ *
+ * @return
+ * 	false if the batch run failed, true otherwise.
+ */
+bool runBatchQuery(const SPConfig config, const SPSearchIndex searchIndex, FeatureExractionFunction func,
+		const char *queriesFilename, const char *resultsFilename) {
+	char logMSG[LOGGER_MSG_LENGTH];
+	SPBatchQueryStats stats;
+	SP_BATCH_QUERY_MSG batchMsg = spBatchQueryRun(config, searchIndex, func, queriesFilename, resultsFilename, &stats);
+	if (batchMsg != SP_BATCH_QUERY_SUCCESS) {
+		sprintf(logMSG, "%s %s %d", BATCH_QUERY_ERROR_MSG, RETURN_VALUE_MSG, batchMsg);
+		SP_LOG_ERROR("%s", logMSG);
+		printf("%s\n", logMSG);
+		return false;
+	}
+	sprintf(logMSG, BATCH_QUERY_STATS_FORMAT, stats.numOfQueries, stats.numOfFailedQueries, stats.elapsedSeconds,
+			stats.elapsedSeconds > 0 ? stats.numOfQueries / stats.elapsedSeconds : 0);
+	SP_LOG_INFO("%s", logMSG);
+	printf("%s\n", logMSG);
 	return true;
 }
 
+/**
+ * Writes the recorded timers and counters to the given file - in the Prometheus text format if the filename ends
+ * with METRICS_PROMETHEUS_SUFFIX, as JSON otherwise.
+ *
+ * @param metricsFilename The path of the metrics file. If NULL nothing is done.
+ */
+void dumpMetrics(const char *metricsFilename) {
+	if (metricsFilename == NULL) {
+		return;
+	}
+	size_t length = strlen(metricsFilename), suffixLength = strlen(METRICS_PROMETHEUS_SUFFIX);
+	SP_METRICS_FORMAT format = SP_METRICS_FORMAT_JSON;
+	if (length >= suffixLength && strcmp(metricsFilename + length - suffixLength, METRICS_PROMETHEUS_SUFFIX) == 0) {
+		format = SP_METRICS_FORMAT_PROMETHEUS;
+	}
+	FILE *metricsFile = fopen(metricsFilename, "w");
+	SP_METRICS_MSG metricsMsg = spMetricsDump(metricsFile, format);
+	if (metricsFile != NULL && fclose(metricsFile) != 0) {
+		metricsMsg = SP_METRICS_WRITE_FAIL;
+	}
+	if (metricsMsg != SP_METRICS_SUCCESS) {
+		SP_LOG_ERROR("%s %s", METRICS_DUMP_ERROR_MSG, metricsFilename);
+		printf("%s %s\n", METRICS_DUMP_ERROR_MSG, metricsFilename);
+	}
+}
+
 /**
  * Main Function of SPCBIR.
- * Creates a kd-tree by the configured parameters, and searches for similar images of user's query paths.
+ * Creates a search index by the configured parameters, and searches for similar images of user's query paths.
  *
  * In the arguments, one can configure a desired configuration file path by using -c flag as follows:
  * 		./SPCBIR -c myconfig.config
  * If not configured, the program will use a default value: spcbir.config
  *
+ * Instead of reading query paths from the standard input, the program can serve queries over a Unix domain socket
+ * (see sp_query_server.h) until it is interrupted, by using -s flag as follows:
+ * 		./SPCBIR -c myconfig.config -s /tmp/spcbir.sock
+ *
+ * Or answer a whole list of query images at once (see sp_batch_query.h) by using -q and -o flags as follows:
+ * 		./SPCBIR -c myconfig.config -q queries.txt -o results.tsv
+ *
+ * In every mode, the -m flag records the hot-path timers and counters (see sp_metrics.h), and writes them to the
+ * given file on exit - in the Prometheus text format for a ".prom" file, as JSON otherwise:
+ * 		./SPCBIR -c myconfig.config -m metrics.json
+ *
  * @param argc Number of command line arguments.
  * @param argv Array of command line arguments.
  *
@@ -117,16 +264,16 @@ bool createLogger(const SPConfig config, SP_LOGGER_MSG *msg) {
  * 	The return code: 1 on failure, 0 on success.
  */
 int main(int argc, char *argv[]) {
-	char logMSG[LOGGER_MSG_LENGTH] = { '\0' };
-
 	int resultsCount;
 	SP_CONFIG_MSG resultMSG;
 
 	// init with nulls for destroy methods
-	SPKDTreeNode searchTree = NULL;
+	SPSearchIndex searchIndex = NULL;
+	SPHitsAccumulator accumulator = NULL;
 	static ImageProc *ipPtr = NULL;
 
 	char *currentResultImagePath = NULL, *imageQueryPath = NULL, *filename = (char *) malloc(LINE_MAX_SIZE * sizeof(char));
+	const char *serverSocketPath = NULL, *queriesFilename = NULL, *resultsFilename = NULL, *metricsFilename = NULL;
 
 	// Input validation and in case of no config, default config file setting
 	if (filename == NULL) {
@@ -134,15 +281,30 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
-	if (argc > 3 || argc == 2 || (argc == 3 && strcmp(argv[1], "-c") != 0)) {
+	strcpy(filename, DEFAULT_CONFIG_FILENAME);
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 < argc && strcmp(argv[i], "-c") == 0) {
+			strcpy(filename, argv[i + 1]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			serverSocketPath = argv[i + 1];
+		} else if (i + 1 < argc && strcmp(argv[i], "-q") == 0) {
+			queriesFilename = argv[i + 1];
+		} else if (i + 1 < argc && strcmp(argv[i], "-o") == 0) {
+			resultsFilename = argv[i + 1];
+		} else if (i + 1 < argc && strcmp(argv[i], "-m") == 0) {
+			metricsFilename = argv[i + 1];
+		} else {
+			printf(INVALID_COMMAND_LINE_TEXT);
+			free(filename);
+			return 1;
+		}
+	}
+	if ((queriesFilename == NULL) != (resultsFilename == NULL) || (queriesFilename != NULL && serverSocketPath != NULL)) {
 		printf(INVALID_COMMAND_LINE_TEXT);
 		free(filename);
 		return 1;
-	} else if (argc == 1) {
-		strcpy(filename, DEFAULT_CONFIG_FILENAME);
-	} else {
-		strcpy(filename, argv[2]);
 	}
+	spMetricsSetEnabled(metricsFilename != NULL);
 
 	// Creating config file and exiting on failure.
 	// Error messages handling by SPConfig.c
@@ -157,7 +319,7 @@ int main(int argc, char *argv[]) {
 
 	if (!createLogger(config, &loggerMSG)) {
 		printf(SP_CONFIG_ACCESS_ERROR);
-		freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 		return 1;
 	}
 
@@ -172,7 +334,7 @@ int main(int argc, char *argv[]) {
 			default:
 				break;
 		}
-		freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 		return 1;
 	}
 
@@ -181,7 +343,7 @@ int main(int argc, char *argv[]) {
 		ipPtr = &ip;
 	} catch (...) {
 		printRErrorMsg(__FILE__, __LINE__, SP_IMAGE_PROC_CREATION_ERROR_MSG);
-		freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 		return 1;
 	}
 
@@ -195,34 +357,61 @@ int main(int argc, char *argv[]) {
 	};
 
 	SP_KD_TREE_CREATION_MSG treeCreationMsg;
-	searchTree = spImagesKDTreeCreate(config, func, &treeCreationMsg);
+	searchIndex = spImagesSearchIndexCreate(config, func, &treeCreationMsg);
 	if (treeCreationMsg == SP_KD_TREE_CREATION_SUCCESS) {
-		spLoggerPrintInfo(TREE_SUCCESSFULLY_CREATE_MSG);
+		SP_LOG_INFO(TREE_SUCCESSFULLY_CREATE_MSG);
 	} else {
 		if (treeCreationMsg != SP_KD_TREE_CREATION_NON_FATAL_ERROR) {
-			sprintf(logMSG, "%s, %s %d", TREE_CREATION_FATAL_ERROR_MSG, RETURN_VALUE_MSG, treeCreationMsg);
-			spLoggerPrintDebug(logMSG, __FILE__, __func__, __LINE__);
+			SP_LOG_DEBUG("%s, %s %d", TREE_CREATION_FATAL_ERROR_MSG, RETURN_VALUE_MSG, treeCreationMsg);
 			printRErrorMsg(__FILE__, __LINE__, TREE_CREATION_FATAL_ERROR_MSG);
-			freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+			freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 			return 1;
 		} else {
 			printf(TREE_CREATION_NON_FATAL_ERROR_MSG);
 		}
 	}
 
+	if (serverSocketPath != NULL) {
+		bool served = runQueryServer(config, searchIndex, func, serverSocketPath);
+		dumpMetrics(metricsFilename);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
+		return served ? 0 : 1;
+	}
+
+	if (queriesFilename != NULL) {
+		bool answered = runBatchQuery(config, searchIndex, func, queriesFilename, resultsFilename);
+		dumpMetrics(metricsFilename);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
+		return answered ? 0 : 1;
+	}
+
 	imageQueryPath = (char *) malloc(LINE_MAX_SIZE * sizeof(char));
 	currentResultImagePath = (char *) malloc (MAX_PATH_LENGTH * sizeof(char));
 
 	if (imageQueryPath == NULL || currentResultImagePath == NULL) {
 		printRErrorMsg(__FILE__, __LINE__, ALLOCATION_ERROR_MSG);
-		freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 		return 1;
 	}
 
 	bool minimalGUI = spConfigMinimalGui(config, &resultMSG);
 	if (resultMSG != SP_CONFIG_SUCCESS) {
 		printf(SP_CONFIG_ACCESS_ERROR);
-		freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
+		return 1;
+	}
+
+	// The hits accumulator is allocated once and reused by all of the queries
+	int numOfImages = spConfigGetNumOfImages(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS) {
+		printf(SP_CONFIG_ACCESS_ERROR);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
+		return 1;
+	}
+	accumulator = spHitsAccumulatorCreate(numOfImages);
+	if (accumulator == NULL) {
+		printRErrorMsg(__FILE__, __LINE__, ALLOCATION_ERROR_MSG);
+		freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 		return 1;
 	}
 
@@ -236,14 +425,13 @@ int main(int argc, char *argv[]) {
 		} else {
 
 			SP_SIMILAR_IMAGES_SEARCH_API_MSG queryMsg;
-			int *similarImages = spFindSimilarImagesIndices(config, imageQueryPath, searchTree, &resultsCount, func, &queryMsg);
+			int *similarImages = spFindSimilarImagesIndicesWithAccumulator(config, imageQueryPath, searchIndex, accumulator,
+					&resultsCount, func, &queryMsg);
 
-			sprintf(logMSG, "%s %d", QUERY_RESULT_COUNT_MSG, resultsCount);
-			spLoggerPrintInfo(logMSG);
+			SP_LOG_INFO("%s %d", QUERY_RESULT_COUNT_MSG, resultsCount);
 
 			if (queryMsg != SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS) {
-				sprintf(logMSG, "%s %s %s %d", QUERY_IMAGE_SEARCH_FAIL_MSG, imageQueryPath, RETURN_VALUE_MSG, queryMsg);
-				spLoggerPrintError(logMSG, __FILE__, __func__, __LINE__);
+				SP_LOG_ERROR("%s %s %s %d", QUERY_IMAGE_SEARCH_FAIL_MSG, imageQueryPath, RETURN_VALUE_MSG, queryMsg);
 				printf("%s %s\n", QUERY_IMAGE_SEARCH_FAIL_MSG, imageQueryPath);
 				continue;
 			}
@@ -269,7 +457,8 @@ int main(int argc, char *argv[]) {
 
 		}
 	}
-	freeAll(config, searchTree, currentResultImagePath, filename, imageQueryPath);
+	dumpMetrics(metricsFilename);
+	freeAll(config, searchIndex, accumulator, currentResultImagePath, filename, imageQueryPath);
 	printf(EXIT_MESSAGE);
 	return 0;
 }
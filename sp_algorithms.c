@@ -7,16 +7,31 @@
 
 #include "sp_algorithms.h"
 #include <math.h>
+#include <string.h>
+#include "sp_metrics.h"
 
-void spKNearestNeighbours(SPKDTreeNode tree, SPBPQueue queue, SPPoint point) {
+/*** Private Methods ***/
+
+/** The work done by a single nearest neighbors search. */
+typedef struct knn_search_counts_t {
+	unsigned long long nodesVisited;
+	unsigned long long leavesScanned;
+} KNNSearchCounts;
+
+/**
+ * Recursive implementation of spKNearestNeighbours, which also counts the work done by the search.
+ */
+void kNearestNeighbours(SPKDTreeNode tree, SPBPQueue queue, SPPoint point, KNNSearchCounts *counts) {
 	int dim;
 	double pointValue, nodeMedianValue, maxQueueValue;
 	SPListElement insertedElement;
 	SPPoint *leafPoint;
-	if (tree == NULL || queue == NULL) {
+	if (tree == NULL) {
 		return;
 	}
+	counts->nodesVisited++;
 	if (spKDTreeNodeIsLeaf(tree)) {
+		counts->leavesScanned++;
 		leafPoint = spKDTreeNodeGetData(tree);
 		insertedElement = spListElementCreate(spPointGetIndex(*leafPoint), spPointL2SquaredDistance(*leafPoint, point));
 		spBPQueueEnqueue(queue, insertedElement);
@@ -30,17 +45,151 @@ void spKNearestNeighbours(SPKDTreeNode tree, SPBPQueue queue, SPPoint point) {
 	pointValue = spPointGetAxisCoor(point, dim);
 
 	if (pointValue <= nodeMedianValue) {
-		spKNearestNeighbours(spKDTreeNodeGetLeftChild(tree), queue, point);
+		kNearestNeighbours(spKDTreeNodeGetLeftChild(tree), queue, point, counts);
 	} else {
-		spKNearestNeighbours(spKDTreeNodeGetRightChild(tree), queue, point);
+		kNearestNeighbours(spKDTreeNodeGetRightChild(tree), queue, point, counts);
 	}
 	maxQueueValue = spBPQueueMaxValue(queue);
 
 	if (!spBPQueueIsFull(queue) || pow(pointValue - nodeMedianValue, 2) < maxQueueValue) {
 		if (pointValue <= nodeMedianValue) {
-			spKNearestNeighbours(spKDTreeNodeGetRightChild(tree), queue, point);
+			kNearestNeighbours(spKDTreeNodeGetRightChild(tree), queue, point, counts);
 		} else {
-			spKNearestNeighbours(spKDTreeNodeGetLeftChild(tree), queue, point);
+			kNearestNeighbours(spKDTreeNodeGetLeftChild(tree), queue, point, counts);
+		}
+	}
+}
+
+/**
+ * Returns the squared distance between two vectors of the given dimension.
+ */
+double vectorsL2SquaredDistance(const double *first, const double *second, int dimension) {
+	int i;
+	double difference, distance = 0;
+	for (i = 0; i < dimension; i++) {
+		difference = first[i] - second[i];
+		distance += difference * difference;
+	}
+	return distance;
+}
+
+/**
+ * Assigns every vector to its nearest centroid.
+ *
+ * @return
+ * 	The number of vectors whose assigned cluster changed.
+ */
+int assignToCentroids(const double *data, int numOfVectors, int dimension, const double *centroids,
+		int numOfClusters, int *assignments, double *distances) {
+	int i, nearest, numOfChanges = 0;
+	for (i = 0; i < numOfVectors; i++) {
+		nearest = spNearestCentroid(centroids, numOfClusters, dimension, data + (size_t) i * dimension,
+				&distances[i]);
+		numOfChanges += (nearest != assignments[i]);
+		assignments[i] = nearest;
+	}
+	return numOfChanges;
+}
+
+/**
+ * Moves every centroid to the mean of its cluster. A centroid of an empty cluster is moved to the vector farthest
+ * from its own centroid, which is then taken out of the ranking of farthest vectors.
+ */
+void updateCentroids(const double *data, int numOfVectors, int dimension, double *centroids, int numOfClusters,
+		const int *assignments, double *distances, int *clusterSizes) {
+	int i, j, cluster, farthest;
+	memset(centroids, 0, (size_t) numOfClusters * dimension * sizeof(double));
+	memset(clusterSizes, 0, numOfClusters * sizeof(int));
+	for (i = 0; i < numOfVectors; i++) {
+		cluster = assignments[i];
+		clusterSizes[cluster]++;
+		for (j = 0; j < dimension; j++) {
+			centroids[(size_t) cluster * dimension + j] += data[(size_t) i * dimension + j];
+		}
+	}
+	for (cluster = 0; cluster < numOfClusters; cluster++) {
+		if (clusterSizes[cluster] > 0) {
+			for (j = 0; j < dimension; j++) {
+				centroids[(size_t) cluster * dimension + j] /= clusterSizes[cluster];
+			}
+			continue;
 		}
+		farthest = 0;
+		for (i = 1; i < numOfVectors; i++) {
+			farthest = (distances[i] > distances[farthest]) ? i : farthest;
+		}
+		memcpy(centroids + (size_t) cluster * dimension, data + (size_t) farthest * dimension,
+				dimension * sizeof(double));
+		distances[farthest] = -1;
+	}
+}
+
+/*** Public Methods ***/
+
+void spKNearestNeighbours(SPKDTreeNode tree, SPBPQueue queue, SPPoint point) {
+	KNNSearchCounts counts = { 0, 0 };
+	if (tree == NULL || queue == NULL) {
+		return;
+	}
+	SP_METRICS_TIMER_START(traversalTimer);
+	kNearestNeighbours(tree, queue, point, &counts);
+	SP_METRICS_TIMER_STOP(traversalTimer, SP_METRICS_TREE_TRAVERSAL);
+	SP_METRICS_COUNT(SP_METRICS_NODES_VISITED, counts.nodesVisited);
+	SP_METRICS_COUNT(SP_METRICS_LEAVES_SCANNED, counts.leavesScanned);
+	// Every leaf holds a single point
+	SP_METRICS_COUNT(SP_METRICS_DISTANCE_COMPUTATIONS, counts.leavesScanned);
+}
+
+bool spKMeans(const double *data, int numOfVectors, int dimension, int numOfClusters, int maxIterations,
+		double *centroids) {
+	int i, iteration, *assignments, *clusterSizes;
+	double *distances;
+	if (data == NULL || centroids == NULL || dimension <= 0 || numOfClusters <= 0 || numOfClusters > numOfVectors
+			|| maxIterations <= 0) {
+		return false;
+	}
+	assignments = (int *) malloc(numOfVectors * sizeof(int));
+	clusterSizes = (int *) malloc(numOfClusters * sizeof(int));
+	distances = (double *) malloc(numOfVectors * sizeof(double));
+	if (assignments == NULL || clusterSizes == NULL || distances == NULL) {
+		free(assignments);
+		free(clusterSizes);
+		free(distances);
+		return false;
+	}
+	for (i = 0; i < numOfClusters; i++) {
+		memcpy(centroids + (size_t) i * dimension, data + ((size_t) i * numOfVectors / numOfClusters) * dimension,
+				dimension * sizeof(double));
+	}
+	for (i = 0; i < numOfVectors; i++) {
+		assignments[i] = -1;
+	}
+	for (iteration = 0; iteration < maxIterations; iteration++) {
+		if (assignToCentroids(data, numOfVectors, dimension, centroids, numOfClusters, assignments, distances) == 0) {
+			break;
+		}
+		updateCentroids(data, numOfVectors, dimension, centroids, numOfClusters, assignments, distances,
+				clusterSizes);
+	}
+	free(assignments);
+	free(clusterSizes);
+	free(distances);
+	return true;
+}
+
+int spNearestCentroid(const double *centroids, int numOfCentroids, int dimension, const double *vector,
+		double *distance) {
+	int i, nearest = 0;
+	double currentDistance, nearestDistance = vectorsL2SquaredDistance(centroids, vector, dimension);
+	for (i = 1; i < numOfCentroids; i++) {
+		currentDistance = vectorsL2SquaredDistance(centroids + (size_t) i * dimension, vector, dimension);
+		if (currentDistance < nearestDistance) {
+			nearestDistance = currentDistance;
+			nearest = i;
+		}
+	}
+	if (distance != NULL) {
+		*distance = nearestDistance;
 	}
+	return nearest;
 }
@@ -9,6 +9,7 @@
 #define SP_ALGORITHMS_H_
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include "SPBPriorityQueue.h"
 #include "SPKDTree.h"
 #include "SPPoint.h"
@@ -18,6 +19,8 @@
  *
  * The following functions are available:
  * 		spKNearestNeighbours 			- Implementation of a nearest neighbor algorithm.
+ * 		spKMeans						- Implementation of the k-means clustering algorithm.
+ * 		spNearestCentroid				- Finds the centroid nearest to a vector.
  *
  */
 
@@ -31,4 +34,38 @@
  */
 void spKNearestNeighbours(SPKDTreeNode tree, SPBPQueue queue, SPPoint point);
 
+/**
+ * Implementation of the k-means clustering algorithm (Lloyd's iterations).
+ * The centroids are initialized to vectors spread evenly over the data, so the clustering is deterministic.
+ * A cluster which is left empty by an iteration is moved to the vector farthest from its centroid.
+ * The iterations stop when no vector changes its cluster, or after maxIterations iterations.
+ *
+ * @param data The vectors to cluster, numOfVectors rows of dimension values.
+ * @param numOfVectors The number of vectors.
+ * @param dimension The dimension of the vectors.
+ * @param numOfClusters The number of clusters, at most numOfVectors.
+ * @param maxIterations The maximal number of iterations.
+ * @param centroids Place-holder for the centroids, numOfClusters rows of dimension values.
+ *
+ * @return
+ * 	false if one of the arguments is invalid or in case of allocation failure, true otherwise.
+ */
+bool spKMeans(const double *data, int numOfVectors, int dimension, int numOfClusters, int maxIterations,
+		double *centroids);
+
+/**
+ * Finds the centroid nearest (by squared distance) to the given vector.
+ *
+ * @param centroids The centroids, numOfCentroids rows of dimension values.
+ * @param numOfCentroids The number of centroids, must be positive.
+ * @param dimension The dimension of the vector and the centroids.
+ * @param vector The vector.
+ * @param distance Place-holder for the squared distance to the nearest centroid, may be NULL.
+ *
+ * @return
+ * 	The index of the nearest centroid.
+ */
+int spNearestCentroid(const double *centroids, int numOfCentroids, int dimension, const double *vector,
+		double *distance);
+
 #endif /* SP_ALGORITHMS_H_ */
@@ -0,0 +1,333 @@
+/*
+ * sp_batch_query.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sp_batch_query.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "SPThreadPool.h"
+#include "SPHitsAccumulator.h"
+#include "SPLogger.h"
+#include "SPKDArray.h"
+#include "sp_features_file_api.h"
+#include "sp_similar_images_search_api.h"
+
+/*** Constants ***/
+
+#define STATUS_OK "OK"
+#define STATUS_EXTRACTION_ERROR "EXTRACTION_ERROR"
+#define STATUS_ERROR "ERROR"
+
+/** An upper bound of the length of a single "<index>:<score>," result. */
+#define RESULT_MAX_LENGTH 48
+
+#define BATCH_QUERY_FAIL_MSG "Batch query failed for path:"
+
+/*** Type declarations ***/
+
+struct batch_run_t;
+
+/** Structure containing a single in flight query. */
+typedef struct batch_slot_t {
+	struct batch_run_t *run;
+	char *queryPath;
+	char *resultLine;
+	bool failed;
+	bool done;
+} BatchSlot;
+
+/** Structure containing the data shared by the queries of a batch run. */
+typedef struct batch_run_t {
+	SPConfig config;
+	SPSearchIndex searchIndex;
+	FeatureExractionFunction extractionFunc;
+	SPHitsAccumulator *accumulators;
+	BatchSlot slots[SP_BATCH_QUERY_WINDOW];
+	pthread_mutex_t mutex;
+	pthread_cond_t slotDone;
+} BatchRun;
+
+/*** Private Methods ***/
+
+/**
+ * Returns a time stamp of a monotonic clock, in seconds.
+ */
+double monotonicSeconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Formats the results line of a query.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the formatted line otherwise.
+ */
+char *formatResultLine(const char *queryPath, const char *status, const int *results, int resultsCount,
+		SPHitsAccumulator accumulator) {
+	int i;
+	size_t length = strlen(queryPath) + strlen(status) + 4 + (size_t) resultsCount * RESULT_MAX_LENGTH;
+	char *line = (char *) malloc(length), *current;
+	if (line == NULL) {
+		return NULL;
+	}
+	current = line + sprintf(line, "%s\t%s\t", queryPath, status);
+	for (i = 0; i < resultsCount; i++) {
+		current += sprintf(current, "%s%d:%g", i > 0 ? "," : "", results[i],
+				spHitsAccumulatorGetHits(accumulator, results[i]));
+	}
+	strcpy(current, "\n");
+	return line;
+}
+
+/**
+ * Searches for the images similar to a query given as a features file, bypassing the image decoding.
+ *
+ * @param run The batch run.
+ * @param featuresPath The path of the query's features file.
+ * @param accumulator The accumulator of the executing worker.
+ * @param resultsCount Place-holder for the number of results.
+ * @param msg Place-holder for the search result. A features file which could not be loaded is reported as a
+ * 		features extraction error.
+ *
+ * @return
+ * 	NULL in case of a failure, the similar images indices otherwise.
+ */
+int *searchByFeaturesFile(BatchRun *run, const char *featuresPath, SPHitsAccumulator accumulator, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SP_CONFIG_MSG configMsg;
+	SP_FEATURES_FILE_API_MSG featuresMsg;
+	SPPoint *features;
+	int numOfFeatures = 0, *results, pcaDimension = spConfigGetPCADim(run->config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR;
+		return NULL;
+	}
+	features = spFeaturesFileAPILoad(featuresPath, 0, pcaDimension, &numOfFeatures, &featuresMsg);
+	if (features == NULL) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR;
+		return NULL;
+	}
+	results = spFindSimilarImagesIndicesByFeatures(run->config, features, numOfFeatures, run->searchIndex,
+			accumulator, resultsCount, msg);
+	spKDArrayFreePointsArray(features, numOfFeatures);
+	return results;
+}
+
+/**
+ * The job answering a single query - searches for the similar images and formats the results line.
+ *
+ * @param arg The query's slot.
+ * @param workerIndex The index of the executing worker.
+ */
+void answerQuery(void *arg, int workerIndex) {
+	BatchSlot *slot = (BatchSlot *) arg;
+	BatchRun *run = slot->run;
+	SPHitsAccumulator accumulator = run->accumulators[workerIndex];
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG searchMsg;
+	int resultsCount = 0, *results;
+	size_t prefixLength = strlen(SP_BATCH_QUERY_FEATURES_PREFIX);
+	if (strncmp(slot->queryPath, SP_BATCH_QUERY_FEATURES_PREFIX, prefixLength) == 0) {
+		results = searchByFeaturesFile(run, slot->queryPath + prefixLength, accumulator, &resultsCount, &searchMsg);
+	} else {
+		results = spFindSimilarImagesIndicesWithAccumulator(run->config, slot->queryPath, run->searchIndex,
+				accumulator, &resultsCount, run->extractionFunc, &searchMsg);
+	}
+	if (results != NULL) {
+		slot->resultLine = formatResultLine(slot->queryPath, STATUS_OK, results, resultsCount, accumulator);
+		free(results);
+	} else {
+		SP_LOG_WARNING("%s %s %s %d", BATCH_QUERY_FAIL_MSG, slot->queryPath, RETURN_VALUE_MSG, searchMsg);
+		slot->resultLine = formatResultLine(slot->queryPath,
+				searchMsg == SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR ?
+						STATUS_EXTRACTION_ERROR : STATUS_ERROR, NULL, 0, accumulator);
+	}
+	slot->failed = (results == NULL);
+	pthread_mutex_lock(&run->mutex);
+	slot->done = true;
+	pthread_cond_broadcast(&run->slotDone);
+	pthread_mutex_unlock(&run->mutex);
+}
+
+/**
+ * Waits for the query of the given slot to be answered, writes its results line and frees the slot.
+ *
+ * @return
+ * 	false if the results line could not be written, true otherwise.
+ */
+bool writeSlot(BatchRun *run, BatchSlot *slot, FILE *resultsFile, SPBatchQueryStats *stats) {
+	bool written;
+	pthread_mutex_lock(&run->mutex);
+	while (!slot->done) {
+		pthread_cond_wait(&run->slotDone, &run->mutex);
+	}
+	pthread_mutex_unlock(&run->mutex);
+	written = slot->resultLine != NULL && fputs(slot->resultLine, resultsFile) >= 0;
+	stats->numOfFailedQueries += slot->failed;
+	free(slot->queryPath);
+	free(slot->resultLine);
+	slot->queryPath = NULL;
+	slot->resultLine = NULL;
+	return written;
+}
+
+/**
+ * Removes the line break characters from the end of the given line.
+ *
+ * @return
+ * 	The length of the trimmed line.
+ */
+size_t trimLineBreak(char *line) {
+	size_t length = strlen(line);
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+		line[--length] = '\0';
+	}
+	return length;
+}
+
+/**
+ * Deallocates the per worker accumulators.
+ */
+void destroyAccumulators(SPHitsAccumulator *accumulators, int numOfWorkers) {
+	int i;
+	if (accumulators == NULL) {
+		return;
+	}
+	for (i = 0; i < numOfWorkers; i++) {
+		spHitsAccumulatorDestroy(accumulators[i]);
+	}
+	free(accumulators);
+}
+
+/*** Public Methods ***/
+
+SP_BATCH_QUERY_MSG spBatchQueryRun(const SPConfig config, const SPSearchIndex searchIndex,
+		FeatureExractionFunction extractionFunc, const char *queriesFilename, const char *resultsFilename,
+		SPBatchQueryStats *stats) {
+	SP_CONFIG_MSG configMsg;
+	SP_BATCH_QUERY_MSG res = SP_BATCH_QUERY_SUCCESS;
+	FILE *queriesFile, *resultsFile;
+	SPThreadPool pool;
+	BatchRun *run;
+	BatchSlot *slot;
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	int i, numOfImages, numOfWorkers, submitted = 0, written = 0;
+	double start = monotonicSeconds();
+	if (config == NULL || searchIndex == NULL || extractionFunc == NULL || queriesFilename == NULL
+			|| resultsFilename == NULL || stats == NULL) {
+		return SP_BATCH_QUERY_INVALID_ARGUMENT;
+	}
+	stats->numOfQueries = 0;
+	stats->numOfFailedQueries = 0;
+	stats->elapsedSeconds = 0;
+	numOfImages = spConfigGetNumOfImages(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return SP_BATCH_QUERY_CONFIG_ERROR;
+	}
+	numOfWorkers = spConfigGetNumOfThreads(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return SP_BATCH_QUERY_CONFIG_ERROR;
+	}
+
+	queriesFile = fopen(queriesFilename, "r");
+	if (queriesFile == NULL) {
+		return SP_BATCH_QUERY_CANNOT_OPEN_QUERIES_FILE;
+	}
+	resultsFile = fopen(resultsFilename, "w");
+	if (resultsFile == NULL) {
+		fclose(queriesFile);
+		return SP_BATCH_QUERY_CANNOT_OPEN_RESULTS_FILE;
+	}
+	run = (BatchRun *) calloc(1, sizeof(BatchRun));
+	if (run != NULL) {
+		run->accumulators = (SPHitsAccumulator *) calloc(numOfWorkers, sizeof(SPHitsAccumulator));
+	}
+	if (run == NULL || run->accumulators == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		free(run);
+		fclose(queriesFile);
+		fclose(resultsFile);
+		return SP_BATCH_QUERY_ALLOC_FAIL;
+	}
+	for (i = 0; i < numOfWorkers; i++) {
+		run->accumulators[i] = spHitsAccumulatorCreate(numOfImages);
+		if (run->accumulators[i] == NULL) {
+			res = SP_BATCH_QUERY_ALLOC_FAIL;
+		}
+	}
+	pool = spThreadPoolCreate(numOfWorkers, SP_BATCH_QUERY_WINDOW);
+	if (pool == NULL || res != SP_BATCH_QUERY_SUCCESS) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		spThreadPoolDestroy(pool);
+		destroyAccumulators(run->accumulators, numOfWorkers);
+		free(run);
+		fclose(queriesFile);
+		fclose(resultsFile);
+		return SP_BATCH_QUERY_ALLOC_FAIL;
+	}
+	run->config = config;
+	run->searchIndex = searchIndex;
+	run->extractionFunc = extractionFunc;
+	pthread_mutex_init(&run->mutex, NULL);
+	pthread_cond_init(&run->slotDone, NULL);
+
+	while (res == SP_BATCH_QUERY_SUCCESS && getline(&line, &lineCapacity, queriesFile) >= 0) {
+		if (trimLineBreak(line) == 0) {
+			continue;
+		}
+		slot = &run->slots[submitted % SP_BATCH_QUERY_WINDOW];
+		// The slot is reused - the query which occupied it must be written first
+		if (submitted - written == SP_BATCH_QUERY_WINDOW) {
+			if (!writeSlot(run, slot, resultsFile, stats)) {
+				res = SP_BATCH_QUERY_WRITE_ERROR;
+			}
+			written++;
+		}
+		slot->run = run;
+		slot->done = false;
+		slot->failed = false;
+		slot->resultLine = NULL;
+		slot->queryPath = (char *) malloc(strlen(line) + 1);
+		if (slot->queryPath == NULL) {
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+			res = SP_BATCH_QUERY_ALLOC_FAIL;
+			break;
+		}
+		strcpy(slot->queryPath, line);
+		spThreadPoolSubmit(pool, answerQuery, slot);
+		submitted++;
+	}
+	free(line);
+
+	// The rest of the in flight queries are written (or at least freed) in order
+	for (; written < submitted; written++) {
+		if (!writeSlot(run, &run->slots[written % SP_BATCH_QUERY_WINDOW], resultsFile, stats)
+				&& res == SP_BATCH_QUERY_SUCCESS) {
+			res = SP_BATCH_QUERY_WRITE_ERROR;
+		}
+	}
+	spThreadPoolDestroy(pool);
+	if (fclose(resultsFile) != 0 && res == SP_BATCH_QUERY_SUCCESS) {
+		res = SP_BATCH_QUERY_WRITE_ERROR;
+	}
+	fclose(queriesFile);
+	pthread_mutex_destroy(&run->mutex);
+	pthread_cond_destroy(&run->slotDone);
+	destroyAccumulators(run->accumulators, numOfWorkers);
+	free(run);
+
+	stats->numOfQueries = submitted;
+	stats->elapsedSeconds = monotonicSeconds() - start;
+	return res;
+}
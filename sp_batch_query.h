@@ -0,0 +1,91 @@
+/*
+ * sp_batch_query.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SP_BATCH_QUERY_H_
+#define SP_BATCH_QUERY_H_
+
+#include "sp_constants.h"
+#include "SPConfig.h"
+#include "SPSearchIndex.h"
+
+/**
+ * Implementation of the batch querying logic - answers a whole list of query images at once.
+ *
+ * The queries are answered concurrently by a pool of spNumOfThreads worker threads which share the (read-only)
+ * search index. Every worker answers a query from start to end (image decoding, features extraction and voting),
+ * so while one worker extracts the features of an image, the others are at different stages of other queries.
+ * The results are written by the calling thread, in the order of the queries, and at most
+ * SP_BATCH_QUERY_WINDOW queries are in flight at any time.
+ *
+ * The queries file contains a query in every line; empty lines are ignored. A query is either a query image path,
+ * or SP_BATCH_QUERY_FEATURES_PREFIX followed by the path of a features file (in the format of the images' features
+ * files, with the configured PCA dimension) - such a query is answered directly from the given features, without
+ * decoding an image.
+ *
+ * The results file is tab separated, with a line for every query, in the order of the queries file:
+ * 		<query path>	<status>	<index>:<score>,<index>:<score>,...
+ * The status is one of:
+ * 		OK					- The results are the similar images indices, ordered from the most similar image,
+ * 							  each with its score (the hits the image got in the voting).
+ * 		EXTRACTION_ERROR	- The features of the query image could not be extracted (or the features file could
+ * 							  not be loaded). There are no results.
+ * 		ERROR				- The query failed for another reason. There are no results.
+ *
+ * The following functions are available:
+ *
+ * 		spBatchQueryRun		- Answers all of the queries of a queries file, into a results file.
+ */
+
+/** The prefix of queries which are given as a features file rather than an image. */
+#define SP_BATCH_QUERY_FEATURES_PREFIX "features:"
+
+/** The maximal number of queries which are answered concurrently or wait for their results to be written. */
+#define SP_BATCH_QUERY_WINDOW 256
+
+/** Enumeration to inform result of batch query method calls. */
+typedef enum sp_batch_query_msg_t {
+	SP_BATCH_QUERY_INVALID_ARGUMENT,
+	SP_BATCH_QUERY_CONFIG_ERROR,
+	SP_BATCH_QUERY_ALLOC_FAIL,
+	SP_BATCH_QUERY_CANNOT_OPEN_QUERIES_FILE,
+	SP_BATCH_QUERY_CANNOT_OPEN_RESULTS_FILE,
+	SP_BATCH_QUERY_WRITE_ERROR,
+	SP_BATCH_QUERY_SUCCESS
+} SP_BATCH_QUERY_MSG;
+
+/** Statistics of a batch run. */
+typedef struct sp_batch_query_stats_t {
+	int numOfQueries;
+	int numOfFailedQueries;
+	double elapsedSeconds;
+} SPBatchQueryStats;
+
+/**
+ * Answers all of the queries of the given queries file, and writes their results to the given results file.
+ * A query which fails does not stop the run - its failure is written as its result.
+ *
+ * @param config The configuration used to provide the different parameters for the search.
+ * @param searchIndex The index of the different image's features.
+ * @param extractionFunc Function used to extract the features of query images. Called concurrently by the workers.
+ * @param queriesFilename The path of the queries file.
+ * @param resultsFilename The path of the results file. An existing file is overwritten.
+ * @param stats Place-holder for the statistics of the run. Filled also in case of a failure.
+ *
+ * @return
+ * 	SP_BATCH_QUERY_INVALID_ARGUMENT			- In case one of the given arguments is NULL.
+ * 	SP_BATCH_QUERY_CONFIG_ERROR				- In case of configuration access error.
+ * 	SP_BATCH_QUERY_ALLOC_FAIL				- In case of allocation failure.
+ * 	SP_BATCH_QUERY_CANNOT_OPEN_QUERIES_FILE	- In case the queries file could not be opened.
+ * 	SP_BATCH_QUERY_CANNOT_OPEN_RESULTS_FILE	- In case the results file could not be opened.
+ * 	SP_BATCH_QUERY_WRITE_ERROR				- In case writing the results failed.
+ * 	SP_BATCH_QUERY_SUCCESS					- In case all of the queries were answered.
+ */
+SP_BATCH_QUERY_MSG spBatchQueryRun(const SPConfig config, const SPSearchIndex searchIndex,
+		FeatureExractionFunction extractionFunc, const char *queriesFilename, const char *resultsFilename,
+		SPBatchQueryStats *stats);
+
+#endif /* SP_BATCH_QUERY_H_ */
@@ -38,6 +38,9 @@ static const int MAX_PATH_LENGTH = 100;
 /** Length of a logger message. */
 #define LOGGER_MSG_LENGTH 2048
 
+/** The number of records an asynchronous logger buffers before it drops records. */
+#define LOGGER_ASYNC_CAPACITY 4096
+
 /** General logger message to report return value of a function call. */
 #define RETURN_VALUE_MSG "return message value:"
 
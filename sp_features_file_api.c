@@ -5,23 +5,209 @@
  *      Author: mataneilat
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <unistd.h>
 #include "sp_features_file_api.h"
 #include "SPKDArray.h"
 #include "sp_util.h"
 #include "sp_constants.h"
 #include "SPLogger.h"
 
+/*** Constants ***/
+
+/** The size of the blocks the features files are read in, and of their write buffer. */
+#define FEATURES_BLOCK_SIZE (1 << 16)
+
+/** The size of the single read the number of features is read with, when the features themselves are not needed. */
+#define NUMBER_OF_FEATURES_READ_SIZE 32
+
+/** The longest number of significant decimal digits parsed exactly by the fast path. */
+#define MAX_FAST_PARSE_DIGITS 19
+
+/** The longest coordinate string parsed by strtod, when it does not fit the fast path. */
+#define MAX_SLOW_PARSE_LENGTH 63
+
+/** Mantissas up to 2^53 and powers of ten up to 10^22 are exact doubles, so their product is correctly rounded. */
+#define MAX_FAST_PARSE_MANTISSA (1ULL << 53)
+#define MAX_FAST_PARSE_EXPONENT 22
+
+/** Coordinates below this magnitude are formatted without printf - their scaled value is below 2^53, so its
+ * integer part is exact and its rounding error is at most 1/16. */
+#define MAX_FAST_FORMAT_COORDINATE 1e9
+
+/** The number of decimal places coordinates are written with, as printf's "%f" does. The scale is exact. */
+#define COORDINATE_DECIMAL_PLACES 6
+#define COORDINATE_DECIMAL_SCALE 1000000ULL
+
+static const double POWERS_OF_TEN[MAX_FAST_PARSE_EXPONENT + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*** Type declarations ***/
+
+/**
+ * A features file being read in large blocks. Lines are parsed in place in the block, and a line which crosses
+ * the end of the block is moved to its beginning before the next block is read after it.
+ */
+typedef struct features_reader_t {
+	FILE *file;
+	size_t readSize;
+	size_t start;
+	size_t end;
+	bool endOfFile;
+	char block[FEATURES_BLOCK_SIZE];
+} FeaturesReader;
+
 /*** Private Methods ***/
 
+/**
+ * Returns the next line of the features file, without its line break. The line is valid until the next call.
+ *
+ * @param reader The features file reader.
+ * @param length Place-holder for the length of the line.
+ *
+ * @return
+ * 	NULL in case there are no more lines, or the next line is longer than a block. Otherwise, the line.
+ */
+const char *readLine(FeaturesReader *reader, size_t *length) {
+	const char *line, *lineBreak;
+	size_t bytesRead;
+	while (true) {
+		line = reader->block + reader->start;
+		lineBreak = (const char *) memchr(line, '\n', reader->end - reader->start);
+		if (lineBreak != NULL) {
+			*length = lineBreak - line;
+			reader->start += *length + 1;
+			break;
+		}
+		if (reader->endOfFile) {
+			// The last line may have no line break
+			*length = reader->end - reader->start;
+			reader->start = reader->end;
+			if (*length == 0) {
+				return NULL;
+			}
+			break;
+		}
+		memmove(reader->block, line, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+		if (reader->end == FEATURES_BLOCK_SIZE) {
+			return NULL;
+		}
+		bytesRead = FEATURES_BLOCK_SIZE - reader->end;
+		bytesRead = fread(reader->block + reader->end, 1, bytesRead < reader->readSize ? bytesRead : reader->readSize,
+				reader->file);
+		reader->end += bytesRead;
+		reader->endOfFile = (bytesRead == 0);
+	}
+	// Tolerate files which were written with windows line breaks
+	if (*length > 0 && line[*length - 1] == '\r') {
+		(*length)--;
+	}
+	return line;
+}
+
+/**
+ * Parses a coordinate which does not fit the fast path with strtod.
+ *
+ * @return
+ * 	false if the token is not entirely a number, true otherwise.
+ */
+bool parseCoordinateSlow(const char *token, size_t length, double *coordinate) {
+	char tokenString[MAX_SLOW_PARSE_LENGTH + 1];
+	char *end;
+	if (length == 0 || length > MAX_SLOW_PARSE_LENGTH) {
+		return false;
+	}
+	memcpy(tokenString, token, length);
+	tokenString[length] = '\0';
+	*coordinate = strtod(tokenString, &end);
+	return end == tokenString + length;
+}
+
+/**
+ * Parses a decimal coordinate - with an optional sign, fraction and exponent - in place.
+ * Numbers of up to MAX_FAST_PARSE_DIGITS significant digits with small exponents (which are all of the numbers
+ * written by this API) are parsed exactly with a single multiplication or division, anything else with strtod.
+ *
+ * @param token The coordinate string, not null terminated.
+ * @param length The length of the coordinate string.
+ * @param coordinate Place-holder for the parsed coordinate.
+ *
+ * @return
+ * 	false if the token is not entirely a number, true otherwise.
+ */
+bool parseCoordinate(const char *token, size_t length, double *coordinate) {
+	const char *p = token, *end = token + length;
+	unsigned long long mantissa = 0;
+	int significantDigits = 0, exponent = 0, explicitExponent = 0, exponentSign = 1;
+	bool negative = false, anyDigit = false, exact = true;
+	double value;
+
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		p++;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++) {
+		anyDigit = true;
+		if (significantDigits < MAX_FAST_PARSE_DIGITS) {
+			mantissa = mantissa * 10 + (*p - '0');
+			significantDigits += (mantissa != 0);
+		} else {
+			exponent++;
+			exact = exact && (*p == '0');
+		}
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+			anyDigit = true;
+			if (significantDigits < MAX_FAST_PARSE_DIGITS) {
+				mantissa = mantissa * 10 + (*p - '0');
+				significantDigits += (mantissa != 0);
+				exponent--;
+			} else {
+				exact = exact && (*p == '0');
+			}
+		}
+	}
+	if (anyDigit && p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		if (p < end && (*p == '-' || *p == '+')) {
+			exponentSign = (*p == '-') ? -1 : 1;
+			p++;
+		}
+		if (p == end) {
+			return false;
+		}
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			// Larger exponents are left to strtod
+			explicitExponent = (explicitExponent < 10000) ? explicitExponent * 10 + (*p - '0') : explicitExponent;
+		}
+		exponent += exponentSign * explicitExponent;
+	}
+	if (!anyDigit || p != end || !exact || mantissa > MAX_FAST_PARSE_MANTISSA
+			|| exponent < -MAX_FAST_PARSE_EXPONENT || exponent > MAX_FAST_PARSE_EXPONENT) {
+		// Infinities, NaNs, and numbers which are not exact doubles
+		return parseCoordinateSlow(token, length, coordinate);
+	}
+	value = (exponent < 0) ? (double) mantissa / POWERS_OF_TEN[-exponent] : (double) mantissa * POWERS_OF_TEN[exponent];
+	*coordinate = negative ? -value : value;
+	return true;
+}
+
 /**
  * Loads the number of features from the features file.
  *
- * @param featuresFile The features file stream to load from.
+ * @param reader The features file reader to load from.
  * @param msg Place-holder for the SP_FEATURES_FILE_API_MSG informing the process result:
- * 		SP_FEATURES_FILE_API_ALLOC_FAIL 		- In case an allocation failure occurred.
  * 		SP_FEATURES_FILE_API_READ_ERROR			- In case reading from the features file went wrong.
  * 		SP_FEATURES_FILE_API_SUCCESS			- In case of success load of number of features.
  *
@@ -29,32 +215,32 @@
  * 	-1 on non-successful load.
  * 	Otherwise, returns the number of features stored in the features file.
  */
-int loadNumberOfFeatures(FILE *featuresFile, SP_FEATURES_FILE_API_MSG *msg) {
-	int numberOfFeatures;
-	char *numberOfFeaturesAsString = (char *) malloc((MAX_NUM_OF_FEATURES_STRING_LEN + 1) * sizeof(char));
-
-	if (numberOfFeaturesAsString == NULL) {
-		*msg = SP_FEATURES_FILE_API_ALLOC_FAIL;
-		return -1;
-	}
-	if (fgets(numberOfFeaturesAsString, MAX_NUM_OF_FEATURES_STRING_LEN, featuresFile) == NULL) {
-		free(numberOfFeaturesAsString);
+int loadNumberOfFeatures(FeaturesReader *reader, SP_FEATURES_FILE_API_MSG *msg) {
+	size_t i, length;
+	int numberOfFeatures = 0;
+	const char *line = readLine(reader, &length);
+	if (line == NULL || length == 0 || length > (size_t) MAX_NUM_OF_FEATURES_STRING_LEN - 1) {
 		*msg = SP_FEATURES_FILE_API_READ_ERROR;
 		return -1;
 	}
-	numberOfFeatures = atoi(numberOfFeaturesAsString);
-
-	free(numberOfFeaturesAsString);
+	for (i = 0; i < length; i++) {
+		if (line[i] < '0' || line[i] > '9') {
+			*msg = SP_FEATURES_FILE_API_READ_ERROR;
+			return -1;
+		}
+		numberOfFeatures = numberOfFeatures * 10 + (line[i] - '0');
+	}
 	*msg = (numberOfFeatures == 0) ? SP_FEATURES_FILE_API_READ_ERROR : SP_FEATURES_FILE_API_SUCCESS;
-	return numberOfFeatures;
+	return (numberOfFeatures == 0) ? -1 : numberOfFeatures;
 }
 
 /**
- * Loads a single feature from the features file stream.
+ * Loads a single feature from the features file.
  *
- * @param featuresFile The features file stream to load the feature from
+ * @param reader The features file reader to load the feature from
  * @param expectedDimension The expected dimension of the loaded point.
  * @param index The index to be set in the loaded point.
+ * @param data A buffer of expectedDimension coordinates, to parse the feature into.
  * @param msg Place-holder for the SP_FEATURES_FILE_API_MSG informing the process result:
  * 		SP_FEATURES_FILE_API_ALLOC_FAIL 		- In case an allocation failure occurred.
  * 		SP_FEATURES_FILE_API_READ_ERROR			- In case reading from the features file went wrong.
@@ -64,52 +250,120 @@ int loadNumberOfFeatures(FILE *featuresFile, SP_FEATURES_FILE_API_MSG *msg) {
  * 	NULL in case of a non-successful load.
  * 	Otherwise, returns the loaded feature.
  */
-SPPoint loadFeature(FILE *featuresFile, int expectedDimension, int index, SP_FEATURES_FILE_API_MSG *msg) {
-	int i, numberOfCoordinates;
-	char **splitResult;
-	double *data;
+SPPoint loadFeature(FeaturesReader *reader, int expectedDimension, int index, double *data,
+		SP_FEATURES_FILE_API_MSG *msg) {
+	int numberOfCoordinates = 0;
+	size_t length;
 	SPPoint feature;
-	int maxFeatureStringLen = (MAX_FEATURE_COORDINATE_STRING_LEN + 1) * expectedDimension;
-	char *featureCoordinatesString = (char *) malloc((maxFeatureStringLen + 1) * sizeof(char));
-
-	if (featureCoordinatesString == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		*msg = SP_FEATURES_FILE_API_ALLOC_FAIL;
+	const char *delimiter, *line = readLine(reader, &length), *end = line + length;
+	if (line == NULL) {
+		*msg = SP_FEATURES_FILE_API_READ_ERROR;
 		return NULL;
 	}
-	if (fgets(featureCoordinatesString, maxFeatureStringLen, featuresFile) == NULL) {
-		free(featureCoordinatesString);
+	while (numberOfCoordinates < expectedDimension) {
+		delimiter = (const char *) memchr(line, FEATURE_COORDINATES_DELIM, end - line);
+		if (delimiter == NULL) {
+			delimiter = end;
+		}
+		if (!parseCoordinate(line, delimiter - line, &data[numberOfCoordinates])) {
+			*msg = SP_FEATURES_FILE_API_READ_ERROR;
+			return NULL;
+		}
+		numberOfCoordinates++;
+		if (delimiter == end) {
+			break;
+		}
+		line = delimiter + 1;
+	}
+	if (numberOfCoordinates != expectedDimension || delimiter != end) {
 		*msg = SP_FEATURES_FILE_API_READ_ERROR;
 		return NULL;
 	}
-
-
-	splitResult = spUtilStrSplit(featureCoordinatesString, FEATURE_COORDINATES_DELIM, &numberOfCoordinates);
-	// The feature coordinates string is no longer needed..
-	free(featureCoordinatesString);
-
-	if (splitResult == NULL || numberOfCoordinates != expectedDimension) {
-		spUtilFreeStringsArray(splitResult, numberOfCoordinates);
-		*msg = SP_FEATURES_FILE_API_READ_ERROR;
+	feature = spPointCreate(data, expectedDimension, index);
+	if (feature == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_FEATURES_FILE_API_ALLOC_FAIL;
 		return NULL;
 	}
+	*msg = SP_FEATURES_FILE_API_SUCCESS;
+	return feature;
+}
 
-	data = (double *) malloc(numberOfCoordinates * sizeof(double));
-	for (i = 0; i < numberOfCoordinates; i++) {
-		double featureCoordinate = atof(splitResult[i]);
-		if (featureCoordinate == 0 && strcmp(splitResult[i], "0") != 0) {
+/**
+ * Loads the given number of features from the features file into the given array.
+ *
+ * @param reader The features file reader to load the features from, after the number of features.
+ * @param numberOfFeatures The number of features to load.
+ * @param expectedDimension The expected dimension of the loaded points.
+ * @param index The index to be set in the loaded points.
+ * @param features The array to load the features into, of at least numberOfFeatures points.
+ *
+ * @return
+ * 	SP_FEATURES_FILE_API_MSG informing the process result, as in loadFeature.
+ * 	In case of failure no loaded feature is left allocated.
+ */
+SP_FEATURES_FILE_API_MSG loadFeatures(FeaturesReader *reader, int numberOfFeatures, int expectedDimension, int index,
+		SPPoint *features) {
+	int i, j;
+	SP_FEATURES_FILE_API_MSG msg;
+	double *data = (double *) malloc(expectedDimension * sizeof(double));
+	if (data == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		return SP_FEATURES_FILE_API_ALLOC_FAIL;
+	}
+	for (i = 0; i < numberOfFeatures; i++) {
+		features[i] = loadFeature(reader, expectedDimension, index, data, &msg);
+		if (msg != SP_FEATURES_FILE_API_SUCCESS) {
+			for (j = 0; j < i; j++) {
+				spPointDestroy(features[j]);
+			}
 			free(data);
-			spUtilFreeStringsArray(splitResult, numberOfCoordinates);
-			*msg = SP_FEATURES_FILE_API_READ_ERROR;
-			return NULL;
+			return msg;
 		}
-		data[i] = featureCoordinate;
 	}
-	feature = spPointCreate(data, numberOfCoordinates, index);
 	free(data);
-	spUtilFreeStringsArray(splitResult, numberOfCoordinates);
+	return SP_FEATURES_FILE_API_SUCCESS;
+}
+
+/**
+ * Opens the given features file for reading in blocks.
+ *
+ * @param filePath The features file path.
+ * @param readSize The number of bytes to read at a time, at most FEATURES_BLOCK_SIZE.
+ * @param msg Place-holder for the SP_FEATURES_FILE_API_MSG informing the process result.
+ *
+ * @return
+ * 	NULL if the file could not be opened or the reader could not be allocated, the reader otherwise.
+ */
+FeaturesReader *openReader(const char *filePath, size_t readSize, SP_FEATURES_FILE_API_MSG *msg) {
+	FeaturesReader *reader = (FeaturesReader *) malloc(sizeof(*reader));
+	if (reader == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_FEATURES_FILE_API_ALLOC_FAIL;
+		return NULL;
+	}
+	reader->file = fopen(filePath, "r");
+	if (reader->file == NULL) {
+		free(reader);
+		*msg = SP_FEATURES_FILE_API_FEATURE_FILE_MISSING;
+		return NULL;
+	}
+	// The reader does its own buffering
+	setvbuf(reader->file, NULL, _IONBF, 0);
+	reader->readSize = readSize;
+	reader->start = 0;
+	reader->end = 0;
+	reader->endOfFile = false;
 	*msg = SP_FEATURES_FILE_API_SUCCESS;
-	return feature;
+	return reader;
+}
+
+/**
+ * Closes the given features file reader and deallocates it.
+ */
+void closeReader(FeaturesReader *reader) {
+	fclose(reader->file);
+	free(reader);
 }
 
 /**
@@ -138,135 +392,223 @@ SP_FEATURES_FILE_API_MSG writeNumberOfFeatures(FILE* featuresFile, int numOfFeat
 	return SP_FEATURES_FILE_API_SUCCESS;
 }
 
+/**
+ * Formats a coordinate as printf's "%f" does - with COORDINATE_DECIMAL_PLACES decimal places, rounding the exact
+ * value of the coordinate to the nearest with ties to even - without printf.
+ * Coordinates of magnitude MAX_FAST_FORMAT_COORDINATE or more (and infinities or NaNs) are formatted with printf.
+ *
+ * @param coordinate The coordinate to format.
+ * @param coordinateString The buffer to format into, of MAX_FEATURE_COORDINATE_STRING_LEN characters.
+ *
+ * @return
+ * 	-1 in case the formatted coordinate is longer than MAX_FEATURE_COORDINATE_STRING_LEN - 1 characters.
+ * 	Otherwise, the number of characters written (which are not null terminated).
+ */
+int formatCoordinate(double coordinate, char *coordinateString) {
+	char digits[MAX_FEATURE_COORDINATE_STRING_LEN];
+	int i, numOfDigits = 0, length = 0;
+	double magnitude = coordinate < 0 ? -coordinate : coordinate;
+	double product, productError, halfDistance;
+	unsigned long long scaled, integerPart, fractionPart;
+	if (!(magnitude < MAX_FAST_FORMAT_COORDINATE)) {
+		length = snprintf(digits, MAX_FEATURE_COORDINATE_STRING_LEN, "%f", coordinate);
+		if (length <= 0 || length > MAX_FEATURE_COORDINATE_STRING_LEN - 1) {
+			return -1;
+		}
+		memcpy(coordinateString, digits, length);
+		return length;
+	}
+	// The exact scaled value is product + productError, since fma rounds the difference only once
+	product = magnitude * COORDINATE_DECIMAL_SCALE;
+	productError = fma(magnitude, COORDINATE_DECIMAL_SCALE, -product);
+	scaled = (unsigned long long) product;
+	// The fraction of the product is exact, and so is its distance from a half whenever it is at least a quarter.
+	// The sum's sign is the exact sum's sign, which decides the rounding.
+	halfDistance = ((product - (double) scaled) - 0.5) + productError;
+	if (halfDistance > 0 || (halfDistance == 0 && (scaled & 1))) {
+		scaled++;
+	}
+	integerPart = scaled / COORDINATE_DECIMAL_SCALE;
+	fractionPart = scaled % COORDINATE_DECIMAL_SCALE;
+	if (signbit(coordinate)) {
+		coordinateString[length++] = '-';
+	}
+	do {
+		digits[numOfDigits++] = (char) ('0' + integerPart % 10);
+		integerPart /= 10;
+	} while (integerPart > 0);
+	while (numOfDigits > 0) {
+		coordinateString[length++] = digits[--numOfDigits];
+	}
+	coordinateString[length++] = '.';
+	for (i = COORDINATE_DECIMAL_PLACES - 1; i >= 0; i--) {
+		coordinateString[length + i] = (char) ('0' + fractionPart % 10);
+		fractionPart /= 10;
+	}
+	return length + COORDINATE_DECIMAL_PLACES;
+}
+
 /**
  * Writes a single feature to the features file.
  *
  * @param featuresFile The features file stream to the write the feature to.
  * @param feature The SPPoint representing the feature to write.
+ * @param line A buffer for the formatted feature, of (MAX_FEATURE_COORDINATE_STRING_LEN + 1) characters per coordinate.
  *
  * @return
  * 	SP_FEATURES_FILE_API_MSG informing the process result:
  * 		SP_FEATURES_FILE_API_INVALID_ARGUMENT		- In case a feature coordinate base 10 representation is larger than MAX_FEATURE_COORDINATE_STRING_LEN digits.
  * 		SP_FEATURES_FILE_API_WRITE_ERROR			- In case writing to the features file went wrong.
- * 		SP_FEATURES_FILE_API_ALLOC_FAIL				- In case of allocation failure.
  * 		SP_FEATURES_FILE_API_SUCCESS				- In case of successful write.
  */
-SP_FEATURES_FILE_API_MSG writeFeature(FILE* featureFile, SPPoint feature) {
-	int i, numOfChars, dim = spPointGetDimension(feature);
-	char *pointCoordinate = NULL, *joinedCoordinates = NULL;
-	double coordinate;
-	SP_FEATURES_FILE_API_MSG returnMsg;
-	char **pointCoordinates = (char **) malloc(dim * sizeof(*pointCoordinates));
-	if (pointCoordinates == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		return SP_FEATURES_FILE_API_ALLOC_FAIL;
-	}
+SP_FEATURES_FILE_API_MSG writeFeature(FILE* featureFile, SPPoint feature, char *line) {
+	int i, numOfChars, length = 0, dim = spPointGetDimension(feature);
 	for (i = 0; i < dim; i++) {
-		coordinate = spPointGetAxisCoor(feature, i);
-		pointCoordinate = (char *) malloc(MAX_FEATURE_COORDINATE_STRING_LEN * sizeof(char));
-		if (pointCoordinate == NULL) {
-			spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-			spUtilFreeStringsArray(pointCoordinates, i);
-			free(pointCoordinate);
-			return SP_FEATURES_FILE_API_ALLOC_FAIL;
-		}
-
-		numOfChars = sprintf(pointCoordinate, "%f", coordinate);
-		if (numOfChars <= 0 || numOfChars > MAX_FEATURE_COORDINATE_STRING_LEN - 1) {
-			spUtilFreeStringsArray(pointCoordinates, i);
-			free(pointCoordinate);
+		numOfChars = formatCoordinate(spPointGetAxisCoor(feature, i), line + length);
+		if (numOfChars < 0) {
 			return SP_FEATURES_FILE_API_INVALID_ARGUMENT;
 		}
-		pointCoordinates[i] = pointCoordinate;
-	}
-	returnMsg = SP_FEATURES_FILE_API_SUCCESS;
-	joinedCoordinates = spUtilStrJoin((const char **)pointCoordinates, dim, FEATURE_COORDINATES_DELIM);
-	if (joinedCoordinates == NULL) {
-		returnMsg = SP_FEATURES_FILE_API_WRITE_ERROR;
-	} else {
-		if (fputs(joinedCoordinates, featureFile) == EOF || fputc('\n', featureFile) == EOF) {
-			returnMsg = SP_FEATURES_FILE_API_WRITE_ERROR;
-		}
+		length += numOfChars;
+		line[length++] = (i < dim - 1) ? FEATURE_COORDINATES_DELIM : '\n';
+	}
+	if (fwrite(line, 1, length, featureFile) != (size_t) length) {
+		return SP_FEATURES_FILE_API_WRITE_ERROR;
 	}
-	free(joinedCoordinates);
-	spUtilFreeStringsArray(pointCoordinates, dim);
-	return returnMsg;
+	return SP_FEATURES_FILE_API_SUCCESS;
 }
 
+/*** Public Methods ***/
+
 SPPoint *spFeaturesFileAPILoad(const char *filePath, int index, int expectedFeatureDimension, int *numOfFeaturesLoaded,
 		SP_FEATURES_FILE_API_MSG *msg) {
+	FeaturesReader *reader;
+	SPPoint *features;
+	int numberOfFeatures;
 	if (filePath == NULL || numOfFeaturesLoaded == NULL || msg == NULL || expectedFeatureDimension <= 0) {
 		*msg = SP_FEATURES_FILE_API_INVALID_ARGUMENT;
 		return NULL;
 	}
-	FILE *featuresFile = fopen(filePath, "r");
-	int i, j;
-	if (featuresFile == NULL) {
-		*msg = SP_FEATURES_FILE_API_FEATURE_FILE_MISSING;
+	reader = openReader(filePath, FEATURES_BLOCK_SIZE, msg);
+	if (reader == NULL) {
 		return NULL;
 	}
-	int numberOfFeatures = loadNumberOfFeatures(featuresFile, msg);
+	numberOfFeatures = loadNumberOfFeatures(reader, msg);
 	if (*msg != SP_FEATURES_FILE_API_SUCCESS) {
-		fclose(featuresFile);
+		closeReader(reader);
 		return NULL;
 	}
 
-	SPPoint *features = (SPPoint *) malloc(numberOfFeatures * sizeof(SPPoint));
+	features = (SPPoint *) malloc(numberOfFeatures * sizeof(SPPoint));
 	if (features == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		fclose(featuresFile);
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		closeReader(reader);
 		*msg = SP_FEATURES_FILE_API_ALLOC_FAIL;
 		return NULL;
 	}
-	for (i = 0; i < numberOfFeatures; i++) {
-		SPPoint feature = loadFeature(featuresFile, expectedFeatureDimension, index, msg);
-		if (*msg != SP_FEATURES_FILE_API_SUCCESS) {
-			for (j = 0; j < i; j++) {
-				spPointDestroy(features[j]);
-			}
-			free(features);
-			fclose(featuresFile);
-			return NULL;
-		}
-		features[i] = feature;
+	*msg = loadFeatures(reader, numberOfFeatures, expectedFeatureDimension, index, features);
+	closeReader(reader);
+	if (*msg != SP_FEATURES_FILE_API_SUCCESS) {
+		free(features);
+		return NULL;
 	}
-
-	fclose(featuresFile);
-	*msg = SP_FEATURES_FILE_API_SUCCESS;
 	*numOfFeaturesLoaded = numberOfFeatures;
 	return features;
 
 }
 
-SP_FEATURES_FILE_API_MSG spFeaturesFileAPIWrite(const char *filePath, const SPPoint *features, int numOfFeatures) {
-	int i;
+int spFeaturesFileAPILoadNumOfFeatures(const char *filePath, SP_FEATURES_FILE_API_MSG *msg) {
+	FeaturesReader *reader;
+	int numberOfFeatures;
+	if (filePath == NULL || msg == NULL) {
+		if (msg != NULL) {
+			*msg = SP_FEATURES_FILE_API_INVALID_ARGUMENT;
+		}
+		return -1;
+	}
+	reader = openReader(filePath, NUMBER_OF_FEATURES_READ_SIZE, msg);
+	if (reader == NULL) {
+		return -1;
+	}
+	numberOfFeatures = loadNumberOfFeatures(reader, msg);
+	closeReader(reader);
+	return numberOfFeatures;
+}
+
+SP_FEATURES_FILE_API_MSG spFeaturesFileAPILoadInto(const char *filePath, int index, int expectedFeatureDimension,
+		SPPoint *features, int numOfFeatures) {
+	FeaturesReader *reader;
+	SP_FEATURES_FILE_API_MSG msg;
+	if (filePath == NULL || features == NULL || expectedFeatureDimension <= 0 || numOfFeatures <= 0) {
+		return SP_FEATURES_FILE_API_INVALID_ARGUMENT;
+	}
+	reader = openReader(filePath, FEATURES_BLOCK_SIZE, &msg);
+	if (reader == NULL) {
+		return msg;
+	}
+	// The file may have been rewritten since its number of features was read
+	if (loadNumberOfFeatures(reader, &msg) != numOfFeatures && msg == SP_FEATURES_FILE_API_SUCCESS) {
+		msg = SP_FEATURES_FILE_API_READ_ERROR;
+	}
+	if (msg == SP_FEATURES_FILE_API_SUCCESS) {
+		msg = loadFeatures(reader, numOfFeatures, expectedFeatureDimension, index, features);
+	}
+	closeReader(reader);
+	return msg;
+}
+
+/**
+ * Writes features to a given file, as in spFeaturesFileAPIWrite.
+ *
+ * @param sync Whether to flush the file to the disk (with fdatasync) before closing it.
+ */
+SP_FEATURES_FILE_API_MSG writeFeaturesFile(const char *filePath, const SPPoint *features, int numOfFeatures,
+		bool sync) {
+	int i, dim;
+	char *line;
 	FILE *featuresFile;
 	SP_FEATURES_FILE_API_MSG msg;
 
 	if (filePath == NULL || features == NULL || numOfFeatures <= 0) {
 		return SP_FEATURES_FILE_API_INVALID_ARGUMENT;
 	}
+	dim = spPointGetDimension(features[0]);
+	for (i = 1; i < numOfFeatures; i++) {
+		dim = (spPointGetDimension(features[i]) > dim) ? spPointGetDimension(features[i]) : dim;
+	}
+	line = (char *) malloc((MAX_FEATURE_COORDINATE_STRING_LEN + 1) * dim * sizeof(char));
+	if (line == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		return SP_FEATURES_FILE_API_ALLOC_FAIL;
+	}
 	featuresFile = fopen(filePath, "w");
 	if (featuresFile == NULL) {
+		free(line);
 		return SP_FEATURES_FILE_API_WRITE_ERROR;
 	}
+	setvbuf(featuresFile, NULL, _IOFBF, FEATURES_BLOCK_SIZE);
 
 	msg = writeNumberOfFeatures(featuresFile, numOfFeatures);
+	for (i = 0; i < numOfFeatures && msg == SP_FEATURES_FILE_API_SUCCESS; i++) {
+		msg = writeFeature(featuresFile, features[i], line);
+	}
+	free(line);
+	if (sync && msg == SP_FEATURES_FILE_API_SUCCESS
+			&& (fflush(featuresFile) != 0 || fdatasync(fileno(featuresFile)) != 0)) {
+		msg = SP_FEATURES_FILE_API_WRITE_ERROR;
+	}
+	if (fclose(featuresFile) != 0 && msg == SP_FEATURES_FILE_API_SUCCESS) {
+		msg = SP_FEATURES_FILE_API_WRITE_ERROR;
+	}
 	if (msg != SP_FEATURES_FILE_API_SUCCESS) {
-		fclose(featuresFile);
 		remove(filePath);
-		return msg;
 	}
+	return msg;
+}
 
-	for (i = 0; i < numOfFeatures; i++) {
-		msg = writeFeature(featuresFile, features[i]);
-		if (msg != SP_FEATURES_FILE_API_SUCCESS) {
-			fclose(featuresFile);
-			remove(filePath);
-			return msg;
-		}
-	}
-	fclose(featuresFile);
-	return SP_FEATURES_FILE_API_SUCCESS;
+SP_FEATURES_FILE_API_MSG spFeaturesFileAPIWrite(const char *filePath, const SPPoint *features, int numOfFeatures) {
+	return writeFeaturesFile(filePath, features, numOfFeatures, false);
 }
 
+SP_FEATURES_FILE_API_MSG spFeaturesFileAPISyncWrite(const char *filePath, const SPPoint *features, int numOfFeatures) {
+	return writeFeaturesFile(filePath, features, numOfFeatures, true);
+}
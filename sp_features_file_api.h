@@ -16,7 +16,10 @@
  *
  * The following functions are available:
  * 		spFeaturesFileAPILoad 		- Loads a features array from the given file.
+ * 		spFeaturesFileAPILoadNumOfFeatures	- Loads only the number of features of the given file.
+ * 		spFeaturesFileAPILoadInto	- Loads the features of the given file into a given array.
  * 		spFeaturesFileAPIWrite		- Writes a features array to a given file.
+ * 		spFeaturesFileAPISyncWrite	- Writes a features array to a given file, and flushes it to the disk.
  */
 
 /** Enumeration to inform result of API method calls. */
@@ -60,6 +63,46 @@ static const char FEATURE_COORDINATES_DELIM = ' ';
 SPPoint *spFeaturesFileAPILoad(const char *filePath, int index, int expectedFeatureDimension, int *numOfFeaturesLoaded,
 		SP_FEATURES_FILE_API_MSG *msg);
 
+/**
+ * Reads the number of features of the given file, without reading the features themselves.
+ *
+ * @param filePath The path to the file containing the features data.
+ * @param msg Place-holder for the SP_FEATURES_FILE_API_MSG informing the process result:
+ *		SP_FEATURES_FILE_API_INVALID_ARGUMENT 		- In case filePath is NULL.
+ *		SP_FEATURES_FILE_API_FEATURE_FILE_MISSING 	- In case the features file is missing
+ *		SP_FEATURES_FILE_API_ALLOC_FAIL				- In case an allocation failure occurred.
+ *		SP_FEATURES_FILE_API_READ_ERROR				- In case reading from the features file went wrong.
+ *		SP_FEATURES_FILE_API_SUCCESS				- In case of a successful read.
+ *
+ * @return
+ *	-1 in case of a non-successful read, otherwise the number of features in the file.
+ */
+int spFeaturesFileAPILoadNumOfFeatures(const char *filePath, SP_FEATURES_FILE_API_MSG *msg);
+
+/**
+ * Reads features from the given file into the given array, which allows loading several files concurrently into
+ * one preallocated array. The file must hold exactly the given number of features.
+ *
+ * @param filePath The path to the file containing the features data.
+ * @param index The index of the image, to be put in each extracted point.
+ * @param expectedFeatureDimension The expected dimension of the point.
+ * @param features The array to load the features into, of at least numOfFeatures points.
+ * @param numOfFeatures The number of features in the file, as read by spFeaturesFileAPILoadNumOfFeatures.
+ *
+ * @return
+ * 	 SP_FEATURES_FILE_API_MSG informing the method result status:
+ *		SP_FEATURES_FILE_API_INVALID_ARGUMENT 		- In case any pointer parameter is NULL,
+ *													  or the expected feature dimension or number of features is non-positive.
+ *		SP_FEATURES_FILE_API_FEATURE_FILE_MISSING 	- In case the features file is missing
+ *		SP_FEATURES_FILE_API_ALLOC_FAIL				- In case an allocation failure occurred.
+ *		SP_FEATURES_FILE_API_READ_ERROR				- In case reading from the features file went wrong,
+ *													  or the file does not hold numOfFeatures features.
+ *		SP_FEATURES_FILE_API_SUCCESS				- In case of successful load of features.
+ *	 In case of failure no loaded feature is left allocated.
+ */
+SP_FEATURES_FILE_API_MSG spFeaturesFileAPILoadInto(const char *filePath, int index, int expectedFeatureDimension,
+		SPPoint *features, int numOfFeatures);
+
 /**
  * Writes features to a given file.
  *
@@ -79,5 +122,19 @@ SPPoint *spFeaturesFileAPILoad(const char *filePath, int index, int expectedFeat
  */
 SP_FEATURES_FILE_API_MSG spFeaturesFileAPIWrite(const char *filePath, const SPPoint *features, int numOfFeatures);
 
+/**
+ * Writes features to a given file as spFeaturesFileAPIWrite does, and flushes the file to the disk (with fdatasync)
+ * before closing it, so the features are durable once SP_FEATURES_FILE_API_SUCCESS is returned.
+ *
+ * @param filePath The path to the file to write the features data to.
+ * @param features The features to write to the file.
+ * @param numOfFeatures The number of features in the features array.
+ *
+ * @return
+ * 	 SP_FEATURES_FILE_API_MSG informing the method result status, as in spFeaturesFileAPIWrite.
+ * 	 Failing to flush the file is a SP_FEATURES_FILE_API_WRITE_ERROR.
+ */
+SP_FEATURES_FILE_API_MSG spFeaturesFileAPISyncWrite(const char *filePath, const SPPoint *features, int numOfFeatures);
+
 
 #endif /* SP_FEATURES_FILE_API_H_ */
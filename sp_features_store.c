@@ -0,0 +1,443 @@
+/*
+ * sp_features_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sp_features_store.h"
+#include "sp_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*** Constants ***/
+
+#define FEATURES_STORE_MAGIC "SPFS"
+#define FEATURES_STORE_VERSION 1
+#define TEMPORARY_FILE_SUFFIX ".tmp"
+
+/** The size of the write buffer, so that the features are written to the disk in large sequential blocks. */
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+/** Offset table entry flags. */
+#define ENTRY_STORED 1u
+#define ENTRY_HASHED 2u
+
+/*** Type declarations ***/
+
+/** The file header - its size is a multiple of 8, so the features after it are aligned. */
+typedef struct sp_features_store_header_t {
+	char magic[4];
+	uint32_t version;
+	uint32_t dimension;
+	uint32_t numOfImages;
+	uint64_t tableOffset;
+	uint64_t checksum;
+} SPFeaturesStoreHeader;
+
+/** An offset table entry - the features of an image, at the given offset of the file. */
+typedef struct sp_features_store_entry_t {
+	uint64_t offset;
+	uint32_t numOfFeatures;
+	uint32_t flags;
+	uint64_t hash;
+} SPFeaturesStoreEntry;
+
+struct sp_features_store_writer_t {
+	FILE *file;
+	char *filePath;
+	char *temporaryPath;
+	char *buffer;
+	double *row;
+	int dimension;
+	int numOfImages;
+	uint64_t offset;
+	SPFeaturesStoreEntry *entries;
+};
+
+struct sp_features_store_t {
+	void *mapping;
+	size_t mappingSize;
+	const SPFeaturesStoreHeader *header;
+	const SPFeaturesStoreEntry *entries;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Closes and removes the temporary file of the given writer (if still open), and deallocates it.
+ */
+static void destroyWriter(SPFeaturesStoreWriter writer) {
+	if (writer->file != NULL) {
+		fclose(writer->file);
+		remove(writer->temporaryPath);
+	}
+	free(writer->filePath);
+	free(writer->temporaryPath);
+	free(writer->buffer);
+	free(writer->row);
+	free(writer->entries);
+	free(writer);
+}
+
+/**
+ * Returns the features of the given entry in the mapping.
+ */
+static const double *entryFeatures(SPFeaturesStore store, const SPFeaturesStoreEntry *entry) {
+	return (const double *) ((const char *) store->mapping + entry->offset);
+}
+
+/**
+ * Creates points from the features of the given entry into the given array.
+ *
+ * @return
+ * 	false in case of an allocation failure (in which case no point is left allocated), true otherwise.
+ */
+static bool createEntryPoints(SPFeaturesStore store, const SPFeaturesStoreEntry *entry, int imageIndex,
+		SPPoint *points) {
+	int i, dimension = (int) store->header->dimension;
+	const double *data = entryFeatures(store, entry);
+	for (i = 0; i < (int) entry->numOfFeatures; i++) {
+		// The points copy their data, so the mapping is only read
+		points[i] = spPointCreate((double *) (data + (size_t) i * dimension), dimension, imageIndex);
+		if (points[i] == NULL) {
+			while (--i >= 0) {
+				spPointDestroy(points[i]);
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Checks that the offset table of the given mapped store points inside its features section.
+ */
+static bool isTableValid(SPFeaturesStore store) {
+	uint32_t i;
+	uint64_t featureSize = (uint64_t) store->header->dimension * sizeof(double);
+	uint64_t tableOffset = store->header->tableOffset;
+	for (i = 0; i < store->header->numOfImages; i++) {
+		const SPFeaturesStoreEntry *entry = &store->entries[i];
+		if (!(entry->flags & ENTRY_STORED)) {
+			if (entry->numOfFeatures != 0) {
+				return false;
+			}
+			continue;
+		}
+		if (entry->offset < sizeof(SPFeaturesStoreHeader) || entry->offset > tableOffset
+				|| entry->offset % sizeof(double) != 0 || entry->numOfFeatures == 0
+				|| entry->numOfFeatures > INT_MAX
+				|| entry->numOfFeatures > (tableOffset - entry->offset) / featureSize) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*** Public Methods ***/
+
+SPFeaturesStoreWriter spFeaturesStoreWriterCreate(const char *filePath, int dimension, int numOfImages,
+		SP_FEATURES_STORE_MSG *msg) {
+	SPFeaturesStoreWriter writer;
+	SPFeaturesStoreHeader header;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (filePath == NULL || dimension <= 0 || numOfImages < 0) {
+		*msg = SP_FEATURES_STORE_INVALID_ARGUMENT;
+		return NULL;
+	}
+	writer = (SPFeaturesStoreWriter) calloc(1, sizeof(*writer));
+	if (writer == NULL) {
+		*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	writer->dimension = dimension;
+	writer->numOfImages = numOfImages;
+	writer->filePath = (char *) malloc(strlen(filePath) + 1);
+	writer->temporaryPath = (char *) malloc(strlen(filePath) + strlen(TEMPORARY_FILE_SUFFIX) + 1);
+	writer->buffer = (char *) malloc(WRITE_BUFFER_SIZE);
+	writer->row = (double *) malloc(dimension * sizeof(double));
+	// An extra entry, so that an empty store still allocates its table
+	writer->entries = (SPFeaturesStoreEntry *) calloc(numOfImages + 1, sizeof(SPFeaturesStoreEntry));
+	if (writer->filePath == NULL || writer->temporaryPath == NULL || writer->buffer == NULL || writer->row == NULL
+			|| writer->entries == NULL) {
+		destroyWriter(writer);
+		*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	strcpy(writer->filePath, filePath);
+	sprintf(writer->temporaryPath, "%s%s", filePath, TEMPORARY_FILE_SUFFIX);
+
+	writer->file = fopen(writer->temporaryPath, "wb");
+	if (writer->file == NULL) {
+		destroyWriter(writer);
+		*msg = SP_FEATURES_STORE_WRITE_ERROR;
+		return NULL;
+	}
+	setvbuf(writer->file, writer->buffer, _IOFBF, WRITE_BUFFER_SIZE);
+	// The header is rewritten on commit, once the table offset is known
+	memset(&header, 0, sizeof(header));
+	if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+		destroyWriter(writer);
+		*msg = SP_FEATURES_STORE_WRITE_ERROR;
+		return NULL;
+	}
+	writer->offset = sizeof(header);
+	*msg = SP_FEATURES_STORE_SUCCESS;
+	return writer;
+}
+
+SP_FEATURES_STORE_MSG spFeaturesStoreWriterAppend(SPFeaturesStoreWriter writer, int imageIndex,
+		const SPPoint *features, int numOfFeatures, bool hashed, unsigned long long imageHash) {
+	int i, j;
+	SPFeaturesStoreEntry *entry;
+	if (writer == NULL || features == NULL || numOfFeatures <= 0 || imageIndex < 0
+			|| imageIndex >= writer->numOfImages || (writer->entries[imageIndex].flags & ENTRY_STORED)) {
+		return SP_FEATURES_STORE_INVALID_ARGUMENT;
+	}
+	for (i = 0; i < numOfFeatures; i++) {
+		if (features[i] == NULL || spPointGetDimension(features[i]) != writer->dimension) {
+			return SP_FEATURES_STORE_INVALID_ARGUMENT;
+		}
+	}
+	for (i = 0; i < numOfFeatures; i++) {
+		for (j = 0; j < writer->dimension; j++) {
+			writer->row[j] = spPointGetAxisCoor(features[i], j);
+		}
+		if (fwrite(writer->row, sizeof(double), writer->dimension, writer->file) != (size_t) writer->dimension) {
+			return SP_FEATURES_STORE_WRITE_ERROR;
+		}
+	}
+	entry = &writer->entries[imageIndex];
+	entry->offset = writer->offset;
+	entry->numOfFeatures = (uint32_t) numOfFeatures;
+	entry->flags = ENTRY_STORED | (hashed ? ENTRY_HASHED : 0u);
+	entry->hash = hashed ? (uint64_t) imageHash : 0;
+	writer->offset += (uint64_t) numOfFeatures * writer->dimension * sizeof(double);
+	return SP_FEATURES_STORE_SUCCESS;
+}
+
+SP_FEATURES_STORE_MSG spFeaturesStoreWriterCommit(SPFeaturesStoreWriter writer) {
+	SPFeaturesStoreHeader header;
+	size_t tableSize;
+	bool success;
+	if (writer == NULL) {
+		return SP_FEATURES_STORE_INVALID_ARGUMENT;
+	}
+	tableSize = (size_t) writer->numOfImages * sizeof(SPFeaturesStoreEntry);
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FEATURES_STORE_MAGIC, sizeof(header.magic));
+	header.version = FEATURES_STORE_VERSION;
+	header.dimension = (uint32_t) writer->dimension;
+	header.numOfImages = (uint32_t) writer->numOfImages;
+	header.tableOffset = writer->offset;
+	header.checksum = spUtilFNV1aHash(writer->entries, tableSize, SP_UTIL_FNV1A_INITIAL_HASH);
+
+	success = fwrite(writer->entries, sizeof(SPFeaturesStoreEntry), writer->numOfImages, writer->file)
+			== (size_t) writer->numOfImages
+			&& fseek(writer->file, 0, SEEK_SET) == 0
+			&& fwrite(&header, sizeof(header), 1, writer->file) == 1
+			&& fflush(writer->file) == 0
+			&& fsync(fileno(writer->file)) == 0;
+	success = (fclose(writer->file) == 0) && success;
+	writer->file = NULL;
+	success = success && rename(writer->temporaryPath, writer->filePath) == 0;
+	if (!success) {
+		remove(writer->temporaryPath);
+	}
+	destroyWriter(writer);
+	return success ? SP_FEATURES_STORE_SUCCESS : SP_FEATURES_STORE_WRITE_ERROR;
+}
+
+void spFeaturesStoreWriterAbort(SPFeaturesStoreWriter writer) {
+	if (writer == NULL) {
+		return;
+	}
+	destroyWriter(writer);
+}
+
+SPFeaturesStore spFeaturesStoreLoad(const char *filePath, SP_FEATURES_STORE_MSG *msg) {
+	struct stat fileStat;
+	const SPFeaturesStoreHeader *header;
+	SPFeaturesStore store;
+	uint64_t tableSize;
+	int fd;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (filePath == NULL) {
+		*msg = SP_FEATURES_STORE_INVALID_ARGUMENT;
+		return NULL;
+	}
+	fd = open(filePath, O_RDONLY);
+	if (fd < 0) {
+		*msg = errno == ENOENT ? SP_FEATURES_STORE_MISSING : SP_FEATURES_STORE_READ_ERROR;
+		return NULL;
+	}
+	if (fstat(fd, &fileStat) != 0) {
+		close(fd);
+		*msg = SP_FEATURES_STORE_READ_ERROR;
+		return NULL;
+	}
+	if ((size_t) fileStat.st_size < sizeof(SPFeaturesStoreHeader)) {
+		close(fd);
+		*msg = SP_FEATURES_STORE_INVALID_FORMAT;
+		return NULL;
+	}
+	store = (SPFeaturesStore) malloc(sizeof(*store));
+	if (store == NULL) {
+		close(fd);
+		*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	store->mappingSize = (size_t) fileStat.st_size;
+	store->mapping = mmap(NULL, store->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+	if (store->mapping == MAP_FAILED) {
+		free(store);
+		*msg = SP_FEATURES_STORE_READ_ERROR;
+		return NULL;
+	}
+	header = (const SPFeaturesStoreHeader *) store->mapping;
+	tableSize = (uint64_t) header->numOfImages * sizeof(SPFeaturesStoreEntry);
+	if (memcmp(header->magic, FEATURES_STORE_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != FEATURES_STORE_VERSION || header->dimension == 0 || header->numOfImages > INT_MAX
+			|| header->tableOffset < sizeof(SPFeaturesStoreHeader) || header->tableOffset % sizeof(double) != 0
+			|| header->tableOffset > store->mappingSize || store->mappingSize - header->tableOffset != tableSize) {
+		spFeaturesStoreDestroy(store);
+		*msg = SP_FEATURES_STORE_INVALID_FORMAT;
+		return NULL;
+	}
+	store->header = header;
+	store->entries = (const SPFeaturesStoreEntry *) ((const char *) store->mapping + header->tableOffset);
+	if (spUtilFNV1aHash(store->entries, tableSize, SP_UTIL_FNV1A_INITIAL_HASH) != header->checksum) {
+		spFeaturesStoreDestroy(store);
+		*msg = SP_FEATURES_STORE_CHECKSUM_MISMATCH;
+		return NULL;
+	}
+	if (!isTableValid(store)) {
+		spFeaturesStoreDestroy(store);
+		*msg = SP_FEATURES_STORE_INVALID_FORMAT;
+		return NULL;
+	}
+	*msg = SP_FEATURES_STORE_SUCCESS;
+	return store;
+}
+
+int spFeaturesStoreGetDimension(SPFeaturesStore store) {
+	return store == NULL ? -1 : (int) store->header->dimension;
+}
+
+int spFeaturesStoreGetNumOfImages(SPFeaturesStore store) {
+	return store == NULL ? -1 : (int) store->header->numOfImages;
+}
+
+int spFeaturesStoreGetNumOfFeatures(SPFeaturesStore store, int imageIndex) {
+	if (store == NULL || imageIndex < 0 || imageIndex >= (int) store->header->numOfImages) {
+		return -1;
+	}
+	return (int) store->entries[imageIndex].numOfFeatures;
+}
+
+bool spFeaturesStoreGetImageHash(SPFeaturesStore store, int imageIndex, unsigned long long *imageHash) {
+	if (store == NULL || imageHash == NULL || imageIndex < 0 || imageIndex >= (int) store->header->numOfImages
+			|| !(store->entries[imageIndex].flags & ENTRY_HASHED)) {
+		return false;
+	}
+	*imageHash = (unsigned long long) store->entries[imageIndex].hash;
+	return true;
+}
+
+SPPoint *spFeaturesStoreGetImageFeatures(SPFeaturesStore store, int imageIndex, int *numOfFeatures,
+		SP_FEATURES_STORE_MSG *msg) {
+	const SPFeaturesStoreEntry *entry;
+	SPPoint *features;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (store == NULL || numOfFeatures == NULL || imageIndex < 0 || imageIndex >= (int) store->header->numOfImages) {
+		*msg = SP_FEATURES_STORE_INVALID_ARGUMENT;
+		return NULL;
+	}
+	entry = &store->entries[imageIndex];
+	if (!(entry->flags & ENTRY_STORED)) {
+		*msg = SP_FEATURES_STORE_IMAGE_MISSING;
+		return NULL;
+	}
+	features = (SPPoint *) malloc(entry->numOfFeatures * sizeof(SPPoint));
+	if (features == NULL || !createEntryPoints(store, entry, imageIndex, features)) {
+		free(features);
+		*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	*numOfFeatures = (int) entry->numOfFeatures;
+	*msg = SP_FEATURES_STORE_SUCCESS;
+	return features;
+}
+
+SPPoint *spFeaturesStoreLoadAll(SPFeaturesStore store, int *numOfFeatures, SP_FEATURES_STORE_MSG *msg) {
+	int imageIndex, numOfImages;
+	size_t totalFeaturesCount = 0, loadedCount = 0;
+	SPPoint *features;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (store == NULL || numOfFeatures == NULL) {
+		*msg = SP_FEATURES_STORE_INVALID_ARGUMENT;
+		return NULL;
+	}
+	numOfImages = (int) store->header->numOfImages;
+	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
+		totalFeaturesCount += store->entries[imageIndex].numOfFeatures;
+	}
+	if (totalFeaturesCount == 0 || totalFeaturesCount > INT_MAX) {
+		*msg = totalFeaturesCount == 0 ? SP_FEATURES_STORE_IMAGE_MISSING : SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	features = (SPPoint *) malloc(totalFeaturesCount * sizeof(SPPoint));
+	if (features == NULL) {
+		*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+		return NULL;
+	}
+	// Only a hint - the features are read once, front to back
+	posix_madvise(store->mapping, store->header->tableOffset, POSIX_MADV_SEQUENTIAL);
+	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
+		const SPFeaturesStoreEntry *entry = &store->entries[imageIndex];
+		if (!(entry->flags & ENTRY_STORED)) {
+			continue;
+		}
+		if (!createEntryPoints(store, entry, imageIndex, features + loadedCount)) {
+			while (loadedCount > 0) {
+				spPointDestroy(features[--loadedCount]);
+			}
+			free(features);
+			*msg = SP_FEATURES_STORE_ALLOC_FAIL;
+			return NULL;
+		}
+		loadedCount += entry->numOfFeatures;
+	}
+	*numOfFeatures = (int) totalFeaturesCount;
+	*msg = SP_FEATURES_STORE_SUCCESS;
+	return features;
+}
+
+void spFeaturesStoreDestroy(SPFeaturesStore store) {
+	if (store == NULL) {
+		return;
+	}
+	munmap(store->mapping, store->mappingSize);
+	free(store);
+}
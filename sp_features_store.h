@@ -0,0 +1,225 @@
+/*
+ * sp_features_store.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SP_FEATURES_STORE_H_
+#define SP_FEATURES_STORE_H_
+
+#include <stdbool.h>
+#include "SPPoint.h"
+
+/**
+ * A single binary file holding the features of all of the images, as an alternative to one .feats file per image.
+ *
+ * The file is a fixed header, the features of the images one after the other (each feature as dimension doubles,
+ * in the machine's byte order), and an offset table with an entry per image at its end:
+ * 		magic "SPFS", version, dimension, number of images, table offset, checksum	- the header
+ * 		features																	- appended per image, in any order
+ * 		offset table																- per image: offset, number of features, hash
+ * The checksum is the 64-bit FNV-1a hash of the offset table, which is validated (together with the offsets
+ * themselves) when the file is loaded. The file is loaded by memory mapping it, so an image's features are
+ * accessed at random by its index, and all of the features are loaded with one sequential pass over the mapping.
+ *
+ * The following functions are available:
+ *
+ * 		spFeaturesStoreWriterCreate			- Starts writing a features store.
+ * 		spFeaturesStoreWriterAppend			- Appends the features of an image to a features store being written.
+ * 		spFeaturesStoreWriterCommit			- Completes writing a features store.
+ * 		spFeaturesStoreWriterAbort			- Discards a features store being written.
+ * 		spFeaturesStoreLoad					- Maps and validates a features store.
+ * 		spFeaturesStoreGetDimension			- Returns the features dimension.
+ * 		spFeaturesStoreGetNumOfImages		- Returns the number of images the store has entries for.
+ * 		spFeaturesStoreGetNumOfFeatures		- Returns the number of features of an image.
+ * 		spFeaturesStoreGetImageHash			- Returns the hash an image's features were stored with.
+ * 		spFeaturesStoreGetImageFeatures		- Loads the features of an image.
+ * 		spFeaturesStoreLoadAll				- Loads the features of all of the images.
+ * 		spFeaturesStoreDestroy				- Unmaps a features store.
+ */
+
+/** Enumeration to inform result of features store method calls. */
+typedef enum sp_features_store_msg_t {
+	SP_FEATURES_STORE_INVALID_ARGUMENT,
+	SP_FEATURES_STORE_MISSING,
+	SP_FEATURES_STORE_ALLOC_FAIL,
+	SP_FEATURES_STORE_WRITE_ERROR,
+	SP_FEATURES_STORE_READ_ERROR,
+	SP_FEATURES_STORE_INVALID_FORMAT,
+	SP_FEATURES_STORE_CHECKSUM_MISMATCH,
+	SP_FEATURES_STORE_IMAGE_MISSING,
+	SP_FEATURES_STORE_SUCCESS
+} SP_FEATURES_STORE_MSG;
+
+/** Type for defining a features store being written. */
+typedef struct sp_features_store_writer_t *SPFeaturesStoreWriter;
+
+/** Type for defining a mapped features store. */
+typedef struct sp_features_store_t *SPFeaturesStore;
+
+/**
+ * Starts writing a features store to the given path. The features are written to a temporary file which is renamed
+ * over the given one on commit, so the previous store (if any) stays readable until then.
+ *
+ * @param filePath The path of the features store to write.
+ * @param dimension The dimension of the features.
+ * @param numOfImages The number of images in the store.
+ * @param msg Place-holder for the SP_FEATURES_STORE_MSG informing the result:
+ * 		SP_FEATURES_STORE_INVALID_ARGUMENT	- In case filePath is NULL, the dimension is non-positive
+ * 											  or the number of images is negative.
+ * 		SP_FEATURES_STORE_ALLOC_FAIL		- In case of an allocation failure.
+ * 		SP_FEATURES_STORE_WRITE_ERROR		- In case the temporary file could not be created.
+ * 		SP_FEATURES_STORE_SUCCESS			- Otherwise.
+ *
+ * @return
+ * 	NULL in case of failure, otherwise a writer which must be committed or aborted.
+ */
+SPFeaturesStoreWriter spFeaturesStoreWriterCreate(const char *filePath, int dimension, int numOfImages,
+		SP_FEATURES_STORE_MSG *msg);
+
+/**
+ * Appends the features of the given image to the store. The images may be appended in any order, each at most once.
+ * An image which is never appended is missing from the store.
+ *
+ * @param writer The features store writer.
+ * @param imageIndex The index of the image.
+ * @param features The features of the image, all of the store's dimension.
+ * @param numOfFeatures The number of features.
+ * @param hashed Whether the features are stored with a hash (see spFeaturesStoreGetImageHash).
+ * @param imageHash The hash to store with the features, ignored if hashed is false.
+ *
+ * @return
+ * 	SP_FEATURES_STORE_INVALID_ARGUMENT	- In case writer or features is NULL, numOfFeatures is non-positive,
+ * 										  the image index is out of range or was already appended,
+ * 										  or a feature is not of the store's dimension.
+ * 	SP_FEATURES_STORE_WRITE_ERROR		- In case writing the features failed.
+ * 	SP_FEATURES_STORE_SUCCESS			- Otherwise.
+ */
+SP_FEATURES_STORE_MSG spFeaturesStoreWriterAppend(SPFeaturesStoreWriter writer, int imageIndex,
+		const SPPoint *features, int numOfFeatures, bool hashed, unsigned long long imageHash);
+
+/**
+ * Writes the offset table, flushes the store to the disk and renames it to its path.
+ * The writer is deallocated in any case.
+ *
+ * @param writer The features store writer.
+ *
+ * @return
+ * 	SP_FEATURES_STORE_INVALID_ARGUMENT	- In case writer is NULL.
+ * 	SP_FEATURES_STORE_WRITE_ERROR		- In case writing the store failed, in which case the previous store
+ * 										  (if any) is left as it was.
+ * 	SP_FEATURES_STORE_SUCCESS			- Otherwise.
+ */
+SP_FEATURES_STORE_MSG spFeaturesStoreWriterCommit(SPFeaturesStoreWriter writer);
+
+/**
+ * Discards the features written so far and deallocates the writer. If writer is NULL nothing is done.
+ *
+ * @param writer The features store writer.
+ */
+void spFeaturesStoreWriterAbort(SPFeaturesStoreWriter writer);
+
+/**
+ * Maps the given features store to memory, and validates its header, offset table and checksum.
+ *
+ * @param filePath The path of the features store.
+ * @param msg Place-holder for the SP_FEATURES_STORE_MSG informing the load result:
+ * 		SP_FEATURES_STORE_INVALID_ARGUMENT	- In case filePath is NULL.
+ * 		SP_FEATURES_STORE_MISSING			- In case the file does not exist.
+ * 		SP_FEATURES_STORE_ALLOC_FAIL		- In case of an allocation failure.
+ * 		SP_FEATURES_STORE_READ_ERROR		- In case the file could not be mapped.
+ * 		SP_FEATURES_STORE_INVALID_FORMAT	- In case the file is not a features store of this version, is truncated,
+ * 											  or an offset points outside of the features.
+ * 		SP_FEATURES_STORE_CHECKSUM_MISMATCH	- In case the offset table does not match the checksum.
+ * 		SP_FEATURES_STORE_SUCCESS			- In case of a successful load.
+ *
+ * @return
+ * 	NULL in case of a non-successful load, otherwise the mapped store - which must be destroyed with
+ * 	spFeaturesStoreDestroy.
+ */
+SPFeaturesStore spFeaturesStoreLoad(const char *filePath, SP_FEATURES_STORE_MSG *msg);
+
+/**
+ * @param store The mapped store.
+ *
+ * @return
+ * 	The dimension of the features, -1 if store is NULL.
+ */
+int spFeaturesStoreGetDimension(SPFeaturesStore store);
+
+/**
+ * @param store The mapped store.
+ *
+ * @return
+ * 	The number of images the store was written for, -1 if store is NULL.
+ */
+int spFeaturesStoreGetNumOfImages(SPFeaturesStore store);
+
+/**
+ * @param store The mapped store.
+ * @param imageIndex The index of the image.
+ *
+ * @return
+ * 	The number of features stored for the image, 0 if the image is missing from the store,
+ * 	-1 if store is NULL or the index is out of range.
+ */
+int spFeaturesStoreGetNumOfFeatures(SPFeaturesStore store, int imageIndex);
+
+/**
+ * Returns the hash the features of the given image were appended with.
+ *
+ * @param store The mapped store.
+ * @param imageIndex The index of the image.
+ * @param imageHash Place-holder for the hash.
+ *
+ * @return
+ * 	false if store or imageHash is NULL, the index is out of range, or the image's features were stored without
+ * 	a hash, true otherwise.
+ */
+bool spFeaturesStoreGetImageHash(SPFeaturesStore store, int imageIndex, unsigned long long *imageHash);
+
+/**
+ * Loads the features of the given image.
+ *
+ * @param store The mapped store.
+ * @param imageIndex The index of the image, which is also set in each of the loaded points.
+ * @param numOfFeatures Place-holder for the number of features loaded.
+ * @param msg Place-holder for the SP_FEATURES_STORE_MSG informing the load result:
+ * 		SP_FEATURES_STORE_INVALID_ARGUMENT	- In case any pointer is NULL or the index is out of range.
+ * 		SP_FEATURES_STORE_IMAGE_MISSING		- In case the image is missing from the store.
+ * 		SP_FEATURES_STORE_ALLOC_FAIL		- In case of an allocation failure.
+ * 		SP_FEATURES_STORE_SUCCESS			- In case of a successful load.
+ *
+ * @return
+ * 	NULL in case of a non-successful load, otherwise the features of the image.
+ */
+SPPoint *spFeaturesStoreGetImageFeatures(SPFeaturesStore store, int imageIndex, int *numOfFeatures,
+		SP_FEATURES_STORE_MSG *msg);
+
+/**
+ * Loads the features of all of the images in the store (ordered by image index), into one array which is allocated
+ * once, with a single sequential pass over the mapping.
+ *
+ * @param store The mapped store.
+ * @param numOfFeatures Place-holder for the total number of features loaded.
+ * @param msg Place-holder for the SP_FEATURES_STORE_MSG informing the load result:
+ * 		SP_FEATURES_STORE_INVALID_ARGUMENT	- In case any pointer is NULL.
+ * 		SP_FEATURES_STORE_IMAGE_MISSING		- In case no image has features in the store.
+ * 		SP_FEATURES_STORE_ALLOC_FAIL		- In case of an allocation failure.
+ * 		SP_FEATURES_STORE_SUCCESS			- In case of a successful load.
+ *
+ * @return
+ * 	NULL in case of a non-successful load, otherwise the features of all of the images.
+ */
+SPPoint *spFeaturesStoreLoadAll(SPFeaturesStore store, int *numOfFeatures, SP_FEATURES_STORE_MSG *msg);
+
+/**
+ * Unmaps the given store. Features loaded from it stay valid, as they are copies.
+ * If store is NULL nothing is done.
+ *
+ * @param store The mapped store.
+ */
+void spFeaturesStoreDestroy(SPFeaturesStore store);
+
+#endif /* SP_FEATURES_STORE_H_ */
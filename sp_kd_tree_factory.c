@@ -8,10 +8,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "sp_features_file_api.h"
+#include "sp_features_store.h"
 #include "SPKDArray.h"
 #include "sp_kd_tree_factory.h"
 #include "SPLogger.h"
+#include "SPThreadPool.h"
+#include "sp_util.h"
 
 /*** Constants ***/
 
@@ -20,6 +24,23 @@
 #define FEATURES_WRITE_FAILURE_MSG "Could not write features to file:"
 #define FEATURES_LOAD_FAILURE_MSG "Could not load features from file:"
 #define FILE_DOESNT_EXISTS_MSG "File does not exist at path:"
+#define EXTRACTION_CACHE_DISABLED_MSG "The extraction cache is disabled, the PCA file couldn't be hashed:"
+#define EXTRACTION_CACHE_WRITE_FAILURE_MSG "Could not write extraction cache file:"
+#define EXTRACTION_CACHE_HITS_MSG "Images whose features were reused from the extraction cache:"
+#define FEATURES_STORE_MISMATCH_MSG "The features store does not match the configured images and PCA dimension:"
+#define IMAGE_MISSING_FROM_STORE_MSG "The features store has no features for image:"
+#define HNSW_INDEX_LOADED_MSG "Loaded the saved HNSW graph of the features:"
+#define HNSW_INDEX_STALE_MSG "The saved HNSW graph does not match the features or parameters, rebuilding it:"
+#define HNSW_INDEX_SAVE_FAILURE_MSG "Could not save the HNSW graph to file:"
+
+/** The number of chunks of images each thread loads the features files of. */
+#define LOAD_CHUNKS_PER_THREAD 8
+
+/** The suffix of the extraction cache file written next to every features file. */
+#define EXTRACTION_CACHE_SUFFIX ".hash"
+
+/** The number of extracted images whose features may wait to be written, before the extraction waits for the writer. */
+#define FEATURES_WRITE_QUEUE_CAPACITY 16
 
 
 /*** Private Methods ***/
@@ -43,9 +64,89 @@ void destroyVariables(SPPoint *allFeatures, int totalFeaturesCount, char *imageP
 	free(featuresPath);
 }
 
+/**
+ * A chunk of consecutive images whose features files are read by one thread pool job.
+ * The jobs of a load share the per-image arrays, each writing only the entries of its own images.
+ */
+typedef struct features_load_chunk_t {
+	SPConfig config;
+	int firstImage;
+	int endImage;
+	int expectedDimension;
+	int *counts;
+	size_t *offsets;
+	SPPoint *allFeatures;
+	SP_FEATURES_FILE_API_MSG *msgs;
+} FeaturesLoadChunk;
+
+/**
+ * Thread pool job - reads the number of features of each image of the chunk from its features file header,
+ * -1 for an image whose features file could not be read.
+ */
+void countChunkFeatures(void *arg, int worker) {
+	FeaturesLoadChunk *chunk = (FeaturesLoadChunk *) arg;
+	char featuresPath[MAX_PATH_LENGTH];
+	int imageIndex;
+	(void) worker;
+	for (imageIndex = chunk->firstImage; imageIndex < chunk->endImage; imageIndex++) {
+		chunk->counts[imageIndex] = -1;
+		if (spConfigGetImageFeaturesPath(featuresPath, chunk->config, imageIndex) != SP_CONFIG_SUCCESS) {
+			chunk->msgs[imageIndex] = SP_FEATURES_FILE_API_INVALID_ARGUMENT;
+			continue;
+		}
+		chunk->counts[imageIndex] = spFeaturesFileAPILoadNumOfFeatures(featuresPath, &chunk->msgs[imageIndex]);
+	}
+}
+
+/**
+ * Thread pool job - loads the features of each counted image of the chunk into its offset of the features array.
+ */
+void loadChunkFeatures(void *arg, int worker) {
+	FeaturesLoadChunk *chunk = (FeaturesLoadChunk *) arg;
+	char featuresPath[MAX_PATH_LENGTH];
+	int imageIndex;
+	(void) worker;
+	for (imageIndex = chunk->firstImage; imageIndex < chunk->endImage; imageIndex++) {
+		if (chunk->counts[imageIndex] <= 0) {
+			continue;
+		}
+		spConfigGetImageFeaturesPath(featuresPath, chunk->config, imageIndex);
+		chunk->msgs[imageIndex] = spFeaturesFileAPILoadInto(featuresPath, imageIndex, chunk->expectedDimension,
+				chunk->allFeatures + chunk->offsets[imageIndex], chunk->counts[imageIndex]);
+	}
+}
+
+/**
+ * Runs the given job on each of the chunks, on the given pool - or on the calling thread if there is no pool -
+ * and waits for all of them.
+ */
+void runChunkJobs(SPThreadPool pool, SPThreadPoolJob job, FeaturesLoadChunk *chunks, int numOfChunks) {
+	int i;
+	for (i = 0; i < numOfChunks; i++) {
+		if (pool == NULL || spThreadPoolSubmit(pool, job, &chunks[i]) != SP_THREAD_POOL_SUCCESS) {
+			job(&chunks[i], 0);
+		}
+	}
+	spThreadPoolWait(pool);
+}
+
+/**
+ * Logs a warning for the features file of the given image which could not be loaded.
+ */
+void warnFeaturesLoadFailure(SPConfig config, int imageIndex, SP_FEATURES_FILE_API_MSG featuresAPIMsg) {
+	char featuresPath[MAX_PATH_LENGTH];
+	spConfigGetImageFeaturesPath(featuresPath, config, imageIndex);
+	SP_LOG_DEBUG("%s %s, %s %d", FEATURES_LOAD_FAILURE_MSG, featuresPath, RETURN_VALUE_MSG, featuresAPIMsg);
+	SP_LOG_WARNING("%s %s", FEATURES_LOAD_FAILURE_MSG, featuresPath);
+}
+
 /**
  * Loads the features for the configured images, as one array of features.
  *
+ * The features files are loaded concurrently, by spNumOfThreads threads, in two passes: the first reads the number
+ * of features of every file from its header, so the features array is allocated once and each image is given its
+ * offset in it, and the second parses the files into their offsets.
+ *
  * @param config The configuration used to load images features.
  * @param numberOfFeatures Place-holder for the total number of features loaded.
  * @param msg SP_KD_TREE_CREATION_MSG informing the load result:
@@ -60,82 +161,429 @@ void destroyVariables(SPPoint *allFeatures, int totalFeaturesCount, char *imageP
  * 	Otherwise, returns the loaded features.
  */
 SPPoint *loadAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_CREATION_MSG *msg) {
-	char loggerMSG[LOGGER_MSG_LENGTH] = { '\0' };
-	*msg = SP_KD_TREE_CREATION_SUCCESS;
-	char *featuresPath = NULL;
 	SPPoint *allFeatures = NULL;
-	SP_CONFIG_MSG resultMSG;
-	int i, numOfFeaturesLoaded, expectedDimension, imageIndex, totalFeaturesCount = 0,
-			numOfImages = spConfigGetNumOfImages(config, &resultMSG);
-
-	if (resultMSG != SP_CONFIG_SUCCESS) {
+	SPThreadPool pool = NULL;
+	FeaturesLoadChunk *chunks;
+	int *counts;
+	size_t *offsets, totalFeaturesCount = 0, loadedCount = 0;
+	SP_FEATURES_FILE_API_MSG *msgs;
+	SP_CONFIG_MSG numOfImagesMsg, pcaDimMsg, numOfThreadsMsg;
+	int i, imageIndex, numOfChunks, chunkSize,
+			numOfImages = spConfigGetNumOfImages(config, &numOfImagesMsg),
+			expectedDimension = spConfigGetPCADim(config, &pcaDimMsg),
+			numOfThreads = spConfigGetNumOfThreads(config, &numOfThreadsMsg);
+	*msg = SP_KD_TREE_CREATION_SUCCESS;
+	if (numOfImagesMsg != SP_CONFIG_SUCCESS || pcaDimMsg != SP_CONFIG_SUCCESS || numOfThreadsMsg != SP_CONFIG_SUCCESS) {
 		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
 		return NULL;
 	}
-
-	expectedDimension = spConfigGetPCADim(config, &resultMSG);
-	if (resultMSG != SP_CONFIG_SUCCESS) {
-		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+	if (numOfImages == 0) {
+		*msg = SP_KD_TREE_CREATION_LOAD_ERROR;
 		return NULL;
 	}
 
-	allFeatures = (SPPoint *) malloc(1 * sizeof(SPPoint));
-	featuresPath = (char *) malloc (MAX_PATH_LENGTH * sizeof(char));
-	if (allFeatures == NULL || featuresPath == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		destroyVariables(allFeatures, 0, NULL, featuresPath);
+	// Several chunks per thread, so that threads which got small files are not left idle
+	numOfChunks = (numOfImages < numOfThreads * LOAD_CHUNKS_PER_THREAD) ? numOfImages : numOfThreads * LOAD_CHUNKS_PER_THREAD;
+	chunkSize = (numOfImages + numOfChunks - 1) / numOfChunks;
+	numOfChunks = (numOfImages + chunkSize - 1) / chunkSize;
+	chunks = (FeaturesLoadChunk *) malloc(numOfChunks * sizeof(*chunks));
+	counts = (int *) malloc(numOfImages * sizeof(*counts));
+	offsets = (size_t *) malloc(numOfImages * sizeof(*offsets));
+	msgs = (SP_FEATURES_FILE_API_MSG *) malloc(numOfImages * sizeof(*msgs));
+	if (chunks == NULL || counts == NULL || offsets == NULL || msgs == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		free(chunks);
+		free(counts);
+		free(offsets);
+		free(msgs);
 		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
 		return NULL;
 	}
+	for (i = 0; i < numOfChunks; i++) {
+		chunks[i].config = config;
+		chunks[i].firstImage = i * chunkSize;
+		chunks[i].endImage = (i + 1) * chunkSize < numOfImages ? (i + 1) * chunkSize : numOfImages;
+		chunks[i].expectedDimension = expectedDimension;
+		chunks[i].counts = counts;
+		chunks[i].offsets = offsets;
+		chunks[i].msgs = msgs;
+	}
+	// Without a pool the files are simply loaded on this thread
+	pool = (numOfThreads > 1) ? spThreadPoolCreate(numOfThreads, numOfChunks) : NULL;
 
+	runChunkJobs(pool, countChunkFeatures, chunks, numOfChunks);
 	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
-		if (spConfigGetImageFeaturesPath(featuresPath, config, imageIndex) != SP_CONFIG_SUCCESS) {
-			destroyVariables(allFeatures, totalFeaturesCount, NULL, featuresPath);
-			*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
-			return NULL;
+		offsets[imageIndex] = totalFeaturesCount;
+		if (counts[imageIndex] > 0) {
+			totalFeaturesCount += counts[imageIndex];
+		}
+	}
+	if (totalFeaturesCount > INT_MAX
+			|| (totalFeaturesCount > 0 && (allFeatures = (SPPoint *) malloc(totalFeaturesCount * sizeof(SPPoint))) == NULL)) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	} else {
+		if (allFeatures != NULL) {
+			for (i = 0; i < numOfChunks; i++) {
+				chunks[i].allFeatures = allFeatures;
+			}
+			runChunkJobs(pool, loadChunkFeatures, chunks, numOfChunks);
+		}
+		// Compact the features of the images which were loaded, in place of those which were not
+		for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
+			if (counts[imageIndex] <= 0 || msgs[imageIndex] != SP_FEATURES_FILE_API_SUCCESS) {
+				warnFeaturesLoadFailure(config, imageIndex, msgs[imageIndex]);
+				*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+				continue;
+			}
+			memmove(allFeatures + loadedCount, allFeatures + offsets[imageIndex], counts[imageIndex] * sizeof(SPPoint));
+			loadedCount += counts[imageIndex];
 		}
-		SP_FEATURES_FILE_API_MSG featuresAPIMsg;
-		SPPoint *features = spFeaturesFileAPILoad(featuresPath, imageIndex, expectedDimension, &numOfFeaturesLoaded, &featuresAPIMsg);
-		if (featuresAPIMsg != SP_FEATURES_FILE_API_SUCCESS) {
-			sprintf(loggerMSG, "%s %s, %s %d", FEATURES_LOAD_FAILURE_MSG, featuresPath, RETURN_VALUE_MSG, featuresAPIMsg);
-			spLoggerPrintDebug(loggerMSG, __FILE__, __func__, __LINE__);
-			sprintf(loggerMSG, "%s %s", FEATURES_LOAD_FAILURE_MSG, featuresPath);
-			spLoggerPrintWarning(loggerMSG, __FILE__, __func__, __LINE__);
+	}
+	spThreadPoolDestroy(pool);
+	free(chunks);
+	free(counts);
+	free(offsets);
+	free(msgs);
+
+	*numberOfFeatures = (int) loadedCount;
+	if (*msg != SP_KD_TREE_CREATION_ALLOC_FAIL && loadedCount == 0) {
+		// In case no features were loaded, return error.
+		*msg = SP_KD_TREE_CREATION_LOAD_ERROR;
+	}
+	if (loadedCount == 0) {
+		free(allFeatures);
+		return NULL;
+	}
+	return allFeatures;
+}
+
+/**
+ * Loads the features for the configured images from the features store, as one array of features.
+ *
+ * @param config The configuration used to load images features.
+ * @param numberOfFeatures Place-holder for the total number of features loaded.
+ * @param msg SP_KD_TREE_CREATION_MSG informing the load result:
+ * 		SP_KD_TREE_CREATION_CONFIG_ERROR			- In case of a configuration access error.
+ * 		SP_KD_TREE_CREATION_ALLOC_FAIL				- In case of allocation failure.
+ *		SP_KD_TREE_CREATION_NON_FATAL_ERROR			- In case some of the images are missing from the store.
+ *		SP_KD_TREE_CREATION_LOAD_ERROR				- In case the store could not be loaded, does not match the
+ *													  configuration, or has no features.
+ *		SP_KD_TREE_CREATION_SUCCESS					- In case all features were successfully loaded.
+ *
+ * @return
+ * 	NULL in case of a non-successful fatal load.
+ * 	Otherwise, returns the loaded features.
+ */
+SPPoint *loadAllStoredFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_CREATION_MSG *msg) {
+	char storePath[MAX_PATH_LENGTH];
+	SPPoint *allFeatures;
+	SPFeaturesStore store;
+	SP_FEATURES_STORE_MSG storeMsg;
+	SP_CONFIG_MSG numOfImagesMsg, pcaDimMsg;
+	int imageIndex, numOfImages = spConfigGetNumOfImages(config, &numOfImagesMsg),
+			expectedDimension = spConfigGetPCADim(config, &pcaDimMsg);
+	*msg = SP_KD_TREE_CREATION_SUCCESS;
+	if (numOfImagesMsg != SP_CONFIG_SUCCESS || pcaDimMsg != SP_CONFIG_SUCCESS
+			|| spConfigGetFeaturesStorePath(storePath, config) != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	store = spFeaturesStoreLoad(storePath, &storeMsg);
+	if (store == NULL) {
+		SP_LOG_DEBUG("%s %s, %s %d", FEATURES_LOAD_FAILURE_MSG, storePath, RETURN_VALUE_MSG, storeMsg);
+		SP_LOG_ERROR("%s %s", FEATURES_LOAD_FAILURE_MSG, storePath);
+		*msg = (storeMsg == SP_FEATURES_STORE_ALLOC_FAIL) ? SP_KD_TREE_CREATION_ALLOC_FAIL : SP_KD_TREE_CREATION_LOAD_ERROR;
+		return NULL;
+	}
+	if (spFeaturesStoreGetNumOfImages(store) != numOfImages || spFeaturesStoreGetDimension(store) != expectedDimension) {
+		SP_LOG_ERROR("%s %s", FEATURES_STORE_MISMATCH_MSG, storePath);
+		spFeaturesStoreDestroy(store);
+		*msg = SP_KD_TREE_CREATION_LOAD_ERROR;
+		return NULL;
+	}
+	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
+		if (spFeaturesStoreGetNumOfFeatures(store, imageIndex) == 0) {
+			SP_LOG_WARNING("%s %d", IMAGE_MISSING_FROM_STORE_MSG, imageIndex);
 			*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
-			continue;
 		}
+	}
+	allFeatures = spFeaturesStoreLoadAll(store, numberOfFeatures, &storeMsg);
+	spFeaturesStoreDestroy(store);
+	if (allFeatures == NULL) {
+		if (storeMsg == SP_FEATURES_STORE_ALLOC_FAIL) {
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		}
+		*msg = (storeMsg == SP_FEATURES_STORE_ALLOC_FAIL) ? SP_KD_TREE_CREATION_ALLOC_FAIL : SP_KD_TREE_CREATION_LOAD_ERROR;
+		return NULL;
+	}
+	return allFeatures;
+}
+
+/**
+ * Computes the hash of the parameters the features are extracted with - the SIFT and PCA parameters, and the
+ * contents of the PCA file. Features are reused from the extraction cache only if this hash did not change.
+ *
+ * @param config The configuration used to extract images features.
+ * @param hash Place-holder for the parameters hash.
+ *
+ * @return
+ * 	false if the parameters could not be read, or the PCA file could not be hashed, true otherwise.
+ */
+bool extractionParametersHash(SPConfig config, unsigned long long *hash) {
+	char pcaPath[MAX_PATH_LENGTH];
+	SP_CONFIG_MSG numOfFeaturesMsg, pcaDimMsg, maxImageSideMsg;
+	int parameters[3];
+	parameters[0] = spConfigGetNumOfFeatures(config, &numOfFeaturesMsg);
+	parameters[1] = spConfigGetPCADim(config, &pcaDimMsg);
+	parameters[2] = spConfigGetMaxImageSide(config, &maxImageSideMsg);
+	if (numOfFeaturesMsg != SP_CONFIG_SUCCESS || pcaDimMsg != SP_CONFIG_SUCCESS || maxImageSideMsg != SP_CONFIG_SUCCESS
+			|| spConfigGetPCAPath(pcaPath, config) != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	*hash = spUtilFNV1aHash(parameters, sizeof(parameters), SP_UTIL_FNV1A_INITIAL_HASH);
+	if (!spUtilFNV1aHashFile(pcaPath, hash)) {
+		SP_LOG_WARNING("%s %s", EXTRACTION_CACHE_DISABLED_MSG, pcaPath);
+		return false;
+	}
+	return true;
+}
 
-		totalFeaturesCount += numOfFeaturesLoaded;
+/**
+ * Returns the path of the extraction cache file of the given features file.
+ *
+ * @return
+ * 	NULL in case of an allocation failure, otherwise the path - which must be freed by the caller.
+ */
+char *extractionCachePath(const char *featuresPath) {
+	char *cachePath = (char *) malloc(strlen(featuresPath) + strlen(EXTRACTION_CACHE_SUFFIX) + 1);
+	if (cachePath != NULL) {
+		sprintf(cachePath, "%s%s", featuresPath, EXTRACTION_CACHE_SUFFIX);
+	}
+	return cachePath;
+}
 
-		allFeatures = (SPPoint *) realloc(allFeatures, totalFeaturesCount * sizeof(SPPoint));
-		if (allFeatures == NULL) {
-			spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-			destroyVariables(allFeatures, totalFeaturesCount, NULL, featuresPath);
-			spKDArrayFreePointsArray(features, numOfFeaturesLoaded);
-			*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+/**
+ * Checks whether the given features file was extracted from an image (and with parameters) of the given hash.
+ *
+ * @param featuresPath The features file path.
+ * @param imageHash The hash of the image contents and the extraction parameters.
+ *
+ * @return
+ * 	true if the features file's extraction cache file holds the given hash, false otherwise.
+ */
+bool isExtractionCached(const char *featuresPath, unsigned long long imageHash) {
+	unsigned long long cachedHash;
+	bool cached;
+	FILE *cacheFile;
+	char *cachePath = extractionCachePath(featuresPath);
+	if (cachePath == NULL) {
+		return false;
+	}
+	cacheFile = fopen(cachePath, "r");
+	free(cachePath);
+	if (cacheFile == NULL) {
+		return false;
+	}
+	cached = fscanf(cacheFile, "%llx", &cachedHash) == 1 && cachedHash == imageHash;
+	fclose(cacheFile);
+	return cached;
+}
+
+/**
+ * Writes the given hash to the extraction cache file of the given (just written) features file.
+ *
+ * @param featuresPath The features file path.
+ * @param imageHash The hash of the image contents and the extraction parameters.
+ */
+void writeExtractionCache(const char *featuresPath, unsigned long long imageHash) {
+	FILE *cacheFile;
+	bool written = false;
+	char *cachePath = extractionCachePath(featuresPath);
+	if (cachePath != NULL && (cacheFile = fopen(cachePath, "w")) != NULL) {
+		written = fprintf(cacheFile, "%016llx\n", imageHash) > 0;
+		written = (fclose(cacheFile) == 0) && written;
+	}
+	if (!written) {
+		SP_LOG_WARNING("%s %s", EXTRACTION_CACHE_WRITE_FAILURE_MSG, featuresPath);
+	}
+	free(cachePath);
+}
+
+/**
+ * Removes the extraction cache file of the given features file, so that stale features are never reused.
+ *
+ * @param featuresPath The features file path.
+ */
+void removeExtractionCache(const char *featuresPath) {
+	char *cachePath = extractionCachePath(featuresPath);
+	if (cachePath != NULL) {
+		remove(cachePath);
+	}
+	free(cachePath);
+}
+
+/**
+ * Loads the features of the given image from the extraction cache - either from the previous features store,
+ * or from the image's features file - if they were extracted from an image (and with parameters) of the given hash.
+ *
+ * @param previousStore The features store written by the previous extraction, NULL if there is none.
+ * @param useStore Whether the features store is used instead of the features files.
+ * @param featuresPath The features file path of the image.
+ * @param imageIndex The index of the image.
+ * @param imageHash The hash of the image contents and the extraction parameters.
+ * @param pcaDim The features dimension.
+ * @param numOfFeaturesLoaded Place-holder for the number of features loaded.
+ *
+ * @return
+ * 	NULL in case the image is not cached, otherwise its cached features.
+ */
+SPPoint *loadCachedFeatures(SPFeaturesStore previousStore, bool useStore, const char *featuresPath, int imageIndex,
+		unsigned long long imageHash, int pcaDim, int *numOfFeaturesLoaded) {
+	unsigned long long storedHash;
+	SP_FEATURES_STORE_MSG storeMsg;
+	SP_FEATURES_FILE_API_MSG featuresFileAPIMsg;
+	if (useStore) {
+		if (!spFeaturesStoreGetImageHash(previousStore, imageIndex, &storedHash) || storedHash != imageHash) {
 			return NULL;
 		}
+		return spFeaturesStoreGetImageFeatures(previousStore, imageIndex, numOfFeaturesLoaded, &storeMsg);
+	}
+	if (!isExtractionCached(featuresPath, imageHash)) {
+		return NULL;
+	}
+	return spFeaturesFileAPILoad(featuresPath, imageIndex, pcaDim, numOfFeaturesLoaded, &featuresFileAPIMsg);
+}
 
-		for (i = 0; i < numOfFeaturesLoaded; i++) {
-			allFeatures[totalFeaturesCount - numOfFeaturesLoaded + i] = features[i];
+/**
+ * The stage which writes the extracted features on a thread of its own, so the extraction of the next image is
+ * not blocked by writing the features of the previous one. The writes are queued in the bounded queue of a single
+ * thread pool, in the order of the images, and are done on the calling thread if the writer thread couldn't be started.
+ * The stage's fields are only accessed by the writer until the stage is finished.
+ */
+typedef struct features_write_stage_t {
+	SPThreadPool writer;
+	bool useStore;
+	bool sync;
+	SPFeaturesStoreWriter storeWriter;
+	const char *storePath;
+	bool failed;
+} FeaturesWriteStage;
+
+/**
+ * The features of a single image, queued to be written by the write stage.
+ * The job owns the features array, but not the features themselves - which must outlive the stage.
+ */
+typedef struct features_write_job_t {
+	FeaturesWriteStage *stage;
+	int imageIndex;
+	SPPoint *features;
+	int numOfFeatures;
+	bool imageHashed;
+	unsigned long long imageHash;
+	char featuresPath[]; // Allocated together with the job
+} FeaturesWriteJob;
+
+/**
+ * Thread pool job - writes the features of an image to its features file and updates its extraction cache file,
+ * or appends them to the features store. Failures are logged and mark the stage as failed.
+ */
+void writeImageFeatures(void *arg, int worker) {
+	FeaturesWriteJob *job = (FeaturesWriteJob *) arg;
+	FeaturesWriteStage *stage = job->stage;
+	SP_FEATURES_FILE_API_MSG featuresFileAPIMsg;
+	SP_FEATURES_STORE_MSG storeMsg;
+	(void) worker;
+	if (stage->useStore) {
+		if (stage->storeWriter != NULL && (storeMsg = spFeaturesStoreWriterAppend(stage->storeWriter, job->imageIndex,
+				job->features, job->numOfFeatures, job->imageHashed, job->imageHash)) != SP_FEATURES_STORE_SUCCESS) {
+			SP_LOG_DEBUG("%s %s, %s %d", FEATURES_WRITE_FAILURE_MSG, stage->storePath, RETURN_VALUE_MSG, storeMsg);
+			SP_LOG_WARNING("%s %s", FEATURES_WRITE_FAILURE_MSG, stage->storePath);
+			stage->failed = true;
+			// A partial append leaves the store inconsistent, so nothing more is written to it
+			spFeaturesStoreWriterAbort(stage->storeWriter);
+			stage->storeWriter = NULL;
+		}
+	} else {
+		featuresFileAPIMsg = stage->sync ?
+				spFeaturesFileAPISyncWrite(job->featuresPath, job->features, job->numOfFeatures) :
+				spFeaturesFileAPIWrite(job->featuresPath, job->features, job->numOfFeatures);
+		if (featuresFileAPIMsg != SP_FEATURES_FILE_API_SUCCESS) {
+			SP_LOG_DEBUG("%s %s, %s %d", FEATURES_WRITE_FAILURE_MSG, job->featuresPath, RETURN_VALUE_MSG,
+					featuresFileAPIMsg);
+			SP_LOG_WARNING("%s %s", FEATURES_WRITE_FAILURE_MSG, job->featuresPath);
+			stage->failed = true;
+			removeExtractionCache(job->featuresPath);
+		} else if (job->imageHashed) {
+			writeExtractionCache(job->featuresPath, job->imageHash);
+		} else {
+			removeExtractionCache(job->featuresPath);
 		}
-		free(features);
 	}
+	free(job->features);
+	free(job);
+}
 
-	free(featuresPath);
-	*numberOfFeatures = totalFeaturesCount;
-	if (totalFeaturesCount == 0) {
-		// In case no features were loaded, return error.
-		destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
-		*msg = SP_KD_TREE_CREATION_LOAD_ERROR;
-		return NULL;
+/**
+ * Queues the features of an image to be written by the write stage. In case the queue is full, waits for
+ * the writer to make room in it.
+ *
+ * @return
+ * 	false in case of an allocation failure (in which case the features array is left to the caller), true otherwise.
+ */
+bool submitFeaturesWrite(FeaturesWriteStage *stage, const char *featuresPath, int imageIndex, SPPoint *features,
+		int numOfFeatures, bool imageHashed, unsigned long long imageHash) {
+	FeaturesWriteJob *job = (FeaturesWriteJob *) malloc(sizeof(*job) + strlen(featuresPath) + 1);
+	if (job == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		return false;
 	}
-	return allFeatures;
+	job->stage = stage;
+	strcpy(job->featuresPath, featuresPath);
+	job->imageIndex = imageIndex;
+	job->features = features;
+	job->numOfFeatures = numOfFeatures;
+	job->imageHashed = imageHashed;
+	job->imageHash = imageHash;
+	if (stage->writer == NULL || spThreadPoolSubmit(stage->writer, writeImageFeatures, job) != SP_THREAD_POOL_SUCCESS) {
+		writeImageFeatures(job, 0);
+	}
+	return true;
+}
+
+/**
+ * Waits for all of the queued features to be written and stops the writer thread. Then commits the features store,
+ * or discards it if the extraction is not completed.
+ *
+ * @param stage The write stage.
+ * @param completed Whether all of the images were handed to the stage.
+ *
+ * @return
+ * 	false if any of the writes (or the commit) failed, true otherwise.
+ */
+bool finishFeaturesWrites(FeaturesWriteStage *stage, bool completed) {
+	SP_FEATURES_STORE_MSG storeMsg;
+	spThreadPoolDestroy(stage->writer);
+	stage->writer = NULL;
+	if (!completed) {
+		spFeaturesStoreWriterAbort(stage->storeWriter);
+	} else if (stage->storeWriter != NULL
+			&& (storeMsg = spFeaturesStoreWriterCommit(stage->storeWriter)) != SP_FEATURES_STORE_SUCCESS) {
+		SP_LOG_DEBUG("%s %s, %s %d", FEATURES_WRITE_FAILURE_MSG, stage->storePath, RETURN_VALUE_MSG, storeMsg);
+		SP_LOG_WARNING("%s %s", FEATURES_WRITE_FAILURE_MSG, stage->storePath);
+		stage->failed = true;
+	}
+	stage->storeWriter = NULL;
+	return !stage->failed;
 }
 
 /**
  * Extracts features for the configured images, as one array of features.
- * For each image, this method also writes the extracted features to .feats file using sp_features_file_api.
+ * For each image, this method also writes the extracted features to .feats file using sp_features_file_api,
+ * or to the features store if spFeaturesStore is set. The features are written by a write stage with a thread of
+ * its own while the next images are extracted, and are flushed to the disk if spFeaturesSync is set.
+ * If spExtractionCache is set, the features of an image whose contents and extraction parameters did not change
+ * since its features were written are loaded from the file (or the previous store) instead of being extracted.
  *
  * @param config The configuration used to extract images features.
  * @param numberOfFeatures Place-holder for the total number of extracted features.
@@ -155,59 +603,104 @@ SPPoint *loadAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_CREA
 SPPoint *extractAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_CREATION_MSG *msg,
 		 FeatureExractionFunction featureExactionFunction) {
 	*msg = SP_KD_TREE_CREATION_SUCCESS;
-	char loggerMSG[LOGGER_MSG_LENGTH] = { '\0' };
 	char *imagePath = NULL, *featuresPath = NULL;
+	char storePath[MAX_PATH_LENGTH];
 	SPPoint *allFeatures = NULL, *features = NULL;
 	SP_CONFIG_MSG resultMSG;
-	SP_FEATURES_FILE_API_MSG featuresFileAPIMsg;
-	int i, imageIndex, numOfFeaturesExtracted, totalFeaturesCount = 0, numOfImages = spConfigGetNumOfImages(config, &resultMSG);
+	SP_FEATURES_STORE_MSG storeMsg;
+	SPFeaturesStore previousStore = NULL;
+	FeaturesWriteStage writeStage;
+	unsigned long long parametersHash = 0, imageHash = 0;
+	bool useCache, useStore, imageHashed, cacheHit;
+	int i, imageIndex, numOfFeaturesExtracted, numOfCacheHits = 0, totalFeaturesCount = 0,
+			numOfImages = spConfigGetNumOfImages(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	int pcaDim = spConfigGetPCADim(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	useStore = spConfigIsFeaturesStore(config, &resultMSG);
+	if (resultMSG != SP_CONFIG_SUCCESS
+			|| (useStore && spConfigGetFeaturesStorePath(storePath, config) != SP_CONFIG_SUCCESS)) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	writeStage.sync = spConfigIsFeaturesSync(config, &resultMSG);
 	if (resultMSG != SP_CONFIG_SUCCESS) {
 		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
 		return NULL;
 	}
+	useCache = spConfigIsExtractionCache(config, &resultMSG) && resultMSG == SP_CONFIG_SUCCESS
+			&& extractionParametersHash(config, &parametersHash);
 
 	allFeatures = (SPPoint *) malloc(1 * sizeof(SPPoint));
 	imagePath = (char *) malloc (MAX_PATH_LENGTH * sizeof(char));
 	featuresPath = (char *) malloc (MAX_PATH_LENGTH * sizeof(char));
 	if (allFeatures == NULL || imagePath == NULL || featuresPath == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
 		destroyVariables(allFeatures, 0, imagePath, featuresPath);
 		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
 		return NULL;
 	}
 
+	writeStage.useStore = useStore;
+	writeStage.storeWriter = NULL;
+	writeStage.storePath = storePath;
+	writeStage.failed = false;
+	if (useStore) {
+		// The previous store stays readable (for the cache) until the new one is committed over it
+		previousStore = useCache ? spFeaturesStoreLoad(storePath, &storeMsg) : NULL;
+		writeStage.storeWriter = spFeaturesStoreWriterCreate(storePath, pcaDim, numOfImages, &storeMsg);
+		if (writeStage.storeWriter == NULL) {
+			SP_LOG_DEBUG("%s %s, %s %d", FEATURES_WRITE_FAILURE_MSG, storePath, RETURN_VALUE_MSG, storeMsg);
+			SP_LOG_WARNING("%s %s", FEATURES_WRITE_FAILURE_MSG, storePath);
+			*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+		}
+	}
+	writeStage.writer = spThreadPoolCreate(1, FEATURES_WRITE_QUEUE_CAPACITY);
+
 	for (imageIndex = 0; imageIndex < numOfImages; imageIndex++) {
 		if (spConfigGetImagePath(imagePath, config, imageIndex) != SP_CONFIG_SUCCESS ||
 				spConfigGetImageFeaturesPath(featuresPath, config, imageIndex) != SP_CONFIG_SUCCESS) {
+			// The queued writes use the features, so they are done before the features are destroyed
+			finishFeaturesWrites(&writeStage, false);
 			destroyVariables(allFeatures, totalFeaturesCount, imagePath, featuresPath);
+			spFeaturesStoreDestroy(previousStore);
 			*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
 			return NULL;
 		}
 
-		features = featureExactionFunction(imagePath, imageIndex, &numOfFeaturesExtracted);
-		if (features == NULL || numOfFeaturesExtracted <= 0) {
-			sprintf(loggerMSG, "%s %s", FEATURE_EXTRACTION_FAILURE_MSG, imagePath);
-			spLoggerPrintWarning(loggerMSG, __FILE__, __func__, __LINE__);
-			*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
-			continue;
+		features = NULL;
+		imageHash = parametersHash;
+		imageHashed = useCache && spUtilFNV1aHashFile(imagePath, &imageHash);
+		if (imageHashed) {
+			features = loadCachedFeatures(previousStore, useStore, featuresPath, imageIndex, imageHash, pcaDim,
+					&numOfFeaturesExtracted);
 		}
+		cacheHit = (features != NULL);
+		numOfCacheHits += cacheHit;
 
-		featuresFileAPIMsg = spFeaturesFileAPIWrite(featuresPath, features, numOfFeaturesExtracted);
-
-		if (featuresFileAPIMsg != SP_FEATURES_FILE_API_SUCCESS) {
-			sprintf(loggerMSG, "%s %s, %s %d", FEATURES_LOAD_FAILURE_MSG, featuresPath, RETURN_VALUE_MSG, featuresFileAPIMsg);
-			spLoggerPrintDebug(loggerMSG, __FILE__, __func__, __LINE__);
-			sprintf(loggerMSG, "%s %s", FEATURES_WRITE_FAILURE_MSG, featuresPath);
-			spLoggerPrintWarning(loggerMSG, __FILE__, __func__, __LINE__);
-			*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+		if (!cacheHit) {
+			features = featureExactionFunction(imagePath, imageIndex, &numOfFeaturesExtracted);
+			if (features == NULL || numOfFeaturesExtracted <= 0) {
+				SP_LOG_WARNING("%s %s", FEATURE_EXTRACTION_FAILURE_MSG, imagePath);
+				*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+				continue;
+			}
 		}
 
 		totalFeaturesCount += numOfFeaturesExtracted;
 		allFeatures = (SPPoint *) realloc(allFeatures, totalFeaturesCount * sizeof(SPPoint));
 		if (allFeatures == NULL) {
-			spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+			finishFeaturesWrites(&writeStage, false);
 			destroyVariables(allFeatures, totalFeaturesCount, imagePath, featuresPath);
 			spKDArrayFreePointsArray(features, numOfFeaturesExtracted);
+			spFeaturesStoreDestroy(previousStore);
 			*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
 			return NULL;
 		}
@@ -215,12 +708,31 @@ SPPoint *extractAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_C
 		for (i = 0; i < numOfFeaturesExtracted; i++) {
 			allFeatures[totalFeaturesCount - numOfFeaturesExtracted + i] = features[i];
 		}
-		free(features);
+
+		// Cached features are appended to the store as well, as the store is rewritten as a whole
+		if (!useStore && cacheHit) {
+			free(features);
+		} else if (!submitFeaturesWrite(&writeStage, featuresPath, imageIndex, features, numOfFeaturesExtracted,
+				imageHashed, imageHash)) {
+			free(features);
+			finishFeaturesWrites(&writeStage, false);
+			destroyVariables(allFeatures, totalFeaturesCount, imagePath, featuresPath);
+			spFeaturesStoreDestroy(previousStore);
+			*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+			return NULL;
+		}
 	}
 
 	free(imagePath);
 	free(featuresPath);
+	spFeaturesStoreDestroy(previousStore);
+	if (!finishFeaturesWrites(&writeStage, true)) {
+		*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+	}
 	*numberOfFeatures = totalFeaturesCount;
+	if (useCache) {
+		SP_LOG_INFO("%s %d/%d", EXTRACTION_CACHE_HITS_MSG, numOfCacheHits, numOfImages);
+	}
 
 	if (totalFeaturesCount == 0) {
 		// In case no features were extracted, return error.
@@ -234,7 +746,8 @@ SPPoint *extractAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_C
 
 
 /**
- * According to the configured extraction-mode, either extract or load all of the images features.
+ * According to the configured extraction-mode, either extract or load all of the images features
+ * (from the features files, or from the features store if spFeaturesStore is set).
  *
  * @param config The configuration used to extract/load images features.
  * @param numberOfFeatures Place-holder for the total number of extracted/loaded features.
@@ -258,16 +771,255 @@ SPPoint *getAllFeatures(SPConfig config, int *numberOfFeatures, SP_KD_TREE_CREAT
 	if (config == NULL) {
 		return NULL;
 	}
-	SP_CONFIG_MSG resultMSG;
-	bool extractionMode = spConfigIsExtractionMode(config, &resultMSG);
-	if (resultMSG != SP_CONFIG_SUCCESS) {
+	SP_CONFIG_MSG extractionModeMsg, featuresStoreMsg;
+	bool extractionMode = spConfigIsExtractionMode(config, &extractionModeMsg);
+	bool featuresStore = spConfigIsFeaturesStore(config, &featuresStoreMsg);
+	if (extractionModeMsg != SP_CONFIG_SUCCESS || featuresStoreMsg != SP_CONFIG_SUCCESS) {
 		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
 		return NULL;
 	}
-	return extractionMode ? extractAllFeatures(config, numberOfFeatures, msg, featureExtractionFunction) :
+	if (extractionMode) {
+		return extractAllFeatures(config, numberOfFeatures, msg, featureExtractionFunction);
+	}
+	return featuresStore ? loadAllStoredFeatures(config, numberOfFeatures, msg) :
 			loadAllFeatures(config, numberOfFeatures, msg);
 }
 
+/**
+ * Builds a kd-tree of the given features, with the configured split method.
+ *
+ * @return
+ * 	NULL in case of failure (msg is set accordingly), the tree otherwise.
+ */
+SPKDTreeNode buildFeaturesKDTree(SPConfig config, SPPoint *allFeatures, int totalFeaturesCount,
+		SP_KD_TREE_CREATION_MSG *msg) {
+	SPKDArray kdArray;
+	SP_CONFIG_MSG configMsg;
+	SP_TREE_SPLIT_METHOD splitMethod;
+	SPKDTreeNode tree;
+	splitMethod = spConfigGetSplitMethod(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	kdArray = spKDArrayInit(allFeatures, totalFeaturesCount);
+	if (kdArray == NULL) {
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+		return NULL;
+	}
+	tree = spKDTreeBuild(kdArray, splitMethod);
+	spKDArrayDestroy(kdArray);
+	if (tree == NULL) {
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	}
+	return tree;
+}
+
+/**
+ * Builds a PQ index of the given features, with the configured number of sub-quantizers.
+ *
+ * @return
+ * 	NULL in case of failure (msg is set accordingly), the index otherwise.
+ */
+SPSearchIndex buildFeaturesPQIndex(SPConfig config, SPPoint *allFeatures, int totalFeaturesCount,
+		SP_KD_TREE_CREATION_MSG *msg) {
+	SP_CONFIG_MSG configMsg;
+	SP_PQ_INDEX_MSG pqMsg;
+	SPPQIndex pqIndex;
+	SPSearchIndex searchIndex;
+	int numOfSubquantizers = spConfigGetPQSubquantizers(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	pqIndex = spPQIndexCreate(allFeatures, totalFeaturesCount, numOfSubquantizers, &pqMsg);
+	if (pqIndex == NULL) {
+		// The features are valid, so an invalid argument is a number of sub-quantizers larger than their dimension
+		*msg = (pqMsg == SP_PQ_INDEX_INVALID_ARGUMENT) ? SP_KD_TREE_CREATION_CONFIG_ERROR
+				: SP_KD_TREE_CREATION_ALLOC_FAIL;
+		return NULL;
+	}
+	searchIndex = spSearchIndexCreatePQ(pqIndex);
+	if (searchIndex == NULL) {
+		spPQIndexDestroy(pqIndex);
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	}
+	return searchIndex;
+}
+
+/**
+ * Builds an IVF index of the given features, with the configured lists and probes. The features of the lists are
+ * encoded with the configured number of PQ sub-quantizers if quantized is true.
+ *
+ * @return
+ * 	NULL in case of failure (msg is set accordingly), the index otherwise.
+ */
+SPSearchIndex buildFeaturesIVFIndex(SPConfig config, SPPoint *allFeatures, int totalFeaturesCount, bool quantized,
+		SP_KD_TREE_CREATION_MSG *msg) {
+	SP_CONFIG_MSG listsMsg, probesMsg, subquantizersMsg = SP_CONFIG_SUCCESS;
+	SP_IVF_INDEX_MSG ivfMsg;
+	SPIVFIndex ivfIndex;
+	SPSearchIndex searchIndex;
+	int numOfLists = spConfigGetIVFLists(config, &listsMsg);
+	int numOfProbes = spConfigGetIVFProbes(config, &probesMsg);
+	int numOfSubquantizers = quantized ? spConfigGetPQSubquantizers(config, &subquantizersMsg) : 0;
+	if (listsMsg != SP_CONFIG_SUCCESS || probesMsg != SP_CONFIG_SUCCESS || subquantizersMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	ivfIndex = spIVFIndexCreate(allFeatures, totalFeaturesCount, numOfLists, numOfProbes, numOfSubquantizers,
+			&ivfMsg);
+	if (ivfIndex == NULL) {
+		// As with the PQ index, an invalid argument is a number of sub-quantizers larger than the dimension
+		*msg = (ivfMsg == SP_IVF_INDEX_INVALID_ARGUMENT) ? SP_KD_TREE_CREATION_CONFIG_ERROR
+				: SP_KD_TREE_CREATION_ALLOC_FAIL;
+		return NULL;
+	}
+	searchIndex = spSearchIndexCreateIVF(ivfIndex);
+	if (searchIndex == NULL) {
+		spIVFIndexDestroy(ivfIndex);
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	}
+	return searchIndex;
+}
+
+/**
+ * Computes the hash of the given features - of their coordinates and image indices, in their order.
+ * The HNSW graph is saved with this hash, so a saved graph is reused only for the very features it was built of.
+ */
+unsigned long long featuresHash(SPPoint *allFeatures, int totalFeaturesCount) {
+	int i, j, imageIndex;
+	double coordinate;
+	unsigned long long hash = SP_UTIL_FNV1A_INITIAL_HASH;
+	for (i = 0; i < totalFeaturesCount; i++) {
+		imageIndex = spPointGetIndex(allFeatures[i]);
+		hash = spUtilFNV1aHash(&imageIndex, sizeof(imageIndex), hash);
+		for (j = 0; j < spPointGetDimension(allFeatures[i]); j++) {
+			coordinate = spPointGetAxisCoor(allFeatures[i], j);
+			hash = spUtilFNV1aHash(&coordinate, sizeof(coordinate), hash);
+		}
+	}
+	return hash;
+}
+
+/**
+ * Loads the HNSW graph saved at the given path, if it was built of the given features with the configured M and
+ * efConstruction.
+ *
+ * @return
+ * 	NULL if there is no such graph, the loaded graph otherwise.
+ */
+SPHNSWIndex loadSavedHNSWIndex(const char *indexPath, SPPoint *allFeatures, int totalFeaturesCount,
+		unsigned long long hash, int M, int efConstruction, int efSearch) {
+	SP_HNSW_INDEX_MSG hnswMsg;
+	unsigned long long savedHash;
+	SPHNSWIndex hnswIndex = spHNSWIndexLoad(indexPath, efSearch, &savedHash, &hnswMsg);
+	if (hnswIndex == NULL) {
+		if (hnswMsg != SP_HNSW_INDEX_MISSING) {
+			SP_LOG_DEBUG("%s %s, %s %d", HNSW_INDEX_STALE_MSG, indexPath, RETURN_VALUE_MSG, hnswMsg);
+		}
+		return NULL;
+	}
+	if (savedHash != hash || spHNSWIndexGetNumOfFeatures(hnswIndex) != totalFeaturesCount
+			|| spHNSWIndexGetDimension(hnswIndex) != spPointGetDimension(allFeatures[0])
+			|| spHNSWIndexGetM(hnswIndex) != M || spHNSWIndexGetEfConstruction(hnswIndex) != efConstruction) {
+		SP_LOG_INFO("%s %s", HNSW_INDEX_STALE_MSG, indexPath);
+		spHNSWIndexDestroy(hnswIndex);
+		return NULL;
+	}
+	SP_LOG_INFO("%s %s", HNSW_INDEX_LOADED_MSG, indexPath);
+	return hnswIndex;
+}
+
+/**
+ * Builds an HNSW index of the given features, with the configured M, efConstruction and efSearch, inserting the
+ * features with spNumOfThreads threads. The graph saved by a previous run is loaded instead, if it was built of the
+ * same features with the same parameters, and a newly built graph is saved for the next runs.
+ *
+ * @return
+ * 	NULL in case of failure (msg is set accordingly), the index otherwise.
+ */
+SPSearchIndex buildFeaturesHNSWIndex(SPConfig config, SPPoint *allFeatures, int totalFeaturesCount,
+		SP_KD_TREE_CREATION_MSG *msg) {
+	char indexPath[MAX_PATH_LENGTH];
+	SP_CONFIG_MSG mMsg, efConstructionMsg, efSearchMsg, numOfThreadsMsg;
+	SP_HNSW_INDEX_MSG hnswMsg;
+	SPHNSWIndex hnswIndex;
+	SPSearchIndex searchIndex;
+	unsigned long long hash;
+	int M = spConfigGetHNSWM(config, &mMsg);
+	int efConstruction = spConfigGetHNSWEfConstruction(config, &efConstructionMsg);
+	int efSearch = spConfigGetHNSWEfSearch(config, &efSearchMsg);
+	int numOfThreads = spConfigGetNumOfThreads(config, &numOfThreadsMsg);
+	if (mMsg != SP_CONFIG_SUCCESS || efConstructionMsg != SP_CONFIG_SUCCESS || efSearchMsg != SP_CONFIG_SUCCESS
+			|| numOfThreadsMsg != SP_CONFIG_SUCCESS || spConfigGetHNSWIndexPath(indexPath, config) != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	hash = featuresHash(allFeatures, totalFeaturesCount);
+	hnswIndex = loadSavedHNSWIndex(indexPath, allFeatures, totalFeaturesCount, hash, M, efConstruction, efSearch);
+	if (hnswIndex == NULL) {
+		hnswIndex = spHNSWIndexCreate(allFeatures, totalFeaturesCount, M, efConstruction, efSearch, numOfThreads,
+				&hnswMsg);
+		if (hnswIndex == NULL) {
+			*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+			return NULL;
+		}
+		hnswMsg = spHNSWIndexSave(hnswIndex, indexPath, hash);
+		if (hnswMsg != SP_HNSW_INDEX_SUCCESS) {
+			SP_LOG_DEBUG("%s %s, %s %d", HNSW_INDEX_SAVE_FAILURE_MSG, indexPath, RETURN_VALUE_MSG, hnswMsg);
+			SP_LOG_WARNING("%s %s", HNSW_INDEX_SAVE_FAILURE_MSG, indexPath);
+			*msg = SP_KD_TREE_CREATION_NON_FATAL_ERROR;
+		}
+	}
+	searchIndex = spSearchIndexCreateHNSW(hnswIndex);
+	if (searchIndex == NULL) {
+		spHNSWIndexDestroy(hnswIndex);
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	}
+	return searchIndex;
+}
+
+/**
+ * Builds the configured search index of the given features.
+ *
+ * @return
+ * 	NULL in case of failure (msg is set accordingly), the index otherwise.
+ */
+SPSearchIndex buildFeaturesSearchIndex(SPConfig config, SPPoint *allFeatures, int totalFeaturesCount,
+		SP_KD_TREE_CREATION_MSG *msg) {
+	SP_CONFIG_MSG configMsg;
+	SPKDTreeNode tree;
+	SPSearchIndex searchIndex;
+	SP_SEARCH_INDEX_TYPE indexType = spConfigGetSearchIndex(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_KD_TREE_CREATION_CONFIG_ERROR;
+		return NULL;
+	}
+	switch (indexType) {
+	case SEARCH_INDEX_PQ:
+		return buildFeaturesPQIndex(config, allFeatures, totalFeaturesCount, msg);
+	case SEARCH_INDEX_IVF:
+		return buildFeaturesIVFIndex(config, allFeatures, totalFeaturesCount, false, msg);
+	case SEARCH_INDEX_IVF_PQ:
+		return buildFeaturesIVFIndex(config, allFeatures, totalFeaturesCount, true, msg);
+	case SEARCH_INDEX_HNSW:
+		return buildFeaturesHNSWIndex(config, allFeatures, totalFeaturesCount, msg);
+	default:
+		break;
+	}
+	tree = buildFeaturesKDTree(config, allFeatures, totalFeaturesCount, msg);
+	if (tree == NULL) {
+		return NULL;
+	}
+	searchIndex = spSearchIndexCreateKDTree(tree);
+	if (searchIndex == NULL) {
+		spKDTreeDestroy(tree);
+		*msg = SP_KD_TREE_CREATION_ALLOC_FAIL;
+	}
+	return searchIndex;
+}
+
 /*** Public Methods ***/
 
 SPKDTreeNode spImagesKDTreeCreate(const SPConfig config,
@@ -276,9 +1028,6 @@ SPKDTreeNode spImagesKDTreeCreate(const SPConfig config,
 
 	SPPoint *allFeatures = NULL;
 	int totalFeaturesCount = 0;
-	SPKDArray kdArray;
-	SP_CONFIG_MSG configMsg;
-	SP_TREE_SPLIT_METHOD splitMethod;
 	SPKDTreeNode tree;
 	if (config == NULL || featureExtractionFunction == NULL || msg == NULL) {
 		*msg = SP_KD_TREE_CREATION_INVALID_ARGUMENT;
@@ -289,24 +1038,28 @@ SPKDTreeNode spImagesKDTreeCreate(const SPConfig config,
 		destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
 		return NULL;
 	}
-	kdArray = spKDArrayInit(allFeatures, totalFeaturesCount);
-	if (kdArray == NULL) {
-		destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
-		return NULL;
-	}
-	splitMethod = spConfigGetSplitMethod(config, &configMsg);
-	if (configMsg != SP_CONFIG_SUCCESS) {
-		spKDArrayDestroy(kdArray);
-		destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
+	tree = buildFeaturesKDTree(config, allFeatures, totalFeaturesCount, msg);
+	destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
+	return tree;
+}
+
+SPSearchIndex spImagesSearchIndexCreate(const SPConfig config,
+		FeatureExractionFunction featureExtractionFunction,
+		SP_KD_TREE_CREATION_MSG *msg) {
+
+	SPPoint *allFeatures = NULL;
+	int totalFeaturesCount = 0;
+	SPSearchIndex searchIndex;
+	if (config == NULL || featureExtractionFunction == NULL || msg == NULL) {
+		*msg = SP_KD_TREE_CREATION_INVALID_ARGUMENT;
 		return NULL;
 	}
-	tree = spKDTreeBuild(kdArray, splitMethod);
-	if (tree == NULL) {
-		spKDArrayDestroy(kdArray);
+	allFeatures = getAllFeatures(config, &totalFeaturesCount, msg, featureExtractionFunction);
+	if (allFeatures == NULL || totalFeaturesCount <= 0 || (*msg != SP_KD_TREE_CREATION_SUCCESS && *msg != SP_KD_TREE_CREATION_NON_FATAL_ERROR)) {
 		destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
 		return NULL;
 	}
-	spKDArrayDestroy(kdArray);
+	searchIndex = buildFeaturesSearchIndex(config, allFeatures, totalFeaturesCount, msg);
 	destroyVariables(allFeatures, totalFeaturesCount, NULL, NULL);
-	return tree;
+	return searchIndex;
 }
@@ -10,16 +10,20 @@
 
 #include <stdlib.h>
 #include "SPKDTree.h"
+#include "SPSearchIndex.h"
 #include "SPConfig.h"
 #include "sp_constants.h"
 
 /**
- * Factory which supplies initialization methods of features kd-trees out of configured images.
+ * Factory which supplies initialization methods of features kd-trees (and of the other search indices) out of
+ * configured images.
  *
  * The following functions are available:
  *
  * 		spImagesKDTreeCreate 		- Creates a kd-tree for the configured images,
  * 									  by extraction or by loading previously extracted features.
+ * 		spImagesSearchIndexCreate	- Creates the configured search index for the configured images,
+ * 									  by extraction or by loading previously extracted features.
  *
  */
 
@@ -39,9 +43,11 @@ typedef enum sp_kd_tree_creation_msg_t {
  *
  * If extraction mode is configured, the method will create the kd-tree and will also write the extracted images features to .feat
  * corresponding files, using the sp_features_file_api methods, which can be loaded by re-running with non-extraction mode.
+ * If spFeaturesStore is configured, the features are written to a single features store file instead, using the
+ * sp_features_store methods.
  *
  * If non-extraction mode is configured, the method will create the kd-tree by loading the images features from the previously written .feats files,
- * using the sp_features_file_api methods.
+ * using the sp_features_file_api methods (or from the previously written features store, if spFeaturesStore is configured).
  *
  * @param config The configuration to use in order to create the kd-tree.
  * @param featureExtractionFunction a function used for extracting images features if needed.
@@ -64,4 +70,25 @@ SPKDTreeNode spImagesKDTreeCreate(const SPConfig config,
 		FeatureExractionFunction featureExtractionFunction,
 		SP_KD_TREE_CREATION_MSG *msg);
 
+/**
+ * Creates the configured search index (see spConfigGetSearchIndex) for the configured images. The features are
+ * extracted or loaded exactly as in spImagesKDTreeCreate, and are indexed by a kd-tree, a PQ index, an IVF index or
+ * an HNSW index. A built HNSW graph is saved to spConfigGetHNSWIndexPath, and is loaded instead of being rebuilt by
+ * the next runs, as long as it was built of the same features with the same spHNSWM and spHNSWEfConstruction.
+ *
+ * @param config The configuration to use in order to create the index.
+ * @param featureExtractionFunction a function used for extracting images features if needed.
+ * @param msg The SP_KD_TREE_CREATION_MSG informing the result of the creation, as in spImagesKDTreeCreate.
+ * 		SP_KD_TREE_CREATION_CONFIG_ERROR is informed also in case the configured number of PQ sub-quantizers is
+ * 		larger than the dimension of the features (for a PQ or an IVF_PQ index).
+ * 		SP_KD_TREE_CREATION_NON_FATAL_ERROR is informed also in case a built HNSW graph could not be saved.
+ *
+ * @return
+ * 	NULL in case of a non-successful fatal creation.
+ * 	Otherwise, returns the created search index for the configured images.
+ */
+SPSearchIndex spImagesSearchIndexCreate(const SPConfig config,
+		FeatureExractionFunction featureExtractionFunction,
+		SP_KD_TREE_CREATION_MSG *msg);
+
 #endif /* SP_KD_TREE_FACTORY_H_ */
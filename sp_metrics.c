@@ -0,0 +1,337 @@
+/*
+ * sp_metrics.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sp_metrics.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/*** Type declarations ***/
+
+/** The histogram of a single timer. */
+typedef struct sp_metrics_histogram_t {
+	unsigned long long count;
+	unsigned long long sumNanos;
+	unsigned long long maxBucket;
+	unsigned long long buckets[SP_METRICS_NUM_OF_BUCKETS];
+} SPMetricsHistogram;
+
+/**
+ * The values recorded by a single thread. Only the owning thread writes them, so updates are plain (relaxed)
+ * load and store pairs - dumps read them concurrently with relaxed loads.
+ */
+typedef struct sp_metrics_thread_t {
+	SPMetricsHistogram timers[SP_METRICS_NUM_OF_TIMERS];
+	unsigned long long counters[SP_METRICS_NUM_OF_COUNTERS];
+	struct sp_metrics_thread_t *next;
+	struct sp_metrics_thread_t *previous;
+} SPMetricsThread;
+
+/*** Private Variables ***/
+
+static const char *TIMER_NAMES[SP_METRICS_NUM_OF_TIMERS] = {
+	"image_decode", "sift", "pca_projection", "tree_traversal", "voting", "sorting", "search"
+};
+
+static const char *COUNTER_NAMES[SP_METRICS_NUM_OF_COUNTERS] = {
+	"queries", "nodes_visited", "leaves_scanned", "distance_computations"
+};
+
+static int metricsEnabled = 0;
+
+/** The values of the live threads, and the sums of the threads which exited. Guarded by threadsMutex. */
+static pthread_mutex_t threadsMutex = PTHREAD_MUTEX_INITIALIZER;
+static SPMetricsThread *liveThreads = NULL;
+static SPMetricsThread exitedThreads;
+
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadKey;
+
+/*** Private Methods ***/
+
+/**
+ * Adds to a value owned by the calling thread.
+ */
+static void addOwned(unsigned long long *value, unsigned long long delta) {
+	__atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+static unsigned long long loadValue(const unsigned long long *value) {
+	return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+/**
+ * Adds all of the values of source to target.
+ */
+static void addThreadValues(SPMetricsThread *target, const SPMetricsThread *source) {
+	int i, j;
+	unsigned long long maxBucket;
+	for (i = 0; i < SP_METRICS_NUM_OF_TIMERS; i++) {
+		target->timers[i].count += loadValue(&source->timers[i].count);
+		target->timers[i].sumNanos += loadValue(&source->timers[i].sumNanos);
+		maxBucket = loadValue(&source->timers[i].maxBucket);
+		if (maxBucket > target->timers[i].maxBucket) {
+			target->timers[i].maxBucket = maxBucket;
+		}
+		for (j = 0; j < SP_METRICS_NUM_OF_BUCKETS; j++) {
+			target->timers[i].buckets[j] += loadValue(&source->timers[i].buckets[j]);
+		}
+	}
+	for (i = 0; i < SP_METRICS_NUM_OF_COUNTERS; i++) {
+		target->counters[i] += loadValue(&source->counters[i]);
+	}
+}
+
+/**
+ * Thread exit destructor - moves the values of the exiting thread into the exited threads sums.
+ */
+static void releaseThreadValues(void *values) {
+	SPMetricsThread *thread = (SPMetricsThread *) values;
+	pthread_mutex_lock(&threadsMutex);
+	addThreadValues(&exitedThreads, thread);
+	if (thread->previous != NULL) {
+		thread->previous->next = thread->next;
+	} else {
+		liveThreads = thread->next;
+	}
+	if (thread->next != NULL) {
+		thread->next->previous = thread->previous;
+	}
+	pthread_mutex_unlock(&threadsMutex);
+	free(thread);
+}
+
+static void createThreadKey() {
+	pthread_key_create(&threadKey, releaseThreadValues);
+}
+
+/**
+ * Returns the values of the calling thread, registering them on the first call.
+ *
+ * @return
+ * 	NULL in case of allocation failure, the values of the calling thread otherwise.
+ */
+static SPMetricsThread *threadValues() {
+	SPMetricsThread *thread;
+	pthread_once(&threadKeyOnce, createThreadKey);
+	thread = (SPMetricsThread *) pthread_getspecific(threadKey);
+	if (thread != NULL) {
+		return thread;
+	}
+	thread = (SPMetricsThread *) calloc(1, sizeof(*thread));
+	if (thread == NULL) {
+		return NULL;
+	}
+	if (pthread_setspecific(threadKey, thread) != 0) {
+		free(thread);
+		return NULL;
+	}
+	pthread_mutex_lock(&threadsMutex);
+	thread->next = liveThreads;
+	if (liveThreads != NULL) {
+		liveThreads->previous = thread;
+	}
+	liveThreads = thread;
+	pthread_mutex_unlock(&threadsMutex);
+	return thread;
+}
+
+static long long monotonicNanos() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * Returns the histogram bucket of the given duration.
+ */
+static int bucketOf(unsigned long long nanos) {
+	int bucket = 0;
+	while (nanos > 1 && bucket < SP_METRICS_NUM_OF_BUCKETS - 1) {
+		nanos >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+/**
+ * Sums the values of all of the threads into the given place-holder.
+ */
+static void sumAllThreads(SPMetricsThread *sum) {
+	SPMetricsThread *thread;
+	memset(sum, 0, sizeof(*sum));
+	pthread_mutex_lock(&threadsMutex);
+	addThreadValues(sum, &exitedThreads);
+	for (thread = liveThreads; thread != NULL; thread = thread->next) {
+		addThreadValues(sum, thread);
+	}
+	pthread_mutex_unlock(&threadsMutex);
+}
+
+/** The upper bound of a bucket, in seconds. */
+static double bucketBoundSeconds(int bucket) {
+	return (double) (1ULL << (bucket + 1)) / 1e9;
+}
+
+static bool dumpJSON(FILE *stream, const SPMetricsThread *sum) {
+	int i, j;
+	unsigned long long cumulative, queries = sum->counters[SP_METRICS_QUERIES];
+	const SPMetricsHistogram *histogram;
+	bool success = fprintf(stream, "{\"timers\": {") >= 0;
+	for (i = 0; i < SP_METRICS_NUM_OF_TIMERS && success; i++) {
+		histogram = &sum->timers[i];
+		success = fprintf(stream, "%s\"%s\": {\"count\": %llu, \"sum_seconds\": %.9f, \"mean_seconds\": %.9f, "
+				"\"buckets\": [", i == 0 ? "" : ", ", TIMER_NAMES[i], histogram->count, histogram->sumNanos / 1e9,
+				histogram->count == 0 ? 0 : histogram->sumNanos / 1e9 / histogram->count) >= 0;
+		cumulative = 0;
+		for (j = 0; histogram->count > 0 && j <= (int) histogram->maxBucket && success; j++) {
+			cumulative += histogram->buckets[j];
+			success = fprintf(stream, "%s{\"le_seconds\": %.9f, \"count\": %llu}", j == 0 ? "" : ", ",
+					bucketBoundSeconds(j), cumulative) >= 0;
+		}
+		success = success && fprintf(stream, "]}") >= 0;
+	}
+	success = success && fprintf(stream, "}, \"counters\": {") >= 0;
+	for (i = 0; i < SP_METRICS_NUM_OF_COUNTERS && success; i++) {
+		success = fprintf(stream, "%s\"%s\": {\"total\": %llu, \"per_query\": %.3f}", i == 0 ? "" : ", ",
+				COUNTER_NAMES[i], sum->counters[i], queries == 0 ? 0 : (double) sum->counters[i] / queries) >= 0;
+	}
+	return success && fprintf(stream, "}}\n") >= 0;
+}
+
+static bool dumpPrometheus(FILE *stream, const SPMetricsThread *sum) {
+	int i, j;
+	unsigned long long cumulative;
+	const SPMetricsHistogram *histogram;
+	bool success = true;
+	for (i = 0; i < SP_METRICS_NUM_OF_TIMERS && success; i++) {
+		histogram = &sum->timers[i];
+		success = fprintf(stream, "# TYPE sp_%s_seconds histogram\n", TIMER_NAMES[i]) >= 0;
+		cumulative = 0;
+		for (j = 0; histogram->count > 0 && j <= (int) histogram->maxBucket && success; j++) {
+			cumulative += histogram->buckets[j];
+			success = fprintf(stream, "sp_%s_seconds_bucket{le=\"%.9f\"} %llu\n", TIMER_NAMES[i],
+					bucketBoundSeconds(j), cumulative) >= 0;
+		}
+		success = success
+				&& fprintf(stream, "sp_%s_seconds_bucket{le=\"+Inf\"} %llu\n", TIMER_NAMES[i], histogram->count) >= 0
+				&& fprintf(stream, "sp_%s_seconds_sum %.9f\n", TIMER_NAMES[i], histogram->sumNanos / 1e9) >= 0
+				&& fprintf(stream, "sp_%s_seconds_count %llu\n", TIMER_NAMES[i], histogram->count) >= 0;
+	}
+	for (i = 0; i < SP_METRICS_NUM_OF_COUNTERS && success; i++) {
+		success = fprintf(stream, "# TYPE sp_%s_total counter\nsp_%s_total %llu\n", COUNTER_NAMES[i],
+				COUNTER_NAMES[i], sum->counters[i]) >= 0;
+	}
+	return success;
+}
+
+/*** Public Methods ***/
+
+void spMetricsSetEnabled(bool enabled) {
+	__atomic_store_n(&metricsEnabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+bool spMetricsIsEnabled() {
+	return __atomic_load_n(&metricsEnabled, __ATOMIC_RELAXED) != 0;
+}
+
+long long spMetricsTimerStart() {
+	if (!spMetricsIsEnabled()) {
+		return -1;
+	}
+	return monotonicNanos();
+}
+
+void spMetricsTimerStop(long long start, SP_METRICS_TIMER timer) {
+	SPMetricsThread *thread;
+	SPMetricsHistogram *histogram;
+	unsigned long long nanos;
+	int bucket;
+	if (start < 0 || (int) timer < 0 || timer >= SP_METRICS_NUM_OF_TIMERS) {
+		return;
+	}
+	nanos = (unsigned long long) (monotonicNanos() - start);
+	thread = threadValues();
+	if (thread == NULL) {
+		return;
+	}
+	histogram = &thread->timers[timer];
+	bucket = bucketOf(nanos);
+	addOwned(&histogram->count, 1);
+	addOwned(&histogram->sumNanos, nanos);
+	addOwned(&histogram->buckets[bucket], 1);
+	if ((unsigned long long) bucket > loadValue(&histogram->maxBucket)) {
+		__atomic_store_n(&histogram->maxBucket, (unsigned long long) bucket, __ATOMIC_RELAXED);
+	}
+}
+
+void spMetricsCount(SP_METRICS_COUNTER counter, unsigned long long value) {
+	SPMetricsThread *thread;
+	if (!spMetricsIsEnabled() || (int) counter < 0 || counter >= SP_METRICS_NUM_OF_COUNTERS) {
+		return;
+	}
+	thread = threadValues();
+	if (thread != NULL) {
+		addOwned(&thread->counters[counter], value);
+	}
+}
+
+unsigned long long spMetricsGetCounter(SP_METRICS_COUNTER counter) {
+	SPMetricsThread sum;
+	if ((int) counter < 0 || counter >= SP_METRICS_NUM_OF_COUNTERS) {
+		return 0;
+	}
+	sumAllThreads(&sum);
+	return sum.counters[counter];
+}
+
+unsigned long long spMetricsGetTimerCount(SP_METRICS_TIMER timer) {
+	SPMetricsThread sum;
+	if ((int) timer < 0 || timer >= SP_METRICS_NUM_OF_TIMERS) {
+		return 0;
+	}
+	sumAllThreads(&sum);
+	return sum.timers[timer].count;
+}
+
+void spMetricsReset() {
+	SPMetricsThread *thread;
+	unsigned long long *values;
+	size_t i, numOfValues = offsetof(SPMetricsThread, next) / sizeof(unsigned long long);
+	pthread_mutex_lock(&threadsMutex);
+	memset(&exitedThreads, 0, sizeof(exitedThreads));
+	for (thread = liveThreads; thread != NULL; thread = thread->next) {
+		// The values are all unsigned long long, laid out before the list links
+		values = (unsigned long long *) thread;
+		for (i = 0; i < numOfValues; i++) {
+			__atomic_store_n(&values[i], 0ULL, __ATOMIC_RELAXED);
+		}
+	}
+	pthread_mutex_unlock(&threadsMutex);
+}
+
+SP_METRICS_MSG spMetricsDump(FILE *stream, SP_METRICS_FORMAT format) {
+	SPMetricsThread sum;
+	bool success;
+	if (stream == NULL) {
+		return SP_METRICS_INVALID_ARGUMENT;
+	}
+	sumAllThreads(&sum);
+	if (format == SP_METRICS_FORMAT_PROMETHEUS) {
+		success = dumpPrometheus(stream, &sum);
+	} else {
+		success = dumpJSON(stream, &sum);
+	}
+	if (!success || fflush(stream) != 0) {
+		return SP_METRICS_WRITE_FAIL;
+	}
+	return SP_METRICS_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*
+ * sp_metrics.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SP_METRICS_H_
+#define SP_METRICS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**
+ * Hot-path timing instrumentation and counters.
+ *
+ * Timers measure the duration of a stage (image decoding, SIFT, PCA projection, tree traversal, voting, sorting
+ * and the whole search) into a histogram with power-of-two nanosecond buckets. Counters count events, such as
+ * the kd-tree nodes visited by the nearest neighbors search.
+ *
+ * Every thread records into its own histograms and counters, so recording never takes a lock. A dump sums the
+ * values of all of the threads (threads which exited are kept in the sums).
+ *
+ * The instrumentation is disabled until spMetricsSetEnabled is called - a disabled timer or counter costs a
+ * single flag check. Instrumented code should use the SP_METRICS_* macros, which compile to nothing when
+ * SP_METRICS_COMPILED is 0 (e.g. -DSP_METRICS_COMPILED=0).
+ *
+ * The following functions are available:
+ *
+ * 		spMetricsSetEnabled			- Enables or disables the recording.
+ * 		spMetricsIsEnabled			- Checks if the recording is enabled.
+ * 		spMetricsTimerStart			- Starts a timer measurement.
+ * 		spMetricsTimerStop			- Records the duration of a timer measurement.
+ * 		spMetricsCount				- Adds to a counter.
+ * 		spMetricsGetCounter			- Returns the total of a counter.
+ * 		spMetricsGetTimerCount		- Returns the number of measurements of a timer.
+ * 		spMetricsReset				- Zeroes all of the timers and counters.
+ * 		spMetricsDump				- Writes all of the timers and counters as JSON or Prometheus text.
+ */
+
+/** Set to 0 in order to compile the SP_METRICS_* macros out. */
+#ifndef SP_METRICS_COMPILED
+#define SP_METRICS_COMPILED 1
+#endif
+
+/** The number of histogram buckets, bucket i counts durations in [2^i, 2^(i+1)) nanoseconds. */
+#define SP_METRICS_NUM_OF_BUCKETS 40
+
+/** The timed stages. */
+typedef enum sp_metrics_timer_t {
+	SP_METRICS_IMAGE_DECODE,
+	SP_METRICS_SIFT,
+	SP_METRICS_PCA_PROJECTION,
+	SP_METRICS_TREE_TRAVERSAL,
+	SP_METRICS_VOTING,
+	SP_METRICS_SORTING,
+	SP_METRICS_SEARCH,
+	SP_METRICS_NUM_OF_TIMERS
+} SP_METRICS_TIMER;
+
+/** The counters. */
+typedef enum sp_metrics_counter_t {
+	SP_METRICS_QUERIES,
+	SP_METRICS_NODES_VISITED,
+	SP_METRICS_LEAVES_SCANNED,
+	SP_METRICS_DISTANCE_COMPUTATIONS,
+	SP_METRICS_NUM_OF_COUNTERS
+} SP_METRICS_COUNTER;
+
+/** The formats of a metrics dump. */
+typedef enum sp_metrics_format_t {
+	SP_METRICS_FORMAT_JSON,
+	SP_METRICS_FORMAT_PROMETHEUS
+} SP_METRICS_FORMAT;
+
+/** Enumeration to inform result of metrics method calls. */
+typedef enum sp_metrics_msg_t {
+	SP_METRICS_INVALID_ARGUMENT,
+	SP_METRICS_WRITE_FAIL,
+	SP_METRICS_SUCCESS
+} SP_METRICS_MSG;
+
+/**
+ * Starts measuring the given stage into a new variable named timer, e.g.
+ * 		SP_METRICS_TIMER_START(decodeTimer);
+ * 		img = imread(...);
+ * 		SP_METRICS_TIMER_STOP(decodeTimer, SP_METRICS_IMAGE_DECODE);
+ */
+#if SP_METRICS_COMPILED
+#define SP_METRICS_TIMER_START(timer) long long timer = spMetricsTimerStart()
+#define SP_METRICS_TIMER_STOP(timer, metric) spMetricsTimerStop((timer), (metric))
+#define SP_METRICS_COUNT(counter, value) spMetricsCount((counter), (value))
+#else
+#define SP_METRICS_TIMER_START(timer) ((void) 0)
+#define SP_METRICS_TIMER_STOP(timer, metric) ((void) 0)
+#define SP_METRICS_COUNT(counter, value) ((void) 0)
+#endif
+
+/**
+ * Enables or disables the recording of all of the timers and counters. The recorded values are kept.
+ *
+ * @param enabled true in order to record, false otherwise.
+ */
+void spMetricsSetEnabled(bool enabled);
+
+/**
+ * Checks if the recording is enabled.
+ *
+ * @return
+ * 	true if the timers and counters are recorded, false otherwise.
+ */
+bool spMetricsIsEnabled();
+
+/**
+ * Starts a timer measurement.
+ *
+ * @return
+ * 	The start time stamp, in nanoseconds of a monotonic clock, or -1 if the recording is disabled.
+ */
+long long spMetricsTimerStart();
+
+/**
+ * Records the time passed since the given start time stamp into the given timer's histogram.
+ * Nothing is recorded if the measurement was started while the recording was disabled.
+ *
+ * @param start The start time stamp, as returned by spMetricsTimerStart.
+ * @param timer The timer.
+ */
+void spMetricsTimerStop(long long start, SP_METRICS_TIMER timer);
+
+/**
+ * Adds the given value to the given counter, if the recording is enabled.
+ *
+ * @param counter The counter.
+ * @param value The value to add.
+ */
+void spMetricsCount(SP_METRICS_COUNTER counter, unsigned long long value);
+
+/**
+ * Returns the total of the given counter, over all of the threads.
+ *
+ * @param counter The counter.
+ *
+ * @return
+ * 	The total of the counter, 0 for an invalid counter.
+ */
+unsigned long long spMetricsGetCounter(SP_METRICS_COUNTER counter);
+
+/**
+ * Returns the number of measurements of the given timer, over all of the threads.
+ *
+ * @param timer The timer.
+ *
+ * @return
+ * 	The number of measurements, 0 for an invalid timer.
+ */
+unsigned long long spMetricsGetTimerCount(SP_METRICS_TIMER timer);
+
+/**
+ * Zeroes all of the timers and counters. Values recorded concurrently with the reset may be partially kept.
+ */
+void spMetricsReset();
+
+/**
+ * Writes all of the timers and counters, summed over all of the threads, to the given stream.
+ *
+ * The JSON format is a single object:
+ * 		{"timers": {"<name>": {"count": N, "sum_seconds": S, "mean_seconds": M,
+ * 				"buckets": [{"le_seconds": B, "count": N}, ...]}, ...},
+ * 		 "counters": {"<name>": {"total": N, "per_query": A}, ...}}
+ * where the buckets are cumulative and only buckets up to the longest measurement are listed.
+ *
+ * The Prometheus format is the text exposition format - every timer is a histogram named
+ * sp_<name>_seconds and every counter is named sp_<name>_total.
+ *
+ * @param stream The stream to write to.
+ * @param format The format of the dump.
+ *
+ * @return
+ * 	SP_METRICS_INVALID_ARGUMENT	- If stream is NULL.
+ * 	SP_METRICS_WRITE_FAIL		- If writing to the stream failed.
+ * 	SP_METRICS_SUCCESS			- Otherwise.
+ */
+SP_METRICS_MSG spMetricsDump(FILE *stream, SP_METRICS_FORMAT format);
+
+#endif /* SP_METRICS_H_ */
@@ -0,0 +1,204 @@
+/*
+ * sp_pca_file.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sp_pca_file.h"
+#include "sp_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*** Constants ***/
+
+#define PCA_FILE_MAGIC "SPPC"
+#define PCA_FILE_VERSION 2
+#define TEMPORARY_FILE_SUFFIX ".tmp"
+
+/*** Type declarations ***/
+
+/** The file header - its size is a multiple of 8, so the arrays after it are aligned. */
+typedef struct sp_pca_file_header_t {
+	char magic[4];
+	uint32_t version;
+	uint32_t dimension;
+	uint32_t numOfComponents;
+	uint64_t checksum;
+	uint64_t sourceHash;
+} SPPCAFileHeader;
+
+struct sp_pca_file_t {
+	void *mapping;
+	size_t mappingSize;
+	const SPPCAFileHeader *header;
+	const float *mean;
+	const float *eigenvectors;
+	const float *eigenvalues;
+};
+
+/*** Private Methods ***/
+
+/**
+ * Returns the number of floats following a header with the given dimensions.
+ */
+static size_t arraysLength(size_t dimension, size_t numOfComponents) {
+	return dimension + numOfComponents * dimension + numOfComponents;
+}
+
+/*** Public Methods ***/
+
+SP_PCA_FILE_MSG spPCAFileWrite(const char *filePath, int dimension, int numOfComponents, const float *mean,
+		const float *eigenvectors, const float *eigenvalues, unsigned long long sourceHash) {
+	SPPCAFileHeader header;
+	char *temporaryPath;
+	FILE *file;
+	bool success;
+	size_t eigenvectorsLength;
+	if (filePath == NULL || mean == NULL || eigenvectors == NULL || eigenvalues == NULL || dimension <= 0
+			|| numOfComponents <= 0) {
+		return SP_PCA_FILE_INVALID_ARGUMENT;
+	}
+	eigenvectorsLength = (size_t) numOfComponents * dimension;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PCA_FILE_MAGIC, sizeof(header.magic));
+	header.version = PCA_FILE_VERSION;
+	header.dimension = (uint32_t) dimension;
+	header.numOfComponents = (uint32_t) numOfComponents;
+	header.checksum = spUtilFNV1aHash(mean, dimension * sizeof(float), SP_UTIL_FNV1A_INITIAL_HASH);
+	header.checksum = spUtilFNV1aHash(eigenvectors, eigenvectorsLength * sizeof(float), header.checksum);
+	header.checksum = spUtilFNV1aHash(eigenvalues, numOfComponents * sizeof(float), header.checksum);
+	header.sourceHash = sourceHash;
+
+	temporaryPath = (char *) malloc(strlen(filePath) + strlen(TEMPORARY_FILE_SUFFIX) + 1);
+	if (temporaryPath == NULL) {
+		return SP_PCA_FILE_ALLOC_FAIL;
+	}
+	sprintf(temporaryPath, "%s%s", filePath, TEMPORARY_FILE_SUFFIX);
+	file = fopen(temporaryPath, "wb");
+	if (file == NULL) {
+		free(temporaryPath);
+		return SP_PCA_FILE_WRITE_ERROR;
+	}
+	success = fwrite(&header, sizeof(header), 1, file) == 1
+			&& fwrite(mean, sizeof(float), dimension, file) == (size_t) dimension
+			&& fwrite(eigenvectors, sizeof(float), eigenvectorsLength, file) == eigenvectorsLength
+			&& fwrite(eigenvalues, sizeof(float), numOfComponents, file) == (size_t) numOfComponents;
+	success = (fclose(file) == 0) && success;
+	success = success && rename(temporaryPath, filePath) == 0;
+	if (!success) {
+		remove(temporaryPath);
+	}
+	free(temporaryPath);
+	return success ? SP_PCA_FILE_SUCCESS : SP_PCA_FILE_WRITE_ERROR;
+}
+
+SPPCAFile spPCAFileLoad(const char *filePath, unsigned long long sourceHash, SP_PCA_FILE_MSG *msg) {
+	struct stat fileStat;
+	const SPPCAFileHeader *header;
+	SPPCAFile pcaFile;
+	size_t length;
+	uint64_t checksum;
+	int fd;
+	if (msg == NULL) {
+		return NULL;
+	}
+	if (filePath == NULL) {
+		*msg = SP_PCA_FILE_INVALID_ARGUMENT;
+		return NULL;
+	}
+	fd = open(filePath, O_RDONLY);
+	if (fd < 0) {
+		*msg = errno == ENOENT ? SP_PCA_FILE_MISSING : SP_PCA_FILE_READ_ERROR;
+		return NULL;
+	}
+	if (fstat(fd, &fileStat) != 0) {
+		close(fd);
+		*msg = SP_PCA_FILE_READ_ERROR;
+		return NULL;
+	}
+	if ((size_t) fileStat.st_size < sizeof(SPPCAFileHeader)) {
+		close(fd);
+		*msg = SP_PCA_FILE_INVALID_FORMAT;
+		return NULL;
+	}
+	pcaFile = (SPPCAFile) malloc(sizeof(*pcaFile));
+	if (pcaFile == NULL) {
+		close(fd);
+		*msg = SP_PCA_FILE_ALLOC_FAIL;
+		return NULL;
+	}
+	pcaFile->mappingSize = (size_t) fileStat.st_size;
+	pcaFile->mapping = mmap(NULL, pcaFile->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+	if (pcaFile->mapping == MAP_FAILED) {
+		free(pcaFile);
+		*msg = SP_PCA_FILE_READ_ERROR;
+		return NULL;
+	}
+	header = (const SPPCAFileHeader *) pcaFile->mapping;
+	length = arraysLength(header->dimension, header->numOfComponents);
+	if (memcmp(header->magic, PCA_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != PCA_FILE_VERSION
+			|| header->dimension == 0 || header->numOfComponents == 0
+			|| pcaFile->mappingSize != sizeof(SPPCAFileHeader) + length * sizeof(float)) {
+		spPCAFileDestroy(pcaFile);
+		*msg = SP_PCA_FILE_INVALID_FORMAT;
+		return NULL;
+	}
+	pcaFile->header = header;
+	pcaFile->mean = (const float *) (header + 1);
+	pcaFile->eigenvectors = pcaFile->mean + header->dimension;
+	pcaFile->eigenvalues = pcaFile->eigenvectors + (size_t) header->numOfComponents * header->dimension;
+	checksum = spUtilFNV1aHash(pcaFile->mean, length * sizeof(float), SP_UTIL_FNV1A_INITIAL_HASH);
+	if (checksum != header->checksum) {
+		spPCAFileDestroy(pcaFile);
+		*msg = SP_PCA_FILE_CHECKSUM_MISMATCH;
+		return NULL;
+	}
+	if (header->sourceHash != sourceHash) {
+		spPCAFileDestroy(pcaFile);
+		*msg = SP_PCA_FILE_SOURCE_MISMATCH;
+		return NULL;
+	}
+	*msg = SP_PCA_FILE_SUCCESS;
+	return pcaFile;
+}
+
+int spPCAFileGetDimension(SPPCAFile pcaFile) {
+	return pcaFile == NULL ? -1 : (int) pcaFile->header->dimension;
+}
+
+int spPCAFileGetNumOfComponents(SPPCAFile pcaFile) {
+	return pcaFile == NULL ? -1 : (int) pcaFile->header->numOfComponents;
+}
+
+const float *spPCAFileGetMean(SPPCAFile pcaFile) {
+	return pcaFile == NULL ? NULL : pcaFile->mean;
+}
+
+const float *spPCAFileGetEigenvectors(SPPCAFile pcaFile) {
+	return pcaFile == NULL ? NULL : pcaFile->eigenvectors;
+}
+
+const float *spPCAFileGetEigenvalues(SPPCAFile pcaFile) {
+	return pcaFile == NULL ? NULL : pcaFile->eigenvalues;
+}
+
+void spPCAFileDestroy(SPPCAFile pcaFile) {
+	if (pcaFile == NULL) {
+		return;
+	}
+	munmap(pcaFile->mapping, pcaFile->mappingSize);
+	free(pcaFile);
+}
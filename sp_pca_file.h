@@ -0,0 +1,142 @@
+/*
+ * sp_pca_file.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SP_PCA_FILE_H_
+#define SP_PCA_FILE_H_
+
+/**
+ * A compact binary file of a PCA basis, which is loaded by memory mapping instead of parsing.
+ *
+ * The file is a fixed header followed by the raw float arrays, in the machine's byte order:
+ * 		magic "SPPC", version, dimension, number of components, checksum,
+ * 		source hash															- the header
+ * 		mean																- dimension floats
+ * 		eigenvectors														- (components x dimension) floats, row major
+ * 		eigenvalues															- components floats
+ * The checksum is the 64-bit FNV-1a hash of the arrays, so a truncated or corrupted file is never used.
+ * The source hash is given by the writer - the hash of the file the basis was read from (e.g. the YAML PCA file),
+ * so a binary file which was not rebuilt after its source was replaced is never used.
+ *
+ * The following functions are available:
+ *
+ * 		spPCAFileWrite				- Writes a PCA basis to a file.
+ * 		spPCAFileLoad				- Maps and validates a PCA basis file.
+ * 		spPCAFileGetDimension		- Returns the dimension of the mapped basis.
+ * 		spPCAFileGetNumOfComponents	- Returns the number of components of the mapped basis.
+ * 		spPCAFileGetMean			- Returns the mapped mean.
+ * 		spPCAFileGetEigenvectors	- Returns the mapped eigenvectors.
+ * 		spPCAFileGetEigenvalues		- Returns the mapped eigenvalues.
+ * 		spPCAFileDestroy			- Unmaps a PCA basis file.
+ */
+
+/** Enumeration to inform result of PCA file method calls. */
+typedef enum sp_pca_file_msg_t {
+	SP_PCA_FILE_INVALID_ARGUMENT,
+	SP_PCA_FILE_MISSING,
+	SP_PCA_FILE_ALLOC_FAIL,
+	SP_PCA_FILE_WRITE_ERROR,
+	SP_PCA_FILE_READ_ERROR,
+	SP_PCA_FILE_INVALID_FORMAT,
+	SP_PCA_FILE_CHECKSUM_MISMATCH,
+	SP_PCA_FILE_SOURCE_MISMATCH,
+	SP_PCA_FILE_SUCCESS
+} SP_PCA_FILE_MSG;
+
+/** Type for defining a mapped PCA basis file. */
+typedef struct sp_pca_file_t *SPPCAFile;
+
+/**
+ * Writes the given PCA basis to the given file. The file is written to a temporary file which is renamed over the
+ * given one, so a concurrent reader never maps a partially written file.
+ *
+ * @param filePath The path of the file to write.
+ * @param dimension The dimension of the data (the mean's length).
+ * @param numOfComponents The number of principal components.
+ * @param mean The mean, dimension floats.
+ * @param eigenvectors The eigenvectors, (numOfComponents x dimension) floats in row major order.
+ * @param eigenvalues The eigenvalues, numOfComponents floats.
+ * @param sourceHash The hash of the basis' source, which spPCAFileLoad checks.
+ *
+ * @return
+ * 	SP_PCA_FILE_INVALID_ARGUMENT	- In case any pointer is NULL, or the dimension or components are non-positive.
+ * 	SP_PCA_FILE_ALLOC_FAIL			- In case of an allocation failure.
+ * 	SP_PCA_FILE_WRITE_ERROR			- In case writing the file failed.
+ * 	SP_PCA_FILE_SUCCESS				- Otherwise.
+ */
+SP_PCA_FILE_MSG spPCAFileWrite(const char *filePath, int dimension, int numOfComponents, const float *mean,
+		const float *eigenvectors, const float *eigenvalues, unsigned long long sourceHash);
+
+/**
+ * Maps the given PCA basis file to memory, and validates its header, checksum and source hash.
+ *
+ * @param filePath The path of the file to load.
+ * @param sourceHash The hash of the basis' source, as it is now.
+ * @param msg Place-holder for the SP_PCA_FILE_MSG informing the load result:
+ * 		SP_PCA_FILE_INVALID_ARGUMENT	- In case any pointer is NULL.
+ * 		SP_PCA_FILE_MISSING				- In case the file does not exist.
+ * 		SP_PCA_FILE_ALLOC_FAIL			- In case of an allocation failure.
+ * 		SP_PCA_FILE_READ_ERROR			- In case the file could not be mapped.
+ * 		SP_PCA_FILE_INVALID_FORMAT		- In case the file is not a PCA basis file of this version, or is truncated.
+ * 		SP_PCA_FILE_CHECKSUM_MISMATCH	- In case the arrays do not match the checksum.
+ * 		SP_PCA_FILE_SOURCE_MISMATCH		- In case the file was written for a source with a different hash.
+ * 		SP_PCA_FILE_SUCCESS				- In case of a successful load.
+ *
+ * @return
+ * 	NULL in case of a non-successful load, otherwise the mapped file - which must be destroyed with spPCAFileDestroy.
+ */
+SPPCAFile spPCAFileLoad(const char *filePath, unsigned long long sourceHash, SP_PCA_FILE_MSG *msg);
+
+/**
+ * @param pcaFile The mapped file.
+ *
+ * @return
+ * 	The dimension of the data, -1 if pcaFile is NULL.
+ */
+int spPCAFileGetDimension(SPPCAFile pcaFile);
+
+/**
+ * @param pcaFile The mapped file.
+ *
+ * @return
+ * 	The number of principal components, -1 if pcaFile is NULL.
+ */
+int spPCAFileGetNumOfComponents(SPPCAFile pcaFile);
+
+/**
+ * @param pcaFile The mapped file.
+ *
+ * @return
+ * 	The mean (dimension floats) in the mapped memory, NULL if pcaFile is NULL.
+ */
+const float *spPCAFileGetMean(SPPCAFile pcaFile);
+
+/**
+ * @param pcaFile The mapped file.
+ *
+ * @return
+ * 	The eigenvectors ((components x dimension) floats in row major order) in the mapped memory,
+ * 	NULL if pcaFile is NULL.
+ */
+const float *spPCAFileGetEigenvectors(SPPCAFile pcaFile);
+
+/**
+ * @param pcaFile The mapped file.
+ *
+ * @return
+ * 	The eigenvalues (components floats) in the mapped memory, NULL if pcaFile is NULL.
+ */
+const float *spPCAFileGetEigenvalues(SPPCAFile pcaFile);
+
+/**
+ * Unmaps the given file. The arrays returned for it must not be used afterwards.
+ * If pcaFile is NULL nothing is done.
+ *
+ * @param pcaFile The mapped file.
+ */
+void spPCAFileDestroy(SPPCAFile pcaFile);
+
+#endif /* SP_PCA_FILE_H_ */
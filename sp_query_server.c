@@ -0,0 +1,825 @@
+/*
+ * sp_query_server.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sp_query_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include "SPThreadPool.h"
+#include "SPHitsAccumulator.h"
+#include "SPLogger.h"
+#include "sp_similar_images_search_api.h"
+#include "sp_metrics.h"
+
+/*** Constants ***/
+
+/** The maximal number of accepted connections which wait to be accepted by the server. */
+#define PENDING_CONNECTIONS 64
+
+/** The maximal number of complete requests which are served or wait for a free worker. */
+#define PENDING_REQUESTS 64
+
+/** The initial capacity of the open connections array. */
+#define INITIAL_CONNECTIONS_CAPACITY 16
+
+/** The fixed entries of the polled file descriptors - the listening socket and the wake up pipe. */
+#define LISTEN_POLL_INDEX 0
+#define WAKE_POLL_INDEX 1
+#define CONNECTIONS_POLL_INDEX 2
+
+/** Sizes of the protocol fields. */
+#define LENGTH_FIELD_SIZE 4
+#define STATUS_FIELD_SIZE 1
+#define RESULT_SIZE 12
+#define FEATURES_HEADER_SIZE 9
+
+#define SERVER_LISTENING_MSG "Query server is listening on:"
+#define MALFORMED_REQUEST_MSG "Closing a query server connection due to a malformed request"
+#define SOCKET_PATH_IN_USE_MSG "The query server socket path is in use by a file or a running server:"
+
+/*** Type declarations ***/
+
+/** The states of a client connection. */
+typedef enum connection_state_t {
+	CONNECTION_READING,	// Polled by the server, until a complete request is read
+	CONNECTION_READY,	// Holds a complete request, which waits for room in the jobs queue
+	CONNECTION_SERVED	// Its request was given to the workers
+} CONNECTION_STATE;
+
+/** The results of the requests given to the workers. */
+typedef enum request_result_t {
+	REQUEST_PENDING,	// The request is not answered yet
+	REQUEST_ANSWERED,	// The request was answered, and the connection keeps serving
+	REQUEST_FAILED		// The request was malformed or could not be answered, so the connection is closed
+} REQUEST_RESULT;
+
+/** Structure containing the server data. */
+struct sp_query_server_t {
+	SPConfig config;
+	SPSearchIndex searchIndex;
+	FeatureExractionFunction extractionFunc;
+	char *socketPath;
+	int listenFd;
+	int wakePipe[2];
+	SPThreadPool pool;
+	SPHitsAccumulator *accumulators;
+	int numOfWorkers;
+	int stopRequested;
+	// Guards the results of the requests given to the workers
+	pthread_mutex_t connectionsLock;
+	bool connectionsLockInitialized;
+};
+
+/**
+ * Structure containing a client connection, and the request which is read from it. Only the server's thread
+ * touches a connection, except for the worker which answers its request while it is CONNECTION_SERVED.
+ */
+typedef struct connection_t {
+	SPQueryServer server;
+	int fd;
+	CONNECTION_STATE state;
+	REQUEST_RESULT result;
+	unsigned char lengthField[LENGTH_FIELD_SIZE];
+	size_t lengthBytesRead;
+	uint32_t length;
+	unsigned char *payload;
+	size_t payloadBytesRead;
+} Connection;
+
+/** Structure containing the open connections, and the file descriptors polled by the server. */
+typedef struct connections_t {
+	Connection **connections;
+	int numOfConnections;
+	int capacity;
+	struct pollfd *pollFds;
+	// The connection of every polled file descriptor, from CONNECTIONS_POLL_INDEX on
+	Connection **polled;
+	int numOfPolled;
+	int requestsInFlight;
+} Connections;
+
+/*** Private Methods ***/
+
+/**
+ * Encodes the given 32 bits integer in network byte order.
+ */
+void writeUInt32(unsigned char *buffer, uint32_t value) {
+	value = htonl(value);
+	memcpy(buffer, &value, sizeof(value));
+}
+
+/**
+ * Decodes a 32 bits integer which is encoded in network byte order.
+ */
+uint32_t readUInt32(const unsigned char *buffer) {
+	uint32_t value;
+	memcpy(&value, buffer, sizeof(value));
+	return ntohl(value);
+}
+
+/**
+ * Encodes the given double as its IEEE-754 representation, in network byte order.
+ */
+void writeDouble(unsigned char *buffer, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeUInt32(buffer, (uint32_t) (bits >> 32));
+	writeUInt32(buffer + 4, (uint32_t) bits);
+}
+
+/**
+ * Decodes a double which is encoded as its IEEE-754 representation, in network byte order.
+ */
+double readDouble(const unsigned char *buffer) {
+	double value;
+	uint64_t bits = ((uint64_t) readUInt32(buffer) << 32) | readUInt32(buffer + 4);
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/**
+ * Writes exactly the given amount of bytes to the connection. A client which closed its connection does not
+ * raise SIGPIPE.
+ *
+ * @return
+ * 	false if writing failed, true otherwise.
+ */
+bool writeFully(int fd, const unsigned char *buffer, size_t length) {
+	ssize_t bytesWritten;
+	while (length > 0) {
+		bytesWritten = send(fd, buffer, length, MSG_NOSIGNAL);
+		if (bytesWritten < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesWritten <= 0) {
+			return false;
+		}
+		buffer += bytesWritten;
+		length -= bytesWritten;
+	}
+	return true;
+}
+
+/**
+ * Sends a response with the given status and results. The scores of the results are taken from the accumulator.
+ *
+ * @return
+ * 	false if the response could not be sent, true otherwise.
+ */
+bool sendResponse(int fd, SP_QUERY_RESPONSE_STATUS status, const int *results, int resultsCount,
+		SPHitsAccumulator accumulator) {
+	int i;
+	bool sent;
+	size_t payloadLength = STATUS_FIELD_SIZE + LENGTH_FIELD_SIZE + (size_t) resultsCount * RESULT_SIZE;
+	unsigned char *response = (unsigned char *) malloc(LENGTH_FIELD_SIZE + payloadLength), *current;
+	if (response == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		return false;
+	}
+	writeUInt32(response, (uint32_t) payloadLength);
+	response[LENGTH_FIELD_SIZE] = (unsigned char) status;
+	writeUInt32(response + LENGTH_FIELD_SIZE + STATUS_FIELD_SIZE, (uint32_t) resultsCount);
+	current = response + LENGTH_FIELD_SIZE + STATUS_FIELD_SIZE + LENGTH_FIELD_SIZE;
+	for (i = 0; i < resultsCount; i++, current += RESULT_SIZE) {
+		writeUInt32(current, (uint32_t) results[i]);
+		writeDouble(current + LENGTH_FIELD_SIZE, spHitsAccumulatorGetHits(accumulator, results[i]));
+	}
+	sent = writeFully(fd, response, LENGTH_FIELD_SIZE + payloadLength);
+	free(response);
+	return sent;
+}
+
+/**
+ * Sends a metrics response, with the current timers and counters in the Prometheus text format.
+ *
+ * @return
+ * 	false if the response could not be sent, true otherwise.
+ */
+bool sendMetricsResponse(int fd) {
+	char *text = NULL;
+	size_t textLength = 0;
+	bool sent;
+	unsigned char header[LENGTH_FIELD_SIZE + STATUS_FIELD_SIZE + LENGTH_FIELD_SIZE];
+	FILE *stream = open_memstream(&text, &textLength);
+	SP_METRICS_MSG dumpMsg = SP_METRICS_WRITE_FAIL;
+	if (stream != NULL) {
+		dumpMsg = spMetricsDump(stream, SP_METRICS_FORMAT_PROMETHEUS);
+		fclose(stream);
+	}
+	if (dumpMsg != SP_METRICS_SUCCESS) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		free(text);
+		return sendResponse(fd, SP_QUERY_RESPONSE_INTERNAL_ERROR, NULL, 0, NULL);
+	}
+	writeUInt32(header, (uint32_t) (STATUS_FIELD_SIZE + LENGTH_FIELD_SIZE + textLength));
+	header[LENGTH_FIELD_SIZE] = (unsigned char) SP_QUERY_RESPONSE_SUCCESS;
+	writeUInt32(header + LENGTH_FIELD_SIZE + STATUS_FIELD_SIZE, (uint32_t) textLength);
+	sent = writeFully(fd, header, sizeof(header)) && writeFully(fd, (const unsigned char *) text, textLength);
+	free(text);
+	return sent;
+}
+
+/**
+ * Decodes the descriptors of a features request into a single contiguous array.
+ *
+ * @param payload The request payload, after the request type.
+ * @param length The length of the payload, after the request type.
+ * @param numOfDescriptors Place-holder for the number of decoded descriptors.
+ * @param dimension Place-holder for the dimension of the descriptors.
+ *
+ * @return
+ * 	NULL if the payload is malformed or an allocation failed, the decoded descriptors otherwise.
+ */
+double *decodeDescriptors(const unsigned char *payload, uint32_t length, int *numOfDescriptors, int *dimension) {
+	uint32_t i, count, descriptorDimension;
+	uint64_t numOfValues;
+	double *descriptors;
+	if (length < FEATURES_HEADER_SIZE - 1) {
+		return NULL;
+	}
+	count = readUInt32(payload);
+	descriptorDimension = readUInt32(payload + LENGTH_FIELD_SIZE);
+	payload += FEATURES_HEADER_SIZE - 1;
+	numOfValues = (uint64_t) count * descriptorDimension;
+	if (count == 0 || descriptorDimension == 0
+			|| (uint64_t) length - (FEATURES_HEADER_SIZE - 1) != numOfValues * sizeof(double)) {
+		return NULL;
+	}
+	descriptors = (double *) malloc(numOfValues * sizeof(double));
+	if (descriptors == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < numOfValues; i++, payload += sizeof(double)) {
+		descriptors[i] = readDouble(payload);
+	}
+	*numOfDescriptors = (int) count;
+	*dimension = (int) descriptorDimension;
+	return descriptors;
+}
+
+/**
+ * Maps the search API result to the response status.
+ */
+SP_QUERY_RESPONSE_STATUS responseStatus(SP_SIMILAR_IMAGES_SEARCH_API_MSG msg) {
+	switch (msg) {
+	case SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS:
+		return SP_QUERY_RESPONSE_SUCCESS;
+	case SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT:
+		return SP_QUERY_RESPONSE_BAD_REQUEST;
+	case SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR:
+		return SP_QUERY_RESPONSE_EXTRACTION_ERROR;
+	default:
+		return SP_QUERY_RESPONSE_INTERNAL_ERROR;
+	}
+}
+
+/**
+ * Answers a single request.
+ *
+ * @param server The server.
+ * @param workerIndex The index of the serving worker.
+ * @param fd The client connection.
+ * @param payload The request payload.
+ * @param length The length of the payload.
+ *
+ * @return
+ * 	false if the request was malformed or the response could not be sent, true otherwise.
+ */
+bool handleRequest(SPQueryServer server, int workerIndex, int fd, const unsigned char *payload, uint32_t length) {
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG searchMsg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
+	SPHitsAccumulator accumulator = server->accumulators[workerIndex];
+	int resultsCount = 0, numOfDescriptors = 0, dimension = 0, *results = NULL;
+	char *queryPath;
+	double *descriptors;
+	bool sent;
+	if (length < 1) {
+		return false;
+	}
+	switch (payload[0]) {
+	case SP_QUERY_REQUEST_IMAGE_PATH:
+		if (length < 2) {
+			return false;
+		}
+		queryPath = (char *) malloc(length);
+		if (queryPath != NULL) {
+			memcpy(queryPath, payload + 1, length - 1);
+			queryPath[length - 1] = '\0';
+			results = spFindSimilarImagesIndicesWithAccumulator(server->config, queryPath, server->searchIndex,
+					accumulator, &resultsCount, server->extractionFunc, &searchMsg);
+			free(queryPath);
+		}
+		break;
+	case SP_QUERY_REQUEST_FEATURES:
+		descriptors = decodeDescriptors(payload + 1, length - 1, &numOfDescriptors, &dimension);
+		if (descriptors == NULL) {
+			return sendResponse(fd, SP_QUERY_RESPONSE_BAD_REQUEST, NULL, 0, accumulator);
+		}
+		// A dimension other than the PCA dimension is answered as a bad request
+		results = spFindSimilarImagesIndicesByDescriptors(server->config, descriptors, numOfDescriptors, dimension,
+				server->searchIndex, accumulator, &resultsCount, &searchMsg);
+		free(descriptors);
+		break;
+	case SP_QUERY_REQUEST_METRICS:
+		return sendMetricsResponse(fd);
+	default:
+		return false;
+	}
+	if (results == NULL) {
+		return sendResponse(fd, responseStatus(searchMsg), NULL, 0, accumulator);
+	}
+	sent = sendResponse(fd, SP_QUERY_RESPONSE_SUCCESS, results, resultsCount, accumulator);
+	free(results);
+	return sent;
+}
+
+/**
+ * Wakes the server's thread up from polling. Safe to call from a signal handler.
+ */
+void wakeServer(SPQueryServer server) {
+	int savedErrno = errno;
+	ssize_t written;
+	// A full pipe already wakes the server up
+	do {
+		written = write(server->wakePipe[1], "", 1);
+	} while (written < 0 && errno == EINTR);
+	errno = savedErrno;
+}
+
+/**
+ * Returns whether the server was asked to stop.
+ */
+bool isStopRequested(SPQueryServer server) {
+	return __atomic_load_n(&server->stopRequested, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * The job answering a single request of a client connection.
+ *
+ * @param arg The connection, which holds the request.
+ * @param workerIndex The index of the serving worker.
+ */
+void serveRequest(void *arg, int workerIndex) {
+	Connection *connection = (Connection *) arg;
+	SPQueryServer server = connection->server;
+	bool answered = handleRequest(server, workerIndex, connection->fd, connection->payload, connection->length);
+	if (!answered) {
+		SP_LOG_WARNING(MALFORMED_REQUEST_MSG);
+	}
+	free(connection->payload);
+	connection->payload = NULL;
+	pthread_mutex_lock(&server->connectionsLock);
+	connection->result = answered ? REQUEST_ANSWERED : REQUEST_FAILED;
+	pthread_mutex_unlock(&server->connectionsLock);
+	wakeServer(server);
+}
+
+/**
+ * Closes the given connection and deallocates it.
+ */
+void destroyConnection(Connection *connection) {
+	close(connection->fd);
+	free(connection->payload);
+	free(connection);
+}
+
+/**
+ * Adds a newly accepted client connection to the open connections.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool addConnection(SPQueryServer server, Connections *connections, int fd) {
+	Connection *connection = (Connection *) calloc(1, sizeof(*connection));
+	Connection **grownConnections, **grownPolled;
+	struct pollfd *grownPollFds;
+	int capacity = connections->capacity;
+	if (connection == NULL) {
+		return false;
+	}
+	if (connections->numOfConnections == capacity) {
+		capacity *= 2;
+		grownConnections = (Connection **) realloc(connections->connections, capacity * sizeof(Connection *));
+		if (grownConnections != NULL) {
+			connections->connections = grownConnections;
+		}
+		grownPolled = (Connection **) realloc(connections->polled, capacity * sizeof(Connection *));
+		if (grownPolled != NULL) {
+			connections->polled = grownPolled;
+		}
+		grownPollFds = (struct pollfd *) realloc(connections->pollFds,
+				(CONNECTIONS_POLL_INDEX + capacity) * sizeof(struct pollfd));
+		if (grownPollFds != NULL) {
+			connections->pollFds = grownPollFds;
+		}
+		if (grownConnections == NULL || grownPolled == NULL || grownPollFds == NULL) {
+			free(connection);
+			return false;
+		}
+		connections->capacity = capacity;
+	}
+	connection->server = server;
+	connection->fd = fd;
+	connection->state = CONNECTION_READING;
+	connections->connections[connections->numOfConnections++] = connection;
+	return true;
+}
+
+/**
+ * Reads the available bytes of the request of the given connection, without blocking. Once the request is
+ * complete the connection becomes CONNECTION_READY.
+ *
+ * @return
+ * 	false if the connection was closed by the client, failed, or sent a too long request, true otherwise.
+ */
+bool readAvailableBytes(Connection *connection) {
+	ssize_t bytesRead;
+	if (connection->lengthBytesRead < LENGTH_FIELD_SIZE) {
+		bytesRead = recv(connection->fd, connection->lengthField + connection->lengthBytesRead,
+				LENGTH_FIELD_SIZE - connection->lengthBytesRead, MSG_DONTWAIT);
+	} else {
+		bytesRead = recv(connection->fd, connection->payload + connection->payloadBytesRead,
+				connection->length - connection->payloadBytesRead, MSG_DONTWAIT);
+	}
+	if (bytesRead < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+		return true;
+	}
+	if (bytesRead <= 0) {
+		return false;
+	}
+	if (connection->lengthBytesRead < LENGTH_FIELD_SIZE) {
+		connection->lengthBytesRead += bytesRead;
+		if (connection->lengthBytesRead < LENGTH_FIELD_SIZE) {
+			return true;
+		}
+		connection->length = readUInt32(connection->lengthField);
+		if (connection->length > SP_QUERY_SERVER_MAX_MESSAGE_LENGTH) {
+			SP_LOG_WARNING(MALFORMED_REQUEST_MSG);
+			return false;
+		}
+		connection->payload = (unsigned char *) malloc(connection->length > 0 ? connection->length : 1);
+		if (connection->payload == NULL) {
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+			return false;
+		}
+		connection->payloadBytesRead = 0;
+	} else {
+		connection->payloadBytesRead += bytesRead;
+	}
+	if (connection->payloadBytesRead == connection->length) {
+		connection->lengthBytesRead = 0;
+		connection->state = CONNECTION_READY;
+	}
+	return true;
+}
+
+/**
+ * Updates the states of the connections whose requests were answered by the workers, closes the failed
+ * connections, and gives the complete requests to the workers while there is room in the jobs queue.
+ * Requests are given in the order of the connections, and a connection has a single request in flight at most,
+ * so the requests of every connection are answered in order.
+ */
+void dispatchRequests(SPQueryServer server, Connections *connections) {
+	Connection *connection;
+	REQUEST_RESULT result;
+	int i = 0;
+	while (i < connections->numOfConnections) {
+		connection = connections->connections[i];
+		if (connection->state != CONNECTION_SERVED) {
+			i++;
+			continue;
+		}
+		pthread_mutex_lock(&server->connectionsLock);
+		result = connection->result;
+		pthread_mutex_unlock(&server->connectionsLock);
+		if (result != REQUEST_PENDING) {
+			connections->requestsInFlight--;
+		}
+		if (result == REQUEST_FAILED) {
+			destroyConnection(connection);
+			connections->connections[i] = connections->connections[--connections->numOfConnections];
+			continue;
+		}
+		if (result == REQUEST_ANSWERED) {
+			connection->state = CONNECTION_READING;
+		}
+		i++;
+	}
+	for (i = 0; i < connections->numOfConnections && connections->requestsInFlight < PENDING_REQUESTS; i++) {
+		connection = connections->connections[i];
+		if (connection->state == CONNECTION_READY) {
+			connection->state = CONNECTION_SERVED;
+			connection->result = REQUEST_PENDING;
+			connections->requestsInFlight++;
+			// Never blocks, as the jobs queue has room for all of the requests in flight
+			spThreadPoolSubmit(server->pool, serveRequest, connection);
+		}
+	}
+}
+
+/**
+ * Fills the polled file descriptors - the listening socket, the wake up pipe, and the connections which wait
+ * for (the rest of) a request.
+ *
+ * @return
+ * 	The number of polled file descriptors.
+ */
+int preparePollFds(SPQueryServer server, Connections *connections) {
+	int i;
+	connections->pollFds[LISTEN_POLL_INDEX].fd = server->listenFd;
+	connections->pollFds[LISTEN_POLL_INDEX].events = POLLIN;
+	connections->pollFds[WAKE_POLL_INDEX].fd = server->wakePipe[0];
+	connections->pollFds[WAKE_POLL_INDEX].events = POLLIN;
+	connections->numOfPolled = 0;
+	for (i = 0; i < connections->numOfConnections; i++) {
+		if (connections->connections[i]->state == CONNECTION_READING) {
+			connections->polled[connections->numOfPolled] = connections->connections[i];
+			connections->pollFds[CONNECTIONS_POLL_INDEX + connections->numOfPolled].fd =
+					connections->connections[i]->fd;
+			connections->pollFds[CONNECTIONS_POLL_INDEX + connections->numOfPolled].events = POLLIN;
+			connections->numOfPolled++;
+		}
+	}
+	return CONNECTIONS_POLL_INDEX + connections->numOfPolled;
+}
+
+/**
+ * Reads from the polled connections which are readable, and closes the ones which were closed by their clients
+ * or failed.
+ */
+void readPolledConnections(Connections *connections) {
+	Connection *connection;
+	int i, j;
+	for (i = 0; i < connections->numOfPolled; i++) {
+		connection = connections->polled[i];
+		if (connections->pollFds[CONNECTIONS_POLL_INDEX + i].revents == 0 || readAvailableBytes(connection)) {
+			continue;
+		}
+		for (j = 0; connections->connections[j] != connection; j++);
+		connections->connections[j] = connections->connections[--connections->numOfConnections];
+		destroyConnection(connection);
+	}
+}
+
+/**
+ * Deallocates the open connections, once none of them is served.
+ */
+void destroyConnections(Connections *connections) {
+	int i;
+	for (i = 0; i < connections->numOfConnections; i++) {
+		destroyConnection(connections->connections[i]);
+	}
+	free(connections->connections);
+	free(connections->polled);
+	free(connections->pollFds);
+}
+
+/**
+ * Creates the non-blocking pipe which wakes the server's thread up.
+ *
+ * @return
+ * 	false in case of failure, true otherwise.
+ */
+bool createWakePipe(int *wakePipe) {
+	if (pipe(wakePipe) < 0) {
+		wakePipe[0] = wakePipe[1] = -1;
+		return false;
+	}
+	return fcntl(wakePipe[0], F_SETFL, O_NONBLOCK) == 0 && fcntl(wakePipe[1], F_SETFL, O_NONBLOCK) == 0;
+}
+
+/**
+ * Removes the socket file at the given address if it is stale - a socket which was left by a previous run, and which
+ * nobody listens on. Any other file, and the socket of a running server, is left in place.
+ *
+ * @return
+ * 	true if nothing is left at the address, false otherwise.
+ */
+bool removeStaleSocket(const struct sockaddr_un *address) {
+	struct stat fileStat;
+	bool stale;
+	int probe;
+	if (lstat(address->sun_path, &fileStat) != 0) {
+		return errno == ENOENT;
+	}
+	if (!S_ISSOCK(fileStat.st_mode)) {
+		return false;
+	}
+	probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe < 0) {
+		return false;
+	}
+	stale = connect(probe, (const struct sockaddr *) address, sizeof(*address)) < 0 && errno == ECONNREFUSED;
+	close(probe);
+	return stale && unlink(address->sun_path) == 0;
+}
+
+/**
+ * Creates the listening Unix domain socket of the server.
+ *
+ * @return
+ * 	-1 in case of failure, the socket file descriptor otherwise.
+ */
+int createListeningSocket(const char *socketPath) {
+	struct sockaddr_un address;
+	int fd;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	if (!removeStaleSocket(&address)) {
+		SP_LOG_ERROR("%s %s", SOCKET_PATH_IN_USE_MSG, socketPath);
+		return -1;
+	}
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(fd, PENDING_CONNECTIONS) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*** Public Methods ***/
+
+SPQueryServer spQueryServerCreate(const SPConfig config, const SPSearchIndex searchIndex,
+		FeatureExractionFunction extractionFunc, const char *socketPath, SP_QUERY_SERVER_MSG *msg) {
+	SP_CONFIG_MSG configMsg;
+	SPQueryServer server;
+	int i, numOfImages, numOfWorkers;
+	if (config == NULL || searchIndex == NULL || extractionFunc == NULL || socketPath == NULL
+			|| strlen(socketPath) >= sizeof(((struct sockaddr_un *) NULL)->sun_path)) {
+		*msg = SP_QUERY_SERVER_INVALID_ARGUMENT;
+		return NULL;
+	}
+	numOfImages = spConfigGetNumOfImages(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_QUERY_SERVER_CONFIG_ERROR;
+		return NULL;
+	}
+	numOfWorkers = spConfigGetNumOfThreads(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		*msg = SP_QUERY_SERVER_CONFIG_ERROR;
+		return NULL;
+	}
+
+	server = (SPQueryServer) malloc(sizeof(*server));
+	if (server == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_QUERY_SERVER_ALLOC_FAIL;
+		return NULL;
+	}
+	server->config = config;
+	server->searchIndex = searchIndex;
+	server->extractionFunc = extractionFunc;
+	server->numOfWorkers = numOfWorkers;
+	server->stopRequested = 0;
+	server->listenFd = -1;
+	server->wakePipe[0] = server->wakePipe[1] = -1;
+	server->pool = NULL;
+	server->connectionsLockInitialized = pthread_mutex_init(&server->connectionsLock, NULL) == 0;
+	server->socketPath = (char *) malloc(strlen(socketPath) + 1);
+	server->accumulators = (SPHitsAccumulator *) calloc(numOfWorkers, sizeof(SPHitsAccumulator));
+	if (server->socketPath == NULL || server->accumulators == NULL || !server->connectionsLockInitialized) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		spQueryServerDestroy(server);
+		*msg = SP_QUERY_SERVER_ALLOC_FAIL;
+		return NULL;
+	}
+	strcpy(server->socketPath, socketPath);
+	for (i = 0; i < numOfWorkers; i++) {
+		server->accumulators[i] = spHitsAccumulatorCreate(numOfImages);
+		if (server->accumulators[i] == NULL) {
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+			spQueryServerDestroy(server);
+			*msg = SP_QUERY_SERVER_ALLOC_FAIL;
+			return NULL;
+		}
+	}
+	server->pool = spThreadPoolCreate(numOfWorkers, PENDING_REQUESTS);
+	if (server->pool == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		spQueryServerDestroy(server);
+		*msg = SP_QUERY_SERVER_ALLOC_FAIL;
+		return NULL;
+	}
+	server->listenFd = createListeningSocket(socketPath);
+	if (server->listenFd < 0 || !createWakePipe(server->wakePipe)) {
+		spQueryServerDestroy(server);
+		*msg = SP_QUERY_SERVER_SOCKET_ERROR;
+		return NULL;
+	}
+	SP_LOG_INFO("%s %s", SERVER_LISTENING_MSG, socketPath);
+	*msg = SP_QUERY_SERVER_SUCCESS;
+	return server;
+}
+
+SP_QUERY_SERVER_MSG spQueryServerRun(SPQueryServer server) {
+	SP_QUERY_SERVER_MSG res = SP_QUERY_SERVER_SUCCESS;
+	Connections connections;
+	unsigned char wakeBytes[64];
+	int ready, clientFd, numOfPollFds;
+	if (server == NULL) {
+		return SP_QUERY_SERVER_INVALID_ARGUMENT;
+	}
+	connections.numOfConnections = 0;
+	connections.numOfPolled = 0;
+	connections.requestsInFlight = 0;
+	connections.capacity = INITIAL_CONNECTIONS_CAPACITY;
+	connections.connections = (Connection **) malloc(connections.capacity * sizeof(Connection *));
+	connections.polled = (Connection **) malloc(connections.capacity * sizeof(Connection *));
+	connections.pollFds = (struct pollfd *) malloc((CONNECTIONS_POLL_INDEX + connections.capacity)
+			* sizeof(struct pollfd));
+	if (connections.connections == NULL || connections.polled == NULL || connections.pollFds == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		destroyConnections(&connections);
+		return SP_QUERY_SERVER_ALLOC_FAIL;
+	}
+	while (!isStopRequested(server)) {
+		numOfPollFds = preparePollFds(server, &connections);
+		ready = poll(connections.pollFds, numOfPollFds, -1);
+		if (ready < 0 && errno != EINTR) {
+			res = SP_QUERY_SERVER_SOCKET_ERROR;
+			break;
+		}
+		if (ready <= 0) {
+			continue;
+		}
+		if (connections.pollFds[WAKE_POLL_INDEX].revents != 0) {
+			while (read(server->wakePipe[0], wakeBytes, sizeof(wakeBytes)) > 0);
+		}
+		readPolledConnections(&connections);
+		dispatchRequests(server, &connections);
+		if (connections.pollFds[LISTEN_POLL_INDEX].revents == 0) {
+			continue;
+		}
+		clientFd = accept(server->listenFd, NULL, NULL);
+		if (clientFd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			res = SP_QUERY_SERVER_SOCKET_ERROR;
+			break;
+		}
+		if (!addConnection(server, &connections, clientFd)) {
+			SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+			close(clientFd);
+		}
+	}
+	// The requests in flight are answered before their connections are closed
+	spThreadPoolWait(server->pool);
+	destroyConnections(&connections);
+	return res;
+}
+
+void spQueryServerStop(SPQueryServer server) {
+	if (server != NULL) {
+		__atomic_store_n(&server->stopRequested, 1, __ATOMIC_RELEASE);
+		wakeServer(server);
+	}
+}
+
+void spQueryServerDestroy(SPQueryServer server) {
+	int i;
+	if (server == NULL) {
+		return;
+	}
+	spThreadPoolDestroy(server->pool);
+	// The socket file is removed only if it is the server's own socket
+	if (server->listenFd >= 0) {
+		close(server->listenFd);
+		unlink(server->socketPath);
+	}
+	if (server->wakePipe[0] >= 0) {
+		close(server->wakePipe[0]);
+		close(server->wakePipe[1]);
+	}
+	if (server->connectionsLockInitialized) {
+		pthread_mutex_destroy(&server->connectionsLock);
+	}
+	free(server->socketPath);
+	if (server->accumulators != NULL) {
+		for (i = 0; i < server->numOfWorkers; i++) {
+			spHitsAccumulatorDestroy(server->accumulators[i]);
+		}
+		free(server->accumulators);
+	}
+	free(server);
+}
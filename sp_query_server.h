@@ -0,0 +1,138 @@
+/*
+ * sp_query_server.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#ifndef SP_QUERY_SERVER_H_
+#define SP_QUERY_SERVER_H_
+
+#include "sp_constants.h"
+#include "SPConfig.h"
+#include "SPSearchIndex.h"
+
+/**
+ * Implementation of a long running similar images query server.
+ *
+ * The server listens on a Unix domain socket, and serves the queries of its clients concurrently with a pool of
+ * spNumOfThreads worker threads which share the (read-only) search index. Every worker has its own hits accumulator.
+ * The server's thread polls all of the open connections, and gives every complete request to the workers as a job
+ * of its own, so a connection holds a worker only while its request is answered - idle clients do not keep other
+ * clients waiting. A connection may carry any number of requests, which are answered one at a time and in order.
+ * Requests which arrive while all of the workers are busy wait for a free worker.
+ *
+ * The protocol:
+ *
+ * Every message, in both directions, is a 4 bytes length followed by a payload of that length.
+ * All of the integers are unsigned and all of the numbers are sent in network byte order (big endian);
+ * doubles are sent as their 8 bytes IEEE-754 representation.
+ *
+ * Request payload - 1 byte request type, followed by:
+ * 		SP_QUERY_REQUEST_IMAGE_PATH		- The path of the query image (not NUL terminated).
+ * 		SP_QUERY_REQUEST_FEATURES		- 4 bytes number of features, 4 bytes features dimension (must be the
+ * 										  configured PCA dimension), and then the features' coordinates as doubles,
+ * 										  feature after feature.
+ * 		SP_QUERY_REQUEST_METRICS		- Nothing - asks for the timers and counters of the server (see sp_metrics.h).
+ *
+ * Response payload - 1 byte SP_QUERY_RESPONSE_STATUS, 4 bytes number of results, and for every result (ordered from
+ * the most similar image) 4 bytes image index and a double score - the hits the image got in the voting.
+ * A response with a non-successful status has no results.
+ * The response to a metrics request is 1 byte SP_QUERY_RESPONSE_STATUS, 4 bytes text length, and the metrics in the
+ * Prometheus text format (not NUL terminated).
+ *
+ * A malformed message (or a message longer than SP_QUERY_SERVER_MAX_MESSAGE_LENGTH) closes the connection.
+ *
+ * The following functions are available:
+ *
+ * 		spQueryServerCreate		- Creates a new server, listening on a given socket path.
+ * 		spQueryServerRun		- Serves queries until the server is stopped.
+ * 		spQueryServerStop		- Asks the server to stop (may be called from a signal handler).
+ * 		spQueryServerDestroy	- Deallocates the server and removes its socket.
+ */
+
+/** The maximal length of a single request payload. */
+#define SP_QUERY_SERVER_MAX_MESSAGE_LENGTH (64 * 1024 * 1024)
+
+/** The request types. */
+#define SP_QUERY_REQUEST_IMAGE_PATH 'P'
+#define SP_QUERY_REQUEST_FEATURES 'F'
+#define SP_QUERY_REQUEST_METRICS 'M'
+
+/** The statuses of the responses. */
+typedef enum sp_query_response_status_t {
+	SP_QUERY_RESPONSE_SUCCESS = 0,
+	SP_QUERY_RESPONSE_BAD_REQUEST = 1,
+	SP_QUERY_RESPONSE_EXTRACTION_ERROR = 2,
+	SP_QUERY_RESPONSE_INTERNAL_ERROR = 3
+} SP_QUERY_RESPONSE_STATUS;
+
+/** Type for defining the query server. */
+typedef struct sp_query_server_t *SPQueryServer;
+
+/** Enumeration to inform result of server method calls. */
+typedef enum sp_query_server_msg_t {
+	SP_QUERY_SERVER_INVALID_ARGUMENT,
+	SP_QUERY_SERVER_CONFIG_ERROR,
+	SP_QUERY_SERVER_ALLOC_FAIL,
+	SP_QUERY_SERVER_SOCKET_ERROR,
+	SP_QUERY_SERVER_SUCCESS
+} SP_QUERY_SERVER_MSG;
+
+/**
+ * Creates a new query server, and starts listening on the given socket path.
+ * A stale socket file at the given path (one which no server listens on) is replaced. Any other file at the path,
+ * and the socket of a running server, is left in place and the creation fails.
+ *
+ * The server does not own the configuration nor the search index, and they must outlive it.
+ *
+ * @param config The configuration used to provide the different parameters for the search.
+ * @param searchIndex The index of the different image's features.
+ * @param extractionFunc Function used to extract the features of query images. Called concurrently by the workers.
+ * @param socketPath The path of the Unix domain socket to listen on.
+ * @param msg Place-holder for SP_QUERY_SERVER_MSG to inform the creation result:
+ * 		SP_QUERY_SERVER_INVALID_ARGUMENT	- In case one of the given arguments is NULL or the socket path is too long.
+ * 		SP_QUERY_SERVER_CONFIG_ERROR		- In case of configuration access error.
+ * 		SP_QUERY_SERVER_ALLOC_FAIL			- In case of allocation failure.
+ * 		SP_QUERY_SERVER_SOCKET_ERROR		- In case the socket could not be created, or the path is in use.
+ * 		SP_QUERY_SERVER_SUCCESS				- In case the server was created successfully.
+ *
+ * @return
+ * 	NULL in case of a failure, the created server otherwise.
+ */
+SPQueryServer spQueryServerCreate(const SPConfig config, const SPSearchIndex searchIndex,
+		FeatureExractionFunction extractionFunc, const char *socketPath, SP_QUERY_SERVER_MSG *msg);
+
+/**
+ * Accepts clients and serves their queries, until spQueryServerStop is called.
+ * Returns once the requests which were given to the workers are answered and all of the clients connections are
+ * closed.
+ *
+ * @param server The server to run.
+ *
+ * @return
+ * 	SP_QUERY_SERVER_INVALID_ARGUMENT	- If server is NULL.
+ * 	SP_QUERY_SERVER_ALLOC_FAIL			- In case of allocation failure.
+ * 	SP_QUERY_SERVER_SOCKET_ERROR		- If accepting clients failed.
+ * 	SP_QUERY_SERVER_SUCCESS				- If the server was stopped.
+ */
+SP_QUERY_SERVER_MSG spQueryServerRun(SPQueryServer server);
+
+/**
+ * Asks the given server to stop. The server stops accepting clients and closes the connections of its clients
+ * after their current request is answered.
+ * The method only sets a flag and wakes the server up through a pipe, so it is safe to call it from a signal handler
+ * or from another thread.
+ *
+ * @param server The server to stop. If NULL nothing is done.
+ */
+void spQueryServerStop(SPQueryServer server);
+
+/**
+ * Deallocates the given server and removes its socket file. Must not be called while the server runs.
+ *
+ * @param server The server to deallocate. If NULL nothing is done.
+ */
+void spQueryServerDestroy(SPQueryServer server);
+
+#endif /* SP_QUERY_SERVER_H_ */
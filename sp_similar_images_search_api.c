@@ -9,149 +9,361 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include "SPBPriorityQueue.h"
-#include "sp_algorithms.h"
 #include "SPKDArray.h"
 #include "sp_util.h"
 #include "SPPoint.h"
 #include "SPLogger.h"
 #include "SPConfig.h"
-
-/** Structure to count images 'hits', meaning the amount of times an image's feature was found in nearest neighbor search. */
-typedef struct hit_info_t {
-   int index;
-   int hits;
-} HitInfo;
-
+#include "sp_metrics.h"
 
 /*** Private Methods ***/
 
 /**
- * Compares to HitInfos - to be used by qsort.
- * First it compares by hits in descending order - meaning higher amount of hits will come before.
- * If two HitInfos have same amount of hits, than the one with lower index will come before.
+ * Deallocates variables used in the query method.
+ *
+ * @param features Features array to destroy.
+ * @param numOfFeatures The number of features in the array.
+ * @param queue The nearest neighbors queue to destroy.
+ *
+ */
+void destroyImageQueryVariables(SPPoint *features, int numOfFeatures, SPBPQueue queue) {
+	spBPQueueDestroy(queue);
+	spKDArrayFreePointsArray(features, numOfFeatures);
+}
+
+/**
+ * Empties the given nearest neighbors queue of a single query feature, and adds the hits of the neighbors to
+ * the accumulator according to the voting method:
+ *
+ * 	VOTING_MODE_FLAT				- Every neighbor adds one hit to its image.
+ * 	VOTING_MODE_DISTANCE_WEIGHTED	- Every neighbor adds the squared distance of the nearest neighbor divided by its own
+ * 									  squared distance hits to its image - one hit for the nearest neighbor, and less
+ * 									  for farther ones. The weights do not depend on the scale of the coordinates.
+ * 	VOTING_MODE_RATIO_TEST			- The nearest neighbor adds one hit to its image, only if its distance is smaller
+ * 									  than ratioTestThreshold times the distance of the second nearest neighbor.
+ * 									  If there is no second neighbor (spKNN is 1), the nearest neighbor always votes.
  *
- * @param a - First HitInfo pointer.
- * @param b - Second HitInfo pointer.
+ * @param accumulator The accumulator to add the hits to.
+ * @param queue The nearest neighbors queue, with the squared distances as values.
+ * @param votingMode The voting method.
+ * @param ratioTestThreshold The distances ratio threshold, used by the ratio test voting method.
  *
  * @return
- * 	The compare result.
+ * 	The result of adding the hits to the accumulator.
  */
-int cmpHitInfos(const void * a, const void * b) {
-	HitInfo aInfo = *(HitInfo*)a;
-	HitInfo bInfo = *(HitInfo*)b;
-	int res = (bInfo.hits - aInfo.hits);
-	if (res != 0) {
+SP_HITS_ACCUMULATOR_MSG addNeighborsVotes(SPHitsAccumulator accumulator, SPBPQueue queue, SP_VOTING_MODE votingMode,
+		double ratioTestThreshold) {
+	SP_HITS_ACCUMULATOR_MSG res = SP_HITS_ACCUMULATOR_SUCCESS;
+	SPListElement listElement;
+	int nearestIndex;
+	double nearestDistance = 0, distance, hits;
+	bool isNearest = true;
+	if (votingMode == VOTING_MODE_RATIO_TEST) {
+		if (spBPQueueIsEmpty(queue)) {
+			return SP_HITS_ACCUMULATOR_SUCCESS;
+		}
+		listElement = spBPQueuePeek(queue);
+		nearestIndex = spListElementGetIndex(listElement);
+		nearestDistance = spListElementGetValue(listElement);
+		spListElementDestroy(listElement);
+		spBPQueueDequeue(queue);
+		// Distances are squared, so is the threshold
+		if (spBPQueueIsEmpty(queue)
+				|| nearestDistance < ratioTestThreshold * ratioTestThreshold * spBPQueueMinValue(queue)) {
+			res = spHitsAccumulatorAdd(accumulator, nearestIndex, 1);
+		}
+		spBPQueueClear(queue);
 		return res;
 	}
-	return aInfo.index - bInfo.index;
+	while (!spBPQueueIsEmpty(queue)) {
+		listElement = spBPQueuePeek(queue);
+		spBPQueueDequeue(queue);
+		distance = spListElementGetValue(listElement);
+		if (isNearest) {
+			nearestDistance = distance;
+			isNearest = false;
+		}
+		hits = 1;
+		// Neighbors as near as the nearest one (an exact match included) get one hit
+		if (votingMode == VOTING_MODE_DISTANCE_WEIGHTED && distance > nearestDistance) {
+			hits = nearestDistance / distance;
+		}
+		// Farther neighbors of an exact match get no hits
+		if (res == SP_HITS_ACCUMULATOR_SUCCESS && hits > 0) {
+			res = spHitsAccumulatorAdd(accumulator, spListElementGetIndex(listElement), hits);
+		}
+		spListElementDestroy(listElement);
+	}
+	return res;
 }
 
 /**
- * Deallocates variables used in the query method.
+ * The configured parameters of a search.
+ */
+typedef struct search_parameters_t {
+	int KNN;
+	int numOfImages;
+	int similarImages;
+	int PCADimension;
+	SP_VOTING_MODE votingMode;
+	double ratioTestThreshold;
+} SearchParameters;
+
+/**
+ * Reads the parameters of a search from the configuration.
  *
- * @param features Features array to destroy.
- * @param numOfFeatures The number of features in the array.
- * @param hitInfos Array of HitInfos to free.
+ * @param config The configuration.
+ * @param params Place-holder for the parameters.
  *
+ * @return
+ * 	false in case of configuration access error, true otherwise.
  */
-void destroyImageQueryVariables(SPPoint *features, int numOfFeatures, HitInfo *hitInfos) {
-	free(hitInfos);
-	spKDArrayFreePointsArray(features, numOfFeatures);
+bool loadSearchParameters(const SPConfig config, SearchParameters *params) {
+	SP_CONFIG_MSG configMsg;
+	params->KNN = spConfigGetKNN(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	params->numOfImages = spConfigGetNumOfImages(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	params->similarImages = spConfigGetNumOfSimilarImages(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	params->PCADimension = spConfigGetPCADim(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	params->votingMode = spConfigGetVotingMode(config, &configMsg);
+	if (configMsg != SP_CONFIG_SUCCESS) {
+		return false;
+	}
+	params->ratioTestThreshold = spConfigGetRatioTestThreshold(config, &configMsg);
+	return configMsg == SP_CONFIG_SUCCESS;
 }
 
-/*** Public Methods ***/
-
-int *spFindSimilarImagesIndices(const SPConfig config, const char *queryImagePath,
-		const SPKDTreeNode searchTree, int *resultsCount, FeatureExractionFunction extractionFunc,
+/**
+ * Prepares a search - reads its parameters, validates the accumulator, clears it and creates the nearest neighbors
+ * queue.
+ *
+ * @param config The configuration.
+ * @param accumulator The hits accumulator of the search.
+ * @param params Place-holder for the parameters.
+ * @param msg Place-holder for the failure reason.
+ *
+ * @return
+ * 	NULL in case of failure, the nearest neighbors queue otherwise.
+ */
+SPBPQueue prepareSearch(const SPConfig config, SPHitsAccumulator accumulator, SearchParameters *params,
 		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
-	SP_CONFIG_MSG configMsg;
-	int i, j, KNN, numOfImages, similarImages, numOfFeaturesExtracted, *resValue;
-	SPPoint *features;
-	HitInfo* hitInfos;
-	if (config == NULL || queryImagePath == NULL || searchTree == NULL || resultsCount == NULL || extractionFunc == NULL) {
+	SPBPQueue queue;
+	if (!loadSearchParameters(config, params)) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR;
+		return NULL;
+	}
+	if (spHitsAccumulatorGetNumOfImages(accumulator) != params->numOfImages) {
 		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
 		return NULL;
 	}
+	queue = spBPQueueCreate(params->KNN);
+	if (queue == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
+		return NULL;
+	}
+	// The accumulator may hold hits of a previous query
+	spHitsAccumulatorClear(accumulator);
+	return queue;
+}
 
-	KNN = spConfigGetKNN(config, &configMsg);
-	if (configMsg != SP_CONFIG_SUCCESS) {
-		*msg = SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR;
+/**
+ * Adds the votes of a single query feature's neighbors (see addNeighborsVotes), and times the voting.
+ *
+ * @return
+ * 	false in case of allocation failure, true otherwise.
+ */
+bool voteForNeighbors(SPHitsAccumulator accumulator, SPBPQueue queue, const SearchParameters *params) {
+	SP_HITS_ACCUMULATOR_MSG res;
+	SP_METRICS_TIMER_START(votingTimer);
+	res = addNeighborsVotes(accumulator, queue, params->votingMode, params->ratioTestThreshold);
+	SP_METRICS_TIMER_STOP(votingTimer, SP_METRICS_VOTING);
+	return res == SP_HITS_ACCUMULATOR_SUCCESS;
+}
+
+/**
+ * Finishes a search - selects the top images from the accumulator and destroys the queue.
+ *
+ * @return
+ * 	NULL in case of failure, the top images indices otherwise.
+ */
+int *finishSearch(SPBPQueue queue, SPHitsAccumulator accumulator, const SearchParameters *params, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SP_METRICS_TIMER_START(sortingTimer);
+	int *resValue = spHitsAccumulatorTopImages(accumulator, params->similarImages, resultsCount);
+	SP_METRICS_TIMER_STOP(sortingTimer, SP_METRICS_SORTING);
+	spBPQueueDestroy(queue);
+	if (resValue == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
 		return NULL;
 	}
-	numOfImages = spConfigGetNumOfImages(config, &configMsg);
-	if (configMsg != SP_CONFIG_SUCCESS) {
-		*msg = SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR;
+	*msg = SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS;
+	return resValue;
+}
+
+/**
+ * Reports an allocation failure in the middle of a search, and destroys the queue.
+ */
+void failSearch(SPBPQueue queue, SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
+	spBPQueueDestroy(queue);
+	*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
+}
+
+/**
+ * Searches the nearest neighbors of a single query feature in the index, and adds their votes.
+ *
+ * @return
+ * 	false in case of failure, in which case the queue is destroyed and msg informs the failure, true otherwise.
+ */
+bool searchAndVote(SPSearchIndex searchIndex, SPBPQueue queue, SPPoint feature, SPHitsAccumulator accumulator,
+		const SearchParameters *params, SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SP_SEARCH_INDEX_MSG searchMsg = spSearchIndexKNearestNeighbours(searchIndex, queue, feature);
+	if (searchMsg == SP_SEARCH_INDEX_INVALID_ARGUMENT) {
+		spBPQueueDestroy(queue);
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
+		return false;
+	}
+	if (searchMsg != SP_SEARCH_INDEX_SUCCESS || !voteForNeighbors(accumulator, queue, params)) {
+		failSearch(queue, msg);
+		return false;
+	}
+	return true;
+}
+
+/*** Public Methods ***/
+
+int *spFindSimilarImagesIndices(const SPConfig config, const char *queryImagePath,
+		const SPSearchIndex searchIndex, int *resultsCount, FeatureExractionFunction extractionFunc,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SP_CONFIG_MSG configMsg;
+	int *resValue, numOfImages;
+	SPHitsAccumulator accumulator;
+	if (config == NULL || queryImagePath == NULL || searchIndex == NULL || resultsCount == NULL || extractionFunc == NULL) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
 		return NULL;
 	}
-	similarImages = spConfigGetNumOfSimilarImages(config, &configMsg);
+	numOfImages = spConfigGetNumOfImages(config, &configMsg);
 	if (configMsg != SP_CONFIG_SUCCESS) {
 		*msg = SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR;
 		return NULL;
 	}
-
-	hitInfos = (HitInfo*) malloc(numOfImages * sizeof(HitInfo));
-	if (hitInfos == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
+	accumulator = spHitsAccumulatorCreate(numOfImages);
+	if (accumulator == NULL) {
+		SP_LOG_ERROR(ALLOCATION_ERROR_MSG);
 		*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
 		return NULL;
 	}
+	resValue = spFindSimilarImagesIndicesWithAccumulator(config, queryImagePath, searchIndex, accumulator,
+			resultsCount, extractionFunc, msg);
+	spHitsAccumulatorDestroy(accumulator);
+	return resValue;
+}
 
-	for (i = 0; i < numOfImages; i++) {
-		HitInfo info = (HitInfo) {i, 0};
-		hitInfos[i] = info;
+int *spFindSimilarImagesIndicesWithAccumulator(const SPConfig config, const char *queryImagePath,
+		const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		FeatureExractionFunction extractionFunc, SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	int numOfFeaturesExtracted, *resValue;
+	SPPoint *features;
+	if (config == NULL || queryImagePath == NULL || searchIndex == NULL || accumulator == NULL || resultsCount == NULL
+			|| extractionFunc == NULL) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
+		return NULL;
 	}
 
 	features = extractionFunc(queryImagePath, 0, &numOfFeaturesExtracted);
 
 	if (features == NULL || numOfFeaturesExtracted <= 0) {
-		destroyImageQueryVariables(features, numOfFeaturesExtracted, hitInfos);
+		destroyImageQueryVariables(features, numOfFeaturesExtracted, NULL);
 		*msg = SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR;
 		return NULL;
 	}
 
-	SPBPQueue queue = spBPQueueCreate(KNN);
+	resValue = spFindSimilarImagesIndicesByFeatures(config, features, numOfFeaturesExtracted, searchIndex,
+			accumulator, resultsCount, msg);
+	destroyImageQueryVariables(features, numOfFeaturesExtracted, NULL);
+	return resValue;
+}
+
+int *spFindSimilarImagesIndicesByFeatures(const SPConfig config, const SPPoint *features, int numOfFeatures,
+		const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SearchParameters params;
+	SPBPQueue queue;
+	int i, *resValue;
+	if (config == NULL || features == NULL || numOfFeatures <= 0 || searchIndex == NULL || accumulator == NULL
+			|| resultsCount == NULL) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
+		return NULL;
+	}
+	SP_METRICS_TIMER_START(searchTimer);
+	queue = prepareSearch(config, accumulator, &params, msg);
 	if (queue == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		destroyImageQueryVariables(features, numOfFeaturesExtracted, hitInfos);
-		*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
 		return NULL;
 	}
-
-	for (i = 0; i < numOfFeaturesExtracted; i++) {
-		SPPoint feature = features[i];
-		spKNearestNeighbours(searchTree, queue, feature);
-		int queueSize = spBPQueueSize(queue);
-		for (j = 0; j < queueSize; j++) {
-			SPListElement listElement = spBPQueuePeek(queue);
-			int index = spListElementGetIndex(listElement);
-			hitInfos[index].hits++;
-			spBPQueueDequeue(queue);
-			spListElementDestroy(listElement);
+	for (i = 0; i < numOfFeatures; i++) {
+		if (!searchAndVote(searchIndex, queue, features[i], accumulator, &params, msg)) {
+			return NULL;
 		}
-		spBPQueueClear(queue);
 	}
-	// No need for the queue anymore
-	spBPQueueDestroy(queue);
-
-	qsort(hitInfos, numOfImages, sizeof(HitInfo), cmpHitInfos);
-
-	resValue = (int *) malloc(similarImages * sizeof(int));
+	resValue = finishSearch(queue, accumulator, &params, resultsCount, msg);
+	SP_METRICS_TIMER_STOP(searchTimer, SP_METRICS_SEARCH);
+	SP_METRICS_COUNT(SP_METRICS_QUERIES, 1);
+	return resValue;
+}
 
-	if (resValue == NULL) {
-		spLoggerPrintError(ALLOCATION_ERROR_MSG, __FILE__, __func__, __LINE__);
-		destroyImageQueryVariables(features, numOfFeaturesExtracted, hitInfos);
-		*msg = SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL;
+int *spFindSimilarImagesIndicesByDescriptors(const SPConfig config, const double *descriptors, int numOfDescriptors,
+		int dimension, const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg) {
+	SearchParameters params;
+	SPBPQueue queue;
+	SPPoint feature;
+	bool success;
+	int i, *resValue;
+	if (config == NULL || descriptors == NULL || numOfDescriptors <= 0 || searchIndex == NULL || accumulator == NULL
+			|| resultsCount == NULL) {
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
 		return NULL;
 	}
-
-	for (i = 0; i < similarImages; i++) {
-		resValue[i] = hitInfos[i].index;
+	SP_METRICS_TIMER_START(searchTimer);
+	queue = prepareSearch(config, accumulator, &params, msg);
+	if (queue == NULL) {
+		return NULL;
 	}
-
-	destroyImageQueryVariables(features, numOfFeaturesExtracted, hitInfos);
-	*resultsCount = similarImages;
-	*msg = SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS;
+	if (dimension != params.PCADimension) {
+		spBPQueueDestroy(queue);
+		*msg = SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT;
+		return NULL;
+	}
+	for (i = 0; i < numOfDescriptors; i++) {
+		// Only a single descriptor's point is alive at a time
+		feature = spPointCreate((double *) descriptors + (size_t) i * dimension, dimension, 0);
+		if (feature == NULL) {
+			failSearch(queue, msg);
+			return NULL;
+		}
+		success = searchAndVote(searchIndex, queue, feature, accumulator, &params, msg);
+		spPointDestroy(feature);
+		if (!success) {
+			return NULL;
+		}
+	}
+	resValue = finishSearch(queue, accumulator, &params, resultsCount, msg);
+	SP_METRICS_TIMER_STOP(searchTimer, SP_METRICS_SEARCH);
+	SP_METRICS_COUNT(SP_METRICS_QUERIES, 1);
 	return resValue;
-
 }
@@ -11,14 +11,21 @@
 #include <stdlib.h>
 #include "sp_constants.h"
 #include "SPConfig.h"
-#include "SPKDTree.h"
+#include "SPSearchIndex.h"
+#include "SPHitsAccumulator.h"
 
 /**
  * Implementation of the similar images querying logic.
  *
  * The following functions are available:
- * 		spFindSimilarImagesIndices			- Finds the indices of the the most similar images,
- * 											  based on kd-tree nearest features search.
+ * 		spFindSimilarImagesIndices					- Finds the indices of the the most similar images,
+ * 													  based on nearest features search in the search index.
+ * 		spFindSimilarImagesIndicesWithAccumulator	- Same as spFindSimilarImagesIndices, but counts the images hits
+ * 													  with a given (reusable) hits accumulator.
+ * 		spFindSimilarImagesIndicesByFeatures		- Same as spFindSimilarImagesIndicesWithAccumulator, but for
+ * 													  already extracted query features.
+ * 		spFindSimilarImagesIndicesByDescriptors		- Same as spFindSimilarImagesIndicesByFeatures, but for query
+ * 													  descriptors given in a single contiguous array.
  */
 
 /** Enumeration to inform result of API method calls. */
@@ -36,11 +43,19 @@ typedef enum sp_similar_images_search_api_msg_t {
  * 	- Finding the nearest features for each feature.
  * 	- Counting the most repeated images.
  *
+ * The hits each nearest feature gives its image depend on the configured voting method (spVotingMode):
+ * a flat hit for every neighbor, a hit weighted by the neighbor's distance, or a single hit for the nearest neighbor
+ * only when it passes the ratio test against the second nearest one (see spConfigGetVotingMode).
+ *
+ * Images with the same amount of hits are ordered by their index (lower index first).
+ * Only the images which were found as nearest neighbors are ranked, and in case there are less of them than the
+ * configured similar images count, the results are completed with the lowest indices of the rest of the images.
+ *
  * The different parameters for the run (Nearest neighbors count, similar images count, etc.) are provided by the given configuration
  *
  * @param config The configuration used to provide the different parameters for the search.
  * @param queryImagePath The queried image, meaning the image that the result images should be similar to.
- * @param searchTree The kd-tree containing the different image's features to perform nearest nearest neighbor algorithm.
+ * @param searchIndex The index of the different image's features to perform nearest neighbor search in.
  * @param resultCount Place-holder for the amount of indices in the result
  * @param extractionFunc Function used to extract the image's features.
  * @param msg Place-holder for SP_SIMILAR_IMAGES_SEARCH_API_MSG to inform the process result:
@@ -56,8 +71,99 @@ typedef enum sp_similar_images_search_api_msg_t {
  *
  */
 int *spFindSimilarImagesIndices(const SPConfig config, const char *queryImagePath,
-		const SPKDTreeNode searchTree, int *resultsCount, FeatureExractionFunction extractionFunc,
+		const SPSearchIndex searchIndex, int *resultsCount, FeatureExractionFunction extractionFunc,
 		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg);
 
+/**
+ * Finds the indices of the images most similar to a given image, exactly as spFindSimilarImagesIndices does,
+ * but uses the given hits accumulator to count the images hits.
+ *
+ * spFindSimilarImagesIndices allocates a hits accumulator for the whole catalog on every call. Querying through
+ * a long lived accumulator (one per querying thread) makes the cost of a query depend only on the number of
+ * features and nearest neighbors, and not on the number of images.
+ * The accumulator is cleared by this method, so it can be passed as is from one query to another.
+ *
+ * @param config The configuration used to provide the different parameters for the search.
+ * @param queryImagePath The queried image, meaning the image that the result images should be similar to.
+ * @param searchIndex The index of the different image's features to perform nearest neighbor search in.
+ * @param accumulator The hits accumulator to use, created for the configured number of images.
+ * @param resultCount Place-holder for the amount of indices in the result
+ * @param extractionFunc Function used to extract the image's features.
+ * @param msg Place-holder for SP_SIMILAR_IMAGES_SEARCH_API_MSG to inform the process result:
+ * 		SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT 			- In case one of the given arguments is NULL,
+ * 																  or the accumulator does not match the number of images.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR				- In case of configuration access error.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL					- In case of allocation failure.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR	- In case image's features extraction went wrong.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS					- In case search finished successfully.
+ *
+ * @return
+ * 	NULL in case of a non-successful search.
+ * 	Otherwise, returns the indices of the most similar images.
+ */
+int *spFindSimilarImagesIndicesWithAccumulator(const SPConfig config, const char *queryImagePath,
+		const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		FeatureExractionFunction extractionFunc, SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg);
+
+/**
+ * Finds the indices of the images most similar to an image whose features were already extracted, exactly as
+ * spFindSimilarImagesIndicesWithAccumulator does after the features extraction.
+ *
+ * After a successful search, the accumulator holds the hits of every image until it is used again,
+ * so the score of each result image can be queried with spHitsAccumulatorGetHits.
+ * The features are not modified nor deallocated.
+ *
+ * @param config The configuration used to provide the different parameters for the search.
+ * @param features The features of the queried image.
+ * @param numOfFeatures The number of features.
+ * @param searchIndex The index of the different image's features to perform nearest neighbor search in.
+ * @param accumulator The hits accumulator to use, created for the configured number of images.
+ * @param resultCount Place-holder for the amount of indices in the result
+ * @param msg Place-holder for SP_SIMILAR_IMAGES_SEARCH_API_MSG to inform the process result:
+ * 		SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT 			- In case one of the given arguments is NULL,
+ * 																  numOfFeatures is non-positive or the accumulator
+ * 																  does not match the number of images.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR				- In case of configuration access error.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL					- In case of allocation failure.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS					- In case search finished successfully.
+ *
+ * @return
+ * 	NULL in case of a non-successful search.
+ * 	Otherwise, returns the indices of the most similar images.
+ */
+int *spFindSimilarImagesIndicesByFeatures(const SPConfig config, const SPPoint *features, int numOfFeatures,
+		const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg);
+
+/**
+ * Finds the indices of the images most similar to an image whose PCA-SIFT descriptors were already computed
+ * (e.g. by the client), exactly as spFindSimilarImagesIndicesByFeatures does.
+ *
+ * The descriptors are given row after row in a single contiguous array, so clients need not create a point
+ * per descriptor, nor write an image to the disk.
+ *
+ * @param config The configuration used to provide the different parameters for the search.
+ * @param descriptors The descriptors of the queried image - numOfDescriptors * dimension values.
+ * @param numOfDescriptors The number of descriptors.
+ * @param dimension The dimension of every descriptor, must be the configured PCA dimension.
+ * @param searchIndex The index of the different image's features to perform nearest neighbor search in.
+ * @param accumulator The hits accumulator to use, created for the configured number of images.
+ * @param resultCount Place-holder for the amount of indices in the result
+ * @param msg Place-holder for SP_SIMILAR_IMAGES_SEARCH_API_MSG to inform the process result:
+ * 		SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT 			- In case one of the given arguments is NULL,
+ * 																  numOfDescriptors is non-positive, the dimension is
+ * 																  not the PCA dimension or the accumulator does not
+ * 																  match the number of images.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_CONFIG_ERROR				- In case of configuration access error.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_ALLOC_FAIL					- In case of allocation failure.
+ *		SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS					- In case search finished successfully.
+ *
+ * @return
+ * 	NULL in case of a non-successful search.
+ * 	Otherwise, returns the indices of the most similar images.
+ */
+int *spFindSimilarImagesIndicesByDescriptors(const SPConfig config, const double *descriptors, int numOfDescriptors,
+		int dimension, const SPSearchIndex searchIndex, SPHitsAccumulator accumulator, int *resultsCount,
+		SP_SIMILAR_IMAGES_SEARCH_API_MSG *msg);
 
 #endif /* SP_SIMILAR_IMAGES_SEARCH_API_H_ */
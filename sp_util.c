@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#define HASH_FILE_BLOCK_SIZE 65536
+
 /*** Private Methods ***/
 
 /**
@@ -136,4 +138,28 @@ void spUtilFreeStringsArray(char **strings, int count) {
 	free(strings);
 }
 
+unsigned long long spUtilFNV1aHash(const void *data, size_t length, unsigned long long hash) {
+	const unsigned char *bytes = (const unsigned char *) data;
+	size_t i;
+	for (i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
 
+bool spUtilFNV1aHashFile(const char *path, unsigned long long *hash) {
+	unsigned char block[HASH_FILE_BLOCK_SIZE];
+	size_t blockLength;
+	bool success;
+	FILE *file;
+	if (path == NULL || hash == NULL || (file = fopen(path, "rb")) == NULL) {
+		return false;
+	}
+	while ((blockLength = fread(block, 1, sizeof(block), file)) > 0) {
+		*hash = spUtilFNV1aHash(block, blockLength, *hash);
+	}
+	success = !ferror(file);
+	fclose(file);
+	return success;
+}
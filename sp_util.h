@@ -9,6 +9,7 @@
 #define SP_UTIL_
 
 #include <stdlib.h>
+#include <stdbool.h>
 
 /**
  * General utilities class to be used throughout the system.
@@ -18,6 +19,8 @@
  * 		spUtilStrSplit			- Splits a given string with respect to the given delimiter.
  * 		spUtilStrJoin			- Joins the given strings array using the given delimiter.
  *		spUtilFreeStringsArray	- Deallocates the given array of strings.
+ *		spUtilFNV1aHash			- Hashes (or continues hashing) a buffer with the 64-bit FNV-1a hash.
+ *		spUtilFNV1aHashFile		- Continues a 64-bit FNV-1a hash with the contents of a file.
  */
 
 /*** Constants ***/
@@ -25,6 +28,9 @@
 /** The maximum size of each token between delimiters - used by the split method. */
 static const int TOKEN_MAX_LEN = 100;
 
+/** The initial value of the 64-bit FNV-1a hash, to be given to the first spUtilFNV1aHash call. */
+#define SP_UTIL_FNV1A_INITIAL_HASH 0xcbf29ce484222325ULL
+
 
 /**
  * Splits the given string with respect to the given delimiter.
@@ -64,4 +70,31 @@ char *spUtilStrJoin(const char **strs, int stringsCount, const char delim);
  */
 void spUtilFreeStringsArray(char **strings, int count);
 
+/**
+ * Hashes the given buffer with the 64-bit FNV-1a hash. A hash of several buffers is computed by passing the hash
+ * of the previous buffers, e.g.
+ * 		hash = spUtilFNV1aHash(first, firstLength, SP_UTIL_FNV1A_INITIAL_HASH);
+ * 		hash = spUtilFNV1aHash(second, secondLength, hash);
+ *
+ * @param data The buffer to hash.
+ * @param length The buffer length, in bytes.
+ * @param hash The hash of the preceding data, or SP_UTIL_FNV1A_INITIAL_HASH.
+ *
+ * @return
+ * 	The hash of the preceding data followed by the buffer.
+ */
+unsigned long long spUtilFNV1aHash(const void *data, size_t length, unsigned long long hash);
+
+/**
+ * Continues the given 64-bit FNV-1a hash with the contents of the given file, read in blocks.
+ *
+ * @param path The path of the file to hash.
+ * @param hash In - the hash of the preceding data (or SP_UTIL_FNV1A_INITIAL_HASH), out - the hash of the preceding
+ * 		  data followed by the file contents. Not defined if the method fails.
+ *
+ * @return
+ * 	false if any parameter is NULL, or the file could not be read, true otherwise.
+ */
+bool spUtilFNV1aHashFile(const char *path, unsigned long long *hash);
+
 #endif /* SP_UTIL_ */
@@ -70,3 +70,32 @@ SPPoint nDPoint(int index, int n, ...) {
 	return point;
 }
 
+SPPoint *createClusteredFeatures(int dim, int numOfImages, int featuresPerImage,
+		double (*spread)(int feature, int coordinate, void *spreadState), void *spreadState) {
+	int i, j, k;
+	double *coordinates = (double *) malloc(dim * sizeof(double));
+	SPPoint *features = (SPPoint *) malloc(numOfImages * featuresPerImage * sizeof(*features));
+	for (i = 0; i < numOfImages; i++) {
+		for (j = 0; j < featuresPerImage; j++) {
+			for (k = 0; k < dim; k++) {
+				coordinates[k] = i * CLUSTERS_DISTANCE + spread(j, k, spreadState);
+			}
+			features[i * featuresPerImage + j] = spPointCreate(coordinates, dim, i);
+		}
+	}
+	free(coordinates);
+	return features;
+}
+
+double gridSpread(int feature, int coordinate, void *spreadState) {
+	(void) spreadState;
+	return ((feature * 7 + coordinate * 3) % 19) / 2.0 - 4.5;
+}
+
+void destroyFeatures(SPPoint *features, int numOfFeatures) {
+	int i;
+	for (i = 0; i < numOfFeatures; i++) {
+		spPointDestroy(features[i]);
+	}
+	free(features);
+}
@@ -19,4 +19,27 @@ SPPoint indexedThreeDPoint(int index, double x, double y, double z);
 
 SPPoint nDPoint(int index, int n, ...);
 
+/*
+ * The distance (in every coordinate) between the centers of consecutive clusters of createClusteredFeatures.
+ */
+#define CLUSTERS_DISTANCE 100.0
+
+/**
+ * Features of numOfImages images, the features of image i are spread around the point whose coordinates are all
+ * i * CLUSTERS_DISTANCE. Coordinate k of the j-th feature of an image is offset from the center by
+ * spread(j, k, spreadState).
+ *
+ * @return
+ * 	An array of numOfImages * featuresPerImage features, ordered by image, to be destroyed by destroyFeatures.
+ */
+SPPoint *createClusteredFeatures(int dim, int numOfImages, int featuresPerImage,
+		double (*spread)(int feature, int coordinate, void *spreadState), void *spreadState);
+
+/**
+ * A deterministic spread for createClusteredFeatures, of less than 5 in every coordinate. Needs no state.
+ */
+double gridSpread(int feature, int coordinate, void *spreadState);
+
+void destroyFeatures(SPPoint *features, int numOfFeatures);
+
 #endif /* UNIT_TESTS_COMMON_TEST_UTIL_H_ */
@@ -85,6 +85,36 @@ static bool spSimpleNearestNeighboutTest() {
 	return true;
 }
 
+static bool spKMeansTest() {
+	// Two clusters of two 2D vectors each
+	double data[] = { 0, 0, 1, 0, 10, 10, 11, 10 };
+	double centroids[8], distance;
+	int first, second;
+	double vector[] = { 9, 10 };
+
+	ASSERT_TRUE(spKMeans(data, 4, 2, 2, 10, centroids));
+	first = spNearestCentroid(centroids, 2, 2, data, NULL);
+	second = spNearestCentroid(centroids, 2, 2, data + 4, NULL);
+	ASSERT_NOT_SAME(first, second);
+	ASSERT_SAME(centroids[2 * first], 0.5);
+	ASSERT_SAME(centroids[2 * first + 1], 0.0);
+	ASSERT_SAME(centroids[2 * second], 10.5);
+	ASSERT_SAME(centroids[2 * second + 1], 10.0);
+
+	ASSERT_SAME(spNearestCentroid(centroids, 2, 2, vector, &distance), second);
+	ASSERT_SAME(distance, 2.25);
+
+	// As many clusters as vectors - every vector is a centroid
+	ASSERT_TRUE(spKMeans(data, 4, 2, 4, 10, centroids));
+	ASSERT_SAME(spNearestCentroid(centroids, 4, 2, data + 6, &distance), 3);
+	ASSERT_SAME(distance, 0.0);
+
+	ASSERT_FALSE(spKMeans(data, 4, 2, 5, 10, centroids));
+	ASSERT_FALSE(spKMeans(NULL, 4, 2, 2, 10, centroids));
+	ASSERT_FALSE(spKMeans(data, 4, 0, 2, 10, centroids));
+	return true;
+}
+
 static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value) {
 	SPListElement element = spBPQueuePeek(queue);
 	ASSERT_SAME(spListElementGetIndex(element), index);
@@ -98,4 +128,5 @@ static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value) {
 int main() {
 	printf("Running SPAlgorithmsTest.. \n");
 	RUN_TEST(spSimpleNearestNeighboutTest);
+	RUN_TEST(spKMeansTest);
 }
@@ -0,0 +1,216 @@
+/*
+ * sp_batch_query_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+#include "../SPSearchIndex.h"
+#include "../sp_features_file_api.h"
+#include "../sp_batch_query.h"
+#include "unit_test_util.h"
+#include "common_test_util.h"
+
+#define RESULTS_FILENAME "./sp_batch_query_unit_test_results.tsv"
+#define QUERIES_FILENAME "./sp_batch_query_unit_test_queries.txt"
+#define FEATURES_FILENAME "./sp_batch_query_unit_test.feats"
+
+/**
+ * The searched space - images 0, 1 and 2 have features, images 3 and 4 have none.
+ */
+static SPSearchIndex createSearchIndex() {
+	SPPoint points[6];
+	SPKDArray kdArray;
+	SPKDTreeNode tree;
+	int i;
+	points[0] = indexedThreeDPoint(0, 0, 0, 0);
+	points[1] = indexedThreeDPoint(0, 1, 0, 0);
+	points[2] = indexedThreeDPoint(1, 10, 10, 10);
+	points[3] = indexedThreeDPoint(1, 11, 10, 10);
+	points[4] = indexedThreeDPoint(2, 100, 100, 100);
+	points[5] = indexedThreeDPoint(2, 101, 100, 100);
+	kdArray = spKDArrayInit(points, 6);
+	tree = spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD);
+	spKDArrayDestroy(kdArray);
+	for (i = 0; i < 6; i++) {
+		spPointDestroy(points[i]);
+	}
+	return spSearchIndexCreateKDTree(tree);
+}
+
+static SPPoint *queryExtractionMockFunction(const char *imagePath, int imageIndex, int *numOfFeaturesExtracted) {
+	SPPoint *points;
+	(void) imageIndex;
+	if (strcmp(imagePath, "near_second") == 0) {
+		points = (SPPoint *) malloc(2 * sizeof(*points));
+		points[0] = threeDPoint(10, 10, 10);
+		points[1] = threeDPoint(11, 10, 10);
+		*numOfFeaturesExtracted = 2;
+		return points;
+	} else if (strcmp(imagePath, "between_first_and_third") == 0) {
+		points = (SPPoint *) malloc(2 * sizeof(*points));
+		points[0] = threeDPoint(100, 100, 100);
+		points[1] = threeDPoint(0, 0, 0);
+		*numOfFeaturesExtracted = 2;
+		return points;
+	}
+	*numOfFeaturesExtracted = 0;
+	return NULL;
+}
+
+static bool spBatchQueryRunTest() {
+	SP_CONFIG_MSG configMsg;
+	SPBatchQueryStats stats;
+	char line[256];
+	FILE *results;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+
+	ASSERT_SAME(spBatchQueryRun(config, searchIndex, queryExtractionMockFunction, "./test_resources/batch_queries.txt",
+			RESULTS_FILENAME, &stats), SP_BATCH_QUERY_SUCCESS);
+	ASSERT_SAME(stats.numOfQueries, 3);
+	ASSERT_SAME(stats.numOfFailedQueries, 1);
+	ASSERT(stats.elapsedSeconds >= 0);
+
+	// The results are in the order of the queries
+	results = fopen(RESULTS_FILENAME, "r");
+	ASSERT_NOT_NULL(results);
+	ASSERT_NOT_NULL(fgets(line, sizeof(line), results));
+	ASSERT_SAME(strcmp(line, "near_second\tOK\t1:4,0:0,2:0\n"), 0);
+	ASSERT_NOT_NULL(fgets(line, sizeof(line), results));
+	ASSERT_SAME(strcmp(line, "missing\tEXTRACTION_ERROR\t\n"), 0);
+	ASSERT_NOT_NULL(fgets(line, sizeof(line), results));
+	ASSERT_SAME(strcmp(line, "between_first_and_third\tOK\t0:2,2:2,1:0\n"), 0);
+	ASSERT_NULL(fgets(line, sizeof(line), results));
+	fclose(results);
+	remove(RESULTS_FILENAME);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spBatchQueryManyQueriesTest() {
+	SP_CONFIG_MSG configMsg;
+	SPBatchQueryStats stats;
+	char line[256];
+	int i, numOfQueries = 3 * SP_BATCH_QUERY_WINDOW + 1;
+	FILE *file;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+
+	// More queries than the in flight window
+	file = fopen(QUERIES_FILENAME, "w");
+	for (i = 0; i < numOfQueries; i++) {
+		fprintf(file, "%s\n", i % 2 == 0 ? "near_second" : "between_first_and_third");
+	}
+	fclose(file);
+	ASSERT_SAME(spBatchQueryRun(config, searchIndex, queryExtractionMockFunction, QUERIES_FILENAME, RESULTS_FILENAME,
+			&stats), SP_BATCH_QUERY_SUCCESS);
+	ASSERT_SAME(stats.numOfQueries, numOfQueries);
+	ASSERT_SAME(stats.numOfFailedQueries, 0);
+
+	file = fopen(RESULTS_FILENAME, "r");
+	for (i = 0; i < numOfQueries; i++) {
+		ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+		ASSERT_SAME(strcmp(line, i % 2 == 0 ? "near_second\tOK\t1:4,0:0,2:0\n"
+				: "between_first_and_third\tOK\t0:2,2:2,1:0\n"), 0);
+	}
+	ASSERT_NULL(fgets(line, sizeof(line), file));
+	fclose(file);
+	remove(QUERIES_FILENAME);
+	remove(RESULTS_FILENAME);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spBatchQueryFeaturesFileTest() {
+	SP_CONFIG_MSG configMsg;
+	SPBatchQueryStats stats;
+	char line[256];
+	int i;
+	FILE *file;
+	SPPoint points[4], features[2];
+	SPKDArray kdArray;
+	SPSearchIndex searchIndex;
+	// A configuration with a 10 dimensional PCA
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	points[0] = nDPoint(0, 10, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0);
+	points[1] = nDPoint(0, 10, 2.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0);
+	points[2] = nDPoint(2, 10, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 10.0);
+	points[3] = nDPoint(2, 10, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 11.0);
+	kdArray = spKDArrayInit(points, 4);
+	searchIndex = spSearchIndexCreateKDTree(spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD));
+	spKDArrayDestroy(kdArray);
+	for (i = 0; i < 4; i++) {
+		spPointDestroy(points[i]);
+	}
+	features[0] = nDPoint(0, 10, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 10.0);
+	features[1] = nDPoint(0, 10, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 11.0);
+	ASSERT_SAME(spFeaturesFileAPIWrite(FEATURES_FILENAME, features, 2), SP_FEATURES_FILE_API_SUCCESS);
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+
+	file = fopen(QUERIES_FILENAME, "w");
+	fprintf(file, "%s%s\n%s%s\n", SP_BATCH_QUERY_FEATURES_PREFIX, FEATURES_FILENAME, SP_BATCH_QUERY_FEATURES_PREFIX,
+			"./missing.feats");
+	fclose(file);
+	// The features queries are answered without the extraction function
+	ASSERT_SAME(spBatchQueryRun(config, searchIndex, queryExtractionMockFunction, QUERIES_FILENAME, RESULTS_FILENAME,
+			&stats), SP_BATCH_QUERY_SUCCESS);
+	ASSERT_SAME(stats.numOfQueries, 2);
+	ASSERT_SAME(stats.numOfFailedQueries, 1);
+
+	file = fopen(RESULTS_FILENAME, "r");
+	ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+	ASSERT_SAME(strcmp(line, "features:./sp_batch_query_unit_test.feats\tOK\t2:4,0:0,1:0\n"), 0);
+	ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+	ASSERT_SAME(strcmp(line, "features:./missing.feats\tEXTRACTION_ERROR\t\n"), 0);
+	ASSERT_NULL(fgets(line, sizeof(line), file));
+	fclose(file);
+	remove(FEATURES_FILENAME);
+	remove(QUERIES_FILENAME);
+	remove(RESULTS_FILENAME);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spBatchQueryErrorsTest() {
+	SP_CONFIG_MSG configMsg;
+	SPBatchQueryStats stats;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+
+	ASSERT_SAME(spBatchQueryRun(NULL, searchIndex, queryExtractionMockFunction, "./test_resources/batch_queries.txt",
+			RESULTS_FILENAME, &stats), SP_BATCH_QUERY_INVALID_ARGUMENT);
+	ASSERT_SAME(spBatchQueryRun(config, searchIndex, queryExtractionMockFunction, "./test_resources/missing.txt",
+			RESULTS_FILENAME, &stats), SP_BATCH_QUERY_CANNOT_OPEN_QUERIES_FILE);
+	ASSERT_SAME(spBatchQueryRun(config, searchIndex, queryExtractionMockFunction, "./test_resources/batch_queries.txt",
+			"./missing_directory/results.tsv", &stats), SP_BATCH_QUERY_CANNOT_OPEN_RESULTS_FILE);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+int main() {
+	printf("Running SPBatchQueryTest.. \n");
+	RUN_TEST(spBatchQueryRunTest);
+	RUN_TEST(spBatchQueryManyQueriesTest);
+	RUN_TEST(spBatchQueryFeaturesFileTest);
+	RUN_TEST(spBatchQueryErrorsTest);
+}
@@ -46,6 +46,37 @@ static bool spConfigProperConfigFileTest() {
 	ASSERT_NOT_NULL(imagesPrefix);
 	ASSERT_SAME(strcmp(imagesPrefix, "sp"), 0);
 
+	ASSERT_FALSE(spConfigIsLoggerAsync(config, &resultMsg));
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_FALSE(spConfigIsLoggerRecordTags(config, &resultMsg));
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetPCATrainingImages(config, &resultMsg), 0);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetPCATrainingSamples(config, &resultMsg), 0);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetMaxImageSide(config, &resultMsg), 0);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_FALSE(spConfigIsExtractionCache(config, &resultMsg));
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_FALSE(spConfigIsFeaturesStore(config, &resultMsg));
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_FALSE(spConfigIsFeaturesSync(config, &resultMsg));
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetSearchIndex(config, &resultMsg), SEARCH_INDEX_KD_TREE);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetPQSubquantizers(config, &resultMsg), 8);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetIVFLists(config, &resultMsg), 256);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetIVFProbes(config, &resultMsg), 8);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetHNSWM(config, &resultMsg), 16);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetHNSWEfConstruction(config, &resultMsg), 200);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetHNSWEfSearch(config, &resultMsg), 64);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+
 	spConfigDestroy(config);
 	return true;
 
@@ -68,6 +99,14 @@ static bool spConfigPCAPathTest() {
 
 	ASSERT_SAME(strcmp("/tmp/testDirectory/pca.yml", pcaPath), 0);
 
+	ASSERT_SAME(spConfigGetFeaturesStorePath(NULL, config), SP_CONFIG_INVALID_ARGUMENT);
+	ASSERT_SAME(spConfigGetFeaturesStorePath(pcaPath, config), SP_CONFIG_SUCCESS);
+	ASSERT_SAME(strcmp("/tmp/testDirectory/sp.store", pcaPath), 0);
+
+	ASSERT_SAME(spConfigGetHNSWIndexPath(NULL, config), SP_CONFIG_INVALID_ARGUMENT);
+	ASSERT_SAME(spConfigGetHNSWIndexPath(pcaPath, config), SP_CONFIG_SUCCESS);
+	ASSERT_SAME(strcmp("/tmp/testDirectory/sp.hnsw", pcaPath), 0);
+
 	free(pcaPath);
 	spConfigDestroy(config);
 	return true;
@@ -99,6 +138,26 @@ static bool spConfigImagesPathTest() {
 
 /*** Help Assert Methods ***/
 
+static bool spConfigVotingModeTest() {
+	SP_CONFIG_MSG resultMsg;
+	SPConfig config = spConfigCreate("./test_resources/test_config_1.txt", &resultMsg);
+	ASSERT_SAME(spConfigGetVotingMode(config, &resultMsg), VOTING_MODE_FLAT);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetRatioTestThreshold(config, &resultMsg), 0.8);
+	ASSERT_SAME(resultMsg, SP_CONFIG_SUCCESS);
+	spConfigDestroy(config);
+
+	config = spConfigCreate("./test_resources/search_api_ratio_test_config.txt", &resultMsg);
+	ASSERT_NOT_NULL(config);
+	ASSERT_SAME(spConfigGetVotingMode(config, &resultMsg), VOTING_MODE_RATIO_TEST);
+	spConfigDestroy(config);
+
+	spConfigGetRatioTestThreshold(NULL, &resultMsg);
+	ASSERT_SAME(resultMsg, SP_CONFIG_INVALID_ARGUMENT);
+	ASSERT(configCreateError("./test_resources/test_config_invalid_ratio.txt", SP_CONFIG_INVALID_DOUBLE));
+	return true;
+}
+
 static bool configCreateError(const char *filename, SP_CONFIG_MSG expectedMsg) {
 	SP_CONFIG_MSG returnMsg;
 	SPConfig config = spConfigCreate(filename, &returnMsg);
@@ -115,4 +174,5 @@ int main() {
 	RUN_TEST(spConfigMissingConfigFileTest);
 	RUN_TEST(spConfigPCAPathTest);
 	RUN_TEST(spConfigImagesPathTest);
+	RUN_TEST(spConfigVotingModeTest);
 }
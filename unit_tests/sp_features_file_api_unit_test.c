@@ -0,0 +1,256 @@
+/*
+ * sp_features_file_api_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "../sp_features_file_api.h"
+#include "../SPPoint.h"
+#include "unit_test_util.h"
+
+#define FEATURES_FILENAME "sp_features_file_api_unit_test.feats"
+#define DIMENSION 4
+#define RANDOM_FEATURES 2000
+#define RANDOM_FEATURE_LINE_LENGTH 128
+
+static void writeTestFile(const char *contents) {
+	FILE *file = fopen(FEATURES_FILENAME, "w");
+	fputs(contents, file);
+	fclose(file);
+}
+
+static bool readTestFile(char *contents, size_t size) {
+	size_t length;
+	FILE *file = fopen(FEATURES_FILENAME, "r");
+	if (file == NULL) {
+		return false;
+	}
+	length = fread(contents, 1, size - 1, file);
+	contents[length] = '\0';
+	fclose(file);
+	return true;
+}
+
+static void destroyPoints(SPPoint *points, int numOfPoints) {
+	int i;
+	for (i = 0; i < numOfPoints; i++) {
+		spPointDestroy(points[i]);
+	}
+	free(points);
+}
+
+/**
+ * Loads the test file, expecting it to hold a single feature of the given coordinates.
+ */
+static bool loadsSingleFeature(double c0, double c1, double c2, double c3) {
+	SP_FEATURES_FILE_API_MSG msg;
+	int numOfFeatures;
+	bool equal;
+	SPPoint *features = spFeaturesFileAPILoad(FEATURES_FILENAME, 7, DIMENSION, &numOfFeatures, &msg);
+	if (features == NULL || msg != SP_FEATURES_FILE_API_SUCCESS || numOfFeatures != 1) {
+		return false;
+	}
+	equal = spPointGetIndex(features[0]) == 7 && spPointGetAxisCoor(features[0], 0) == c0
+			&& spPointGetAxisCoor(features[0], 1) == c1 && spPointGetAxisCoor(features[0], 2) == c2
+			&& spPointGetAxisCoor(features[0], 3) == c3;
+	destroyPoints(features, numOfFeatures);
+	return equal;
+}
+
+/**
+ * Loads the test file, expecting it to be rejected with the given message.
+ */
+static bool failsToLoad(SP_FEATURES_FILE_API_MSG expectedMsg) {
+	SP_FEATURES_FILE_API_MSG msg;
+	int numOfFeatures;
+	SPPoint *features = spFeaturesFileAPILoad(FEATURES_FILENAME, 0, DIMENSION, &numOfFeatures, &msg);
+	return features == NULL && msg == expectedMsg;
+}
+
+static bool spFeaturesFileAPIWriteLoadTest() {
+	double data[2][DIMENSION] = { { 0.0, -0.5, 123456.789012, 1e-7 }, { -0.0, 3.0, -99999.25, 0.125 } };
+	SPPoint features[2];
+	SPPoint *loaded;
+	SP_FEATURES_FILE_API_MSG msg;
+	int i, j, numOfFeatures;
+	features[0] = spPointCreate(data[0], DIMENSION, 3);
+	features[1] = spPointCreate(data[1], DIMENSION, 3);
+	ASSERT_SAME(spFeaturesFileAPIWrite(FEATURES_FILENAME, features, 2), SP_FEATURES_FILE_API_SUCCESS);
+
+	ASSERT_SAME(spFeaturesFileAPILoadNumOfFeatures(FEATURES_FILENAME, &msg), 2);
+	ASSERT_SAME(msg, SP_FEATURES_FILE_API_SUCCESS);
+	loaded = spFeaturesFileAPILoad(FEATURES_FILENAME, 3, DIMENSION, &numOfFeatures, &msg);
+	// Zero coordinates used to be rejected as unparsable
+	ASSERT_SAME(msg, SP_FEATURES_FILE_API_SUCCESS);
+	ASSERT_SAME(numOfFeatures, 2);
+	for (i = 0; i < 2; i++) {
+		for (j = 0; j < DIMENSION; j++) {
+			// The coordinates are written with 6 decimal places
+			double difference = spPointGetAxisCoor(loaded[i], j) - data[i][j];
+			ASSERT_TRUE(difference < 1e-6 && difference > -1e-6);
+		}
+	}
+	destroyPoints(loaded, numOfFeatures);
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+static bool spFeaturesFileAPISyncWriteTest() {
+	double data[DIMENSION] = { 1.0, 2.0, 3.0, 4.0 };
+	SPPoint feature = spPointCreate(data, DIMENSION, 0);
+	ASSERT_SAME(spFeaturesFileAPISyncWrite(FEATURES_FILENAME, &feature, 1), SP_FEATURES_FILE_API_SUCCESS);
+	ASSERT_TRUE(loadsSingleFeature(1.0, 2.0, 3.0, 4.0));
+	ASSERT_SAME(spFeaturesFileAPISyncWrite(NULL, &feature, 1), SP_FEATURES_FILE_API_INVALID_ARGUMENT);
+	spPointDestroy(feature);
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+static bool spFeaturesFileAPIFormatTest() {
+	double data[DIMENSION] = { 0.1, -2.5, 1234.567891, 2e10 };
+	char expected[256], written[256];
+	SPPoint feature = spPointCreate(data, DIMENSION, 0);
+	// The coordinates are written as printf's "%f" writes them
+	sprintf(expected, "1\n%f %f %f %f\n", data[0], data[1], data[2], data[3]);
+	ASSERT_SAME(spFeaturesFileAPIWrite(FEATURES_FILENAME, &feature, 1), SP_FEATURES_FILE_API_SUCCESS);
+	ASSERT_TRUE(readTestFile(written, sizeof(written)));
+	ASSERT_SAME(strcmp(expected, written), 0);
+	spPointDestroy(feature);
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+/**
+ * A xorshift generator, so the random coordinates are the same on every run.
+ */
+static unsigned long long nextRandom(unsigned long long *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/**
+ * Returns a random coordinate - any double of magnitude 1e-8 to 1e10, or one of the doubles around a half of the
+ * last decimal place, which are the hardest to round.
+ */
+static double randomCoordinate(unsigned long long *state) {
+	double coordinate, half;
+	if (nextRandom(state) % 2 == 0) {
+		coordinate = (double) (nextRandom(state) >> 11) / (1ULL << 53);
+		coordinate *= pow(10, (int) (nextRandom(state) % 19) - 8);
+	} else {
+		half = ((double) (nextRandom(state) % 100000000000ULL) + 0.5) / 1e6;
+		coordinate = nextafter(half, (nextRandom(state) % 2 == 0) ? 0 : INFINITY);
+		coordinate = (nextRandom(state) % 3 == 0) ? half : coordinate;
+	}
+	return (nextRandom(state) % 2 == 0) ? -coordinate : coordinate;
+}
+
+static bool spFeaturesFileAPIRandomFormatTest() {
+	// Coordinates which the scaled coordinate plus a half used to round wrongly
+	double data[DIMENSION] = { 4.9999999999999998e-07, 0.1234565, 6.7347004999999998, -4.8679625 };
+	char *expected = (char *) malloc(RANDOM_FEATURES * RANDOM_FEATURE_LINE_LENGTH);
+	char *written = (char *) malloc(RANDOM_FEATURES * RANDOM_FEATURE_LINE_LENGTH);
+	char *token, *end;
+	SPPoint features[RANDOM_FEATURES], *loaded;
+	SP_FEATURES_FILE_API_MSG msg;
+	unsigned long long state = 2026;
+	int i, j, length, numOfFeatures;
+	ASSERT_TRUE(expected != NULL && written != NULL);
+	length = sprintf(expected, "%d\n", RANDOM_FEATURES);
+	for (i = 0; i < RANDOM_FEATURES; i++) {
+		for (j = 0; i > 0 && j < DIMENSION; j++) {
+			data[j] = randomCoordinate(&state);
+		}
+		features[i] = spPointCreate(data, DIMENSION, 1);
+		length += sprintf(expected + length, "%f %f %f %f\n", data[0], data[1], data[2], data[3]);
+	}
+	ASSERT_SAME(spFeaturesFileAPIWrite(FEATURES_FILENAME, features, RANDOM_FEATURES), SP_FEATURES_FILE_API_SUCCESS);
+	ASSERT_TRUE(readTestFile(written, RANDOM_FEATURES * RANDOM_FEATURE_LINE_LENGTH));
+	ASSERT_SAME(strcmp(expected, written), 0);
+
+	// The loaded coordinates are the ones printf's output parses to
+	loaded = spFeaturesFileAPILoad(FEATURES_FILENAME, 1, DIMENSION, &numOfFeatures, &msg);
+	ASSERT_SAME(msg, SP_FEATURES_FILE_API_SUCCESS);
+	ASSERT_SAME(numOfFeatures, RANDOM_FEATURES);
+	token = strchr(expected, '\n') + 1;
+	for (i = 0; i < RANDOM_FEATURES; i++) {
+		for (j = 0; j < DIMENSION; j++) {
+			ASSERT_TRUE(spPointGetAxisCoor(loaded[i], j) == strtod(token, &end));
+			token = end + 1;
+		}
+		spPointDestroy(features[i]);
+	}
+	destroyPoints(loaded, numOfFeatures);
+	free(expected);
+	free(written);
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+static bool spFeaturesFileAPIParseTest() {
+	writeTestFile("1\n0.000000 -0.000000 +2 .5\n");
+	ASSERT_TRUE(loadsSingleFeature(0.0, 0.0, 2.0, 0.5));
+	// Exponents, numbers which are not exact in the fast path, and windows line breaks without a final line break
+	writeTestFile("1\r\n1.5e3 -25E-1 0.1000000000000000055511151231257827 123456789012345678901234\r");
+	ASSERT_TRUE(loadsSingleFeature(1500.0, -2.5, 0.1, 123456789012345678901234.0));
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+static bool spFeaturesFileAPIInvalidFileTest() {
+	SPPoint features[1];
+	SP_FEATURES_FILE_API_MSG msg;
+	int numOfFeatures;
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_FEATURE_FILE_MISSING));
+	// Too few and too many coordinates
+	writeTestFile("1\n1.0 2.0 3.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	writeTestFile("1\n1.0 2.0 3.0 4.0 5.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	// Coordinates which are not numbers, and an empty coordinate
+	writeTestFile("1\n1.0 2.0x 3.0 4.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	writeTestFile("1\n1.0  3.0 4.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	writeTestFile("1\n1.0 - 3.0 4.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	// Less features than declared, and an invalid number of features
+	writeTestFile("2\n1.0 2.0 3.0 4.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	writeTestFile("0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	writeTestFile("x1\n1.0 2.0 3.0 4.0\n");
+	ASSERT_TRUE(failsToLoad(SP_FEATURES_FILE_API_READ_ERROR));
+	ASSERT_SAME(spFeaturesFileAPILoadNumOfFeatures(FEATURES_FILENAME, &msg), -1);
+	ASSERT_SAME(msg, SP_FEATURES_FILE_API_READ_ERROR);
+
+	// The file must hold the number of features it is loaded into
+	writeTestFile("2\n1.0 2.0 3.0 4.0\n5.0 6.0 7.0 8.0\n");
+	ASSERT_SAME(spFeaturesFileAPILoadInto(FEATURES_FILENAME, 0, DIMENSION, features, 1),
+			SP_FEATURES_FILE_API_READ_ERROR);
+	ASSERT_NULL(spFeaturesFileAPILoad(NULL, 0, DIMENSION, &numOfFeatures, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_FILE_API_INVALID_ARGUMENT);
+	remove(FEATURES_FILENAME);
+	return true;
+}
+
+int main() {
+	printf("Running SPFeaturesFileAPITest.. \n");
+	RUN_TEST(spFeaturesFileAPIWriteLoadTest);
+	RUN_TEST(spFeaturesFileAPISyncWriteTest);
+	RUN_TEST(spFeaturesFileAPIFormatTest);
+	RUN_TEST(spFeaturesFileAPIRandomFormatTest);
+	RUN_TEST(spFeaturesFileAPIParseTest);
+	RUN_TEST(spFeaturesFileAPIInvalidFileTest);
+	return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * sp_features_store_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../sp_features_store.h"
+#include "../SPPoint.h"
+#include "unit_test_util.h"
+
+#define STORE_FILENAME "sp_features_store_unit_test.store"
+#define DIMENSION 3
+#define NUM_OF_IMAGES 3
+
+static double IMAGE_0_DATA[2][DIMENSION] = { { 1.5, -2.25, 0.0 }, { 100.0, 0.125, -7.0 } };
+static double IMAGE_2_DATA[1][DIMENSION] = { { 3.0, 4.0, 5.0 } };
+
+static bool pointEquals(SPPoint point, const double *data, int index) {
+	int i;
+	if (point == NULL || spPointGetIndex(point) != index || spPointGetDimension(point) != DIMENSION) {
+		return false;
+	}
+	for (i = 0; i < DIMENSION; i++) {
+		if (spPointGetAxisCoor(point, i) != data[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void destroyPoints(SPPoint *points, int numOfPoints) {
+	int i;
+	for (i = 0; i < numOfPoints; i++) {
+		spPointDestroy(points[i]);
+	}
+	free(points);
+}
+
+/**
+ * Writes a store in which image 2 is appended before image 0, and image 1 is missing.
+ */
+static bool writeTestStore() {
+	SP_FEATURES_STORE_MSG msg;
+	bool success;
+	SPPoint image0[2], image2[1];
+	SPFeaturesStoreWriter writer = spFeaturesStoreWriterCreate(STORE_FILENAME, DIMENSION, NUM_OF_IMAGES, &msg);
+	if (writer == NULL) {
+		return false;
+	}
+	image0[0] = spPointCreate(IMAGE_0_DATA[0], DIMENSION, 0);
+	image0[1] = spPointCreate(IMAGE_0_DATA[1], DIMENSION, 0);
+	image2[0] = spPointCreate(IMAGE_2_DATA[0], DIMENSION, 2);
+	success = spFeaturesStoreWriterAppend(writer, 2, image2, 1, false, 0) == SP_FEATURES_STORE_SUCCESS
+			&& spFeaturesStoreWriterAppend(writer, 0, image0, 2, true, 0xabcdefULL) == SP_FEATURES_STORE_SUCCESS
+			// An image is appended at most once
+			&& spFeaturesStoreWriterAppend(writer, 0, image0, 2, true, 0xabcdefULL) == SP_FEATURES_STORE_INVALID_ARGUMENT
+			&& spFeaturesStoreWriterAppend(writer, NUM_OF_IMAGES, image2, 1, false, 0) == SP_FEATURES_STORE_INVALID_ARGUMENT;
+	spPointDestroy(image0[0]);
+	spPointDestroy(image0[1]);
+	spPointDestroy(image2[0]);
+	if (!success) {
+		spFeaturesStoreWriterAbort(writer);
+		return false;
+	}
+	return spFeaturesStoreWriterCommit(writer) == SP_FEATURES_STORE_SUCCESS;
+}
+
+/**
+ * Overwrites a single byte of the test store at the given offset from its end.
+ */
+static bool corruptTestStore(long offsetFromEnd) {
+	char byte = 0x7f;
+	FILE *file = fopen(STORE_FILENAME, "r+b");
+	if (file == NULL) {
+		return false;
+	}
+	fseek(file, -offsetFromEnd, SEEK_END);
+	fwrite(&byte, 1, 1, file);
+	fclose(file);
+	return true;
+}
+
+static bool spFeaturesStoreRandomAccessTest() {
+	SP_FEATURES_STORE_MSG msg;
+	SPPoint *features;
+	unsigned long long hash;
+	int numOfFeatures;
+	ASSERT_TRUE(writeTestStore());
+	SPFeaturesStore store = spFeaturesStoreLoad(STORE_FILENAME, &msg);
+	ASSERT_SAME(msg, SP_FEATURES_STORE_SUCCESS);
+	ASSERT_NOT_NULL(store);
+	ASSERT_SAME(spFeaturesStoreGetDimension(store), DIMENSION);
+	ASSERT_SAME(spFeaturesStoreGetNumOfImages(store), NUM_OF_IMAGES);
+	ASSERT_SAME(spFeaturesStoreGetNumOfFeatures(store, 0), 2);
+	ASSERT_SAME(spFeaturesStoreGetNumOfFeatures(store, 1), 0);
+	ASSERT_SAME(spFeaturesStoreGetNumOfFeatures(store, 2), 1);
+	ASSERT_SAME(spFeaturesStoreGetNumOfFeatures(store, NUM_OF_IMAGES), -1);
+
+	ASSERT_TRUE(spFeaturesStoreGetImageHash(store, 0, &hash));
+	ASSERT_SAME(hash, 0xabcdefULL);
+	ASSERT_FALSE(spFeaturesStoreGetImageHash(store, 1, &hash));
+	ASSERT_FALSE(spFeaturesStoreGetImageHash(store, 2, &hash));
+
+	features = spFeaturesStoreGetImageFeatures(store, 2, &numOfFeatures, &msg);
+	ASSERT_SAME(msg, SP_FEATURES_STORE_SUCCESS);
+	ASSERT_SAME(numOfFeatures, 1);
+	ASSERT_TRUE(pointEquals(features[0], IMAGE_2_DATA[0], 2));
+	destroyPoints(features, numOfFeatures);
+
+	ASSERT_NULL(spFeaturesStoreGetImageFeatures(store, 1, &numOfFeatures, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_IMAGE_MISSING);
+	ASSERT_NULL(spFeaturesStoreGetImageFeatures(store, -1, &numOfFeatures, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_INVALID_ARGUMENT);
+
+	spFeaturesStoreDestroy(store);
+	remove(STORE_FILENAME);
+	return true;
+}
+
+static bool spFeaturesStoreLoadAllTest() {
+	SP_FEATURES_STORE_MSG msg;
+	SPPoint *features;
+	int numOfFeatures;
+	ASSERT_TRUE(writeTestStore());
+	SPFeaturesStore store = spFeaturesStoreLoad(STORE_FILENAME, &msg);
+	ASSERT_NOT_NULL(store);
+	features = spFeaturesStoreLoadAll(store, &numOfFeatures, &msg);
+	// The features outlive the mapping
+	spFeaturesStoreDestroy(store);
+	ASSERT_SAME(msg, SP_FEATURES_STORE_SUCCESS);
+	ASSERT_SAME(numOfFeatures, 3);
+	// Ordered by image index, not by append order
+	ASSERT_TRUE(pointEquals(features[0], IMAGE_0_DATA[0], 0));
+	ASSERT_TRUE(pointEquals(features[1], IMAGE_0_DATA[1], 0));
+	ASSERT_TRUE(pointEquals(features[2], IMAGE_2_DATA[0], 2));
+	destroyPoints(features, numOfFeatures);
+	remove(STORE_FILENAME);
+	return true;
+}
+
+static bool spFeaturesStoreEmptyTest() {
+	SP_FEATURES_STORE_MSG msg;
+	int numOfFeatures;
+	SPFeaturesStoreWriter writer = spFeaturesStoreWriterCreate(STORE_FILENAME, DIMENSION, NUM_OF_IMAGES, &msg);
+	ASSERT_NOT_NULL(writer);
+	ASSERT_SAME(spFeaturesStoreWriterCommit(writer), SP_FEATURES_STORE_SUCCESS);
+	SPFeaturesStore store = spFeaturesStoreLoad(STORE_FILENAME, &msg);
+	ASSERT_SAME(msg, SP_FEATURES_STORE_SUCCESS);
+	ASSERT_NULL(spFeaturesStoreLoadAll(store, &numOfFeatures, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_IMAGE_MISSING);
+	spFeaturesStoreDestroy(store);
+	remove(STORE_FILENAME);
+	return true;
+}
+
+static bool spFeaturesStoreAbortTest() {
+	SP_FEATURES_STORE_MSG msg;
+	ASSERT_TRUE(writeTestStore());
+	SPFeaturesStoreWriter writer = spFeaturesStoreWriterCreate(STORE_FILENAME, DIMENSION, 1, &msg);
+	ASSERT_NOT_NULL(writer);
+	spFeaturesStoreWriterAbort(writer);
+	// The previous store is left as it was
+	SPFeaturesStore store = spFeaturesStoreLoad(STORE_FILENAME, &msg);
+	ASSERT_SAME(msg, SP_FEATURES_STORE_SUCCESS);
+	ASSERT_SAME(spFeaturesStoreGetNumOfImages(store), NUM_OF_IMAGES);
+	spFeaturesStoreDestroy(store);
+	remove(STORE_FILENAME);
+	return true;
+}
+
+static bool spFeaturesStoreInvalidLoadTest() {
+	SP_FEATURES_STORE_MSG msg;
+	FILE *file;
+	ASSERT_NULL(spFeaturesStoreLoad(STORE_FILENAME, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_MISSING);
+	ASSERT_NULL(spFeaturesStoreLoad(NULL, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_INVALID_ARGUMENT);
+
+	// The last entry's hash is the last field of the table
+	ASSERT_TRUE(writeTestStore());
+	ASSERT_TRUE(corruptTestStore(1));
+	ASSERT_NULL(spFeaturesStoreLoad(STORE_FILENAME, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_CHECKSUM_MISMATCH);
+
+	file = fopen(STORE_FILENAME, "wb");
+	ASSERT_NOT_NULL(file);
+	fputs("not a features store, but long enough for a header", file);
+	fclose(file);
+	ASSERT_NULL(spFeaturesStoreLoad(STORE_FILENAME, &msg));
+	ASSERT_SAME(msg, SP_FEATURES_STORE_INVALID_FORMAT);
+	remove(STORE_FILENAME);
+	return true;
+}
+
+int main() {
+	printf("Running SPFeaturesStoreTest.. \n");
+	RUN_TEST(spFeaturesStoreRandomAccessTest);
+	RUN_TEST(spFeaturesStoreLoadAllTest);
+	RUN_TEST(spFeaturesStoreEmptyTest);
+	RUN_TEST(spFeaturesStoreAbortTest);
+	RUN_TEST(spFeaturesStoreInvalidLoadTest);
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * sp_hits_accumulator_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "unit_test_util.h"
+#include "../SPHitsAccumulator.h"
+
+static bool spHitsAccumulatorCreateTest() {
+	ASSERT_NULL(spHitsAccumulatorCreate(0));
+	ASSERT_NULL(spHitsAccumulatorCreate(-1));
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(10);
+	ASSERT_NOT_NULL(accumulator);
+	ASSERT_SAME(spHitsAccumulatorGetNumOfImages(accumulator), 10);
+	ASSERT_SAME(spHitsAccumulatorGetTouchedCount(accumulator), 0);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 9), 0);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 10), -1);
+	spHitsAccumulatorDestroy(accumulator);
+	return true;
+}
+
+static bool spHitsAccumulatorAddAndClearTest() {
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(5);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 5, 1), SP_HITS_ACCUMULATOR_INVALID_ARGUMENT);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 0, 0), SP_HITS_ACCUMULATOR_INVALID_ARGUMENT);
+	ASSERT_SAME(spHitsAccumulatorAdd(NULL, 0, 1), SP_HITS_ACCUMULATOR_INVALID_ARGUMENT);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 3, 1), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 3, 2), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 1, 1), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 3), 3);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 1), 1);
+	ASSERT_SAME(spHitsAccumulatorGetTouchedCount(accumulator), 2);
+
+	spHitsAccumulatorClear(accumulator);
+	ASSERT_SAME(spHitsAccumulatorGetTouchedCount(accumulator), 0);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 3), 0);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 1), 0);
+	spHitsAccumulatorDestroy(accumulator);
+	return true;
+}
+
+static bool spHitsAccumulatorTopImagesTest() {
+	int resultsCount, *results;
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(6);
+	spHitsAccumulatorAdd(accumulator, 4, 2);
+	spHitsAccumulatorAdd(accumulator, 2, 5);
+	spHitsAccumulatorAdd(accumulator, 5, 2);
+	spHitsAccumulatorAdd(accumulator, 1, 1);
+
+	results = spHitsAccumulatorTopImages(accumulator, 3, &resultsCount);
+	ASSERT_NOT_NULL(results);
+	ASSERT_SAME(resultsCount, 3);
+	ASSERT_SAME(results[0], 2);
+	ASSERT_SAME(results[1], 4);
+	ASSERT_SAME(results[2], 5);
+	free(results);
+
+	// More results than touched images - completed by the lowest untouched indices
+	results = spHitsAccumulatorTopImages(accumulator, 6, &resultsCount);
+	ASSERT_SAME(resultsCount, 6);
+	ASSERT_SAME(results[3], 1);
+	ASSERT_SAME(results[4], 0);
+	ASSERT_SAME(results[5], 3);
+	free(results);
+
+	// More results than images
+	results = spHitsAccumulatorTopImages(accumulator, 100, &resultsCount);
+	ASSERT_SAME(resultsCount, 6);
+	free(results);
+
+	ASSERT_NULL(spHitsAccumulatorTopImages(accumulator, 0, &resultsCount));
+	spHitsAccumulatorDestroy(accumulator);
+	return true;
+}
+
+static bool spHitsAccumulatorWeightedHitsTest() {
+	int resultsCount, *results;
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(4);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 3, 0.5), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 3, 0.25), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 1, 0.5), SP_HITS_ACCUMULATOR_SUCCESS);
+	ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 2, -0.5), SP_HITS_ACCUMULATOR_INVALID_ARGUMENT);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 3), 0.75);
+	ASSERT_SAME(spHitsAccumulatorGetTouchedCount(accumulator), 2);
+
+	// Hits which differ by less than a whole hit are still ranked apart
+	results = spHitsAccumulatorTopImages(accumulator, 3, &resultsCount);
+	ASSERT_SAME(results[0], 3);
+	ASSERT_SAME(results[1], 1);
+	ASSERT_SAME(results[2], 0);
+	free(results);
+	spHitsAccumulatorDestroy(accumulator);
+	return true;
+}
+
+static bool spHitsAccumulatorReuseTest() {
+	int i, resultsCount, *results;
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(1000);
+	// Touch more images than the initial touched list capacity
+	for (i = 0; i < 500; i++) {
+		ASSERT_SAME(spHitsAccumulatorAdd(accumulator, 999 - i, 1 + (i % 7)), SP_HITS_ACCUMULATOR_SUCCESS);
+	}
+	ASSERT_SAME(spHitsAccumulatorGetTouchedCount(accumulator), 500);
+	results = spHitsAccumulatorTopImages(accumulator, 2, &resultsCount);
+	// Hits of 7 are given to i = 6, 13, ... - the highest image index among those with 7 hits ranks last
+	ASSERT_SAME(results[0], 999 - 496);
+	ASSERT_SAME(results[1], 999 - 489);
+	free(results);
+
+	spHitsAccumulatorClear(accumulator);
+	spHitsAccumulatorAdd(accumulator, 7, 1);
+	results = spHitsAccumulatorTopImages(accumulator, 2, &resultsCount);
+	ASSERT_SAME(results[0], 7);
+	ASSERT_SAME(results[1], 0);
+	free(results);
+	spHitsAccumulatorDestroy(accumulator);
+	return true;
+}
+
+int main() {
+	printf("Running SPHitsAccumulatorTest.. \n");
+	RUN_TEST(spHitsAccumulatorCreateTest);
+	RUN_TEST(spHitsAccumulatorAddAndClearTest);
+	RUN_TEST(spHitsAccumulatorTopImagesTest);
+	RUN_TEST(spHitsAccumulatorWeightedHitsTest);
+	RUN_TEST(spHitsAccumulatorReuseTest);
+}
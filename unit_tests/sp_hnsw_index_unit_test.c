@@ -0,0 +1,330 @@
+/*
+ * sp_hnsw_index_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "../SPHNSWIndex.h"
+#include "../SPListElement.h"
+#include "common_test_util.h"
+#include "unit_test_util.h"
+
+#define NUM_OF_IMAGES 4
+#define FEATURES_PER_IMAGE 500
+#define NUM_OF_FEATURES (NUM_OF_IMAGES * FEATURES_PER_IMAGE)
+#define CLUSTERED_DIM 8
+#define NUM_OF_QUERIES 50
+#define KNN 10
+#define TEST_INDEX_PATH "./test_resources/hnsw_index_test.hnsw"
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value);
+
+/**
+ * A pseudo-random number in [-5, 5), of a linear congruential generator with the given state.
+ */
+static double nextCoordinate(unsigned int *state) {
+	*state = *state * 1103515245u + 12345u;
+	return ((*state >> 8) % 10000) / 1000.0 - 5;
+}
+
+/**
+ * A spread for createClusteredFeatures, of the next pseudo-random number of the given generator state.
+ */
+static double randomSpread(int feature, int coordinate, void *spreadState) {
+	(void) feature;
+	(void) coordinate;
+	return nextCoordinate((unsigned int *) spreadState);
+}
+
+/**
+ * Features of NUM_OF_IMAGES images, spread at random around their clusters. The same features on every call.
+ */
+static SPPoint *createRandomClusteredFeatures() {
+	unsigned int state = 1;
+	return createClusteredFeatures(CLUSTERED_DIM, NUM_OF_IMAGES, FEATURES_PER_IMAGE, randomSpread, &state);
+}
+
+/**
+ * Returns the squared distance of the KNN-th nearest feature to the given point.
+ */
+static double exactKNNDistance(SPPoint *features, SPPoint point) {
+	int i;
+	double distance;
+	SPListElement element;
+	SPBPQueue queue = spBPQueueCreate(KNN);
+	for (i = 0; i < NUM_OF_FEATURES; i++) {
+		element = spListElementCreate(i, spPointL2SquaredDistance(features[i], point));
+		spBPQueueEnqueue(queue, element);
+		spListElementDestroy(element);
+	}
+	distance = spBPQueueMaxValue(queue);
+	spBPQueueDestroy(queue);
+	return distance;
+}
+
+/**
+ * Searches the index for the nearest neighbors of points near the features, and returns the fraction of the found
+ * neighbors which are as near as the exact KNN nearest neighbors.
+ */
+static double recall(SPHNSWIndex index, SPPoint *features) {
+	double coordinates[CLUSTERED_DIM], exactDistance;
+	int i, k, numOfFound = 0;
+	unsigned int state = 7;
+	SPListElement element;
+	SPBPQueue queue = spBPQueueCreate(KNN);
+	SPPoint searchedPoint;
+	for (i = 0; i < NUM_OF_QUERIES; i++) {
+		for (k = 0; k < CLUSTERED_DIM; k++) {
+			coordinates[k] = spPointGetAxisCoor(features[i * NUM_OF_FEATURES / NUM_OF_QUERIES], k)
+					+ nextCoordinate(&state) / 5;
+		}
+		searchedPoint = spPointCreate(coordinates, CLUSTERED_DIM, 0);
+		exactDistance = exactKNNDistance(features, searchedPoint);
+		spHNSWIndexKNearestNeighbours(index, queue, searchedPoint);
+		while (!spBPQueueIsEmpty(queue)) {
+			element = spBPQueuePeek(queue);
+			numOfFound += (spListElementGetValue(element) <= exactDistance);
+			spListElementDestroy(element);
+			spBPQueueDequeue(queue);
+		}
+		spPointDestroy(searchedPoint);
+	}
+	spBPQueueDestroy(queue);
+	return numOfFound / (double) (NUM_OF_QUERIES * KNN);
+}
+
+static bool spHNSWIndexCreateInvalidArgumentsTest() {
+	SP_HNSW_INDEX_MSG msg;
+	SPPoint features[2];
+	features[0] = indexedThreeDPoint(0, 1, 2, 3);
+	features[1] = twoDPoint(1, 2);
+
+	ASSERT_NULL(spHNSWIndexCreate(NULL, 2, 4, 10, 10, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 0, 4, 10, 10, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 1, 1, 10, 10, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 1, 4, 0, 10, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 1, 4, 10, 0, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 1, 4, 10, 10, 0, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	// Features of different dimensions
+	ASSERT_NULL(spHNSWIndexCreate(features, 2, 4, 10, 10, 1, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexCreate(features, 1, 4, 10, 10, 1, NULL));
+
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+	return true;
+}
+
+static bool spHNSWIndexGraphTest() {
+	SP_HNSW_INDEX_MSG msg;
+	int i, layer, numOfLinks;
+	SPPoint *features = createRandomClusteredFeatures();
+	SPHNSWIndex index = spHNSWIndexCreate(features, NUM_OF_FEATURES, 4, 40, 16, 4, &msg);
+	ASSERT_SAME(msg, SP_HNSW_INDEX_SUCCESS);
+	ASSERT_NOT_NULL(index);
+
+	ASSERT_SAME(spHNSWIndexGetNumOfFeatures(index), NUM_OF_FEATURES);
+	ASSERT_SAME(spHNSWIndexGetDimension(index), CLUSTERED_DIM);
+	ASSERT_SAME(spHNSWIndexGetM(index), 4);
+	ASSERT_SAME(spHNSWIndexGetEfConstruction(index), 40);
+	ASSERT_SAME(spHNSWIndexGetEfSearch(index), 16);
+	// About a quarter of the features of every layer are in the layer above it
+	ASSERT_TRUE(spHNSWIndexGetNumOfLayers(index) > 2);
+
+	// Every feature is linked in the bottom layer, and has at most 2 * M links in it and M links above it
+	for (i = 0; i < NUM_OF_FEATURES; i++) {
+		numOfLinks = spHNSWIndexGetNumOfLinks(index, i, 0);
+		ASSERT_TRUE(numOfLinks > 0 && numOfLinks <= 8);
+		for (layer = 1; (numOfLinks = spHNSWIndexGetNumOfLinks(index, i, layer)) >= 0; layer++) {
+			ASSERT_TRUE(numOfLinks <= 4);
+		}
+	}
+	ASSERT_SAME(spHNSWIndexGetNumOfLinks(index, -1, 0), -1);
+	ASSERT_SAME(spHNSWIndexGetNumOfLinks(index, NUM_OF_FEATURES, 0), -1);
+	ASSERT_SAME(spHNSWIndexGetNumOfLinks(index, 0, spHNSWIndexGetNumOfLayers(index)), -1);
+
+	ASSERT_SAME(spHNSWIndexGetNumOfFeatures(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetDimension(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetM(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetEfConstruction(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetEfSearch(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetNumOfLayers(NULL), -1);
+	ASSERT_SAME(spHNSWIndexGetNumOfLinks(NULL, 0, 0), -1);
+
+	spHNSWIndexDestroy(index);
+	destroyFeatures(features, NUM_OF_FEATURES);
+	return true;
+}
+
+static bool spHNSWIndexExactSearchTest() {
+	SP_HNSW_INDEX_MSG msg;
+	SPHNSWIndex index;
+	SPBPQueue queue = spBPQueueCreate(4);
+	SPPoint searchedPoint = threeDPoint(20, 50, 100);
+	SPPoint features[5];
+	int i;
+	features[0] = indexedThreeDPoint(0, 1, 60, -5.5); // distance is 11591.25
+	features[1] = indexedThreeDPoint(1, 123, 70, -4.5); // 21929.25
+	features[2] = indexedThreeDPoint(2, 2, 80, 4.5); // 10344.25
+	features[3] = indexedThreeDPoint(3, 9, 140.5, 7.5); // 16867.5
+	features[4] = indexedThreeDPoint(4, 3, 8, 133.5); // 3175.25
+
+	// The search keeps more candidates than there are features, so it reaches all of them
+	index = spHNSWIndexCreate(features, 5, 2, 10, 10, 1, &msg);
+	ASSERT_SAME(msg, SP_HNSW_INDEX_SUCCESS);
+	for (i = 0; i < 5; i++) {
+		spPointDestroy(features[i]);
+	}
+
+	ASSERT_SAME(spHNSWIndexKNearestNeighbours(index, queue, searchedPoint), SP_HNSW_INDEX_SUCCESS);
+	ASSERT_TRUE(spBPQueueIsFull(queue));
+	ASSERT(peekEqualsAndDequeue(queue, 4, 3175.25));
+	ASSERT(peekEqualsAndDequeue(queue, 2, 10344.25));
+	ASSERT(peekEqualsAndDequeue(queue, 0, 11591.25));
+	ASSERT(peekEqualsAndDequeue(queue, 3, 16867.5));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+
+	spHNSWIndexDestroy(index);
+	spBPQueueDestroy(queue);
+	spPointDestroy(searchedPoint);
+	return true;
+}
+
+static bool spHNSWIndexClusteredSearchTest() {
+	SP_HNSW_INDEX_MSG msg;
+	SPListElement element;
+	double coordinates[CLUSTERED_DIM];
+	int i, k;
+	SPBPQueue queue = spBPQueueCreate(20);
+	SPPoint *features = createRandomClusteredFeatures();
+	// Built concurrently
+	SPHNSWIndex index = spHNSWIndexCreate(features, NUM_OF_FEATURES, 8, 64, 32, 4, &msg);
+	SPPoint searchedPoint;
+	ASSERT_SAME(msg, SP_HNSW_INDEX_SUCCESS);
+
+	// All of the nearest neighbors of a point near the cluster of an image are features of that image
+	for (i = 0; i < NUM_OF_IMAGES; i++) {
+		for (k = 0; k < CLUSTERED_DIM; k++) {
+			coordinates[k] = i * CLUSTERS_DISTANCE + 1;
+		}
+		searchedPoint = spPointCreate(coordinates, CLUSTERED_DIM, 0);
+		ASSERT_SAME(spHNSWIndexKNearestNeighbours(index, queue, searchedPoint), SP_HNSW_INDEX_SUCCESS);
+		ASSERT_TRUE(spBPQueueIsFull(queue));
+		while (!spBPQueueIsEmpty(queue)) {
+			element = spBPQueuePeek(queue);
+			ASSERT_SAME(spListElementGetIndex(element), i);
+			spListElementDestroy(element);
+			spBPQueueDequeue(queue);
+		}
+		spPointDestroy(searchedPoint);
+	}
+
+	// Most of the nearest neighbors found within the clusters are the exact ones
+	ASSERT_TRUE(recall(index, features) >= 0.9);
+
+	// The point must be of the indexed dimension
+	searchedPoint = threeDPoint(1, 1, 1);
+	ASSERT_SAME(spHNSWIndexKNearestNeighbours(index, queue, searchedPoint), SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spHNSWIndexKNearestNeighbours(NULL, queue, searchedPoint), SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spHNSWIndexKNearestNeighbours(index, NULL, searchedPoint), SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spHNSWIndexKNearestNeighbours(index, queue, NULL), SP_HNSW_INDEX_INVALID_ARGUMENT);
+
+	spPointDestroy(searchedPoint);
+	spHNSWIndexDestroy(index);
+	spBPQueueDestroy(queue);
+	destroyFeatures(features, NUM_OF_FEATURES);
+	return true;
+}
+
+static bool spHNSWIndexSaveLoadTest() {
+	SP_HNSW_INDEX_MSG msg;
+	unsigned long long tag = 0;
+	int i, layer;
+	FILE *file;
+	SPPoint *features = createRandomClusteredFeatures();
+	SPHNSWIndex loaded, index = spHNSWIndexCreate(features, NUM_OF_FEATURES, 6, 50, 20, 2, &msg);
+	ASSERT_SAME(msg, SP_HNSW_INDEX_SUCCESS);
+
+	ASSERT_SAME(spHNSWIndexSave(index, TEST_INDEX_PATH, 0xABCDEFULL), SP_HNSW_INDEX_SUCCESS);
+	ASSERT_SAME(spHNSWIndexSave(NULL, TEST_INDEX_PATH, 0), SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spHNSWIndexSave(index, NULL, 0), SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spHNSWIndexSave(index, "./no_such_directory/index.hnsw", 0), SP_HNSW_INDEX_WRITE_ERROR);
+
+	// The loaded graph is the saved one, searched with the given number of candidates
+	loaded = spHNSWIndexLoad(TEST_INDEX_PATH, 30, &tag, &msg);
+	ASSERT_SAME(msg, SP_HNSW_INDEX_SUCCESS);
+	ASSERT_NOT_NULL(loaded);
+	ASSERT_SAME(tag, 0xABCDEFULL);
+	ASSERT_SAME(spHNSWIndexGetNumOfFeatures(loaded), NUM_OF_FEATURES);
+	ASSERT_SAME(spHNSWIndexGetDimension(loaded), CLUSTERED_DIM);
+	ASSERT_SAME(spHNSWIndexGetM(loaded), 6);
+	ASSERT_SAME(spHNSWIndexGetEfConstruction(loaded), 50);
+	ASSERT_SAME(spHNSWIndexGetEfSearch(loaded), 30);
+	ASSERT_SAME(spHNSWIndexGetNumOfLayers(loaded), spHNSWIndexGetNumOfLayers(index));
+	for (i = 0; i < NUM_OF_FEATURES; i++) {
+		for (layer = 0; layer < spHNSWIndexGetNumOfLayers(index); layer++) {
+			ASSERT_SAME(spHNSWIndexGetNumOfLinks(loaded, i, layer), spHNSWIndexGetNumOfLinks(index, i, layer));
+		}
+	}
+	ASSERT_TRUE(recall(loaded, features) >= 0.9);
+	spHNSWIndexDestroy(loaded);
+
+	ASSERT_NULL(spHNSWIndexLoad("./no_such_directory/index.hnsw", 30, &tag, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_MISSING);
+	ASSERT_NULL(spHNSWIndexLoad(NULL, 30, &tag, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexLoad(TEST_INDEX_PATH, 0, &tag, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spHNSWIndexLoad(TEST_INDEX_PATH, 30, NULL, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_ARGUMENT);
+
+	// A changed byte does not match the checksum
+	file = fopen(TEST_INDEX_PATH, "r+b");
+	ASSERT_NOT_NULL(file);
+	fseek(file, 100, SEEK_SET);
+	fputc(fgetc(file) ^ 1, file);
+	fclose(file);
+	ASSERT_NULL(spHNSWIndexLoad(TEST_INDEX_PATH, 30, &tag, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_FORMAT);
+
+	// Neither does a file which is not an index
+	file = fopen(TEST_INDEX_PATH, "wb");
+	ASSERT_NOT_NULL(file);
+	fputs("not an index", file);
+	fclose(file);
+	ASSERT_NULL(spHNSWIndexLoad(TEST_INDEX_PATH, 30, &tag, &msg));
+	ASSERT_SAME(msg, SP_HNSW_INDEX_INVALID_FORMAT);
+
+	remove(TEST_INDEX_PATH);
+	spHNSWIndexDestroy(index);
+	destroyFeatures(features, NUM_OF_FEATURES);
+	return true;
+}
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value) {
+	SPListElement element = spBPQueuePeek(queue);
+	ASSERT_SAME(spListElementGetIndex(element), index);
+	ASSERT_SAME(spListElementGetValue(element), value);
+
+	spBPQueueDequeue(queue);
+	spListElementDestroy(element);
+	return true;
+}
+
+int main() {
+	printf("Running SPHNSWIndexTest.. \n");
+	RUN_TEST(spHNSWIndexCreateInvalidArgumentsTest);
+	RUN_TEST(spHNSWIndexGraphTest);
+	RUN_TEST(spHNSWIndexExactSearchTest);
+	RUN_TEST(spHNSWIndexClusteredSearchTest);
+	RUN_TEST(spHNSWIndexSaveLoadTest);
+}
@@ -0,0 +1,205 @@
+/*
+ * sp_ivf_index_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "../SPIVFIndex.h"
+#include "../SPListElement.h"
+#include "common_test_util.h"
+#include "unit_test_util.h"
+
+#define NUM_OF_IMAGES 4
+#define FEATURES_PER_IMAGE 300
+#define CLUSTERED_DIM 8
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value);
+
+/**
+ * Searches for the nearest neighbors of points near every image's cluster, and asserts they all are features of
+ * that image.
+ */
+static bool nearestNeighborsOfClustersTest(SPIVFIndex index) {
+	SPListElement element;
+	double coordinates[CLUSTERED_DIM];
+	int i, k;
+	SPBPQueue queue = spBPQueueCreate(20);
+	SPPoint searchedPoint;
+	for (i = 0; i < NUM_OF_IMAGES; i++) {
+		for (k = 0; k < CLUSTERED_DIM; k++) {
+			coordinates[k] = i * CLUSTERS_DISTANCE + 1;
+		}
+		searchedPoint = spPointCreate(coordinates, CLUSTERED_DIM, 0);
+		ASSERT_SAME(spIVFIndexKNearestNeighbours(index, queue, searchedPoint), SP_IVF_INDEX_SUCCESS);
+		ASSERT_TRUE(spBPQueueIsFull(queue));
+		while (!spBPQueueIsEmpty(queue)) {
+			element = spBPQueuePeek(queue);
+			ASSERT_SAME(spListElementGetIndex(element), i);
+			spListElementDestroy(element);
+			spBPQueueDequeue(queue);
+		}
+		spPointDestroy(searchedPoint);
+	}
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+static bool spIVFIndexCreateInvalidArgumentsTest() {
+	SP_IVF_INDEX_MSG msg;
+	SPPoint features[2];
+	features[0] = indexedThreeDPoint(0, 1, 2, 3);
+	features[1] = twoDPoint(1, 2);
+
+	ASSERT_NULL(spIVFIndexCreate(NULL, 2, 1, 1, 0, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spIVFIndexCreate(features, 0, 1, 1, 0, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spIVFIndexCreate(features, 1, 0, 1, 0, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spIVFIndexCreate(features, 1, 1, 0, 0, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spIVFIndexCreate(features, 1, 1, 1, -1, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	// More sub-quantizers than coordinates
+	ASSERT_NULL(spIVFIndexCreate(features, 1, 1, 1, 4, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	// Features of different dimensions
+	ASSERT_NULL(spIVFIndexCreate(features, 2, 1, 1, 0, &msg));
+	ASSERT_SAME(msg, SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spIVFIndexCreate(features, 1, 1, 1, 0, NULL));
+
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+	return true;
+}
+
+static bool spIVFIndexListsTest() {
+	SP_IVF_INDEX_MSG msg;
+	int list, totalSize = 0;
+	SPPoint *features = createClusteredFeatures(CLUSTERED_DIM, NUM_OF_IMAGES, FEATURES_PER_IMAGE, gridSpread, NULL);
+	SPIVFIndex index = spIVFIndexCreate(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE, NUM_OF_IMAGES, 2, 0, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT_NOT_NULL(index);
+
+	ASSERT_SAME(spIVFIndexGetNumOfFeatures(index), NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	ASSERT_SAME(spIVFIndexGetDimension(index), CLUSTERED_DIM);
+	ASSERT_SAME(spIVFIndexGetNumOfLists(index), NUM_OF_IMAGES);
+	ASSERT_SAME(spIVFIndexGetNumOfProbes(index), 2);
+	ASSERT_FALSE(spIVFIndexIsQuantized(index));
+	// A list per image's cluster
+	for (list = 0; list < NUM_OF_IMAGES; list++) {
+		ASSERT_SAME(spIVFIndexGetListSize(index, list), FEATURES_PER_IMAGE);
+		totalSize += spIVFIndexGetListSize(index, list);
+	}
+	ASSERT_SAME(totalSize, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	ASSERT_SAME(spIVFIndexGetListSize(index, -1), -1);
+	ASSERT_SAME(spIVFIndexGetListSize(index, NUM_OF_IMAGES), -1);
+	spIVFIndexDestroy(index);
+
+	// At most a list per feature, and at most all of the lists are probed
+	index = spIVFIndexCreate(features, 3, 10, 20, 0, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT_SAME(spIVFIndexGetNumOfLists(index), 3);
+	ASSERT_SAME(spIVFIndexGetNumOfProbes(index), 3);
+	spIVFIndexDestroy(index);
+
+	ASSERT_SAME(spIVFIndexGetNumOfFeatures(NULL), -1);
+	ASSERT_SAME(spIVFIndexGetNumOfLists(NULL), -1);
+	ASSERT_SAME(spIVFIndexGetListSize(NULL, 0), -1);
+	ASSERT_FALSE(spIVFIndexIsQuantized(NULL));
+	destroyFeatures(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	return true;
+}
+
+static bool spIVFIndexExactSearchTest() {
+	SP_IVF_INDEX_MSG msg;
+	SPIVFIndex index;
+	SPBPQueue queue = spBPQueueCreate(4);
+	SPPoint searchedPoint = threeDPoint(20, 50, 100);
+	SPPoint features[5];
+	int i;
+	features[0] = indexedThreeDPoint(0, 1, 60, -5.5); // distance is 11591.25
+	features[1] = indexedThreeDPoint(1, 123, 70, -4.5); // 21929.25
+	features[2] = indexedThreeDPoint(2, 2, 80, 4.5); // 10344.25
+	features[3] = indexedThreeDPoint(3, 9, 140.5, 7.5); // 16867.5
+	features[4] = indexedThreeDPoint(4, 3, 8, 133.5); // 3175.25
+
+	// All of the lists are probed, so the search is exact
+	index = spIVFIndexCreate(features, 5, 2, 2, 0, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(index, queue, searchedPoint), SP_IVF_INDEX_SUCCESS);
+	ASSERT(peekEqualsAndDequeue(queue, 4, 3175.25));
+	ASSERT(peekEqualsAndDequeue(queue, 2, 10344.25));
+	ASSERT(peekEqualsAndDequeue(queue, 0, 11591.25));
+	ASSERT(peekEqualsAndDequeue(queue, 3, 16867.5));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+	spIVFIndexDestroy(index);
+
+	// A list per feature, so the quantized features are exact as well
+	index = spIVFIndexCreate(features, 5, 5, 5, 3, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT_TRUE(spIVFIndexIsQuantized(index));
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(index, queue, searchedPoint), SP_IVF_INDEX_SUCCESS);
+	ASSERT(peekEqualsAndDequeue(queue, 4, 3175.25));
+	ASSERT(peekEqualsAndDequeue(queue, 2, 10344.25));
+	ASSERT(peekEqualsAndDequeue(queue, 0, 11591.25));
+	ASSERT(peekEqualsAndDequeue(queue, 3, 16867.5));
+	spIVFIndexDestroy(index);
+
+	for (i = 0; i < 5; i++) {
+		spPointDestroy(features[i]);
+	}
+	spBPQueueDestroy(queue);
+	spPointDestroy(searchedPoint);
+	return true;
+}
+
+static bool spIVFIndexClusteredSearchTest() {
+	SP_IVF_INDEX_MSG msg;
+	SPPoint *features = createClusteredFeatures(CLUSTERED_DIM, NUM_OF_IMAGES, FEATURES_PER_IMAGE, gridSpread, NULL);
+	SPBPQueue queue = spBPQueueCreate(1);
+	SPPoint searchedPoint = threeDPoint(1, 1, 1);
+	// A single list is probed
+	SPIVFIndex index = spIVFIndexCreate(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE, NUM_OF_IMAGES, 1, 0, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT(nearestNeighborsOfClustersTest(index));
+
+	// The point must be of the indexed dimension
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(index, queue, searchedPoint), SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(NULL, queue, searchedPoint), SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(index, NULL, searchedPoint), SP_IVF_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spIVFIndexKNearestNeighbours(index, queue, NULL), SP_IVF_INDEX_INVALID_ARGUMENT);
+	spIVFIndexDestroy(index);
+
+	index = spIVFIndexCreate(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE, NUM_OF_IMAGES * 4, 2, 2, &msg);
+	ASSERT_SAME(msg, SP_IVF_INDEX_SUCCESS);
+	ASSERT_TRUE(spIVFIndexIsQuantized(index));
+	ASSERT(nearestNeighborsOfClustersTest(index));
+	spIVFIndexDestroy(index);
+
+	destroyFeatures(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	spBPQueueDestroy(queue);
+	spPointDestroy(searchedPoint);
+	return true;
+}
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value) {
+	SPListElement element = spBPQueuePeek(queue);
+	ASSERT_SAME(spListElementGetIndex(element), index);
+	ASSERT_SAME(spListElementGetValue(element), value);
+
+	spBPQueueDequeue(queue);
+	spListElementDestroy(element);
+	return true;
+}
+
+int main() {
+	printf("Running SPIVFIndexTest.. \n");
+	RUN_TEST(spIVFIndexCreateInvalidArgumentsTest);
+	RUN_TEST(spIVFIndexListsTest);
+	RUN_TEST(spIVFIndexExactSearchTest);
+	RUN_TEST(spIVFIndexClusteredSearchTest);
+}
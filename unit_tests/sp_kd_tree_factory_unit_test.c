@@ -40,6 +40,101 @@ SPPoint *extractionMockFunction(const char *imagePath, int imageIndex, int *numO
 
 }
 
+static int numOfCountedExtractions = 0;
+
+SPPoint *countingExtractionMockFunction(const char *imagePath, int imageIndex, int *numOfFacturesExtracted) {
+	SPPoint *points = (SPPoint *) malloc(sizeof(*points));
+	(void) imagePath;
+	numOfCountedExtractions++;
+	points[0] = nDPoint(imageIndex, 10, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0 + imageIndex);
+	*numOfFacturesExtracted = 1;
+	return points;
+}
+
+static void writeTestFile(const char *path, const char *contents) {
+	FILE *file = fopen(path, "w");
+	fputs(contents, file);
+	fclose(file);
+}
+
+/**
+ * Creates the tree of the extraction cache test configuration, and returns the number of extracted images.
+ */
+static int countExtractions(SPConfig config) {
+	SP_KD_TREE_CREATION_MSG treeCreationMsg;
+	SPKDTreeNode searchTree;
+	numOfCountedExtractions = 0;
+	searchTree = spImagesKDTreeCreate(config, countingExtractionMockFunction, &treeCreationMsg);
+	if (searchTree == NULL || treeCreationMsg != SP_KD_TREE_CREATION_SUCCESS) {
+		return -1;
+	}
+	spKDTreeDestroy(searchTree);
+	return numOfCountedExtractions;
+}
+
+static bool kdTreeFactoryExtractionCacheTest() {
+	SP_CONFIG_MSG configMsg;
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_cache_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	writeTestFile("./test_resources/cache0.img", "first image");
+	writeTestFile("./test_resources/cache1.img", "second image");
+	writeTestFile("./test_resources/cache_pca.yml", "basis");
+
+	// Nothing is cached yet, then nothing changed
+	ASSERT_SAME(countExtractions(config), 2);
+	ASSERT_SAME(countExtractions(config), 0);
+
+	// A changed image is extracted again
+	writeTestFile("./test_resources/cache1.img", "changed second image");
+	ASSERT_SAME(countExtractions(config), 1);
+	ASSERT_SAME(countExtractions(config), 0);
+
+	// A changed PCA basis invalidates all of the images
+	writeTestFile("./test_resources/cache_pca.yml", "retrained basis");
+	ASSERT_SAME(countExtractions(config), 2);
+
+	remove("./test_resources/cache0.img");
+	remove("./test_resources/cache1.img");
+	remove("./test_resources/cache_pca.yml");
+	remove("./test_resources/cache0.feats");
+	remove("./test_resources/cache1.feats");
+	remove("./test_resources/cache0.feats.hash");
+	remove("./test_resources/cache1.feats.hash");
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool kdTreeFactoryFeaturesStoreTest() {
+	SP_CONFIG_MSG configMsg;
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_store_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	SPConfig loadConfig = spConfigCreate("./test_resources/tree_factory_store_test_config_after_load.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	writeTestFile("./test_resources/store0.img", "first image");
+	writeTestFile("./test_resources/store1.img", "second image");
+	writeTestFile("./test_resources/store_pca.yml", "basis");
+
+	// The features store also serves as the extraction cache
+	ASSERT_SAME(countExtractions(config), 2);
+	ASSERT_SAME(countExtractions(config), 0);
+	writeTestFile("./test_resources/store1.img", "changed second image");
+	ASSERT_SAME(countExtractions(config), 1);
+
+	// The store is loaded without extracting
+	ASSERT_SAME(countExtractions(loadConfig), 0);
+
+	remove("./test_resources/store0.img");
+	remove("./test_resources/store1.img");
+	remove("./test_resources/store_pca.yml");
+	remove("./test_resources/store.store");
+
+	// A missing store fails the load
+	ASSERT_SAME(countExtractions(loadConfig), -1);
+	spConfigDestroy(loadConfig);
+	spConfigDestroy(config);
+	return true;
+}
+
 static bool kdTreeFactoryCreationTest() {
 	SP_CONFIG_MSG configMsg;
 	SPConfig config = spConfigCreate("./test_resources/tree_factory_test_config.txt", &configMsg);
@@ -74,9 +169,125 @@ static bool kdTreeFactoryCreationAfterLoadTest() {
 	return true;
 }
 
+static bool kdTreeFactoryMissingFeaturesLoadTest() {
+	SP_CONFIG_MSG configMsg;
+	// The features files of images 3 and 4 are missing
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_test_config_missing_features.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+
+	SP_KD_TREE_CREATION_MSG treeCreationMsg;
+	SPKDTreeNode searchTree = spImagesKDTreeCreate(config, extractionMockFunction, &treeCreationMsg);
+
+	ASSERT_NOT_NULL(searchTree);
+	ASSERT_SAME(treeCreationMsg, SP_KD_TREE_CREATION_NON_FATAL_ERROR);
+
+	spKDTreeDestroy(searchTree);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool searchIndexFactoryPQCreationTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_KD_TREE_CREATION_MSG creationMsg;
+	SPSearchIndex searchIndex;
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_pq_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+
+	searchIndex = spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg);
+	ASSERT_NOT_NULL(searchIndex);
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_SUCCESS);
+	ASSERT_SAME(spSearchIndexGetType(searchIndex), SEARCH_INDEX_PQ);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+
+	// More sub-quantizers than the PCA dimension
+	writeTestFile("./test_resources/pq_config.txt", "spImagesDirectory = ./test_resources/\nspImagesPrefix = sp\n"
+			"spImagesSuffix = .img\nspNumOfImages = 3\nspExtractionMode = false\nspPCADimension = 10\n"
+			"spSearchIndex = PQ\nspPQSubquantizers = 11\n");
+	config = spConfigCreate("./test_resources/pq_config.txt", &configMsg);
+	remove("./test_resources/pq_config.txt");
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	ASSERT_NULL(spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg));
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_CONFIG_ERROR);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool searchIndexFactoryIVFCreationTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_KD_TREE_CREATION_MSG creationMsg;
+	SPSearchIndex searchIndex;
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_ivf_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+
+	searchIndex = spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg);
+	ASSERT_NOT_NULL(searchIndex);
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_SUCCESS);
+	ASSERT_SAME(spSearchIndexGetType(searchIndex), SEARCH_INDEX_IVF_PQ);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool searchIndexFactoryHNSWCreationTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_KD_TREE_CREATION_MSG creationMsg;
+	SP_HNSW_INDEX_MSG hnswMsg;
+	SPSearchIndex searchIndex;
+	SPHNSWIndex savedIndex;
+	FILE *file;
+	unsigned long long tag, savedTag;
+	char indexPath[MAX_PATH_LENGTH];
+	SPConfig config = spConfigCreate("./test_resources/tree_factory_hnsw_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	ASSERT_SAME(spConfigGetHNSWIndexPath(indexPath, config), SP_CONFIG_SUCCESS);
+	remove(indexPath);
+
+	// The built graph is saved
+	searchIndex = spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg);
+	ASSERT_NOT_NULL(searchIndex);
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_SUCCESS);
+	ASSERT_SAME(spSearchIndexGetType(searchIndex), SEARCH_INDEX_HNSW);
+	spSearchIndexDestroy(searchIndex);
+	savedIndex = spHNSWIndexLoad(indexPath, 10, &savedTag, &hnswMsg);
+	ASSERT_SAME(hnswMsg, SP_HNSW_INDEX_SUCCESS);
+	ASSERT_SAME(spHNSWIndexGetNumOfFeatures(savedIndex), 6);
+	ASSERT_SAME(spHNSWIndexGetM(savedIndex), 4);
+	spHNSWIndexDestroy(savedIndex);
+
+	// And loaded by the next creation
+	searchIndex = spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg);
+	ASSERT_NOT_NULL(searchIndex);
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_SUCCESS);
+	spSearchIndexDestroy(searchIndex);
+
+	// An invalid saved graph is built again
+	file = fopen(indexPath, "wb");
+	ASSERT_NOT_NULL(file);
+	fputs("not an index", file);
+	fclose(file);
+	searchIndex = spImagesSearchIndexCreate(config, extractionMockFunction, &creationMsg);
+	ASSERT_NOT_NULL(searchIndex);
+	ASSERT_SAME(creationMsg, SP_KD_TREE_CREATION_SUCCESS);
+	spSearchIndexDestroy(searchIndex);
+	savedIndex = spHNSWIndexLoad(indexPath, 10, &tag, &hnswMsg);
+	ASSERT_SAME(hnswMsg, SP_HNSW_INDEX_SUCCESS);
+	ASSERT_SAME(tag, savedTag);
+	spHNSWIndexDestroy(savedIndex);
+
+	remove(indexPath);
+	spConfigDestroy(config);
+	return true;
+}
 
 int main() {
 	printf("Running SPKDTreeFactoryTest.. \n");
 	RUN_TEST(kdTreeFactoryCreationTest);
 	RUN_TEST(kdTreeFactoryCreationAfterLoadTest);
+	RUN_TEST(kdTreeFactoryMissingFeaturesLoadTest);
+	RUN_TEST(searchIndexFactoryPQCreationTest);
+	RUN_TEST(searchIndexFactoryIVFCreationTest);
+	RUN_TEST(searchIndexFactoryHNSWCreationTest);
+	RUN_TEST(kdTreeFactoryExtractionCacheTest);
+	RUN_TEST(kdTreeFactoryFeaturesStoreTest);
 }
@@ -1,6 +1,8 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 #include "unit_test_util.h" //SUPPORTING MACROS ASSERT_TRUE/ASSERT_FALSE etc..
 #include "../SPLogger.h"
 
@@ -84,10 +86,221 @@ static bool loggerOnlyErrorTest() {
 	return true;
 }
 
+//Asynchronous mode writes the same records in the same format
+static bool asyncLoggerDebugTest() {
+	const char* expectedFile = "asyncLoggerDebugTestExp.log";
+	const char* testFile = "asyncLoggerDebugTest.log";
+	ASSERT_TRUE(spLoggerCreateAsync(testFile,SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL,0) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerCreateAsync(testFile,SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL,16) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("MSGA","sp_logger_unit_test.c",__func__,__LINE__) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB","sp_logger_unit_test.c",__func__,__LINE__) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintDebug("MSGD","sp_logger_unit_test.c",__func__,__LINE__) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("MSGE") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerFlush() == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerGetNumOfDroppedRecords() == 0);
+	spLoggerDestroy();
+	ASSERT_TRUE(identicalFiles(testFile,expectedFile));
+	return true;
+}
+
+#define ASYNC_TEST_THREADS 4
+#define ASYNC_TEST_RECORDS_PER_THREAD 2000
+
+//Prints the thread's records, and counts the dropped ones into arg (if given)
+static void* asyncLoggerPrintingThread(void* arg) {
+	unsigned long* dropped = (unsigned long*) arg;
+	int i;
+	for (i = 0; i < ASYNC_TEST_RECORDS_PER_THREAD; i++) {
+		if (spLoggerPrintInfo("MSG") == SP_LOGGER_RECORD_DROPPED && dropped != NULL) {
+			(*dropped)++;
+		}
+	}
+	return NULL;
+}
+
+//Concurrent records are never interleaved - every record is either written whole or dropped
+static bool asyncLoggerConcurrentTest() {
+	const char* testFile = "asyncLoggerConcurrentTest.log";
+	pthread_t threads[ASYNC_TEST_THREADS];
+	char line[256];
+	unsigned long headers = 0, messages = 0, threadDropped[ASYNC_TEST_THREADS] = { 0 }, returnedDrops = 0;
+	int i;
+	FILE* fp;
+	ASSERT_TRUE(spLoggerCreateAsync(testFile,SP_LOGGER_INFO_WARNING_ERROR_LEVEL,64) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < ASYNC_TEST_THREADS; i++) {
+		ASSERT_TRUE(pthread_create(&threads[i], NULL, asyncLoggerPrintingThread, &threadDropped[i]) == 0);
+	}
+	for (i = 0; i < ASYNC_TEST_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		returnedDrops += threadDropped[i];
+	}
+	unsigned long dropped = spLoggerGetNumOfDroppedRecords();
+	ASSERT_TRUE(returnedDrops == dropped); //Every dropped record was reported to its caller
+	spLoggerDestroy();
+
+	fp = fopen(testFile, "r");
+	ASSERT_TRUE(fp != NULL);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strcmp(line, "---INFO---\n") == 0) {
+			headers++;
+		} else if (strcmp(line, "- message: MSG\n") == 0) {
+			ASSERT_TRUE(messages == headers - 1);
+			messages++;
+		} else {
+			ASSERT_TRUE(strncmp(line, "- message: Log records were dropped", 35) == 0);
+		}
+	}
+	fclose(fp);
+	ASSERT_TRUE(headers == messages);
+	ASSERT_TRUE(headers + dropped == ASYNC_TEST_THREADS * ASYNC_TEST_RECORDS_PER_THREAD);
+	return true;
+}
+
+//Records longer than a ring slot are written whole
+static bool asyncLoggerLongRecordTest() {
+	const char* testFile = "asyncLoggerLongRecordTest.log";
+	char msg[3000], line[3100], expected[3100];
+	FILE* fp;
+	memset(msg, 'x', sizeof(msg) - 1);
+	msg[sizeof(msg) - 1] = '\0';
+	ASSERT_TRUE(spLoggerCreateAsync(testFile,SP_LOGGER_INFO_WARNING_ERROR_LEVEL,4) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning(msg,"sp_logger_unit_test.c",__func__,__LINE__) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("MSGE") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerFlush() == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	fp = fopen(testFile, "r");
+	ASSERT_TRUE(fp != NULL);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "---WARNING---\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- file: sp_logger_unit_test.c\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- function: asyncLoggerLongRecordTest\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL); //The line row
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	sprintf(expected, "- message: %s\n", msg);
+	ASSERT_TRUE(strcmp(line, expected) == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- message: MSGE\n") == 0);
+	fclose(fp);
+	return true;
+}
+
+//Every thread's records are written whole, also in synchronous mode
+static bool loggerConcurrentTest() {
+	const char* testFile = "loggerConcurrentTest.log";
+	pthread_t threads[ASYNC_TEST_THREADS];
+	char line[256];
+	unsigned long headers = 0, messages = 0;
+	int i;
+	FILE* fp;
+	ASSERT_TRUE(spLoggerCreate(testFile,SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	for (i = 0; i < ASYNC_TEST_THREADS; i++) {
+		ASSERT_TRUE(pthread_create(&threads[i], NULL, asyncLoggerPrintingThread, NULL) == 0);
+	}
+	for (i = 0; i < ASYNC_TEST_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	spLoggerDestroy();
+
+	fp = fopen(testFile, "r");
+	ASSERT_TRUE(fp != NULL);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strcmp(line, "---INFO---\n") == 0) {
+			ASSERT_TRUE(messages == headers);
+			headers++;
+		} else {
+			ASSERT_TRUE(strcmp(line, "- message: MSG\n") == 0);
+			ASSERT_TRUE(messages == headers - 1);
+			messages++;
+		}
+	}
+	fclose(fp);
+	ASSERT_TRUE(headers == ASYNC_TEST_THREADS * ASYNC_TEST_RECORDS_PER_THREAD);
+	ASSERT_TRUE(messages == headers);
+	return true;
+}
+
+//The thread and timestamp tags are appended to the header
+static bool loggerRecordTagsTest() {
+	const char* testFile = "loggerRecordTagsTest.log";
+	char line[256];
+	unsigned long threadId;
+	double timestamp;
+	FILE* fp;
+	ASSERT_TRUE(spLoggerSetRecordTags(true,true) == SP_LOGGER_UNDEFINED);
+	ASSERT_TRUE(spLoggerCreate(testFile,SP_LOGGER_INFO_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetRecordTags(true,true) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("MSGB","sp_logger_unit_test.c",__func__,__LINE__) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerSetRecordTags(true,false) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("MSGC") == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	fp = fopen(testFile, "r");
+	ASSERT_TRUE(fp != NULL);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(sscanf(line, "---WARNING--- [thread: %lu] [time: %lf]", &threadId, &timestamp) == 2);
+	ASSERT_TRUE(threadId > 0 && timestamp >= 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- file: sp_logger_unit_test.c\n") == 0);
+	for (int i = 0; i < 4; i++) { //The rest of the warning record
+		ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	}
+	ASSERT_TRUE(strncmp(line, "---INFO--- [thread: ", 20) == 0 && strstr(line, "time") == NULL);
+	fclose(fp);
+	return true;
+}
+
+//The macros format the message only for printed levels, and never evaluate the arguments otherwise
+static bool loggerMacrosTest() {
+	const char* testFile = "loggerMacrosTest.log";
+	char line[256], expected[64];
+	int counter = 0, expectedLine;
+	FILE* fp;
+	SP_LOG_ERROR("%d", ++counter); //Logger is not defined
+	ASSERT_SAME(counter, 0);
+	ASSERT_TRUE(spLoggerCreate(testFile,SP_LOGGER_WARNING_ERROR_LEVEL) == SP_LOGGER_SUCCESS);
+	ASSERT_FALSE(spLoggerIsLevelEnabled(SP_LOGGER_INFO_WARNING_ERROR_LEVEL));
+	ASSERT_TRUE(spLoggerIsLevelEnabled(SP_LOGGER_WARNING_ERROR_LEVEL));
+	SP_LOG_DEBUG("%d", ++counter);
+	SP_LOG_INFO("%d", ++counter);
+	ASSERT_SAME(counter, 0);
+	expectedLine = __LINE__; SP_LOG_WARNING("MSG%c %d", 'A', ++counter);
+	ASSERT_SAME(counter, 1);
+	ASSERT_TRUE(spLoggerPrintFormat(SP_LOGGER_ERROR_LEVEL, "sp_logger_unit_test.c", __func__, 1, NULL)
+			== SP_LOGGER_INVAlID_ARGUMENT);
+	spLoggerDestroy();
+
+	fp = fopen(testFile, "r");
+	ASSERT_TRUE(fp != NULL);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "---WARNING---\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strstr(line, "sp_logger_unit_test.c") != NULL);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- function: loggerMacrosTest\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	sprintf(expected, "- line: %d\n", expectedLine);
+	ASSERT_TRUE(strcmp(line, expected) == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+	ASSERT_TRUE(strcmp(line, "- message: MSGA 1\n") == 0);
+	ASSERT_TRUE(fgets(line, sizeof(line), fp) == NULL);
+	fclose(fp);
+	return true;
+}
+
 int main() {
 	RUN_TEST(basicLoggerTest);
 	RUN_TEST(basicLoggerErrorTest);
 	RUN_TEST(basicLoggerDebugTest);
 	RUN_TEST(loggerOnlyErrorTest);
+	RUN_TEST(asyncLoggerDebugTest);
+	RUN_TEST(asyncLoggerConcurrentTest);
+	RUN_TEST(asyncLoggerLongRecordTest);
+	RUN_TEST(loggerConcurrentTest);
+	RUN_TEST(loggerRecordTagsTest);
+	RUN_TEST(loggerMacrosTest);
 	return 0;
 }
@@ -0,0 +1,140 @@
+/*
+ * sp_metrics_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "../sp_metrics.h"
+#include "unit_test_util.h"
+
+#define NUM_OF_THREADS 4
+#define COUNTS_PER_THREAD 1000
+#define DUMP_FILENAME "sp_metrics_unit_test.dump"
+#define DUMP_MAX_LENGTH 32768
+
+static void *countAndExit(void *arg) {
+	int i;
+	(void) arg;
+	for (i = 0; i < COUNTS_PER_THREAD; i++) {
+		SP_METRICS_COUNT(SP_METRICS_NODES_VISITED, 2);
+		SP_METRICS_TIMER_START(timer);
+		SP_METRICS_TIMER_STOP(timer, SP_METRICS_TREE_TRAVERSAL);
+	}
+	return NULL;
+}
+
+/**
+ * Dumps the metrics in the given format and reads the dump into the given buffer.
+ */
+static bool dumpToBuffer(SP_METRICS_FORMAT format, char *buffer) {
+	size_t length;
+	FILE *file = fopen(DUMP_FILENAME, "w");
+	if (file == NULL || spMetricsDump(file, format) != SP_METRICS_SUCCESS) {
+		return false;
+	}
+	fclose(file);
+	file = fopen(DUMP_FILENAME, "r");
+	if (file == NULL) {
+		return false;
+	}
+	length = fread(buffer, 1, DUMP_MAX_LENGTH - 1, file);
+	buffer[length] = '\0';
+	fclose(file);
+	remove(DUMP_FILENAME);
+	return true;
+}
+
+static bool spMetricsDisabledTest() {
+	spMetricsSetEnabled(false);
+	spMetricsReset();
+	ASSERT_FALSE(spMetricsIsEnabled());
+	ASSERT_SAME(spMetricsTimerStart(), -1);
+	SP_METRICS_COUNT(SP_METRICS_QUERIES, 1);
+	SP_METRICS_TIMER_START(timer);
+	SP_METRICS_TIMER_STOP(timer, SP_METRICS_SEARCH);
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_QUERIES), 0);
+	ASSERT_SAME(spMetricsGetTimerCount(SP_METRICS_SEARCH), 0);
+	return true;
+}
+
+static bool spMetricsRecordTest() {
+	spMetricsSetEnabled(true);
+	spMetricsReset();
+	SP_METRICS_COUNT(SP_METRICS_QUERIES, 1);
+	SP_METRICS_COUNT(SP_METRICS_LEAVES_SCANNED, 5);
+	SP_METRICS_COUNT(SP_METRICS_LEAVES_SCANNED, 7);
+	SP_METRICS_TIMER_START(timer);
+	SP_METRICS_TIMER_STOP(timer, SP_METRICS_SEARCH);
+	SP_METRICS_TIMER_STOP(timer, SP_METRICS_SEARCH);
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_QUERIES), 1);
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_LEAVES_SCANNED), 12);
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_NODES_VISITED), 0);
+	ASSERT_SAME(spMetricsGetTimerCount(SP_METRICS_SEARCH), 2);
+	ASSERT_SAME(spMetricsGetTimerCount(SP_METRICS_VOTING), 0);
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_NUM_OF_COUNTERS), 0);
+	spMetricsReset();
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_LEAVES_SCANNED), 0);
+	ASSERT_SAME(spMetricsGetTimerCount(SP_METRICS_SEARCH), 0);
+	spMetricsSetEnabled(false);
+	return true;
+}
+
+// The values of threads which already exited are kept
+static bool spMetricsThreadsTest() {
+	pthread_t threads[NUM_OF_THREADS];
+	int i;
+	spMetricsSetEnabled(true);
+	spMetricsReset();
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		ASSERT_SAME(pthread_create(&threads[i], NULL, countAndExit, NULL), 0);
+	}
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	ASSERT_SAME(spMetricsGetCounter(SP_METRICS_NODES_VISITED), 2 * NUM_OF_THREADS * COUNTS_PER_THREAD);
+	ASSERT_SAME(spMetricsGetTimerCount(SP_METRICS_TREE_TRAVERSAL), NUM_OF_THREADS * COUNTS_PER_THREAD);
+	spMetricsSetEnabled(false);
+	return true;
+}
+
+static bool spMetricsDumpTest() {
+	char *dump = (char *) malloc(DUMP_MAX_LENGTH);
+	ASSERT_NOT_NULL(dump);
+	spMetricsSetEnabled(true);
+	spMetricsReset();
+	SP_METRICS_COUNT(SP_METRICS_QUERIES, 2);
+	SP_METRICS_COUNT(SP_METRICS_DISTANCE_COMPUTATIONS, 7);
+	SP_METRICS_TIMER_START(timer);
+	SP_METRICS_TIMER_STOP(timer, SP_METRICS_SORTING);
+	spMetricsSetEnabled(false);
+	ASSERT_SAME(spMetricsDump(NULL, SP_METRICS_FORMAT_JSON), SP_METRICS_INVALID_ARGUMENT);
+
+	ASSERT_TRUE(dumpToBuffer(SP_METRICS_FORMAT_JSON, dump));
+	ASSERT_TRUE(strncmp(dump, "{\"timers\": {\"image_decode\": {\"count\": 0, ", 40) == 0);
+	ASSERT_NOT_NULL(strstr(dump, "\"sorting\": {\"count\": 1, "));
+	ASSERT_NOT_NULL(strstr(dump, "\"distance_computations\": {\"total\": 7, \"per_query\": 3.500}"));
+	ASSERT_TRUE(strcmp(dump + strlen(dump) - 3, "}}\n") == 0);
+
+	ASSERT_TRUE(dumpToBuffer(SP_METRICS_FORMAT_PROMETHEUS, dump));
+	ASSERT_NOT_NULL(strstr(dump, "# TYPE sp_sorting_seconds histogram\n"));
+	ASSERT_NOT_NULL(strstr(dump, "sp_sorting_seconds_bucket{le=\"+Inf\"} 1\n"));
+	ASSERT_NOT_NULL(strstr(dump, "sp_sorting_seconds_count 1\n"));
+	ASSERT_NOT_NULL(strstr(dump, "sp_voting_seconds_count 0\n"));
+	ASSERT_NOT_NULL(strstr(dump, "# TYPE sp_queries_total counter\nsp_queries_total 2\n"));
+	free(dump);
+	return true;
+}
+
+int main() {
+	printf("Running SPMetricsTest.. \n");
+	RUN_TEST(spMetricsDisabledTest);
+	RUN_TEST(spMetricsRecordTest);
+	RUN_TEST(spMetricsThreadsTest);
+	RUN_TEST(spMetricsDumpTest);
+}
@@ -0,0 +1,96 @@
+/*
+ * sp_pca_file_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../sp_pca_file.h"
+#include "unit_test_util.h"
+
+#define PCA_FILENAME "sp_pca_file_unit_test.bin"
+#define DIMENSION 4
+#define NUM_OF_COMPONENTS 2
+#define SOURCE_HASH 0x1234abcd5678ef01ULL
+
+static const float MEAN[DIMENSION] = { 1.5f, -2.25f, 0.0f, 100.0f };
+static const float EIGENVECTORS[NUM_OF_COMPONENTS * DIMENSION] = {
+	0.5f, 0.5f, 0.5f, 0.5f,
+	-0.5f, 0.5f, -0.5f, 0.5f
+};
+static const float EIGENVALUES[NUM_OF_COMPONENTS] = { 10.0f, 0.125f };
+
+static bool writeTestFile() {
+	return spPCAFileWrite(PCA_FILENAME, DIMENSION, NUM_OF_COMPONENTS, MEAN, EIGENVECTORS, EIGENVALUES, SOURCE_HASH)
+			== SP_PCA_FILE_SUCCESS;
+}
+
+/**
+ * Overwrites a single byte of the test file at the given offset from its end.
+ */
+static bool corruptTestFile(long offsetFromEnd) {
+	char byte = 0x7f;
+	FILE *file = fopen(PCA_FILENAME, "r+b");
+	if (file == NULL) {
+		return false;
+	}
+	fseek(file, -offsetFromEnd, SEEK_END);
+	fwrite(&byte, 1, 1, file);
+	fclose(file);
+	return true;
+}
+
+static bool spPCAFileWriteLoadTest() {
+	SP_PCA_FILE_MSG msg;
+	SPPCAFile pcaFile;
+	ASSERT_TRUE(writeTestFile());
+	pcaFile = spPCAFileLoad(PCA_FILENAME, SOURCE_HASH, &msg);
+	ASSERT_SAME(msg, SP_PCA_FILE_SUCCESS);
+	ASSERT_NOT_NULL(pcaFile);
+	ASSERT_SAME(spPCAFileGetDimension(pcaFile), DIMENSION);
+	ASSERT_SAME(spPCAFileGetNumOfComponents(pcaFile), NUM_OF_COMPONENTS);
+	ASSERT_SAME(memcmp(spPCAFileGetMean(pcaFile), MEAN, sizeof(MEAN)), 0);
+	ASSERT_SAME(memcmp(spPCAFileGetEigenvectors(pcaFile), EIGENVECTORS, sizeof(EIGENVECTORS)), 0);
+	ASSERT_SAME(memcmp(spPCAFileGetEigenvalues(pcaFile), EIGENVALUES, sizeof(EIGENVALUES)), 0);
+	spPCAFileDestroy(pcaFile);
+	remove(PCA_FILENAME);
+	return true;
+}
+
+static bool spPCAFileInvalidFilesTest() {
+	SP_PCA_FILE_MSG msg;
+	ASSERT_NULL(spPCAFileLoad("missing.bin", SOURCE_HASH, &msg));
+	ASSERT_SAME(msg, SP_PCA_FILE_MISSING);
+	ASSERT_NULL(spPCAFileLoad(NULL, SOURCE_HASH, &msg));
+	ASSERT_SAME(msg, SP_PCA_FILE_INVALID_ARGUMENT);
+	ASSERT_SAME(spPCAFileWrite(PCA_FILENAME, 0, NUM_OF_COMPONENTS, MEAN, EIGENVECTORS, EIGENVALUES, SOURCE_HASH),
+			SP_PCA_FILE_INVALID_ARGUMENT);
+
+	// A YAML (or any other) file is not a PCA basis file
+	ASSERT_NULL(spPCAFileLoad("./test_resources/test_config_1.txt", SOURCE_HASH, &msg));
+	ASSERT_SAME(msg, SP_PCA_FILE_INVALID_FORMAT);
+
+	// A file written for another source, e.g. before the YAML PCA file was replaced
+	ASSERT_TRUE(writeTestFile());
+	ASSERT_NULL(spPCAFileLoad(PCA_FILENAME, SOURCE_HASH + 1, &msg));
+	ASSERT_SAME(msg, SP_PCA_FILE_SOURCE_MISMATCH);
+
+	// A corrupted eigenvalue
+	ASSERT_TRUE(writeTestFile());
+	ASSERT_TRUE(corruptTestFile(1));
+	ASSERT_NULL(spPCAFileLoad(PCA_FILENAME, SOURCE_HASH, &msg));
+	ASSERT_SAME(msg, SP_PCA_FILE_CHECKSUM_MISMATCH);
+	remove(PCA_FILENAME);
+	return true;
+}
+
+int main() {
+	printf("Running SPPCAFileTest.. \n");
+	RUN_TEST(spPCAFileWriteLoadTest);
+	RUN_TEST(spPCAFileInvalidFilesTest);
+	return 0;
+}
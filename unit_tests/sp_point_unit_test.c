@@ -62,13 +62,43 @@ bool pointDestroyTest() {
 	return true;
 }
 
-
+//The coordinates of a block's points are written in place, and each point is destroyed on its own
+bool pointBlockTest() {
+	SPPoint points[3];
+	size_t stride;
+	int i, j;
+	double* coordinates = spPointCreateBlock(points, 3, 2, 4, &stride);
+	ASSERT_TRUE(coordinates != NULL);
+	ASSERT_TRUE(stride >= 2 * sizeof(double) && stride % sizeof(double) == 0);
+	for (i = 0; i < 3; i++) {
+		for (j = 0; j < 2; j++) {
+			coordinates[i * stride / sizeof(double) + j] = i * 10 + j;
+		}
+	}
+	SPPoint q = spPointCopy(points[1]);
+	spPointDestroy(points[1]);
+	for (i = 0; i < 3; i++) {
+		if (i == 1) {
+			continue;
+		}
+		ASSERT_TRUE(spPointGetIndex(points[i]) == 4);
+		ASSERT_TRUE(spPointGetDimension(points[i]) == 2);
+		ASSERT_TRUE(spPointGetAxisCoor(points[i], 0) == i * 10);
+		ASSERT_TRUE(spPointGetAxisCoor(points[i], 1) == i * 10 + 1);
+	}
+	ASSERT_TRUE(spPointGetAxisCoor(q, 1) == 11.0);
+	spPointDestroy(points[2]);
+	spPointDestroy(points[0]);
+	spPointDestroy(q);
+	return true;
+}
 
 int main() {
 	RUN_TEST(pointBasicCopyTest);
 	RUN_TEST(pointBasicL2Distance);
 	RUN_TEST(pointGettersTest);
 	RUN_TEST(pointDestroyTest);
+	RUN_TEST(pointBlockTest);
 
 	return 0;
 }
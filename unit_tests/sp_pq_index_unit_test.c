@@ -0,0 +1,172 @@
+/*
+ * sp_pq_index_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "../SPPQIndex.h"
+#include "../SPListElement.h"
+#include "common_test_util.h"
+#include "unit_test_util.h"
+
+#define NUM_OF_IMAGES 4
+#define FEATURES_PER_IMAGE 300
+#define CLUSTERED_DIM 8
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value);
+
+static bool spPQIndexCreateInvalidArgumentsTest() {
+	SP_PQ_INDEX_MSG msg;
+	SPPoint features[2];
+	features[0] = indexedThreeDPoint(0, 1, 2, 3);
+	features[1] = twoDPoint(1, 2);
+
+	ASSERT_NULL(spPQIndexCreate(NULL, 2, 1, &msg));
+	ASSERT_SAME(msg, SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spPQIndexCreate(features, 0, 1, &msg));
+	ASSERT_SAME(msg, SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spPQIndexCreate(features, 1, 0, &msg));
+	ASSERT_SAME(msg, SP_PQ_INDEX_INVALID_ARGUMENT);
+	// More sub-quantizers than coordinates
+	ASSERT_NULL(spPQIndexCreate(features, 1, 4, &msg));
+	ASSERT_SAME(msg, SP_PQ_INDEX_INVALID_ARGUMENT);
+	// Features of different dimensions
+	ASSERT_NULL(spPQIndexCreate(features, 2, 1, &msg));
+	ASSERT_SAME(msg, SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_NULL(spPQIndexCreate(features, 1, 1, NULL));
+
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+	return true;
+}
+
+static bool spPQIndexGettersTest() {
+	SP_PQ_INDEX_MSG msg;
+	SPPoint *features = createClusteredFeatures(CLUSTERED_DIM, NUM_OF_IMAGES, FEATURES_PER_IMAGE, gridSpread, NULL);
+	SPPQIndex index = spPQIndexCreate(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE, 4, &msg);
+	ASSERT_SAME(msg, SP_PQ_INDEX_SUCCESS);
+	ASSERT_NOT_NULL(index);
+
+	ASSERT_SAME(spPQIndexGetNumOfFeatures(index), NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	ASSERT_SAME(spPQIndexGetDimension(index), CLUSTERED_DIM);
+	ASSERT_SAME(spPQIndexGetNumOfSubquantizers(index), 4);
+	// A byte per sub-quantizer, and the index of the image
+	ASSERT_SAME(spPQIndexGetCodesSize(index), (size_t) NUM_OF_IMAGES * FEATURES_PER_IMAGE * (4 + sizeof(int)));
+
+	ASSERT_SAME(spPQIndexGetNumOfFeatures(NULL), -1);
+	ASSERT_SAME(spPQIndexGetDimension(NULL), -1);
+	ASSERT_SAME(spPQIndexGetNumOfSubquantizers(NULL), -1);
+	ASSERT_SAME(spPQIndexGetCodesSize(NULL), (size_t) 0);
+
+	spPQIndexDestroy(index);
+	destroyFeatures(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+	return true;
+}
+
+static bool spPQIndexExactSearchTest() {
+	SP_PQ_INDEX_MSG msg;
+	SPPQIndex index;
+	SPBPQueue queue = spBPQueueCreate(4);
+	SPPoint searchedPoint = threeDPoint(20, 50, 100);
+	SPPoint features[5];
+	int i;
+	features[0] = indexedThreeDPoint(0, 1, 60, -5.5); // distance is 11591.25
+	features[1] = indexedThreeDPoint(1, 123, 70, -4.5); // 21929.25
+	features[2] = indexedThreeDPoint(2, 2, 80, 4.5); // 10344.25
+	features[3] = indexedThreeDPoint(3, 9, 140.5, 7.5); // 16867.5
+	features[4] = indexedThreeDPoint(4, 3, 8, 133.5); // 3175.25
+
+	// Every feature is a centroid of every sub-quantizer, so the distances are exact
+	index = spPQIndexCreate(features, 5, 3, &msg);
+	ASSERT_SAME(msg, SP_PQ_INDEX_SUCCESS);
+	for (i = 0; i < 5; i++) {
+		spPointDestroy(features[i]);
+	}
+
+	ASSERT_SAME(spPQIndexKNearestNeighbours(index, queue, searchedPoint), SP_PQ_INDEX_SUCCESS);
+	ASSERT_TRUE(spBPQueueIsFull(queue));
+	ASSERT(peekEqualsAndDequeue(queue, 4, 3175.25));
+	ASSERT(peekEqualsAndDequeue(queue, 2, 10344.25));
+	ASSERT(peekEqualsAndDequeue(queue, 0, 11591.25));
+	ASSERT(peekEqualsAndDequeue(queue, 3, 16867.5));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+
+	// Only the features of the range are searched
+	ASSERT_SAME(spPQIndexKNearestNeighboursInRange(index, queue, searchedPoint, 1, 4), SP_PQ_INDEX_SUCCESS);
+	ASSERT(peekEqualsAndDequeue(queue, 2, 10344.25));
+	ASSERT(peekEqualsAndDequeue(queue, 3, 16867.5));
+	ASSERT(peekEqualsAndDequeue(queue, 1, 21929.25));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+	ASSERT_SAME(spPQIndexKNearestNeighboursInRange(index, queue, searchedPoint, 2, 2), SP_PQ_INDEX_SUCCESS);
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+	ASSERT_SAME(spPQIndexKNearestNeighboursInRange(index, queue, searchedPoint, 3, 2), SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spPQIndexKNearestNeighboursInRange(index, queue, searchedPoint, 0, 6), SP_PQ_INDEX_INVALID_ARGUMENT);
+
+	spPQIndexDestroy(index);
+	spBPQueueDestroy(queue);
+	spPointDestroy(searchedPoint);
+	return true;
+}
+
+static bool spPQIndexClusteredSearchTest() {
+	SP_PQ_INDEX_MSG msg;
+	SPListElement element;
+	double coordinates[CLUSTERED_DIM];
+	int i, k;
+	SPBPQueue queue = spBPQueueCreate(20);
+	SPPoint *features = createClusteredFeatures(CLUSTERED_DIM, NUM_OF_IMAGES, FEATURES_PER_IMAGE, gridSpread, NULL);
+	SPPQIndex index = spPQIndexCreate(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE, 2, &msg);
+	SPPoint searchedPoint;
+	ASSERT_SAME(msg, SP_PQ_INDEX_SUCCESS);
+	destroyFeatures(features, NUM_OF_IMAGES * FEATURES_PER_IMAGE);
+
+	// All of the nearest neighbors of a point near the cluster of an image are features of that image
+	for (i = 0; i < NUM_OF_IMAGES; i++) {
+		for (k = 0; k < CLUSTERED_DIM; k++) {
+			coordinates[k] = i * CLUSTERS_DISTANCE + 1;
+		}
+		searchedPoint = spPointCreate(coordinates, CLUSTERED_DIM, 0);
+		ASSERT_SAME(spPQIndexKNearestNeighbours(index, queue, searchedPoint), SP_PQ_INDEX_SUCCESS);
+		ASSERT_TRUE(spBPQueueIsFull(queue));
+		while (!spBPQueueIsEmpty(queue)) {
+			element = spBPQueuePeek(queue);
+			ASSERT_SAME(spListElementGetIndex(element), i);
+			spListElementDestroy(element);
+			spBPQueueDequeue(queue);
+		}
+		spPointDestroy(searchedPoint);
+	}
+
+	// The point must be of the indexed dimension
+	searchedPoint = threeDPoint(1, 1, 1);
+	ASSERT_SAME(spPQIndexKNearestNeighbours(index, queue, searchedPoint), SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spPQIndexKNearestNeighbours(NULL, queue, searchedPoint), SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spPQIndexKNearestNeighbours(index, NULL, searchedPoint), SP_PQ_INDEX_INVALID_ARGUMENT);
+	ASSERT_SAME(spPQIndexKNearestNeighbours(index, queue, NULL), SP_PQ_INDEX_INVALID_ARGUMENT);
+
+	spPointDestroy(searchedPoint);
+	spPQIndexDestroy(index);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+static bool peekEqualsAndDequeue(SPBPQueue queue, int index, double value) {
+	SPListElement element = spBPQueuePeek(queue);
+	ASSERT_SAME(spListElementGetIndex(element), index);
+	ASSERT_SAME(spListElementGetValue(element), value);
+
+	spBPQueueDequeue(queue);
+	spListElementDestroy(element);
+	return true;
+}
+
+int main() {
+	printf("Running SPPQIndexTest.. \n");
+	RUN_TEST(spPQIndexCreateInvalidArgumentsTest);
+	RUN_TEST(spPQIndexGettersTest);
+	RUN_TEST(spPQIndexExactSearchTest);
+	RUN_TEST(spPQIndexClusteredSearchTest);
+}
@@ -0,0 +1,412 @@
+/*
+ * sp_query_server_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+#include "../SPSearchIndex.h"
+#include "../sp_query_server.h"
+#include "../sp_metrics.h"
+#include "unit_test_util.h"
+#include "common_test_util.h"
+
+#define SOCKET_PATH "./sp_query_server_unit_test.sock"
+#define DIM 10
+#define MAX_RESULTS 8
+#define MAX_METRICS_LENGTH 32768
+#define NUM_OF_IDLE_CLIENTS 4
+
+/**
+ * The searched space - images 0, 1 and 2 have features, images 3 and 4 have none.
+ */
+static SPSearchIndex createSearchIndex() {
+	SPPoint points[6];
+	SPKDArray kdArray;
+	SPKDTreeNode tree;
+	int i;
+	points[0] = nDPoint(0, DIM, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[1] = nDPoint(0, DIM, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[2] = nDPoint(1, DIM, 10.0, 10.0, 10.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[3] = nDPoint(1, DIM, 11.0, 10.0, 10.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[4] = nDPoint(2, DIM, 100.0, 100.0, 100.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[5] = nDPoint(2, DIM, 101.0, 100.0, 100.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	kdArray = spKDArrayInit(points, 6);
+	tree = spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD);
+	spKDArrayDestroy(kdArray);
+	for (i = 0; i < 6; i++) {
+		spPointDestroy(points[i]);
+	}
+	return spSearchIndexCreateKDTree(tree);
+}
+
+static SPPoint *queryExtractionMockFunction(const char *imagePath, int imageIndex, int *numOfFeaturesExtracted) {
+	SPPoint *points;
+	(void) imageIndex;
+	if (strcmp(imagePath, "near_third") == 0) {
+		points = (SPPoint *) malloc(sizeof(*points));
+		points[0] = nDPoint(0, DIM, 100.0, 100.0, 100.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+		*numOfFeaturesExtracted = 1;
+		return points;
+	}
+	*numOfFeaturesExtracted = 0;
+	return NULL;
+}
+
+static void *runServer(void *server) {
+	spQueryServerRun((SPQueryServer) server);
+	return NULL;
+}
+
+static int connectToServer() {
+	struct sockaddr_un address;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, SOCKET_PATH);
+	if (connect(fd, (struct sockaddr *) &address, sizeof(address)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void putUInt32(unsigned char *buffer, uint32_t value) {
+	value = htonl(value);
+	memcpy(buffer, &value, sizeof(value));
+}
+
+static uint32_t getUInt32(const unsigned char *buffer) {
+	uint32_t value;
+	memcpy(&value, buffer, sizeof(value));
+	return ntohl(value);
+}
+
+static void putDouble(unsigned char *buffer, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	putUInt32(buffer, (uint32_t) (bits >> 32));
+	putUInt32(buffer + 4, (uint32_t) bits);
+}
+
+static double getDouble(const unsigned char *buffer) {
+	double value;
+	uint64_t bits = ((uint64_t) getUInt32(buffer) << 32) | getUInt32(buffer + 4);
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static bool sendPathRequest(int fd, const char *path) {
+	unsigned char request[256];
+	size_t length = strlen(path);
+	putUInt32(request, (uint32_t) (length + 1));
+	request[4] = SP_QUERY_REQUEST_IMAGE_PATH;
+	memcpy(request + 5, path, length);
+	return write(fd, request, length + 5) == (ssize_t) (length + 5);
+}
+
+/**
+ * Sends a request of a single feature, whose first three coordinates are given and the rest are zeros.
+ */
+static bool sendFeatureRequest(int fd, int dimension, double x, double y, double z) {
+	unsigned char request[13 + 8 * DIM];
+	int i;
+	size_t length = 13 + 8 * dimension;
+	putUInt32(request, (uint32_t) (length - 4));
+	request[4] = SP_QUERY_REQUEST_FEATURES;
+	putUInt32(request + 5, 1);
+	putUInt32(request + 9, (uint32_t) dimension);
+	for (i = 0; i < dimension; i++) {
+		putDouble(request + 13 + 8 * i, i == 0 ? x : (i == 1 ? y : (i == 2 ? z : 0)));
+	}
+	return write(fd, request, length) == (ssize_t) length;
+}
+
+static bool readResponse(int fd, int *status, int *indices, double *scores, int *resultsCount) {
+	unsigned char response[9 + 12 * MAX_RESULTS];
+	uint32_t length, count, i;
+	if (read(fd, response, 4) != 4) {
+		return false;
+	}
+	length = getUInt32(response);
+	if (length > sizeof(response) - 4 || read(fd, response + 4, length) != (ssize_t) length) {
+		return false;
+	}
+	*status = response[4];
+	count = getUInt32(response + 5);
+	for (i = 0; i < count; i++) {
+		indices[i] = (int) getUInt32(response + 9 + 12 * i);
+		scores[i] = getDouble(response + 13 + 12 * i);
+	}
+	*resultsCount = (int) count;
+	return true;
+}
+
+/**
+ * Reads a metrics response into the given buffer, as a NUL terminated string.
+ */
+static bool readMetricsResponse(int fd, int *status, char *text) {
+	unsigned char header[9];
+	uint32_t length;
+	size_t received = 0;
+	ssize_t bytes;
+	if (read(fd, header, sizeof(header)) != (ssize_t) sizeof(header)) {
+		return false;
+	}
+	*status = header[4];
+	length = getUInt32(header + 5);
+	if (getUInt32(header) != length + 5 || length >= MAX_METRICS_LENGTH) {
+		return false;
+	}
+	while (received < length) {
+		bytes = read(fd, text + received, length - received);
+		if (bytes <= 0) {
+			return false;
+		}
+		received += (size_t) bytes;
+	}
+	text[length] = '\0';
+	return true;
+}
+
+static bool spQueryServerCreateTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_QUERY_SERVER_MSG msg;
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	ASSERT_NULL(spQueryServerCreate(NULL, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg));
+	ASSERT_SAME(msg, SP_QUERY_SERVER_INVALID_ARGUMENT);
+	ASSERT_NULL(spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, "./missing_directory/a.sock", &msg));
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SOCKET_ERROR);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spQueryServerSocketPathTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_QUERY_SERVER_MSG msg;
+	SPQueryServer server;
+	struct sockaddr_un address;
+	char content[16];
+	int staleFd;
+	FILE *file;
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+
+	// A regular file at the socket path is never removed
+	file = fopen(SOCKET_PATH, "w");
+	ASSERT_NOT_NULL(file);
+	fputs("keep", file);
+	fclose(file);
+	ASSERT_NULL(spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg));
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SOCKET_ERROR);
+	file = fopen(SOCKET_PATH, "r");
+	ASSERT_NOT_NULL(file);
+	ASSERT_NOT_NULL(fgets(content, sizeof(content), file));
+	fclose(file);
+	ASSERT_SAME(strcmp(content, "keep"), 0);
+	ASSERT_SAME(remove(SOCKET_PATH), 0);
+
+	// A socket left by a previous run, which nobody listens on, is replaced
+	staleFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, SOCKET_PATH);
+	ASSERT_SAME(bind(staleFd, (struct sockaddr *) &address, sizeof(address)), 0);
+	close(staleFd);
+	server = spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg);
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SUCCESS);
+
+	// The socket of a running server is not taken over
+	ASSERT_NULL(spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg));
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SOCKET_ERROR);
+	ASSERT_SAME(access(SOCKET_PATH, F_OK), 0);
+
+	spQueryServerDestroy(server);
+	ASSERT(access(SOCKET_PATH, F_OK) != 0);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spQueryServerQueriesTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_QUERY_SERVER_MSG msg;
+	pthread_t serverThread;
+	int firstClient, secondClient, status, resultsCount, indices[MAX_RESULTS];
+	double scores[MAX_RESULTS];
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	SPQueryServer server = spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg);
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SUCCESS);
+	ASSERT_SAME(pthread_create(&serverThread, NULL, runServer, server), 0);
+
+	// Two clients are connected at the same time
+	firstClient = connectToServer();
+	secondClient = connectToServer();
+	ASSERT(firstClient >= 0);
+	ASSERT(secondClient >= 0);
+
+	ASSERT(sendPathRequest(firstClient, "near_third"));
+	ASSERT(sendFeatureRequest(secondClient, DIM, 10, 10, 10));
+	ASSERT(readResponse(secondClient, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	ASSERT_SAME(indices[0], 1);
+	ASSERT_SAME(scores[0], 2);
+	ASSERT_SAME(indices[1], 0);
+	ASSERT_SAME(scores[1], 0);
+	ASSERT(readResponse(firstClient, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(indices[0], 2);
+	ASSERT_SAME(scores[0], 2);
+
+	// Errors are answered, and the connection keeps serving
+	ASSERT(sendPathRequest(firstClient, "missing"));
+	ASSERT(readResponse(firstClient, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_EXTRACTION_ERROR);
+	ASSERT_SAME(resultsCount, 0);
+	ASSERT(sendFeatureRequest(firstClient, 3, 10, 10, 10));
+	ASSERT(readResponse(firstClient, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_BAD_REQUEST);
+	ASSERT(sendFeatureRequest(firstClient, DIM, 0, 0, 0));
+	ASSERT(readResponse(firstClient, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(indices[0], 0);
+
+	close(firstClient);
+	close(secondClient);
+	spQueryServerStop(server);
+	pthread_join(serverThread, NULL);
+	spQueryServerDestroy(server);
+	// The socket is removed
+	ASSERT(access(SOCKET_PATH, F_OK) != 0);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spQueryServerIdleClientsTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_QUERY_SERVER_MSG msg;
+	pthread_t serverThread;
+	int i, client, idleClients[NUM_OF_IDLE_CLIENTS], status, resultsCount, indices[MAX_RESULTS];
+	double scores[MAX_RESULTS];
+	unsigned char request[16];
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	SPQueryServer server = spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg);
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SUCCESS);
+	ASSERT_SAME(pthread_create(&serverThread, NULL, runServer, server), 0);
+
+	// More idle clients than workers, the first one stops in the middle of a request
+	for (i = 0; i < NUM_OF_IDLE_CLIENTS; i++) {
+		idleClients[i] = connectToServer();
+		ASSERT(idleClients[i] >= 0);
+	}
+	putUInt32(request, 11);
+	request[4] = SP_QUERY_REQUEST_IMAGE_PATH;
+	memcpy(request + 5, "near_third", 10);
+	ASSERT(write(idleClients[0], request, 6) == 6);
+
+	// Another client is answered right away, also when it sends its requests without waiting for the responses
+	client = connectToServer();
+	ASSERT(client >= 0);
+	ASSERT(sendFeatureRequest(client, DIM, 10, 10, 10));
+	ASSERT(sendFeatureRequest(client, DIM, 0, 0, 0));
+	ASSERT(readResponse(client, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(indices[0], 1);
+	ASSERT(readResponse(client, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(indices[0], 0);
+
+	// The rest of the request is read once it arrives
+	ASSERT(write(idleClients[0], request + 6, 9) == 9);
+	ASSERT(readResponse(idleClients[0], &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_SAME(indices[0], 2);
+
+	// The server stops although its clients are still connected
+	spQueryServerStop(server);
+	pthread_join(serverThread, NULL);
+	spQueryServerDestroy(server);
+	close(client);
+	for (i = 0; i < NUM_OF_IDLE_CLIENTS; i++) {
+		close(idleClients[i]);
+	}
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spQueryServerMetricsTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_QUERY_SERVER_MSG msg;
+	pthread_t serverThread;
+	int client, status, resultsCount, indices[MAX_RESULTS];
+	double scores[MAX_RESULTS];
+	unsigned char request[5];
+	char *text = (char *) malloc(MAX_METRICS_LENGTH);
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	SPQueryServer server = spQueryServerCreate(config, searchIndex, queryExtractionMockFunction, SOCKET_PATH, &msg);
+	ASSERT_NOT_NULL(text);
+	ASSERT_SAME(msg, SP_QUERY_SERVER_SUCCESS);
+	spMetricsSetEnabled(true);
+	spMetricsReset();
+	ASSERT_SAME(pthread_create(&serverThread, NULL, runServer, server), 0);
+	client = connectToServer();
+	ASSERT(client >= 0);
+
+	ASSERT(sendFeatureRequest(client, DIM, 10, 10, 10));
+	ASSERT(readResponse(client, &status, indices, scores, &resultsCount));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	putUInt32(request, 1);
+	request[4] = SP_QUERY_REQUEST_METRICS;
+	ASSERT(write(client, request, sizeof(request)) == (ssize_t) sizeof(request));
+	ASSERT(readMetricsResponse(client, &status, text));
+	ASSERT_SAME(status, SP_QUERY_RESPONSE_SUCCESS);
+	ASSERT_NOT_NULL(strstr(text, "sp_queries_total 1\n"));
+	ASSERT_NOT_NULL(strstr(text, "sp_search_seconds_count 1\n"));
+	// A single query feature
+	ASSERT_NOT_NULL(strstr(text, "sp_tree_traversal_seconds_count 1\n"));
+
+	close(client);
+	spQueryServerStop(server);
+	pthread_join(serverThread, NULL);
+	spQueryServerDestroy(server);
+	spMetricsSetEnabled(false);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	free(text);
+	return true;
+}
+
+int main() {
+	printf("Running SPQueryServerTest.. \n");
+	RUN_TEST(spQueryServerCreateTest);
+	RUN_TEST(spQueryServerSocketPathTest);
+	RUN_TEST(spQueryServerQueriesTest);
+	RUN_TEST(spQueryServerIdleClientsTest);
+	RUN_TEST(spQueryServerMetricsTest);
+}
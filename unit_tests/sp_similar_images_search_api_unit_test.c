@@ -0,0 +1,331 @@
+/*
+ * sp_similar_images_search_api_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPKDArray.h"
+#include "../SPKDTree.h"
+#include "../SPSearchIndex.h"
+#include "../sp_similar_images_search_api.h"
+#include "unit_test_util.h"
+#include "common_test_util.h"
+
+/**
+ * The searched space, with all of the coordinates multiplied by the given scale - images 0, 1 and 2 have features,
+ * images 3 and 4 have none.
+ */
+static SPSearchIndex createScaledSearchIndex(double scale) {
+	SPPoint points[6];
+	SPKDArray kdArray;
+	SPKDTreeNode tree;
+	int i;
+	points[0] = indexedThreeDPoint(0, 0, 0, 0);
+	points[1] = indexedThreeDPoint(0, scale, 0, 0);
+	points[2] = indexedThreeDPoint(1, 10 * scale, 10 * scale, 10 * scale);
+	points[3] = indexedThreeDPoint(1, 11 * scale, 10 * scale, 10 * scale);
+	points[4] = indexedThreeDPoint(2, 100 * scale, 100 * scale, 100 * scale);
+	points[5] = indexedThreeDPoint(2, 101 * scale, 100 * scale, 100 * scale);
+	kdArray = spKDArrayInit(points, 6);
+	tree = spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD);
+	spKDArrayDestroy(kdArray);
+	for (i = 0; i < 6; i++) {
+		spPointDestroy(points[i]);
+	}
+	return spSearchIndexCreateKDTree(tree);
+}
+
+static SPSearchIndex createSearchIndex() {
+	return createScaledSearchIndex(1);
+}
+
+static SPPoint *queryExtractionMockFunction(const char *imagePath, int imageIndex, int *numOfFeaturesExtracted) {
+	SPPoint *points;
+	(void) imageIndex;
+	if (strcmp(imagePath, "near_second") == 0) {
+		// Each feature votes twice for image 1
+		points = (SPPoint *) malloc(2 * sizeof(*points));
+		points[0] = threeDPoint(10, 10, 10);
+		points[1] = threeDPoint(11, 10, 10);
+		*numOfFeaturesExtracted = 2;
+		return points;
+	} else if (strcmp(imagePath, "between_first_and_third") == 0) {
+		// One feature votes twice for image 2, one feature votes twice for image 0
+		points = (SPPoint *) malloc(2 * sizeof(*points));
+		points[0] = threeDPoint(100, 100, 100);
+		points[1] = threeDPoint(0, 0, 0);
+		*numOfFeaturesExtracted = 2;
+		return points;
+	} else if (strcmp(imagePath, "distinct_second_ambiguous_first") == 0) {
+		// Flat votes tie between images 0 and 1, but the feature of image 0 is much nearer to its nearest neighbor
+		// than to its second one
+		points = (SPPoint *) malloc(2 * sizeof(*points));
+		points[0] = threeDPoint(10.25, 10, 10);
+		points[1] = threeDPoint(0, 0, 0);
+		*numOfFeaturesExtracted = 2;
+		return points;
+	} else if (strcmp(imagePath, "ambiguous_first") == 0) {
+		// Two features which are equally distant from both features of image 0, one exact match of image 2
+		points = (SPPoint *) malloc(3 * sizeof(*points));
+		points[0] = threeDPoint(0.5, 0, 0);
+		points[1] = threeDPoint(0.5, 0, 0);
+		points[2] = threeDPoint(100, 100, 100);
+		*numOfFeaturesExtracted = 3;
+		return points;
+	}
+	*numOfFeaturesExtracted = 0;
+	return NULL;
+}
+
+static bool spFindSimilarImagesRankingTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int resultsCount = 0, *results;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	SPSearchIndex searchIndex = createSearchIndex();
+	ASSERT_NOT_NULL(searchIndex);
+
+	results = spFindSimilarImagesIndices(config, "near_second", searchIndex, &resultsCount, queryExtractionMockFunction,
+			&msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_NOT_NULL(results);
+	ASSERT_SAME(resultsCount, 3);
+	// Image 1 is the only one with hits, the rest are completed by index
+	ASSERT_SAME(results[0], 1);
+	ASSERT_SAME(results[1], 0);
+	ASSERT_SAME(results[2], 2);
+	free(results);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spFindSimilarImagesTieBreakTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int resultsCount = 0, *results;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	SPSearchIndex searchIndex = createSearchIndex();
+
+	results = spFindSimilarImagesIndices(config, "between_first_and_third", searchIndex, &resultsCount,
+			queryExtractionMockFunction, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	// Images 0 and 2 have the same hits - lower index comes first. Then the first image without hits.
+	ASSERT_SAME(results[0], 0);
+	ASSERT_SAME(results[1], 2);
+	ASSERT_SAME(results[2], 1);
+	free(results);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spFindSimilarImagesDistanceWeightedTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int i, resultsCount = 0, *results;
+	SPPoint features[2];
+	SPConfig flatConfig = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPConfig weightedConfig = spConfigCreate("./test_resources/search_api_distance_weighted_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	SPSearchIndex searchIndex = createSearchIndex();
+	SPSearchIndex scaledSearchIndex = createScaledSearchIndex(1000);
+	SPSearchIndex searchIndices[2];
+	const double scales[2] = { 1, 1000 };
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(5);
+	searchIndices[0] = searchIndex;
+	searchIndices[1] = scaledSearchIndex;
+
+	results = spFindSimilarImagesIndices(flatConfig, "distinct_second_ambiguous_first", searchIndex, &resultsCount,
+			queryExtractionMockFunction, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	// Same flat hits - lower index comes first
+	ASSERT_SAME(results[0], 0);
+	ASSERT_SAME(results[1], 1);
+	free(results);
+
+	results = spFindSimilarImagesIndices(weightedConfig, "distinct_second_ambiguous_first", searchIndex,
+			&resultsCount, queryExtractionMockFunction, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	// Image 1 gets 1 + 0.0625 / 0.5625 hits, image 0 gets 1 + 0 / 1 hits
+	ASSERT_SAME(results[0], 1);
+	ASSERT_SAME(results[1], 0);
+	ASSERT_SAME(results[2], 2);
+	free(results);
+
+	// The hits do not depend on the scale of the coordinates
+	for (i = 0; i < 2; i++) {
+		features[0] = threeDPoint(10.25 * scales[i], 10 * scales[i], 10 * scales[i]);
+		features[1] = threeDPoint(0, 0, 0);
+		results = spFindSimilarImagesIndicesByFeatures(weightedConfig, features, 2, searchIndices[i], accumulator,
+				&resultsCount, &msg);
+		ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+		ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 1), 1 + 1.0 / 9);
+		ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 0), 1);
+		free(results);
+		spPointDestroy(features[0]);
+		spPointDestroy(features[1]);
+	}
+
+	spHitsAccumulatorDestroy(accumulator);
+	spSearchIndexDestroy(scaledSearchIndex);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(flatConfig);
+	spConfigDestroy(weightedConfig);
+	return true;
+}
+
+static bool spFindSimilarImagesRatioTestTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int resultsCount = 0, *results;
+	SPConfig flatConfig = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPConfig ratioConfig = spConfigCreate("./test_resources/search_api_ratio_test_config.txt", &configMsg);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	SPSearchIndex searchIndex = createSearchIndex();
+
+	results = spFindSimilarImagesIndices(flatConfig, "ambiguous_first", searchIndex, &resultsCount,
+			queryExtractionMockFunction, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(results[0], 0);
+	ASSERT_SAME(results[1], 2);
+	free(results);
+
+	results = spFindSimilarImagesIndices(ratioConfig, "ambiguous_first", searchIndex, &resultsCount,
+			queryExtractionMockFunction, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	// The ambiguous features fail the ratio test, only the exact match of image 2 votes
+	ASSERT_SAME(results[0], 2);
+	ASSERT_SAME(results[1], 0);
+	ASSERT_SAME(results[2], 1);
+	free(results);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(flatConfig);
+	spConfigDestroy(ratioConfig);
+	return true;
+}
+
+static bool spFindSimilarImagesByFeaturesTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int resultsCount = 0, *results;
+	SPPoint features[2];
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(5);
+	features[0] = threeDPoint(100, 100, 100);
+	features[1] = threeDPoint(10, 10, 10);
+
+	results = spFindSimilarImagesIndicesByFeatures(config, features, 2, searchIndex, accumulator, &resultsCount, &msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	ASSERT_SAME(results[0], 1);
+	ASSERT_SAME(results[1], 2);
+	ASSERT_SAME(results[2], 0);
+	// The hits are kept in the accumulator as the results scores
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 2), 2);
+	free(results);
+
+	ASSERT_NULL(spFindSimilarImagesIndicesByFeatures(config, features, 0, searchIndex, accumulator, &resultsCount, &msg));
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT);
+
+	spPointDestroy(features[0]);
+	spPointDestroy(features[1]);
+	spHitsAccumulatorDestroy(accumulator);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spFindSimilarImagesByDescriptorsTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int i, resultsCount = 0, *results;
+	double descriptors[2 * 10] = { 0 };
+	SPPoint points[4];
+	SPKDArray kdArray;
+	SPSearchIndex searchIndex;
+	SPConfig config = spConfigCreate("./test_resources/query_server_test_config.txt", &configMsg);
+	SPHitsAccumulator accumulator = spHitsAccumulatorCreate(5);
+	ASSERT_SAME(configMsg, SP_CONFIG_SUCCESS);
+	points[0] = nDPoint(0, 10, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[1] = nDPoint(0, 10, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+	points[2] = nDPoint(3, 10, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 10.0);
+	points[3] = nDPoint(3, 10, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 11.0);
+	kdArray = spKDArrayInit(points, 4);
+	searchIndex = spSearchIndexCreateKDTree(spKDTreeBuild(kdArray, TREE_SPLIT_METHOD_MAX_SPREAD));
+	spKDArrayDestroy(kdArray);
+	for (i = 0; i < 4; i++) {
+		spPointDestroy(points[i]);
+	}
+	// The descriptors are contiguous - the second one starts right after the first
+	descriptors[9] = 10;
+	descriptors[10 + 9] = 11;
+
+	results = spFindSimilarImagesIndicesByDescriptors(config, descriptors, 2, 10, searchIndex, accumulator, &resultsCount,
+			&msg);
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_SUCCESS);
+	ASSERT_SAME(resultsCount, 3);
+	ASSERT_SAME(results[0], 3);
+	ASSERT_SAME(spHitsAccumulatorGetHits(accumulator, 3), 4);
+	ASSERT_SAME(results[1], 0);
+	free(results);
+
+	// The descriptors must have the PCA dimension
+	ASSERT_NULL(spFindSimilarImagesIndicesByDescriptors(config, descriptors, 4, 5, searchIndex, accumulator, &resultsCount,
+			&msg));
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT);
+	ASSERT_NULL(spFindSimilarImagesIndicesByDescriptors(config, NULL, 2, 10, searchIndex, accumulator, &resultsCount,
+			&msg));
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT);
+
+	spHitsAccumulatorDestroy(accumulator);
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+static bool spFindSimilarImagesExtractionErrorTest() {
+	SP_CONFIG_MSG configMsg;
+	SP_SIMILAR_IMAGES_SEARCH_API_MSG msg;
+	int resultsCount = 0;
+	SPConfig config = spConfigCreate("./test_resources/search_api_test_config.txt", &configMsg);
+	SPSearchIndex searchIndex = createSearchIndex();
+
+	ASSERT_NULL(spFindSimilarImagesIndices(config, "missing", searchIndex, &resultsCount, queryExtractionMockFunction,
+			&msg));
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_FEATURES_EXTRACTION_ERROR);
+	ASSERT_NULL(spFindSimilarImagesIndices(NULL, "missing", searchIndex, &resultsCount, queryExtractionMockFunction,
+			&msg));
+	ASSERT_SAME(msg, SP_SIMILAR_IMAGES_SEARCH_API_INVALID_ARGUMENT);
+
+	spSearchIndexDestroy(searchIndex);
+	spConfigDestroy(config);
+	return true;
+}
+
+int main() {
+	printf("Running SPSimilarImagesSearchAPITest.. \n");
+	RUN_TEST(spFindSimilarImagesRankingTest);
+	RUN_TEST(spFindSimilarImagesTieBreakTest);
+	RUN_TEST(spFindSimilarImagesDistanceWeightedTest);
+	RUN_TEST(spFindSimilarImagesRatioTestTest);
+	RUN_TEST(spFindSimilarImagesByFeaturesTest);
+	RUN_TEST(spFindSimilarImagesByDescriptorsTest);
+	RUN_TEST(spFindSimilarImagesExtractionErrorTest);
+}
@@ -0,0 +1,89 @@
+/*
+ * sp_thread_pool_unit_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mataneilat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "../SPThreadPool.h"
+#include "unit_test_util.h"
+
+#define NUM_OF_THREADS 4
+#define NUM_OF_JOBS 1000
+
+/** Per worker jobs counters - every worker only touches its own counter. */
+static int workerJobs[NUM_OF_THREADS];
+static int invalidWorkerIndices;
+
+static void countJob(void *arg, int workerIndex) {
+	int *value = (int *) arg;
+	if (workerIndex < 0 || workerIndex >= NUM_OF_THREADS) {
+		invalidWorkerIndices++;
+		return;
+	}
+	workerJobs[workerIndex] += *value;
+}
+
+static bool spThreadPoolCreateTest() {
+	SPThreadPool pool;
+	ASSERT_NULL(spThreadPoolCreate(0, 1));
+	ASSERT_NULL(spThreadPoolCreate(1, 0));
+	pool = spThreadPoolCreate(NUM_OF_THREADS, 1);
+	ASSERT_NOT_NULL(pool);
+	ASSERT_SAME(spThreadPoolGetNumOfThreads(pool), NUM_OF_THREADS);
+	ASSERT_SAME(spThreadPoolGetNumOfThreads(NULL), -1);
+	ASSERT_SAME(spThreadPoolSubmit(pool, NULL, NULL), SP_THREAD_POOL_INVALID_ARGUMENT);
+	ASSERT_SAME(spThreadPoolSubmit(NULL, countJob, NULL), SP_THREAD_POOL_INVALID_ARGUMENT);
+	spThreadPoolDestroy(pool);
+	return true;
+}
+
+static bool spThreadPoolSubmitAndWaitTest() {
+	int i, total = 0, one = 1;
+	// A small queue makes the submission block
+	SPThreadPool pool = spThreadPoolCreate(NUM_OF_THREADS, 2);
+	invalidWorkerIndices = 0;
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		workerJobs[i] = 0;
+	}
+	for (i = 0; i < NUM_OF_JOBS; i++) {
+		ASSERT_SAME(spThreadPoolSubmit(pool, countJob, &one), SP_THREAD_POOL_SUCCESS);
+	}
+	spThreadPoolWait(pool);
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		total += workerJobs[i];
+	}
+	ASSERT_SAME(total, NUM_OF_JOBS);
+	ASSERT_SAME(invalidWorkerIndices, 0);
+	spThreadPoolDestroy(pool);
+	return true;
+}
+
+static bool spThreadPoolDestroyRunsPendingJobsTest() {
+	int i, total = 0, one = 1;
+	SPThreadPool pool = spThreadPoolCreate(1, NUM_OF_JOBS);
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		workerJobs[i] = 0;
+	}
+	for (i = 0; i < NUM_OF_JOBS; i++) {
+		spThreadPoolSubmit(pool, countJob, &one);
+	}
+	spThreadPoolDestroy(pool);
+	for (i = 0; i < NUM_OF_THREADS; i++) {
+		total += workerJobs[i];
+	}
+	ASSERT_SAME(total, NUM_OF_JOBS);
+	// A single worker has index 0
+	ASSERT_SAME(workerJobs[0], NUM_OF_JOBS);
+	return true;
+}
+
+int main() {
+	printf("Running SPThreadPoolTest.. \n");
+	RUN_TEST(spThreadPoolCreateTest);
+	RUN_TEST(spThreadPoolSubmitAndWaitTest);
+	RUN_TEST(spThreadPoolDestroyRunsPendingJobsTest);
+}
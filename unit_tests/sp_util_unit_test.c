@@ -125,6 +125,32 @@ static bool spUtilJoinSingleStringTest() {
 	return true;
 }
 
+static bool spUtilFNV1aHashTest() {
+	unsigned long long hash;
+	// The published FNV-1a test vectors
+	ASSERT_TRUE(spUtilFNV1aHash("", 0, SP_UTIL_FNV1A_INITIAL_HASH) == 0xcbf29ce484222325ULL);
+	ASSERT_TRUE(spUtilFNV1aHash("a", 1, SP_UTIL_FNV1A_INITIAL_HASH) == 0xaf63dc4c8601ec8cULL);
+	ASSERT_TRUE(spUtilFNV1aHash("foobar", 6, SP_UTIL_FNV1A_INITIAL_HASH) == 0x85944171f73967e8ULL);
+
+	// Hashing in parts is the same as hashing at once
+	hash = spUtilFNV1aHash("foo", 3, SP_UTIL_FNV1A_INITIAL_HASH);
+	ASSERT_TRUE(spUtilFNV1aHash("bar", 3, hash) == 0x85944171f73967e8ULL);
+	return true;
+}
+
+static bool spUtilFNV1aHashFileTest() {
+	unsigned long long hash = SP_UTIL_FNV1A_INITIAL_HASH;
+	FILE *file = fopen("sp_util_unit_test.hash", "w");
+	ASSERT_NOT_NULL(file);
+	fputs("foobar", file);
+	fclose(file);
+	ASSERT_TRUE(spUtilFNV1aHashFile("sp_util_unit_test.hash", &hash));
+	ASSERT_TRUE(hash == 0x85944171f73967e8ULL);
+	remove("sp_util_unit_test.hash");
+	ASSERT_FALSE(spUtilFNV1aHashFile("sp_util_unit_test.hash", &hash));
+	return true;
+}
+
 int main() {
 	printf("Running SPUtilTest.. \n");
 	RUN_TEST(spUtilSimpleSplitTest);
@@ -134,4 +160,6 @@ int main() {
 	RUN_TEST(spUtilSplitConsecutiveDeilimitersTest);
 	RUN_TEST(spUtilSimpleJoinTest);
 	RUN_TEST(spUtilJoinSingleStringTest);
+	RUN_TEST(spUtilFNV1aHashTest);
+	RUN_TEST(spUtilFNV1aHashFileTest);
 }